@@ -26,6 +26,7 @@
 #import "OFArray+Private.h"
 #import "OFAdjacentArray.h"
 #import "OFData.h"
+#import "OFJSONWriter.h"
 #import "OFNull.h"
 #import "OFString.h"
 #import "OFSubarray.h"
@@ -39,11 +40,6 @@ static struct {
 	Class isa;
 } placeholder;
 
-@interface OFArray ()
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth;
-@end
-
 @interface OFPlaceholderArray: OFArray
 @end
 
@@ -586,72 +582,32 @@ static struct {
 
 - (OFString *)JSONRepresentation
 {
-	return [self of_JSONRepresentationWithOptions: 0
-						depth: 0];
+	return [self JSONRepresentationWithOptions: 0];
 }
 
 - (OFString *)JSONRepresentationWithOptions: (int)options
 {
-	return [self of_JSONRepresentationWithOptions: options
-						depth: 0];
-}
-
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth
-{
-	OFMutableString *JSON = [OFMutableString stringWithString: @"["];
 	void *pool = objc_autoreleasePoolPush();
-	size_t i, count = self.count;
-
-	if (options & OF_JSON_REPRESENTATION_PRETTY) {
-		OFMutableString *indentation = [OFMutableString string];
-
-		for (i = 0; i < depth; i++)
-			[indentation appendString: @"\t"];
+	OFJSONWriter *writer = [OFJSONWriter writer];
+	OFString *JSON;
 
-		[JSON appendString: @"\n"];
+	writer.options = options;
+	[self writeJSONRepresentationToWriter: writer];
+	JSON = [writer.string retain];
 
-		i = 0;
-		for (id object in self) {
-			void *pool2 = objc_autoreleasePoolPush();
-
-			[JSON appendString: indentation];
-			[JSON appendString: @"\t"];
-			[JSON appendString: [object
-			    of_JSONRepresentationWithOptions: options
-						       depth: depth + 1]];
-
-			if (++i < count)
-				[JSON appendString: @",\n"];
-			else
-				[JSON appendString: @"\n"];
-
-			objc_autoreleasePoolPop(pool2);
-		}
-
-		[JSON appendString: indentation];
-	} else {
-		i = 0;
-		for (id object in self) {
-			void *pool2 = objc_autoreleasePoolPush();
-
-			[JSON appendString: [object
-			    of_JSONRepresentationWithOptions: options
-						       depth: depth + 1]];
-
-			if (++i < count)
-				[JSON appendString: @","];
+	objc_autoreleasePoolPop(pool);
 
-			objc_autoreleasePoolPop(pool2);
-		}
-	}
+	return [JSON autorelease];
+}
 
-	[JSON appendString: @"]"];
-	[JSON makeImmutable];
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer
+{
+	[writer beginArray];
 
-	objc_autoreleasePoolPop(pool);
+	for (id object in self)
+		[writer writeObject: object];
 
-	return JSON;
+	[writer endArray];
 }
 
 - (OFData *)messagePackRepresentation
@@ -26,8 +26,14 @@ OF_ASSUME_NONNULL_BEGIN
 
 #define OF_DNS_RESOLVER_BUFFER_LENGTH 512
 
+/**
+ * @brief The default number of responses cached by an OFDNSResolver.
+ */
+#define OF_DNS_RESOLVER_DEFAULT_CACHE_SIZE 256
+
 @class OFArray OF_GENERIC(ObjectType);
 @class OFDNSResolver;
+@class OFDNSResolverCacheEntry;
 @class OFDNSResolverContext;
 @class OFDNSResolverSettings;
 @class OFDate;
@@ -118,6 +124,10 @@ typedef enum of_dns_resolver_error_t {
  *
  * @brief A class for resolving DNS names.
  *
+ * Responses are cached according to their TTL and identical queries that are
+ * performed while a query is still in flight share a single request to the
+ * name server.
+ *
  * @note If you change any of the properties, make sure to set
  *	 @ref configReloadInterval to 0, as otherwise your changes will be
  *	 reverted back to the system configuration on the next periodic config
@@ -136,6 +146,14 @@ OF_SUBCLASSING_RESTRICTED
 	    *_queries;
 	OFMutableDictionary OF_GENERIC(OFTCPSocket *, OFDNSResolverContext *)
 	    *_TCPQueries;
+	OFMutableDictionary OF_GENERIC(OFDNSQuery *, OFDNSResolverContext *)
+	    *_pendingQueries;
+	OFMutableDictionary OF_GENERIC(OFDNSQuery *, OFDNSResolverCacheEntry *)
+	    *_cache;
+	OFDNSResolverCacheEntry *_Nullable _cacheLRUHead;
+	OFDNSResolverCacheEntry *_Nullable _cacheLRUTail;
+	size_t _cacheSize;
+	unsigned long long _cacheHits, _cacheMisses;
 }
 
 /**
@@ -153,6 +171,13 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property (copy, nonatomic) OFArray OF_GENERIC(OFString *) *nameServers;
 
+/**
+ * @brief The port on which the name servers are contacted.
+ *
+ * The default is 53.
+ */
+@property (nonatomic) uint16_t nameServerPort;
+
 /**
  * @brief The local domain.
  */
@@ -193,6 +218,35 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property (nonatomic) of_time_interval_t configReloadInterval;
 
+/**
+ * @brief The maximum number of responses that are cached.
+ *
+ * Positive responses are cached for the lowest TTL of their answer records.
+ * Responses that the name does not exist or that contain no answer records are
+ * cached for the duration specified by the SOA record in the authority
+ * section, as described in RFC 2308. Responses without such a record are not
+ * cached.
+ *
+ * If the cache is full, the least recently used response is removed. Setting
+ * this to 0 disables the cache.
+ *
+ * The default is @ref OF_DNS_RESOLVER_DEFAULT_CACHE_SIZE.
+ */
+@property (nonatomic) size_t cacheSize;
+
+/**
+ * @brief The number of queries that were answered from the cache.
+ */
+@property (readonly, nonatomic) unsigned long long cacheHits;
+
+/**
+ * @brief The number of queries that could not be answered from the cache.
+ *
+ * This includes queries that were joined with an identical query that was
+ * already in flight.
+ */
+@property (readonly, nonatomic) unsigned long long cacheMisses;
+
 /**
  * @brief Creates a new, autoreleased OFDNSResolver.
  */
@@ -266,6 +320,11 @@ OF_SUBCLASSING_RESTRICTED
 - (OFData *)resolveAddressesForHost: (OFString *)host
 		      addressFamily: (of_socket_address_family_t)addressFamily;
 
+/**
+ * @brief Removes all responses from the cache.
+ */
+- (void)removeAllCachedResponses;
+
 /**
  * @brief Closes all sockets and cancels all ongoing queries.
  */
@@ -61,8 +61,25 @@
 
 #define CNAME_RECURSION 3
 
+/*
+ * Upper bounds for how long responses are cached. The one for negative
+ * responses is the one suggested by RFC 2308.
+ */
+#define MAX_CACHE_TTL 86400
+#define MAX_NEGATIVE_CACHE_TTL 10800
+
 @interface OFDNSResolver () <OFUDPSocketDelegate, OFTCPSocketDelegate>
 - (void)of_contextTimedOut: (OFDNSResolverContext *)context;
+- (void)of_finishContext: (OFDNSResolverContext *)context
+		response: (OFDNSResponse *)response
+	       exception: (id)exception;
+- (void)of_cacheResponse: (OFDNSResponse *)response
+	       exception: (id)exception
+		forQuery: (OFDNSQuery *)query
+		     TTL: (uint32_t)TTL;
+- (void)of_trimCacheToSize: (size_t)size;
+- (void)of_removeCacheEntry: (OFDNSResolverCacheEntry *)entry;
+- (void)of_removeAllCacheEntries;
 @end
 
 OF_DIRECT_MEMBERS
@@ -74,7 +91,8 @@ OF_DIRECT_MEMBERS
 	OFDNSResolverSettings *_settings;
 	size_t _nameServersIndex;
 	unsigned int _attempt;
-	id <OFDNSResolverQueryDelegate> _delegate;
+	OFMutableArray OF_GENERIC(id <OFDNSResolverQueryDelegate>) *_delegates;
+	of_run_loop_mode_t _runLoopMode;
 	OFData *_queryData;
 	of_socket_address_t _usedNameServer;
 	OFTCPSocket *_TCPSocket;
@@ -87,9 +105,56 @@ OF_DIRECT_MEMBERS
 - (instancetype)initWithQuery: (OFDNSQuery *)query
 			   ID: (OFNumber *)ID
 		     settings: (OFDNSResolverSettings *)settings
+		  runLoopMode: (of_run_loop_mode_t)runLoopMode
 		     delegate: (id <OFDNSResolverQueryDelegate>)delegate;
 @end
 
+OF_DIRECT_MEMBERS
+@interface OFDNSResolverCacheEntry: OFObject
+{
+@public
+	OFDNSQuery *_query;
+	OFDNSResponse *_response;
+	id _exception;
+	of_time_interval_t _expiration;
+	/* Not retained, the entries are owned by the cache dictionary */
+	OFDNSResolverCacheEntry *_LRUPrevious, *_LRUNext;
+}
+@end
+
+/* Appends the entry to the end of the LRU list, as the most recently used. */
+static void
+linkCacheEntry(OFDNSResolverCacheEntry **head, OFDNSResolverCacheEntry **tail,
+    OFDNSResolverCacheEntry *entry)
+{
+	entry->_LRUPrevious = *tail;
+	entry->_LRUNext = nil;
+
+	if (*tail != nil)
+		(*tail)->_LRUNext = entry;
+	else
+		*head = entry;
+
+	*tail = entry;
+}
+
+static void
+unlinkCacheEntry(OFDNSResolverCacheEntry **head, OFDNSResolverCacheEntry **tail,
+    OFDNSResolverCacheEntry *entry)
+{
+	if (entry->_LRUPrevious != nil)
+		entry->_LRUPrevious->_LRUNext = entry->_LRUNext;
+	else
+		*head = entry->_LRUNext;
+
+	if (entry->_LRUNext != nil)
+		entry->_LRUNext->_LRUPrevious = entry->_LRUPrevious;
+	else
+		*tail = entry->_LRUPrevious;
+
+	entry->_LRUPrevious = entry->_LRUNext = nil;
+}
+
 static OFString *
 parseString(const unsigned char *buffer, size_t length, size_t *i)
 {
@@ -471,10 +536,79 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	return ret;
 }
 
+static bool
+cacheTTL(OFDictionary *answerRecords, OFDictionary *authorityRecords,
+    bool negative, uint32_t *TTL)
+{
+	bool found = false;
+
+	if (!negative) {
+		for (OFArray *records in answerRecords.objectEnumerator) {
+			for (OFDNSResourceRecord *record in records) {
+				if (!found || record.TTL < *TTL)
+					*TTL = record.TTL;
+
+				found = true;
+			}
+		}
+
+		if (found) {
+			if (*TTL > MAX_CACHE_TTL)
+				*TTL = MAX_CACHE_TTL;
+
+			return true;
+		}
+	}
+
+	/* See RFC 2308, section 5. */
+	for (OFArray *records in authorityRecords.objectEnumerator) {
+		for (OF_KINDOF(OFDNSResourceRecord *) record in records) {
+			uint32_t recordTTL;
+
+			if ([record recordType] != OF_DNS_RECORD_TYPE_SOA)
+				continue;
+
+			recordTTL = [record TTL];
+			if ([record minTTL] < recordTTL)
+				recordTTL = [record minTTL];
+
+			if (!found || recordTTL < *TTL)
+				*TTL = recordTTL;
+
+			found = true;
+		}
+	}
+
+	if (found && *TTL > MAX_NEGATIVE_CACHE_TTL)
+		*TTL = MAX_NEGATIVE_CACHE_TTL;
+
+	return found;
+}
+
+static void
+callDelegateInMode(of_run_loop_mode_t runLoopMode,
+    id <OFDNSResolverQueryDelegate> delegate, OFDNSResolver *resolver,
+    OFDNSQuery *query, OFDNSResponse *response, id exception)
+{
+	SEL selector = @selector(resolver:didPerformQuery:response:exception:);
+	OFTimer *timer = [OFTimer
+	    timerWithTimeInterval: 0
+			   target: delegate
+			 selector: selector
+			   object: resolver
+			   object: query
+			   object: response
+			   object: exception
+			  repeats: false];
+	[[OFRunLoop currentRunLoop] addTimer: timer
+				     forMode: runLoopMode];
+}
+
 @implementation OFDNSResolverContext
 - (instancetype)initWithQuery: (OFDNSQuery *)query
 			   ID: (OFNumber *)ID
 		     settings: (OFDNSResolverSettings *)settings
+		  runLoopMode: (of_run_loop_mode_t)runLoopMode
 		     delegate: (id <OFDNSResolverQueryDelegate>)delegate
 {
 	self = [super init];
@@ -487,7 +621,8 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 		_query = [query copy];
 		_ID = [ID retain];
 		_settings = [settings copy];
-		_delegate = [delegate retain];
+		_runLoopMode = [runLoopMode copy];
+		_delegates = [[OFMutableArray alloc] initWithObject: delegate];
 
 		queryData = [OFMutableData dataWithCapacity: 512];
 
@@ -555,7 +690,8 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	[_query release];
 	[_ID release];
 	[_settings release];
-	[_delegate release];
+	[_runLoopMode release];
+	[_delegates release];
 	[_queryData release];
 	[_TCPSocket release];
 	[_TCPQueryData release];
@@ -566,6 +702,17 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 }
 @end
 
+@implementation OFDNSResolverCacheEntry
+- (void)dealloc
+{
+	[_query release];
+	[_response release];
+	[_exception release];
+
+	[super dealloc];
+}
+@end
+
 @implementation OFDNSResolver
 #ifdef OF_AMIGAOS
 + (void)initialize
@@ -592,6 +739,9 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 		_settings = [[OFDNSResolverSettings alloc] init];
 		_queries = [[OFMutableDictionary alloc] init];
 		_TCPQueries = [[OFMutableDictionary alloc] init];
+		_pendingQueries = [[OFMutableDictionary alloc] init];
+		_cache = [[OFMutableDictionary alloc] init];
+		_cacheSize = OF_DNS_RESOLVER_DEFAULT_CACHE_SIZE;
 
 		[_settings reload];
 	} @catch (id e) {
@@ -615,6 +765,8 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 #endif
 	[_queries release];
 	[_TCPQueries release];
+	[_pendingQueries release];
+	[_cache release];
 
 	[super dealloc];
 }
@@ -641,6 +793,20 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	OFArray *old = _settings->_nameServers;
 	_settings->_nameServers = [nameServers copy];
 	[old release];
+
+	[self of_removeAllCacheEntries];
+}
+
+- (uint16_t)nameServerPort
+{
+	return _settings->_nameServerPort;
+}
+
+- (void)setNameServerPort: (uint16_t)nameServerPort
+{
+	_settings->_nameServerPort = nameServerPort;
+
+	[self of_removeAllCacheEntries];
 }
 
 - (OFString *)localDomain
@@ -712,6 +878,89 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	_settings->_configReloadInterval = configReloadInterval;
 }
 
+- (size_t)cacheSize
+{
+	return _cacheSize;
+}
+
+- (void)setCacheSize: (size_t)cacheSize
+{
+	_cacheSize = cacheSize;
+
+	[self of_trimCacheToSize: cacheSize];
+}
+
+- (unsigned long long)cacheHits
+{
+	return _cacheHits;
+}
+
+- (unsigned long long)cacheMisses
+{
+	return _cacheMisses;
+}
+
+- (void)of_trimCacheToSize: (size_t)size
+{
+	/* Expired entries are removed when they are looked up. */
+	while (_cache.count > size)
+		[self of_removeCacheEntry: _cacheLRUHead];
+}
+
+- (void)of_removeCacheEntry: (OFDNSResolverCacheEntry *)entry
+{
+	OFDNSQuery *query = [entry->_query retain];
+
+	unlinkCacheEntry(&_cacheLRUHead, &_cacheLRUTail, entry);
+
+	@try {
+		[_cache removeObjectForKey: query];
+	} @finally {
+		[query release];
+	}
+}
+
+- (void)of_removeAllCacheEntries
+{
+	_cacheLRUHead = _cacheLRUTail = nil;
+	[_cache removeAllObjects];
+}
+
+- (void)of_cacheResponse: (OFDNSResponse *)response
+	       exception: (id)exception
+		forQuery: (OFDNSQuery *)query
+		     TTL: (uint32_t)TTL
+{
+	OFDNSResolverCacheEntry *entry;
+
+	if (_cacheSize == 0 || TTL == 0)
+		return;
+
+	if ((entry = [_cache objectForKey: query]) != nil)
+		[self of_removeCacheEntry: entry];
+	else
+		[self of_trimCacheToSize: _cacheSize - 1];
+
+	entry = [[OFDNSResolverCacheEntry alloc] init];
+	@try {
+		entry->_query = [query copy];
+		entry->_response = [response retain];
+		entry->_exception = [exception retain];
+		entry->_expiration = [OFDate date].timeIntervalSince1970 + TTL;
+
+		[_cache setObject: entry
+			   forKey: entry->_query];
+		linkCacheEntry(&_cacheLRUHead, &_cacheLRUTail, entry);
+	} @finally {
+		[entry release];
+	}
+}
+
+- (void)removeAllCachedResponses
+{
+	[self of_removeAllCacheEntries];
+}
+
 - (void)of_sendQueryForContext: (OFDNSResolverContext *)context
 		   runLoopMode: (of_run_loop_mode_t)runLoopMode
 {
@@ -746,13 +995,15 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 				forKey: context->_TCPSocket];
 
 		context->_TCPSocket.delegate = self;
-		[context->_TCPSocket asyncConnectToHost: nameServer
-						   port: 53
-					    runLoopMode: runLoopMode];
+		[context->_TCPSocket
+		    asyncConnectToHost: nameServer
+				  port: context->_settings->_nameServerPort
+			   runLoopMode: runLoopMode];
 		return;
 	}
 
-	context->_usedNameServer = of_socket_address_parse_ip(nameServer, 53);
+	context->_usedNameServer = of_socket_address_parse_ip(nameServer,
+	    context->_settings->_nameServerPort);
 
 	switch (context->_usedNameServer.family) {
 #ifdef OF_HAVE_IPV6
@@ -810,17 +1061,48 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 		 delegate: (id <OFDNSResolverQueryDelegate>)delegate
 {
 	void *pool = objc_autoreleasePoolPush();
+	OFDNSResolverCacheEntry *entry;
 	OFNumber *ID;
 	OFDNSResolverContext *context;
 
+	if (query.domainName.UTF8StringLength > 253)
+		@throw [OFOutOfRangeException exception];
+
+	if ((entry = [_cache objectForKey: query]) != nil) {
+		if (entry->_expiration > [OFDate date].timeIntervalSince1970) {
+			callDelegateInMode(runLoopMode, delegate, self, query,
+			    entry->_response, entry->_exception);
+			_cacheHits++;
+
+			unlinkCacheEntry(&_cacheLRUHead, &_cacheLRUTail, entry);
+			linkCacheEntry(&_cacheLRUHead, &_cacheLRUTail, entry);
+
+			objc_autoreleasePoolPop(pool);
+			return;
+		}
+
+		[self of_removeCacheEntry: entry];
+	}
+
+	_cacheMisses++;
+
+	/*
+	 * Join an identical query that is still in flight, unless it runs in a
+	 * different run loop mode, as then we might never see its response.
+	 */
+	context = [_pendingQueries objectForKey: query];
+	if (context != nil && [context->_runLoopMode isEqual: runLoopMode]) {
+		[context->_delegates addObject: delegate];
+
+		objc_autoreleasePoolPop(pool);
+		return;
+	}
+
 	/* Random, unused ID */
 	do {
 		ID = [OFNumber numberWithUnsignedShort: of_random16()];
 	} while ([_queries objectForKey: ID] != nil);
 
-	if (query.domainName.UTF8StringLength > 253)
-		@throw [OFOutOfRangeException exception];
-
 	if (_settings->_nameServers.count == 0) {
 		id exception = [OFDNSQueryFailedException
 		    exceptionWithQuery: query
@@ -836,10 +1118,15 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	    initWithQuery: query
 		       ID: ID
 		 settings: _settings
+	      runLoopMode: runLoopMode
 		 delegate: delegate] autorelease];
 	[self of_sendQueryForContext: context
 			 runLoopMode: runLoopMode];
 
+	if ([_pendingQueries objectForKey: query] == nil)
+		[_pendingQueries setObject: context
+				    forKey: context->_query];
+
 	objc_autoreleasePoolPop(pool);
 }
 
@@ -893,10 +1180,23 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	    exceptionWithQuery: context->_query
 			 error: OF_DNS_RESOLVER_ERROR_TIMEOUT];
 
-	[context->_delegate resolver: self
-		     didPerformQuery: context->_query
-			    response: nil
-			   exception: exception];
+	[self of_finishContext: context
+		      response: nil
+		     exception: exception];
+}
+
+- (void)of_finishContext: (OFDNSResolverContext *)context
+		response: (OFDNSResponse *)response
+	       exception: (id)exception
+{
+	if ([_pendingQueries objectForKey: context->_query] == context)
+		[_pendingQueries removeObjectForKey: context->_query];
+
+	for (id <OFDNSResolverQueryDelegate> delegate in context->_delegates)
+		[delegate resolver: self
+		   didPerformQuery: context->_query
+			  response: response
+			 exception: exception];
 }
 
 - (bool)of_handleResponseBuffer: (unsigned char *)buffer
@@ -907,6 +1207,8 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	OFDictionary *additionalRecords = nil;
 	OFDNSResponse *response = nil;
 	id exception = nil;
+	bool cacheable = false;
+	uint32_t TTL;
 	OFNumber *ID;
 	OFDNSResolverContext *context;
 
@@ -1012,7 +1314,11 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 			}
 		}
 
-		if (buffer[3] & 0x0F)
+		/*
+		 * A name error is still parsed, as it can be cached for as
+		 * long as the SOA record in the authority section says.
+		 */
+		if ((buffer[3] & 0x0F) != 0 && (buffer[3] & 0x0F) != 3)
 			@throw [OFDNSQueryFailedException
 			    exceptionWithQuery: context->_query
 					 error: error];
@@ -1040,6 +1346,14 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 		    numAuthorityRecords);
 		additionalRecords = parseSection(buffer, length, &i,
 		    numAdditionalRecords);
+
+		cacheable = true;
+
+		if (buffer[3] & 0x0F)
+			@throw [OFDNSQueryFailedException
+			    exceptionWithQuery: context->_query
+					 error: error];
+
 		response = [OFDNSResponse
 		    responseWithDomainName: context->_query.domainName
 			     answerRecords: answerRecords
@@ -1052,10 +1366,16 @@ parseSection(const unsigned char *buffer, size_t length, size_t *i,
 	if (exception != nil)
 		response = nil;
 
-	[context->_delegate resolver: self
-		     didPerformQuery: context->_query
-			    response: response
-			   exception: exception];
+	if (cacheable && cacheTTL(answerRecords, authorityRecords,
+	    (exception != nil), &TTL))
+		[self of_cacheResponse: response
+			     exception: exception
+			      forQuery: context->_query
+				   TTL: TTL];
+
+	[self of_finishContext: context
+		      response: response
+		     exception: exception];
 
 	return false;
 }
@@ -1283,13 +1603,13 @@ done:
 		    exceptionWithQuery: context->_query
 				 error: OF_DNS_RESOLVER_ERROR_CANCELED];
 
-		[context->_delegate resolver: self
-			     didPerformQuery: context->_query
-				    response: nil
-				   exception: exception];
+		[self of_finishContext: context
+			      response: nil
+			     exception: exception];
 	}
 
 	[_queries removeAllObjects];
+	[_pendingQueries removeAllObjects];
 
 	objc_autoreleasePoolPop(pool);
 }
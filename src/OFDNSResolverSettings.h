@@ -29,6 +29,7 @@ OF_ASSUME_NONNULL_BEGIN
 	OFDictionary OF_GENERIC(OFString *, OFArray OF_GENERIC(OFString *) *)
 	    *_staticHosts;
 	OFArray OF_GENERIC(OFString *) *_nameServers;
+	uint16_t _nameServerPort;
 	OFString *_Nullable _localDomain;
 	OFArray OF_GENERIC(OFString *) *_searchDomains;
 	of_time_interval_t _timeout;
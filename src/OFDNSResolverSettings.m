@@ -121,6 +121,7 @@ domainFromHostname(void)
 	@try {
 		copy->_staticHosts = [_staticHosts copy];
 		copy->_nameServers = [_nameServers copy];
+		copy->_nameServerPort = _nameServerPort;
 		copy->_localDomain = [_localDomain copy];
 		copy->_searchDomains = [_searchDomains copy];
 		copy->_timeout = _timeout;
@@ -146,6 +147,8 @@ domainFromHostname(void)
 	[_nameServers release];
 	_nameServers = nil;
 
+	_nameServerPort = 53;
+
 	[_localDomain release];
 	_localDomain = nil;
 
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFStream.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#define OF_DEFLATE_STREAM_BUFFER_SIZE 4096
+
+/**
+ * @brief The default compression level of an OFDeflateStream.
+ */
+#define OF_DEFLATE_STREAM_DEFAULT_LEVEL 6
+
+/**
+ * @class OFDeflateStream OFDeflateStream.h ObjFW/OFDeflateStream.h
+ *
+ * @brief A class that handles Deflate compression transparently for an
+ *	  underlying stream.
+ *
+ * All data written to the OFDeflateStream is compressed and written to the
+ * underlying stream. The compressed data is only complete once the
+ * OFDeflateStream has been closed. Closing the OFDeflateStream does not close
+ * the underlying stream.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFDeflateStream: OFStream
+{
+	OFStream *_stream;
+	unsigned int _level;
+	unsigned char *_window;
+	uint16_t *_head, *_prev;
+	uint32_t *_symbols;
+	size_t _symbolsCount;
+	uint32_t _strStart, _lookahead, _blockStart;
+	int32_t _matchStart;
+	uint16_t _matchLength;
+	bool _matchAvailable;
+	uint64_t _bits;
+	uint8_t _bitsLength;
+	unsigned char _buffer[OF_DEFLATE_STREAM_BUFFER_SIZE];
+	size_t _bufferLength;
+	unsigned long long _bytesWritten;
+}
+
+/**
+ * @brief The compression level, from 0 (no compression) to 9 (best
+ *	  compression).
+ *
+ * Level 1 to 3 use greedy matching, which is the fastest, while level 4 to 9
+ * use lazy matching, which compresses better. The default is
+ * @ref OF_DEFLATE_STREAM_DEFAULT_LEVEL.
+ *
+ * The level can be changed at any time and affects all data written
+ * afterwards.
+ */
+@property (nonatomic) unsigned int level;
+
+/**
+ * @brief The number of compressed bytes that have been written to the
+ *	  underlying stream so far.
+ */
+@property (readonly, nonatomic) unsigned long long bytesWritten;
+
+/**
+ * @brief Creates a new OFDeflateStream with the specified underlying stream.
+ *
+ * @param stream The underlying stream to which compressed data is written
+ * @return A new, autoreleased OFDeflateStream
+ */
++ (instancetype)streamWithStream: (OFStream *)stream;
+
+/**
+ * @brief Creates a new OFDeflateStream with the specified underlying stream
+ *	  and compression level.
+ *
+ * @param stream The underlying stream to which compressed data is written
+ * @param level The compression level, from 0 (no compression) to 9 (best
+ *		compression)
+ * @return A new, autoreleased OFDeflateStream
+ */
++ (instancetype)streamWithStream: (OFStream *)stream
+			   level: (unsigned int)level;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated OFDeflateStream with the specified
+ *	  underlying stream.
+ *
+ * @param stream The underlying stream to which compressed data is written
+ * @return An initialized OFDeflateStream
+ */
+- (instancetype)initWithStream: (OFStream *)stream;
+
+/**
+ * @brief Initializes an already allocated OFDeflateStream with the specified
+ *	  underlying stream and compression level.
+ *
+ * @param stream The underlying stream to which compressed data is written
+ * @param level The compression level, from 0 (no compression) to 9 (best
+ *		compression)
+ * @return An initialized OFDeflateStream
+ */
+- (instancetype)initWithStream: (OFStream *)stream
+			 level: (unsigned int)level OF_DESIGNATED_INITIALIZER;
+@end
+
+OF_ASSUME_NONNULL_END
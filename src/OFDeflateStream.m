@@ -0,0 +1,1086 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFDeflateStream.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFNotOpenException.h"
+
+#define BUFFER_SIZE OF_DEFLATE_STREAM_BUFFER_SIZE
+
+#define WINDOW_SIZE 32768
+#define WINDOW_MASK (WINDOW_SIZE - 1)
+#define HASH_BITS 15
+#define HASH_SIZE (1 << HASH_BITS)
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+/* Enough lookahead to find a match of MAX_MATCH and insert its hash. */
+#define MIN_LOOKAHEAD (MAX_MATCH + MIN_MATCH + 1)
+#define MAX_DISTANCE (WINDOW_SIZE - MIN_LOOKAHEAD)
+/* Matches of MIN_MATCH that are further away than this are not worth it. */
+#define TOO_FAR 4096
+#define SYMBOLS_SIZE 16384
+#define SYMBOL_MATCH 0x80000000u
+#define MAX_STORED_LENGTH 65535
+
+#define NUM_LIT_LEN_CODES 286
+#define NUM_DISTANCE_CODES 30
+#define NUM_CODE_LENGTH_CODES 19
+#define END_OF_BLOCK 256
+
+/*
+ * The parameters per level are the same as zlib's, so that the levels behave
+ * like users expect them to: The length from which on the hash chain is only
+ * followed for a quarter of its length, the length up to which lazy matching
+ * is tried (or, for greedy matching, up to which the hashes of a match are
+ * inserted), the length at which the search is stopped and the maximum length
+ * of the hash chain to follow.
+ */
+static const struct {
+	uint16_t goodLength, maxLazy, niceLength, maxChain;
+} configs[10] = {
+	{  0,   0,   0,    0 },
+	{  4,   4,   8,    4 },
+	{  4,   5,  16,    8 },
+	{  4,   6,  32,   32 },
+	{  4,   4,  16,   16 },
+	{  8,  16,  32,   32 },
+	{  8,  16, 128,  128 },
+	{  8,  32, 128,  256 },
+	{ 32, 128, 258, 1024 },
+	{ 32, 258, 258, 4096 }
+};
+
+static const uint8_t lengthCodes[29] = {
+	/* indices are -257, values -3 */
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56,
+	64, 80, 96, 112, 128, 160, 192, 224, 255
+};
+static const uint8_t lengthExtraBits[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+	5, 5, 5, 5, 0
+};
+static const uint16_t distanceCodes[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+	513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t distanceExtraBits[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10,
+	10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t codeLengthsOrder[19] = {
+	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+static const uint8_t codeLengthsExtraBits[19] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 3, 7
+};
+
+/* Maps length - 3 to the index of the length code. */
+static uint8_t lengthCodeIndices[256];
+/*
+ * Maps distance - 1 to the index of the distance code. Distances above 256
+ * are looked up with their lower 7 bits stripped, as these are always extra
+ * bits.
+ */
+static uint8_t distanceCodeIndices[512];
+static uint16_t fixedLitLenCodes[288], fixedDistanceCodes[30];
+static uint8_t fixedLitLenLengths[288], fixedDistanceLengths[30];
+
+static OF_INLINE uint8_t
+distanceCodeIndex(uint16_t distance)
+{
+	distance--;
+
+	if (distance < 256)
+		return distanceCodeIndices[distance];
+
+	return distanceCodeIndices[256 + (distance >> 7)];
+}
+
+static uint16_t
+reverseBits(uint16_t code, uint8_t length)
+{
+	uint16_t ret = 0;
+
+	for (uint8_t i = 0; i < length; i++) {
+		ret = (ret << 1) | (code & 1);
+		code >>= 1;
+	}
+
+	return ret;
+}
+
+/*
+ * Assigns the canonical Huffman codes for the specified lengths. The codes are
+ * returned with their bits reversed, as Deflate writes them starting with the
+ * most significant bit while everything else is written starting with the
+ * least significant bit.
+ */
+static void
+buildCodes(const uint8_t *lengths, uint16_t count, uint16_t *codes)
+{
+	uint16_t lengthCount[16] = { 0 }, nextCode[16];
+	uint16_t code = 0;
+
+	for (uint16_t i = 0; i < count; i++)
+		lengthCount[lengths[i]]++;
+
+	lengthCount[0] = 0;
+	for (uint8_t i = 1; i < 16; i++) {
+		code = (code + lengthCount[i - 1]) << 1;
+		nextCode[i] = code;
+	}
+
+	for (uint16_t i = 0; i < count; i++)
+		if (lengths[i] > 0)
+			codes[i] = reverseBits(nextCode[lengths[i]]++,
+			    lengths[i]);
+		else
+			codes[i] = 0;
+}
+
+static int
+compareSymbols(const void *left, const void *right)
+{
+	const uint32_t *leftSymbol = left, *rightSymbol = right;
+
+	if (leftSymbol[0] != rightSymbol[0])
+		return (leftSymbol[0] < rightSymbol[0] ? -1 : 1);
+
+	return (leftSymbol[1] < rightSymbol[1] ? -1 : 1);
+}
+
+/*
+ * Calculates the lengths of a minimum-redundancy code in place, as described
+ * by Moffat and Katajainen. The frequencies need to be sorted ascending and
+ * are replaced with the code lengths.
+ */
+static void
+calculateMinimumRedundancy(uint32_t *A, int n)
+{
+	int root, leaf, next, available, used, depth;
+
+	if (n == 0)
+		return;
+
+	if (n == 1) {
+		A[0] = 1;
+		return;
+	}
+
+	A[0] += A[1];
+	root = 0;
+	leaf = 2;
+
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) {
+			A[next] = A[root];
+			A[root++] = next;
+		} else
+			A[next] = A[leaf++];
+
+		if (leaf >= n || (root < next && A[root] < A[leaf])) {
+			A[next] += A[root];
+			A[root++] = next;
+		} else
+			A[next] += A[leaf++];
+	}
+
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--)
+		A[next] = A[A[next]] + 1;
+
+	available = 1;
+	used = depth = 0;
+	root = n - 2;
+	next = n - 1;
+
+	while (available > 0) {
+		while (root >= 0 && (int)A[root] == depth) {
+			used++;
+			root--;
+		}
+
+		while (available > used) {
+			A[next--] = depth;
+			available--;
+		}
+
+		available = 2 * used;
+		depth++;
+		used = 0;
+	}
+}
+
+/*
+ * Builds the code lengths for the specified frequencies, limited to the
+ * specified maximum length. At least two codes are always assigned, as some
+ * decoders cannot handle codes with just a single symbol.
+ */
+static void
+buildLengths(const uint32_t *frequencies, uint16_t count, uint8_t maxLength,
+    uint8_t *lengths)
+{
+	uint32_t symbols[NUM_LIT_LEN_CODES][2], lengthsArray[NUM_LIT_LEN_CODES];
+	uint32_t lengthCount[33] = { 0 }, total = 0;
+	uint16_t used = 0, j = 0;
+
+	memset(lengths, 0, count);
+
+	for (uint16_t i = 0; i < count; i++) {
+		if (frequencies[i] == 0)
+			continue;
+
+		symbols[used][0] = frequencies[i];
+		symbols[used][1] = i;
+		used++;
+	}
+
+	if (used < 2) {
+		if (used == 1)
+			lengths[symbols[0][1]] = 1;
+
+		for (uint16_t i = 0; used < 2; i++) {
+			if (lengths[i] != 0)
+				continue;
+
+			lengths[i] = 1;
+			used++;
+		}
+
+		return;
+	}
+
+	qsort(symbols, used, sizeof(*symbols), compareSymbols);
+
+	for (uint16_t i = 0; i < used; i++)
+		lengthsArray[i] = symbols[i][0];
+
+	calculateMinimumRedundancy(lengthsArray, used);
+
+	for (uint16_t i = 0; i < used; i++)
+		lengthCount[lengthsArray[i] < 32 ? lengthsArray[i] : 32]++;
+
+	/*
+	 * Move all codes that are too long to the maximum length and then
+	 * lengthen shorter codes until the code is no longer over-subscribed.
+	 */
+	for (uint8_t i = maxLength + 1; i <= 32; i++) {
+		lengthCount[maxLength] += lengthCount[i];
+		lengthCount[i] = 0;
+	}
+
+	for (uint8_t i = maxLength; i > 0; i--)
+		total += lengthCount[i] << (maxLength - i);
+
+	while (total != (UINT32_C(1) << maxLength)) {
+		lengthCount[maxLength]--;
+
+		for (uint8_t i = maxLength - 1; i > 0; i--) {
+			if (lengthCount[i] != 0) {
+				lengthCount[i]--;
+				lengthCount[i + 1] += 2;
+				break;
+			}
+		}
+
+		total--;
+	}
+
+	/* The least frequent symbols come first and get the longest codes. */
+	for (uint8_t i = maxLength; i > 0; i--)
+		for (uint32_t k = lengthCount[i]; k > 0; k--)
+			lengths[symbols[j++][1]] = i;
+}
+
+@implementation OFDeflateStream
+@synthesize bytesWritten = _bytesWritten;
+
+static void
+flushBuffer(OFDeflateStream *stream)
+{
+	if (stream->_bufferLength == 0)
+		return;
+
+	[stream->_stream writeBuffer: stream->_buffer
+			      length: stream->_bufferLength];
+
+	stream->_bytesWritten += stream->_bufferLength;
+	stream->_bufferLength = 0;
+}
+
+static OF_INLINE void
+putBits(OFDeflateStream *stream, uint32_t bits, uint8_t count)
+{
+	stream->_bits |= (uint64_t)bits << stream->_bitsLength;
+	stream->_bitsLength += count;
+
+	if (stream->_bitsLength >= 32) {
+		unsigned char *buffer;
+
+		if OF_UNLIKELY (stream->_bufferLength + 4 > BUFFER_SIZE)
+			flushBuffer(stream);
+
+		buffer = stream->_buffer + stream->_bufferLength;
+		buffer[0] = stream->_bits & 0xFF;
+		buffer[1] = (stream->_bits >> 8) & 0xFF;
+		buffer[2] = (stream->_bits >> 16) & 0xFF;
+		buffer[3] = (stream->_bits >> 24) & 0xFF;
+
+		stream->_bufferLength += 4;
+		stream->_bits >>= 32;
+		stream->_bitsLength -= 32;
+	}
+}
+
+static void
+alignBits(OFDeflateStream *stream)
+{
+	while (stream->_bitsLength > 0) {
+		if (stream->_bufferLength == BUFFER_SIZE)
+			flushBuffer(stream);
+
+		stream->_buffer[stream->_bufferLength++] =
+		    stream->_bits & 0xFF;
+		stream->_bits >>= 8;
+		stream->_bitsLength =
+		    (stream->_bitsLength > 8 ? stream->_bitsLength - 8 : 0);
+	}
+}
+
+static void
+writeStoredBlocks(OFDeflateStream *stream, const unsigned char *data,
+    size_t length, bool last)
+{
+	do {
+		uint16_t chunkLength = (length > MAX_STORED_LENGTH
+		    ? MAX_STORED_LENGTH : (uint16_t)length);
+
+		putBits(stream, (last && chunkLength == length ? 1 : 0), 1);
+		putBits(stream, 0, 2);
+		alignBits(stream);
+		putBits(stream, chunkLength, 16);
+		putBits(stream, ~chunkLength & 0xFFFF, 16);
+
+		data += chunkLength;
+		length -= chunkLength;
+
+		for (const unsigned char *chunk = data - chunkLength;
+		    chunk < data;) {
+			size_t toCopy = BUFFER_SIZE - stream->_bufferLength;
+
+			if (toCopy > (size_t)(data - chunk))
+				toCopy = data - chunk;
+
+			memcpy(stream->_buffer + stream->_bufferLength, chunk,
+			    toCopy);
+			stream->_bufferLength += toCopy;
+			chunk += toCopy;
+
+			if (stream->_bufferLength == BUFFER_SIZE)
+				flushBuffer(stream);
+		}
+	} while (length > 0);
+}
+
+static void
+writeSymbols(OFDeflateStream *stream, const uint16_t *litLenCodes,
+    const uint8_t *litLenLengths, const uint16_t *distanceCodes_,
+    const uint8_t *distanceLengths)
+{
+	for (size_t i = 0; i < stream->_symbolsCount; i++) {
+		uint32_t symbol = stream->_symbols[i];
+		uint16_t length, distance;
+		uint8_t index;
+
+		if (!(symbol & SYMBOL_MATCH)) {
+			putBits(stream, litLenCodes[symbol],
+			    litLenLengths[symbol]);
+			continue;
+		}
+
+		length = symbol & 0xFF;
+		distance = ((symbol >> 8) & 0x7FFF) + 1;
+
+		index = lengthCodeIndices[length];
+		putBits(stream, litLenCodes[257 + index],
+		    litLenLengths[257 + index]);
+		if (lengthExtraBits[index] > 0)
+			putBits(stream, length - lengthCodes[index],
+			    lengthExtraBits[index]);
+
+		index = distanceCodeIndex(distance);
+		putBits(stream, distanceCodes_[index], distanceLengths[index]);
+		if (distanceExtraBits[index] > 0)
+			putBits(stream, distance - distanceCodes[index],
+			    distanceExtraBits[index]);
+	}
+
+	putBits(stream, litLenCodes[END_OF_BLOCK], litLenLengths[END_OF_BLOCK]);
+}
+
+/*
+ * Writes everything up to the current position as a block, choosing whichever
+ * of a dynamic Huffman, fixed Huffman or stored block is the smallest.
+ */
+static void
+flushBlock(OFDeflateStream *stream, bool last)
+{
+	uint32_t blockEnd =
+	    stream->_strStart - (stream->_matchAvailable ? 1 : 0);
+	uint32_t blockLength = blockEnd - stream->_blockStart;
+	uint32_t litLenFrequencies[NUM_LIT_LEN_CODES] = { 0 };
+	uint32_t distanceFrequencies[NUM_DISTANCE_CODES] = { 0 };
+	uint32_t codeLengthFrequencies[NUM_CODE_LENGTH_CODES] = { 0 };
+	uint8_t litLenLengths[NUM_LIT_LEN_CODES];
+	uint8_t distanceLengths[NUM_DISTANCE_CODES];
+	uint8_t codeLengthLengths[NUM_CODE_LENGTH_CODES];
+	uint16_t litLenCodes[NUM_LIT_LEN_CODES];
+	uint16_t distanceCodes_[NUM_DISTANCE_CODES];
+	uint16_t codeLengthCodes[NUM_CODE_LENGTH_CODES];
+	uint8_t lengths[NUM_LIT_LEN_CODES + NUM_DISTANCE_CODES];
+	uint8_t encodedLengths[NUM_LIT_LEN_CODES + NUM_DISTANCE_CODES][2];
+	uint16_t litLenCodesCount, distanceCodesCount, encodedLengthsCount = 0;
+	uint8_t codeLengthCodesCount;
+	uint64_t extraBits = 0, dynamicBits, fixedBits, storedBits;
+
+	if (blockLength == 0 && !last)
+		return;
+
+	if (stream->_level == 0) {
+		writeStoredBlocks(stream, stream->_window + stream->_blockStart,
+		    blockLength, last);
+		goto done;
+	}
+
+	for (size_t i = 0; i < stream->_symbolsCount; i++) {
+		uint32_t symbol = stream->_symbols[i];
+		uint8_t index;
+
+		if (!(symbol & SYMBOL_MATCH)) {
+			litLenFrequencies[symbol]++;
+			continue;
+		}
+
+		index = lengthCodeIndices[symbol & 0xFF];
+		litLenFrequencies[257 + index]++;
+		extraBits += lengthExtraBits[index];
+
+		index = distanceCodeIndex(((symbol >> 8) & 0x7FFF) + 1);
+		distanceFrequencies[index]++;
+		extraBits += distanceExtraBits[index];
+	}
+	litLenFrequencies[END_OF_BLOCK] = 1;
+
+	buildLengths(litLenFrequencies, NUM_LIT_LEN_CODES, 15, litLenLengths);
+	buildLengths(distanceFrequencies, NUM_DISTANCE_CODES, 15,
+	    distanceLengths);
+
+	for (litLenCodesCount = NUM_LIT_LEN_CODES;
+	    litLenCodesCount > 257 && litLenLengths[litLenCodesCount - 1] == 0;
+	    litLenCodesCount--);
+	for (distanceCodesCount = NUM_DISTANCE_CODES; distanceCodesCount > 1 &&
+	    distanceLengths[distanceCodesCount - 1] == 0;
+	    distanceCodesCount--);
+
+	memcpy(lengths, litLenLengths, litLenCodesCount);
+	memcpy(lengths + litLenCodesCount, distanceLengths, distanceCodesCount);
+
+	/* Run-length encode the code lengths using codes 16, 17 and 18. */
+	for (uint16_t i = 0; i < litLenCodesCount + distanceCodesCount;) {
+		uint8_t length = lengths[i];
+		uint16_t run = 1;
+
+		while (i + run < litLenCodesCount + distanceCodesCount &&
+		    lengths[i + run] == length)
+			run++;
+
+		i += run;
+
+		if (length == 0) {
+			while (run >= 11) {
+				uint8_t count = (run > 138 ? 138 : run);
+
+				encodedLengths[encodedLengthsCount][0] = 18;
+				encodedLengths[encodedLengthsCount++][1] =
+				    count - 11;
+				run -= count;
+			}
+
+			if (run >= 3) {
+				encodedLengths[encodedLengthsCount][0] = 17;
+				encodedLengths[encodedLengthsCount++][1] =
+				    run - 3;
+				run = 0;
+			}
+		} else {
+			encodedLengths[encodedLengthsCount][0] = length;
+			encodedLengths[encodedLengthsCount++][1] = 0;
+			run--;
+
+			while (run >= 3) {
+				uint8_t count = (run > 6 ? 6 : run);
+
+				encodedLengths[encodedLengthsCount][0] = 16;
+				encodedLengths[encodedLengthsCount++][1] =
+				    count - 3;
+				run -= count;
+			}
+		}
+
+		while (run-- > 0) {
+			encodedLengths[encodedLengthsCount][0] = length;
+			encodedLengths[encodedLengthsCount++][1] = 0;
+		}
+	}
+
+	for (uint16_t i = 0; i < encodedLengthsCount; i++)
+		codeLengthFrequencies[encodedLengths[i][0]]++;
+
+	buildLengths(codeLengthFrequencies, NUM_CODE_LENGTH_CODES, 7,
+	    codeLengthLengths);
+
+	for (codeLengthCodesCount = NUM_CODE_LENGTH_CODES;
+	    codeLengthCodesCount > 4 && codeLengthLengths[
+	    codeLengthsOrder[codeLengthCodesCount - 1]] == 0;
+	    codeLengthCodesCount--);
+
+	/* Calculate the size of each block type to pick the smallest. */
+	dynamicBits = 3 + 5 + 5 + 4 + 3 * codeLengthCodesCount + extraBits;
+	fixedBits = 3 + extraBits;
+
+	for (uint8_t i = 0; i < NUM_CODE_LENGTH_CODES; i++)
+		dynamicBits += (uint64_t)codeLengthFrequencies[i] *
+		    (codeLengthLengths[i] + codeLengthsExtraBits[i]);
+
+	for (uint16_t i = 0; i < NUM_LIT_LEN_CODES; i++) {
+		dynamicBits += (uint64_t)litLenFrequencies[i] *
+		    litLenLengths[i];
+		fixedBits += (uint64_t)litLenFrequencies[i] *
+		    fixedLitLenLengths[i];
+	}
+
+	for (uint8_t i = 0; i < NUM_DISTANCE_CODES; i++) {
+		dynamicBits += (uint64_t)distanceFrequencies[i] *
+		    distanceLengths[i];
+		fixedBits += (uint64_t)distanceFrequencies[i] *
+		    fixedDistanceLengths[i];
+	}
+
+	storedBits = (uint64_t)blockLength * 8 +
+	    ((blockLength / MAX_STORED_LENGTH) + 1) * (3 + 7 + 32);
+
+	if (storedBits <= dynamicBits && storedBits <= fixedBits)
+		writeStoredBlocks(stream, stream->_window + stream->_blockStart,
+		    blockLength, last);
+	else if (fixedBits <= dynamicBits) {
+		putBits(stream, (last ? 1 : 0) | (1 << 1), 3);
+		writeSymbols(stream, fixedLitLenCodes, fixedLitLenLengths,
+		    fixedDistanceCodes, fixedDistanceLengths);
+	} else {
+		buildCodes(litLenLengths, NUM_LIT_LEN_CODES, litLenCodes);
+		buildCodes(distanceLengths, NUM_DISTANCE_CODES, distanceCodes_);
+		buildCodes(codeLengthLengths, NUM_CODE_LENGTH_CODES,
+		    codeLengthCodes);
+
+		putBits(stream, (last ? 1 : 0) | (2 << 1), 3);
+		putBits(stream, litLenCodesCount - 257, 5);
+		putBits(stream, distanceCodesCount - 1, 5);
+		putBits(stream, codeLengthCodesCount - 4, 4);
+
+		for (uint8_t i = 0; i < codeLengthCodesCount; i++)
+			putBits(stream, codeLengthLengths[codeLengthsOrder[i]],
+			    3);
+
+		for (uint16_t i = 0; i < encodedLengthsCount; i++) {
+			uint8_t code = encodedLengths[i][0];
+
+			putBits(stream, codeLengthCodes[code],
+			    codeLengthLengths[code]);
+			if (codeLengthsExtraBits[code] > 0)
+				putBits(stream, encodedLengths[i][1],
+				    codeLengthsExtraBits[code]);
+		}
+
+		writeSymbols(stream, litLenCodes, litLenLengths,
+		    distanceCodes_, distanceLengths);
+	}
+
+done:
+	stream->_symbolsCount = 0;
+	stream->_blockStart = blockEnd;
+}
+
+static OF_INLINE bool
+tallyLiteral(OFDeflateStream *stream, unsigned char literal)
+{
+	stream->_symbols[stream->_symbolsCount++] = literal;
+
+	return (stream->_symbolsCount == SYMBOLS_SIZE);
+}
+
+static OF_INLINE bool
+tallyMatch(OFDeflateStream *stream, uint16_t distance, uint16_t length)
+{
+	stream->_symbols[stream->_symbolsCount++] = SYMBOL_MATCH |
+	    ((uint32_t)(distance - 1) << 8) | (length - MIN_MATCH);
+
+	return (stream->_symbolsCount == SYMBOLS_SIZE);
+}
+
+/* Inserts the string at position into the hash chains and returns the head. */
+static OF_INLINE uint16_t
+insertString(OFDeflateStream *stream, uint32_t position)
+{
+	const unsigned char *bytes = stream->_window + position;
+	uint32_t hash = ((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) |
+	    ((uint32_t)bytes[2] << 16)) * UINT32_C(0x9E3779B1);
+	uint16_t head;
+
+	hash >>= 32 - HASH_BITS;
+	head = stream->_head[hash];
+	stream->_prev[position & WINDOW_MASK] = head;
+	stream->_head[hash] = (uint16_t)position;
+
+	return head;
+}
+
+static OF_INLINE uint16_t
+matchLength(const unsigned char *match, const unsigned char *scan)
+{
+	uint16_t length = 0;
+
+	/* Compare a word at a time, the window is padded for overreads. */
+	while (length < MAX_MATCH) {
+		uint64_t matchWord, scanWord;
+
+		memcpy(&matchWord, match + length, sizeof(matchWord));
+		memcpy(&scanWord, scan + length, sizeof(scanWord));
+
+		if (matchWord != scanWord) {
+			while (match[length] == scan[length])
+				length++;
+
+			break;
+		}
+
+		length += sizeof(matchWord);
+	}
+
+	return (length < MAX_MATCH ? length : MAX_MATCH);
+}
+
+/*
+ * Follows the hash chain starting at currentMatch to find a match longer than
+ * previousLength. Returns the length of the longest match, or previousLength
+ * if none was found, and stores its position in _matchStart.
+ */
+static uint16_t
+longestMatch(OFDeflateStream *stream, uint16_t currentMatch,
+    uint16_t previousLength)
+{
+	const unsigned char *window = stream->_window;
+	const unsigned char *scan = window + stream->_strStart;
+	uint32_t chainLength = configs[stream->_level].maxChain;
+	uint16_t niceLength = configs[stream->_level].niceLength;
+	uint16_t bestLength = previousLength;
+	uint32_t limit = (stream->_strStart > MAX_DISTANCE
+	    ? stream->_strStart - MAX_DISTANCE : 0);
+
+	if (previousLength >= configs[stream->_level].goodLength)
+		chainLength >>= 2;
+
+	if (niceLength > stream->_lookahead)
+		niceLength = stream->_lookahead;
+
+	do {
+		const unsigned char *match = window + currentMatch;
+		uint16_t length;
+
+		if (match[bestLength] != scan[bestLength] ||
+		    match[bestLength - 1] != scan[bestLength - 1] ||
+		    match[0] != scan[0] || match[1] != scan[1])
+			continue;
+
+		length = matchLength(match, scan);
+
+		if (length > bestLength) {
+			stream->_matchStart = currentMatch;
+			bestLength = length;
+
+			if (length >= niceLength)
+				break;
+		}
+	} while ((currentMatch = stream->_prev[currentMatch & WINDOW_MASK]) >
+	    limit && --chainLength > 0);
+
+	if (bestLength > stream->_lookahead)
+		return stream->_lookahead;
+
+	return bestLength;
+}
+
+/* Greedy matching, used for the fast levels. */
+static void
+deflateFast(OFDeflateStream *stream, bool flush)
+{
+	while (stream->_lookahead >= MIN_LOOKAHEAD ||
+	    (flush && stream->_lookahead > 0)) {
+		uint16_t hashHead = 0, length = 0;
+		bool full;
+
+		if (stream->_lookahead >= MIN_MATCH)
+			hashHead = insertString(stream, stream->_strStart);
+
+		if (hashHead != 0 &&
+		    stream->_strStart - hashHead <= MAX_DISTANCE)
+			length = longestMatch(stream, hashHead, MIN_MATCH - 1);
+
+		if (length >= MIN_MATCH) {
+			full = tallyMatch(stream,
+			    stream->_strStart - stream->_matchStart, length);
+			stream->_lookahead -= length;
+
+			if (length <= configs[stream->_level].maxLazy &&
+			    stream->_lookahead >= MIN_MATCH) {
+				while (--length > 0)
+					insertString(stream,
+					    ++stream->_strStart);
+
+				stream->_strStart++;
+			} else
+				stream->_strStart += length;
+		} else {
+			full = tallyLiteral(stream,
+			    stream->_window[stream->_strStart]);
+			stream->_lookahead--;
+			stream->_strStart++;
+		}
+
+		if (full)
+			flushBlock(stream, false);
+	}
+}
+
+/*
+ * Lazy matching: A match is only used if there is no longer match starting at
+ * the next byte.
+ */
+static void
+deflateSlow(OFDeflateStream *stream, bool flush)
+{
+	while (stream->_lookahead >= MIN_LOOKAHEAD ||
+	    (flush && stream->_lookahead > 0)) {
+		uint16_t hashHead = 0, previousLength;
+		int32_t previousMatch;
+
+		if (stream->_lookahead >= MIN_MATCH)
+			hashHead = insertString(stream, stream->_strStart);
+
+		previousLength = stream->_matchLength;
+		previousMatch = stream->_matchStart;
+		stream->_matchLength = MIN_MATCH - 1;
+
+		if (hashHead != 0 &&
+		    previousLength < configs[stream->_level].maxLazy &&
+		    stream->_strStart - hashHead <= MAX_DISTANCE) {
+			stream->_matchLength = longestMatch(stream, hashHead,
+			    previousLength);
+
+			if (stream->_matchLength == MIN_MATCH &&
+			    stream->_strStart - stream->_matchStart > TOO_FAR)
+				stream->_matchLength = MIN_MATCH - 1;
+		}
+
+		if (previousLength >= MIN_MATCH &&
+		    stream->_matchLength <= previousLength) {
+			uint32_t maxInsert = stream->_strStart +
+			    stream->_lookahead - MIN_MATCH;
+			bool full;
+
+			full = tallyMatch(stream,
+			    stream->_strStart - 1 - previousMatch,
+			    previousLength);
+
+			/*
+			 * The first byte of the match was already consumed as
+			 * the pending byte.
+			 */
+			stream->_lookahead -= previousLength - 1;
+			previousLength -= 2;
+
+			do {
+				if (++stream->_strStart <= maxInsert)
+					insertString(stream, stream->_strStart);
+			} while (--previousLength > 0);
+
+			stream->_matchAvailable = false;
+			stream->_matchLength = MIN_MATCH - 1;
+			stream->_strStart++;
+
+			if (full)
+				flushBlock(stream, false);
+		} else if (stream->_matchAvailable) {
+			bool full = tallyLiteral(stream,
+			    stream->_window[stream->_strStart - 1]);
+
+			stream->_strStart++;
+			stream->_lookahead--;
+
+			if (full)
+				flushBlock(stream, false);
+		} else {
+			stream->_matchAvailable = true;
+			stream->_strStart++;
+			stream->_lookahead--;
+		}
+	}
+
+	if (flush && stream->_matchAvailable) {
+		bool full = tallyLiteral(stream,
+		    stream->_window[stream->_strStart - 1]);
+
+		stream->_matchAvailable = false;
+
+		if (full)
+			flushBlock(stream, false);
+	}
+}
+
+static void
+deflate(OFDeflateStream *stream, bool flush)
+{
+	if (stream->_level == 0) {
+		stream->_strStart += stream->_lookahead;
+		stream->_lookahead = 0;
+	} else if (stream->_level <= 3)
+		deflateFast(stream, flush);
+	else
+		deflateSlow(stream, flush);
+}
+
+static void
+slideWindow(OFDeflateStream *stream)
+{
+	/* Stored blocks need the data of the block, so it must not be lost. */
+	if (stream->_blockStart < WINDOW_SIZE)
+		flushBlock(stream, false);
+
+	memcpy(stream->_window, stream->_window + WINDOW_SIZE, WINDOW_SIZE);
+	stream->_strStart -= WINDOW_SIZE;
+	stream->_blockStart -= WINDOW_SIZE;
+	stream->_matchStart -= WINDOW_SIZE;
+
+	for (uint32_t i = 0; i < HASH_SIZE; i++)
+		stream->_head[i] = (stream->_head[i] >= WINDOW_SIZE
+		    ? stream->_head[i] - WINDOW_SIZE : 0);
+
+	for (uint32_t i = 0; i < WINDOW_SIZE; i++)
+		stream->_prev[i] = (stream->_prev[i] >= WINDOW_SIZE
+		    ? stream->_prev[i] - WINDOW_SIZE : 0);
+}
+
++ (void)initialize
+{
+	uint8_t index;
+
+	if (self != [OFDeflateStream class])
+		return;
+
+	for (index = 0; index < 29; index++) {
+		uint16_t count = 1u << lengthExtraBits[index];
+
+		for (uint16_t i = 0; i < count; i++)
+			lengthCodeIndices[lengthCodes[index] + i] = index;
+	}
+
+	for (index = 0; index < 30; index++) {
+		uint16_t count = 1u << distanceExtraBits[index];
+
+		for (uint16_t i = 0; i < count; i++) {
+			uint16_t distance = distanceCodes[index] - 1 + i;
+
+			if (distance < 256)
+				distanceCodeIndices[distance] = index;
+			else
+				distanceCodeIndices[256 + (distance >> 7)] =
+				    index;
+		}
+	}
+
+	for (uint16_t i = 0; i <= 143; i++)
+		fixedLitLenLengths[i] = 8;
+	for (uint16_t i = 144; i <= 255; i++)
+		fixedLitLenLengths[i] = 9;
+	for (uint16_t i = 256; i <= 279; i++)
+		fixedLitLenLengths[i] = 7;
+	for (uint16_t i = 280; i <= 287; i++)
+		fixedLitLenLengths[i] = 8;
+
+	buildCodes(fixedLitLenLengths, 288, fixedLitLenCodes);
+
+	for (uint8_t i = 0; i < 30; i++)
+		fixedDistanceLengths[i] = 5;
+
+	buildCodes(fixedDistanceLengths, 30, fixedDistanceCodes);
+}
+
++ (instancetype)streamWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
++ (instancetype)streamWithStream: (OFStream *)stream
+			   level: (unsigned int)level
+{
+	return [[[self alloc] initWithStream: stream
+				       level: level] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	return [self initWithStream: stream
+			      level: OF_DEFLATE_STREAM_DEFAULT_LEVEL];
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+			 level: (unsigned int)level
+{
+	self = [super init];
+
+	@try {
+		if (level > 9)
+			@throw [OFInvalidArgumentException exception];
+
+		/* Padded so that matches can be compared a word at a time. */
+		_window = of_alloc_zeroed(
+		    2 * WINDOW_SIZE + MAX_MATCH + sizeof(uint64_t), 1);
+		_head = of_alloc_zeroed(HASH_SIZE, sizeof(*_head));
+		_prev = of_alloc_zeroed(WINDOW_SIZE, sizeof(*_prev));
+		_symbols = of_alloc(SYMBOLS_SIZE, sizeof(*_symbols));
+
+		_stream = [stream retain];
+		_level = level;
+		_matchLength = MIN_MATCH - 1;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	if (_stream != nil)
+		[self close];
+
+	free(_window);
+	free(_head);
+	free(_prev);
+	free(_symbols);
+
+	[super dealloc];
+}
+
+- (unsigned int)level
+{
+	return _level;
+}
+
+- (void)setLevel: (unsigned int)level
+{
+	if (level > 9)
+		@throw [OFInvalidArgumentException exception];
+
+	if (level == _level)
+		return;
+
+	/*
+	 * The block is ended so that a block never mixes stored and compressed
+	 * data, and a pending byte of lazy matching is written as a literal so
+	 * that switching between greedy and lazy matching is always safe.
+	 */
+	if (_stream != nil) {
+		if (_matchAvailable) {
+			tallyLiteral(self, _window[_strStart - 1]);
+			_matchAvailable = false;
+		}
+		_matchLength = MIN_MATCH - 1;
+
+		flushBlock(self, false);
+	}
+
+	_level = level;
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	const unsigned char *bytes = buffer;
+	size_t remaining = length;
+
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	while (remaining > 0) {
+		size_t toCopy;
+
+		if (_strStart >= WINDOW_SIZE + MAX_DISTANCE)
+			slideWindow(self);
+
+		toCopy = 2 * WINDOW_SIZE - _strStart - _lookahead;
+		if (toCopy > remaining)
+			toCopy = remaining;
+
+		memcpy(_window + _strStart + _lookahead, bytes, toCopy);
+		_lookahead += (uint32_t)toCopy;
+		bytes += toCopy;
+		remaining -= toCopy;
+
+		deflate(self, false);
+	}
+
+	return length;
+}
+
+- (void)close
+{
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	deflate(self, true);
+	flushBlock(self, true);
+	alignBits(self);
+	flushBuffer(self);
+
+	[_stream release];
+	_stream = nil;
+
+	[super close];
+}
+@end
@@ -26,6 +26,7 @@
 #import "OFCharacterSet.h"
 #import "OFData.h"
 #import "OFEnumerator.h"
+#import "OFJSONWriter.h"
 #import "OFMapTableDictionary.h"
 #import "OFString.h"
 #import "OFXMLElement.h"
@@ -40,11 +41,6 @@ static struct {
 
 static OFCharacterSet *URLQueryPartAllowedCharacterSet = nil;
 
-@interface OFDictionary ()
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth;
-@end
-
 @interface OFDictionaryPlaceholder: OFDictionary
 @end
 
@@ -735,95 +731,42 @@ OF_DIRECT_MEMBERS
 
 - (OFString *)JSONRepresentation
 {
-	return [self of_JSONRepresentationWithOptions: 0
-						depth: 0];
+	return [self JSONRepresentationWithOptions: 0];
 }
 
 - (OFString *)JSONRepresentationWithOptions: (int)options
 {
-	return [self of_JSONRepresentationWithOptions: options
-						depth: 0];
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONWriter *writer = [OFJSONWriter writer];
+	OFString *JSON;
+
+	writer.options = options;
+	[self writeJSONRepresentationToWriter: writer];
+	JSON = [writer.string retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [JSON autorelease];
 }
 
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer
 {
-	OFMutableString *JSON = [OFMutableString stringWithString: @"{"];
-	void *pool = objc_autoreleasePoolPush();
 	OFEnumerator *keyEnumerator = [self keyEnumerator];
 	OFEnumerator *objectEnumerator = [self objectEnumerator];
-	size_t i, count = self.count;
 	id key, object;
 
-	if (options & OF_JSON_REPRESENTATION_PRETTY) {
-		OFMutableString *indentation = [OFMutableString string];
-
-		for (i = 0; i < depth; i++)
-			[indentation appendString: @"\t"];
-
-		[JSON appendString: @"\n"];
-
-		i = 0;
-		while ((key = [keyEnumerator nextObject]) != nil &&
-		    (object = [objectEnumerator nextObject]) != nil) {
-			void *pool2 = objc_autoreleasePoolPush();
-			int identifierOptions =
-			    options | OF_JSON_REPRESENTATION_IDENTIFIER;
+	[writer beginObject];
 
-			if (![key isKindOfClass: [OFString class]])
-				@throw [OFInvalidArgumentException exception];
-
-			[JSON appendString: indentation];
-			[JSON appendString: @"\t"];
-			[JSON appendString: [key
-			    of_JSONRepresentationWithOptions: identifierOptions
-						       depth: depth + 1]];
-			[JSON appendString: @": "];
-			[JSON appendString: [object
-			    of_JSONRepresentationWithOptions: options
-						       depth: depth + 1]];
-
-			if (++i < count)
-				[JSON appendString: @",\n"];
-			else
-				[JSON appendString: @"\n"];
-
-			objc_autoreleasePoolPop(pool2);
-		}
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (object = [objectEnumerator nextObject]) != nil) {
+		if (![key isKindOfClass: [OFString class]])
+			@throw [OFInvalidArgumentException exception];
 
-		[JSON appendString: indentation];
-	} else {
-		i = 0;
-		while ((key = [keyEnumerator nextObject]) != nil &&
-		    (object = [objectEnumerator nextObject]) != nil) {
-			void *pool2 = objc_autoreleasePoolPush();
-			int identifierOptions =
-			    options | OF_JSON_REPRESENTATION_IDENTIFIER;
-
-			if (![key isKindOfClass: [OFString class]])
-				@throw [OFInvalidArgumentException exception];
-
-			[JSON appendString: [key
-			    of_JSONRepresentationWithOptions: identifierOptions
-						       depth: depth + 1]];
-			[JSON appendString: @":"];
-			[JSON appendString: [object
-			    of_JSONRepresentationWithOptions: options
-						       depth: depth + 1]];
-
-			if (++i < count)
-				[JSON appendString: @","];
-
-			objc_autoreleasePoolPop(pool2);
-		}
+		[writer writeKey: key];
+		[writer writeObject: object];
 	}
 
-	[JSON appendString: @"}"];
-	[JSON makeImmutable];
-
-	objc_autoreleasePoolPop(pool);
-
-	return JSON;
+	[writer endObject];
 }
 
 - (OFData *)messagePackRepresentation
@@ -19,13 +19,24 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
-@class OFMapTable;
+@class OFMutableData;
+
+struct epoll_event;
+struct of_epoll_fd_state;
 
 @interface OFEpollKernelEventObserver: OFKernelEventObserver
 {
 	int _epfd;
-	OFMapTable *_FDToEvents;
+	struct of_epoll_fd_state *_Nullable _FDStates;
+	size_t _FDStatesCount;
+	OFMutableData *_readyFDs, *_processedReadyFDs;
+	struct epoll_event *_Nullable _eventList;
+	size_t _eventListSize;
+	bool _usesEdgeTriggering, _observesListeningSocketsExclusively;
 }
+
+@property (nonatomic) bool usesEdgeTriggering;
+@property (nonatomic) bool observesListeningSocketsExclusively;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -19,27 +19,62 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <string.h>
 
 #ifdef HAVE_FCNTL_H
 # include <fcntl.h>
 #endif
 #include "unistd_wrapper.h"
 
+#include <poll.h>
 #include <sys/epoll.h>
 
 #import "OFEpollKernelEventObserver.h"
 #import "OFArray.h"
-#import "OFMapTable.h"
-#import "OFNull.h"
+#import "OFData.h"
+#import "OFStreamSocket.h"
 
 #import "OFInitializationFailedException.h"
 #import "OFObserveFailedException.h"
+#import "OFOutOfRangeException.h"
 
 #define EVENTLIST_SIZE 64
 
-static const of_map_table_functions_t mapFunctions = { NULL };
+#ifndef EPOLLRDHUP
+# define EPOLLRDHUP 0
+#endif
+
+enum {
+	NOT_READY = 0,
+	READY,
+	/* Was ready, but it is unknown if the handler consumed everything */
+	MAYBE_READY
+};
+
+struct of_epoll_fd_state {
+	/* Not retained, the superclass retains the observed objects */
+	id _Nullable readObject, writeObject;
+	uint32_t events;
+	unsigned char readReadiness, writeReadiness;
+	bool edgeTriggered, inReadyList;
+};
+
+static bool
+pollFD(int fd, short events)
+{
+	struct pollfd pfd = { fd, events, 0 };
+
+	if (poll(&pfd, 1, 0) < 1)
+		return false;
+
+	return ((pfd.revents & (events | POLLHUP | POLLERR)) != 0);
+}
 
 @implementation OFEpollKernelEventObserver
+@synthesize usesEdgeTriggering = _usesEdgeTriggering;
+@synthesize observesListeningSocketsExclusively =
+    _observesListeningSocketsExclusively;
+
 - (instancetype)init
 {
 	self = [super init];
@@ -62,13 +97,14 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 			fcntl(_epfd, F_SETFD, flags | FD_CLOEXEC);
 #endif
 
-		_FDToEvents = [[OFMapTable alloc]
-		    initWithKeyFunctions: mapFunctions
-			 objectFunctions: mapFunctions];
+		_readyFDs = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(int)];
+		_processedReadyFDs = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(int)];
 
 		memset(&event, 0, sizeof(event));
 		event.events = EPOLLIN;
-		event.data.ptr = [OFNull null];
+		event.data.fd = _cancelFD[0];
 
 		if (epoll_ctl(_epfd, EPOLL_CTL_ADD, _cancelFD[0], &event) == -1)
 			@throw [OFInitializationFailedException
@@ -85,43 +121,151 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 {
 	close(_epfd);
 
-	[_FDToEvents release];
+	free(_FDStates);
+	free(_eventList);
+	[_readyFDs release];
+	[_processedReadyFDs release];
 
 	[super dealloc];
 }
 
+- (struct of_epoll_fd_state *)of_stateForFD: (int)fd
+				     create: (bool)create OF_DIRECT
+{
+	if (fd < 0)
+		@throw [OFObserveFailedException exceptionWithObserver: self
+								 errNo: EBADF];
+
+	if ((size_t)fd >= _FDStatesCount) {
+		size_t count;
+
+		if (!create)
+			return NULL;
+
+		if ((size_t)fd > SIZE_MAX / 2 - 1)
+			@throw [OFOutOfRangeException exception];
+
+		/* File descriptors are small and dense, so index by them. */
+		count = ((size_t)fd + 1) * 2;
+		_FDStates = of_realloc(_FDStates, count, sizeof(*_FDStates));
+		memset(_FDStates + _FDStatesCount, 0,
+		    (count - _FDStatesCount) * sizeof(*_FDStates));
+		_FDStatesCount = count;
+	}
+
+	return &_FDStates[fd];
+}
+
+- (void)of_addReadyFD: (int)fd OF_DIRECT
+{
+	struct of_epoll_fd_state *state = &_FDStates[fd];
+
+	if (state->inReadyList)
+		return;
+
+	[_readyFDs addItem: &fd];
+	state->inReadyList = true;
+}
+
 - (void)of_addObject: (id)object
       fileDescriptor: (int)fd
-	      events: (int)addEvents OF_DIRECT
+	      events: (uint32_t)addEvents OF_DIRECT
 {
+	struct of_epoll_fd_state *state = [self of_stateForFD: fd
+						       create: true];
 	struct epoll_event event;
-	intptr_t events;
+	uint32_t events;
+	int op;
+
+	if (state->events != 0 && state->edgeTriggered) {
+		/*
+		 * The file descriptor is already registered for both
+		 * directions, so there is nothing to tell the kernel. If we
+		 * know or suspect it to be ready, handle it without waiting
+		 * for another edge.
+		 */
+		if (addEvents & EPOLLIN) {
+			state->readObject = object;
+
+			if (state->readReadiness != NOT_READY)
+				[self of_addReadyFD: fd];
+		} else {
+			state->writeObject = object;
+
+			if (state->writeReadiness != NOT_READY)
+				[self of_addReadyFD: fd];
+		}
 
-	events = (intptr_t)[_FDToEvents
-	    objectForKey: (void *)((intptr_t)fd + 1)];
+		return;
+	}
+
+	if (state->events == 0 && _usesEdgeTriggering &&
+	    !(_observesListeningSocketsExclusively &&
+	    [object isKindOfClass: [OFStreamSocket class]] &&
+	    [object isListening])) {
+		events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		op = EPOLL_CTL_ADD;
+	} else {
+		events = state->events | addEvents;
+		op = (state->events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD);
+
+#ifdef EPOLLEXCLUSIVE
+		/*
+		 * Only wake up one of the threads waiting for a listening
+		 * socket shared between several observers. Such a
+		 * registration cannot be modified, but listening sockets are
+		 * only ever observed for reading.
+		 */
+		if (op == EPOLL_CTL_ADD && addEvents == EPOLLIN &&
+		    _observesListeningSocketsExclusively &&
+		    [object isKindOfClass: [OFStreamSocket class]] &&
+		    [object isListening])
+			events |= EPOLLEXCLUSIVE;
+#endif
+	}
 
 	memset(&event, 0, sizeof(event));
-	event.events = (int)events | addEvents;
-	event.data.ptr = object;
+	event.events = events;
+	event.data.fd = fd;
 
-	if (epoll_ctl(_epfd, (events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD),
-	    fd, &event) == -1)
+	if (epoll_ctl(_epfd, op, fd, &event) == -1)
 		@throw [OFObserveFailedException exceptionWithObserver: self
 								 errNo: errno];
 
-	[_FDToEvents setObject: (void *)(events | addEvents)
-			forKey: (void *)((intptr_t)fd + 1)];
+	state->events = events;
+	state->edgeTriggered = ((events & EPOLLET) != 0);
+	state->readReadiness = state->writeReadiness = NOT_READY;
+
+	if (addEvents & EPOLLIN)
+		state->readObject = object;
+	else
+		state->writeObject = object;
 }
 
 - (void)of_removeObject: (id)object
 	 fileDescriptor: (int)fd
-		 events: (int)removeEvents OF_DIRECT
+		 events: (uint32_t)removeEvents OF_DIRECT
 {
-	intptr_t events;
+	struct of_epoll_fd_state *state = [self of_stateForFD: fd
+						       create: false];
+	uint32_t events;
+
+	if (state == NULL || state->events == 0)
+		return;
 
-	events = (intptr_t)[_FDToEvents
-	    objectForKey: (void *)((intptr_t)fd + 1)];
-	events &= ~removeEvents;
+	if (removeEvents & EPOLLIN)
+		state->readObject = nil;
+	else
+		state->writeObject = nil;
+
+	if (state->edgeTriggered) {
+		/* Keep the registration as long as one direction is used. */
+		if (state->readObject != nil || state->writeObject != nil)
+			return;
+
+		events = 0;
+	} else
+		events = state->events & ~removeEvents;
 
 	if (events == 0) {
 		if (epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, NULL) == -1)
@@ -135,22 +279,23 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 				    exceptionWithObserver: self
 						    errNo: errno];
 
-		[_FDToEvents removeObjectForKey: (void *)((intptr_t)fd + 1)];
+		state->readObject = state->writeObject = nil;
+		state->edgeTriggered = false;
+		state->readReadiness = state->writeReadiness = NOT_READY;
 	} else {
 		struct epoll_event event;
 
 		memset(&event, 0, sizeof(event));
-		event.events = (int)events;
-		event.data.ptr = object;
+		event.events = events;
+		event.data.fd = fd;
 
 		if (epoll_ctl(_epfd, EPOLL_CTL_MOD, fd, &event) == -1)
 			@throw [OFObserveFailedException
 			    exceptionWithObserver: self
 					    errNo: errno];
-
-		[_FDToEvents setObject: (void *)events
-				forKey: (void *)((intptr_t)fd + 1)];
 	}
+
+	state->events = events;
 }
 
 - (void)addObjectForReading: (id <OFReadyForReadingObserving>)object
@@ -189,16 +334,107 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 	[super removeObjectForWriting: object];
 }
 
+- (void)of_objectDidDrainForReading: (id)object
+{
+	int fd;
+
+	if (!_usesEdgeTriggering)
+		return;
+
+	fd = [object fileDescriptorForReading];
+
+	if (fd >= 0 && (size_t)fd < _FDStatesCount &&
+	    _FDStates[fd].readObject == object)
+		_FDStates[fd].readReadiness = NOT_READY;
+}
+
+- (void)of_processReadyFD: (int)fd OF_DIRECT
+{
+	struct of_epoll_fd_state *state = &_FDStates[fd];
+	void *pool;
+
+	state->inReadyList = false;
+
+	if (!state->edgeTriggered)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+
+	if (state->readObject != nil && state->readReadiness == MAYBE_READY &&
+	    !pollFD(fd, POLLIN))
+		state->readReadiness = NOT_READY;
+
+	if (state->readObject != nil && state->readReadiness != NOT_READY) {
+		id object = [[state->readObject retain] autorelease];
+
+		/* Reading less than requested marks it as not ready. */
+		state->readReadiness = MAYBE_READY;
+
+		if ([_delegate respondsToSelector:
+		    @selector(objectIsReadyForReading:)])
+			[_delegate objectIsReadyForReading: object];
+
+		/* The handler might have caused a reallocation. */
+		state = &_FDStates[fd];
+	}
+
+	if (state->writeObject != nil && state->writeReadiness == MAYBE_READY &&
+	    !pollFD(fd, POLLOUT))
+		state->writeReadiness = NOT_READY;
+
+	if (state->writeObject != nil && state->writeReadiness != NOT_READY) {
+		id object = [[state->writeObject retain] autorelease];
+
+		state->writeReadiness = MAYBE_READY;
+
+		if ([_delegate respondsToSelector:
+		    @selector(objectIsReadyForWriting:)])
+			[_delegate objectIsReadyForWriting: object];
+
+		state = &_FDStates[fd];
+	}
+
+	/* Check again on the next call if it might still be ready. */
+	if ((state->readObject != nil &&
+	    state->readReadiness != NOT_READY) ||
+	    (state->writeObject != nil && state->writeReadiness != NOT_READY))
+		[self of_addReadyFD: fd];
+
+	objc_autoreleasePoolPop(pool);
+}
+
 - (void)observeForTimeInterval: (of_time_interval_t)timeInterval
 {
-	OFNull *nullObject = [OFNull null];
-	struct epoll_event eventList[EVENTLIST_SIZE];
+	struct epoll_event stackEventList[EVENTLIST_SIZE], *eventList;
+	size_t maxEvents = (_maximumEventsPerObserve > 0
+	    ? _maximumEventsPerObserve : EVENTLIST_SIZE);
+	OFMutableData *readyFDs;
+	size_t count, processed = 0;
 	int events;
 
 	if ([self of_processReadBuffers])
 		return;
 
-	events = epoll_wait(_epfd, eventList, EVENTLIST_SIZE,
+	if (maxEvents > INT_MAX)
+		maxEvents = INT_MAX;
+
+	if (maxEvents <= EVENTLIST_SIZE)
+		eventList = stackEventList;
+	else {
+		if (_eventListSize < maxEvents) {
+			_eventList = of_realloc(_eventList, maxEvents,
+			    sizeof(*_eventList));
+			_eventListSize = maxEvents;
+		}
+
+		eventList = _eventList;
+	}
+
+	/* Don't block if there are file descriptors known to be ready. */
+	if (_readyFDs.count > 0)
+		timeInterval = 0;
+
+	events = epoll_wait(_epfd, eventList, (int)maxEvents,
 	    (timeInterval != -1 ? timeInterval * 1000 : -1));
 
 	if (events < 0)
@@ -206,33 +442,82 @@ static const of_map_table_functions_t mapFunctions = { NULL };
 								 errNo: errno];
 
 	for (int i = 0; i < events; i++) {
-		if (eventList[i].events & EPOLLIN) {
-			void *pool = objc_autoreleasePoolPush();
+		int fd = eventList[i].data.fd;
+		uint32_t revents = eventList[i].events;
+		struct of_epoll_fd_state *state;
+
+		if (fd == _cancelFD[0]) {
+			char buffer;
+			OF_ENSURE(read(_cancelFD[0], &buffer, 1) == 1);
+			continue;
+		}
+
+		if ((size_t)fd >= _FDStatesCount)
+			continue;
 
-			if (eventList[i].data.ptr == nullObject) {
-				char buffer;
-				OF_ENSURE(read(_cancelFD[0], &buffer, 1) == 1);
-				continue;
-			}
+		state = &_FDStates[fd];
+
+		if (state->edgeTriggered) {
+			/* Only record readiness, it's handled below. */
+			if (revents & (EPOLLIN | EPOLLRDHUP | EPOLLHUP |
+			    EPOLLERR))
+				state->readReadiness = READY;
+			if (revents & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+				state->writeReadiness = READY;
+
+			[self of_addReadyFD: fd];
+			continue;
+		}
+
+		if ((revents & EPOLLIN) && state->readObject != nil) {
+			void *pool = objc_autoreleasePoolPush();
+			id object = [[state->readObject retain] autorelease];
 
 			if ([_delegate respondsToSelector:
 			    @selector(objectIsReadyForReading:)])
-				[_delegate objectIsReadyForReading:
-				    eventList[i].data.ptr];
+				[_delegate objectIsReadyForReading: object];
 
 			objc_autoreleasePoolPop(pool);
+
+			/* The handler might have caused a reallocation. */
+			state = &_FDStates[fd];
 		}
 
-		if (eventList[i].events & EPOLLOUT) {
+		if ((revents & EPOLLOUT) && state->writeObject != nil) {
 			void *pool = objc_autoreleasePoolPush();
+			id object = [[state->writeObject retain] autorelease];
 
 			if ([_delegate respondsToSelector:
 			    @selector(objectIsReadyForWriting:)])
-				[_delegate objectIsReadyForWriting:
-				    eventList[i].data.ptr];
+				[_delegate objectIsReadyForWriting: object];
 
 			objc_autoreleasePoolPop(pool);
 		}
 	}
+
+	/*
+	 * Handlers add file descriptors that are still ready to the other
+	 * list, which is then handled on the next call.
+	 */
+	readyFDs = _readyFDs;
+	_readyFDs = _processedReadyFDs;
+	_processedReadyFDs = readyFDs;
+	count = readyFDs.count;
+
+	@try {
+		for (; processed < count; processed++)
+			[self of_processReadyFD:
+			    ((const int *)readyFDs.items)[processed]];
+	} @finally {
+		/* If a handler threw, requeue what was not handled yet. */
+		for (; processed < count; processed++) {
+			int fd = ((const int *)readyFDs.items)[processed];
+
+			_FDStates[fd].inReadyList = false;
+			[self of_addReadyFD: fd];
+		}
+
+		[readyFDs removeAllItems];
+	}
 }
 @end
@@ -18,21 +18,42 @@
 #import "OFStream.h"
 #import "OFDate.h"
 
+@class OFDeflateStream;
 @class OFInflateStream;
+#ifdef OF_HAVE_THREADS
+@class OFMutableArray OF_GENERIC(ObjectType);
+@class OFMutableData;
+@class OFThreadPool;
+#endif
 
 OF_ASSUME_NONNULL_BEGIN
 
+/**
+ * @brief The size of the blocks which are compressed as independent members
+ *	  when an OFGZIPStream compresses in parallel.
+ */
+#define OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE (1024 * 1024)
+
 /**
  * @class OFGZIPStream OFGZIPStream.h ObjFW/OFGZIPStream.h
  *
  * @brief A class that handles GZIP compression and decompression transparently
  *	  for an underlying stream.
+ *
+ * In write mode, the GZIP trailer is written when the OFGZIPStream is closed.
+ * Closing the OFGZIPStream does not close the underlying stream, so it can
+ * also be used to compress the body of an @ref OFHTTPServer response: Set the
+ * `Content-Encoding` header of the response to `gzip` and the
+ * `Transfer-Encoding` header to `chunked`, create an OFGZIPStream in write mode
+ * with the response as the underlying stream, write the body to it and close
+ * it before closing the response.
  */
 OF_SUBCLASSING_RESTRICTED
 @interface OFGZIPStream: OFStream
 {
 	OFStream *_stream;
 	OFInflateStream *_Nullable _inflateStream;
+	OFDeflateStream *_Nullable _deflateStream;
 	enum of_gzip_stream_state {
 		OF_GZIP_STREAM_ID1,
 		OF_GZIP_STREAM_ID2,
@@ -80,6 +101,14 @@ OF_SUBCLASSING_RESTRICTED
 	OFDate *_Nullable _modificationDate;
 	uint16_t _extraLength;
 	uint32_t _CRC32, _uncompressedSize;
+	bool _writing, _headerWritten;
+#ifdef OF_HAVE_THREADS
+	OFThreadPool *_Nullable _threadPool;
+	OFMutableData *_Nullable _parallelInput;
+	OFMutableArray *_Nullable _parallelMembers;
+	size_t _parallelMembersIndex, _parallelOutputIndex;
+	bool _parallelReadingImpossible, _started;
+#endif
 }
 
 /**
@@ -94,10 +123,38 @@ OF_SUBCLASSING_RESTRICTED
 /**
  * @brief The modification date of the original file.
  *
- * This property is only guaranteed to be available once @ref atEndOfStream is
- * true.
+ * When reading, this property is only guaranteed to be available once
+ * @ref atEndOfStream is true.
+ *
+ * When writing, this property needs to be set before anything is written, as
+ * it is part of the header.
+ */
+@property OF_NULLABLE_PROPERTY (copy, nonatomic) OFDate *modificationDate;
+
+#ifdef OF_HAVE_THREADS
+/**
+ * @brief The thread pool to use to compress or decompress in parallel, or nil
+ *	  to not use parallelism.
+ *
+ * When writing, the data is split into blocks of
+ * @ref OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE bytes, which are compressed on the
+ * thread pool and written as separate GZIP members. Any GZIP implementation
+ * can read such a multi-member file. Each member stores its size in an extra
+ * field, which allows to read it in parallel again.
+ *
+ * When reading, members which store their size in an extra field, as written
+ * by OFGZIPStream or in the BGZF format, are decompressed on the thread pool
+ * and reassembled in order. Once a member without size is encountered, the
+ * rest is read sequentially. Reading in parallel blocks on the underlying
+ * stream.
+ *
+ * Members are processed in batches of twice the size of the thread pool.
+ *
+ * Setting this after anything has been read or written raises an
+ * @ref OFAlreadyConnectedException.
  */
-@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFDate *modificationDate;
+@property OF_NULLABLE_PROPERTY (retain, nonatomic) OFThreadPool *threadPool;
+#endif
 
 /**
  * @brief Creates a new OFGZIPStream with the specified underlying stream.
@@ -19,20 +19,351 @@
 
 #import "OFGZIPStream.h"
 #import "OFInflateStream.h"
+#import "OFDeflateStream.h"
 #import "OFDate.h"
+#ifdef OF_HAVE_THREADS
+# import "OFArray.h"
+# import "OFData.h"
+# import "OFThreadPool.h"
+#endif
 
 #import "crc32.h"
 
+#import "OFAlreadyConnectedException.h"
 #import "OFChecksumMismatchException.h"
+#import "OFInvalidArgumentException.h"
 #import "OFInvalidFormatException.h"
 #import "OFNotImplementedException.h"
 #import "OFNotOpenException.h"
 #import "OFTruncatedDataException.h"
 
+#ifdef OF_HAVE_THREADS
+/* Length of the header of a member with the extra field containing its size */
+# define PARALLEL_HEADER_LENGTH 20
+
+OF_DIRECT_MEMBERS
+@interface OFGZIPStreamMember: OFObject
+{
+@public
+	OFMutableData *_input;
+	OFMutableData *_Nullable _output;
+	OFDate *_Nullable _modificationDate;
+	enum of_gzip_stream_operating_system _operatingSystemMadeOn;
+	id _Nullable _exception;
+}
+@end
+
+/* A stream that reads from or appends to the data of a member. */
+OF_DIRECT_MEMBERS
+@interface OFGZIPStreamDataStream: OFStream
+{
+	OFMutableData *_data;
+	size_t _position;
+}
+
+- (instancetype)initWithData: (OFMutableData *)data;
+@end
+
+@interface OFGZIPStream ()
+- (void)of_compressMember: (OFGZIPStreamMember *)member;
+- (void)of_decompressMember: (OFGZIPStreamMember *)member;
+@end
+#endif
+
+static void
+writeLittleEndian32(uint8_t *buffer, uint32_t value)
+{
+	buffer[0] = value & 0xFF;
+	buffer[1] = (value >> 8) & 0xFF;
+	buffer[2] = (value >> 16) & 0xFF;
+	buffer[3] = (value >> 24) & 0xFF;
+}
+
+static void
+makeHeader(uint8_t header[10], OFDate *modificationDate,
+    enum of_gzip_stream_operating_system operatingSystem)
+{
+	of_time_interval_t modificationTime =
+	    modificationDate.timeIntervalSince1970;
+
+	/* 0 means that no modification time is available. */
+	if (modificationTime < 0 || modificationTime > UINT32_MAX)
+		modificationTime = 0;
+
+	header[0] = 0x1F;
+	header[1] = 0x8B;
+	header[2] = 8;
+	header[3] = 0;
+	writeLittleEndian32(header + 4, (uint32_t)modificationTime);
+	header[8] = 0;
+	header[9] = operatingSystem;
+}
+
 @implementation OFGZIPStream
 @synthesize operatingSystemMadeOn = _operatingSystemMadeOn;
 @synthesize modificationDate = _modificationDate;
 
+static void
+writeHeader(OFGZIPStream *stream)
+{
+	uint8_t header[10];
+
+	makeHeader(header, stream->_modificationDate,
+	    stream->_operatingSystemMadeOn);
+
+	[stream->_stream writeBuffer: header
+			      length: sizeof(header)];
+
+	stream->_deflateStream =
+	    [[OFDeflateStream alloc] initWithStream: stream->_stream];
+	stream->_headerWritten = true;
+}
+
+static void
+finishWriting(OFGZIPStream *stream)
+{
+	uint8_t trailer[8];
+
+	if (!stream->_headerWritten)
+		writeHeader(stream);
+
+	[stream->_deflateStream close];
+
+	writeLittleEndian32(trailer, ~stream->_CRC32);
+	writeLittleEndian32(trailer + 4, stream->_uncompressedSize);
+
+	[stream->_stream writeBuffer: trailer
+			      length: sizeof(trailer)];
+}
+
+#ifdef OF_HAVE_THREADS
+static void
+queueParallelInput(OFGZIPStream *stream)
+{
+	OFGZIPStreamMember *member =
+	    [[[OFGZIPStreamMember alloc] init] autorelease];
+
+	member->_input = stream->_parallelInput;
+	stream->_parallelInput = nil;
+	member->_modificationDate = [stream->_modificationDate copy];
+	member->_operatingSystemMadeOn = stream->_operatingSystemMadeOn;
+
+	if (stream->_parallelMembers == nil)
+		stream->_parallelMembers = [[OFMutableArray alloc] init];
+
+	[stream->_parallelMembers addObject: member];
+	stream->_headerWritten = true;
+}
+
+static void
+writeParallelMembers(OFGZIPStream *stream)
+{
+	void *pool = objc_autoreleasePoolPush();
+
+	[stream->_threadPool dispatchWithTarget: stream
+				       selector: @selector(of_compressMember:)
+					objects: stream->_parallelMembers];
+	[stream->_threadPool waitUntilDone];
+
+	for (OFGZIPStreamMember *member in stream->_parallelMembers) {
+		if (member->_exception != nil)
+			@throw [[member->_exception retain] autorelease];
+
+		[stream->_stream writeData: member->_output];
+	}
+
+	[stream->_parallelMembers removeAllObjects];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+finishParallelWriting(OFGZIPStream *stream)
+{
+	/* A GZIP file needs at least one member, even if it is empty. */
+	if (stream->_parallelInput == nil && !stream->_headerWritten)
+		stream->_parallelInput = [[OFMutableData alloc] init];
+
+	if (stream->_parallelInput != nil)
+		queueParallelInput(stream);
+
+	writeParallelMembers(stream);
+}
+
+static void
+fallBackToSequentialReading(OFGZIPStream *stream, OFData *data)
+{
+	[stream->_stream unreadFromBuffer: data.items
+				   length: data.count];
+	stream->_parallelReadingImpossible = true;
+}
+
+/*
+ * Reads a whole member if its size is stored in the extra field. Otherwise,
+ * everything read is given back and reading continues sequentially.
+ */
+static OFGZIPStreamMember *
+readSizedMember(OFGZIPStream *stream)
+{
+	OFMutableData *data;
+	const uint8_t *items;
+	uint16_t extraLength;
+	uint32_t size = 0;
+	OFGZIPStreamMember *member;
+
+	if (stream->_stream.atEndOfStream)
+		return nil;
+
+	data = [OFMutableData dataWithCapacity: PARALLEL_HEADER_LENGTH];
+	[data increaseCountBy: 10];
+	[stream->_stream readIntoBuffer: data.mutableItems
+			    exactLength: 10];
+
+	items = data.items;
+	if (items[0] != 0x1F || items[1] != 0x8B || items[2] != 8 ||
+	    !(items[3] & OF_GZIP_STREAM_FLAG_EXTRA)) {
+		fallBackToSequentialReading(stream, data);
+		return nil;
+	}
+
+	[data increaseCountBy: 2];
+	[stream->_stream readIntoBuffer: (uint8_t *)data.mutableItems + 10
+			    exactLength: 2];
+	items = data.items;
+	extraLength = items[10] | (items[11] << 8);
+
+	[data increaseCountBy: extraLength];
+	[stream->_stream readIntoBuffer: (uint8_t *)data.mutableItems + 12
+			    exactLength: extraLength];
+	items = data.items;
+
+	/* "OF" is written by OFGZIPStream, "BC" is used by BGZF. */
+	for (uint16_t i = 0; i + 4 <= extraLength;) {
+		const uint8_t *subfield = items + 12 + i;
+		uint16_t subfieldLength = subfield[2] | (subfield[3] << 8);
+
+		if (i + 4 + subfieldLength > extraLength)
+			break;
+
+		if (subfield[0] == 'O' && subfield[1] == 'F' &&
+		    subfieldLength == 4) {
+			size = (uint32_t)subfield[4] |
+			    ((uint32_t)subfield[5] << 8) |
+			    ((uint32_t)subfield[6] << 16) |
+			    ((uint32_t)subfield[7] << 24);
+			break;
+		}
+
+		if (subfield[0] == 'B' && subfield[1] == 'C' &&
+		    subfieldLength == 2) {
+			size = (subfield[4] | (subfield[5] << 8)) + 1;
+			break;
+		}
+
+		i += 4 + subfieldLength;
+	}
+
+	/* Also refuse absurd sizes instead of allocating them. */
+	if (size < data.count + 8 ||
+	    size > 2 * OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE) {
+		fallBackToSequentialReading(stream, data);
+		return nil;
+	}
+
+	[data increaseCountBy: size - data.count];
+	[stream->_stream
+	    readIntoBuffer: (uint8_t *)data.mutableItems + 12 + extraLength
+	       exactLength: size - 12 - extraLength];
+
+	member = [[[OFGZIPStreamMember alloc] init] autorelease];
+	member->_input = [data retain];
+
+	return member;
+}
+
+static size_t
+readParallel(OFGZIPStream *stream, void *buffer, size_t length)
+{
+	for (;;) {
+		void *pool;
+		size_t count;
+
+		if (stream->_parallelMembersIndex <
+		    stream->_parallelMembers.count) {
+			OFGZIPStreamMember *member = [stream->_parallelMembers
+			    objectAtIndex: stream->_parallelMembersIndex];
+			size_t remaining;
+
+			if (member->_exception != nil)
+				@throw [[member->_exception retain]
+				    autorelease];
+
+			if (stream->_parallelOutputIndex == 0) {
+				[stream->_modificationDate release];
+				stream->_modificationDate =
+				    [member->_modificationDate retain];
+				stream->_operatingSystemMadeOn =
+				    member->_operatingSystemMadeOn;
+			}
+
+			remaining = member->_output.count -
+			    stream->_parallelOutputIndex;
+
+			if (remaining == 0) {
+				stream->_parallelMembersIndex++;
+				stream->_parallelOutputIndex = 0;
+				continue;
+			}
+
+			if (length > remaining)
+				length = remaining;
+
+			memcpy(buffer, (const char *)member->_output.items +
+			    stream->_parallelOutputIndex, length);
+			stream->_parallelOutputIndex += length;
+
+			return length;
+		}
+
+		if (stream->_parallelReadingImpossible)
+			return 0;
+
+		if (stream->_parallelMembers == nil)
+			stream->_parallelMembers =
+			    [[OFMutableArray alloc] init];
+
+		[stream->_parallelMembers removeAllObjects];
+		stream->_parallelMembersIndex = 0;
+		stream->_parallelOutputIndex = 0;
+
+		pool = objc_autoreleasePoolPush();
+
+		count = 2 * stream->_threadPool.size;
+		while (stream->_parallelMembers.count < count) {
+			OFGZIPStreamMember *member = readSizedMember(stream);
+
+			if (member == nil)
+				break;
+
+			[stream->_parallelMembers addObject: member];
+		}
+
+		if (stream->_parallelMembers.count == 0) {
+			objc_autoreleasePoolPop(pool);
+			return 0;
+		}
+
+		[stream->_threadPool
+		    dispatchWithTarget: stream
+			      selector: @selector(of_decompressMember:)
+			       objects: stream->_parallelMembers];
+		[stream->_threadPool waitUntilDone];
+
+		objc_autoreleasePoolPop(pool);
+	}
+}
+#endif
+
 + (instancetype)streamWithStream: (OFStream *)stream
 			    mode: (OFString *)mode
 {
@@ -51,7 +382,9 @@
 	self = [super init];
 
 	@try {
-		if (![mode isEqual: @"r"])
+		if ([mode isEqual: @"w"])
+			_writing = true;
+		else if (![mode isEqual: @"r"])
 			@throw [OFNotImplementedException
 			    exceptionWithSelector: _cmd
 					   object: nil];
@@ -74,17 +407,134 @@
 		[self close];
 
 	[_inflateStream release];
+	[_deflateStream release];
 	[_modificationDate release];
+#ifdef OF_HAVE_THREADS
+	[_threadPool release];
+	[_parallelInput release];
+	[_parallelMembers release];
+#endif
 
 	[super dealloc];
 }
 
+#ifdef OF_HAVE_THREADS
+- (void)setThreadPool: (OFThreadPool *)threadPool
+{
+	OFThreadPool *old;
+
+	/* Parallel and sequential state cannot be converted into each other. */
+	if (_started)
+		@throw [OFAlreadyConnectedException exception];
+
+	old = _threadPool;
+	_threadPool = [threadPool retain];
+	[old release];
+}
+
+- (OFThreadPool *)threadPool
+{
+	return _threadPool;
+}
+
+- (void)of_compressMember: (OFGZIPStreamMember *)member
+{
+	@try {
+		OFMutableData *input = member->_input;
+		OFMutableData *output = [OFMutableData
+		    dataWithCapacity: input.count / 2 + PARALLEL_HEADER_LENGTH];
+		uint8_t header[PARALLEL_HEADER_LENGTH], trailer[8];
+		OFGZIPStreamDataStream *outputStream;
+		OFDeflateStream *deflateStream;
+
+		makeHeader(header, member->_modificationDate,
+		    member->_operatingSystemMadeOn);
+		header[3] = OF_GZIP_STREAM_FLAG_EXTRA;
+		/* Extra field with a single "OF" subfield for the size. */
+		header[10] = 8;
+		header[11] = 0;
+		header[12] = 'O';
+		header[13] = 'F';
+		header[14] = 4;
+		header[15] = 0;
+		/* The size is filled in once it is known. */
+		writeLittleEndian32(header + 16, 0);
+
+		[output addItems: header
+			   count: sizeof(header)];
+
+		outputStream = [[[OFGZIPStreamDataStream alloc]
+		    initWithData: output] autorelease];
+		deflateStream =
+		    [OFDeflateStream streamWithStream: outputStream];
+		[deflateStream writeBuffer: input.items
+				    length: input.count];
+		[deflateStream close];
+
+		writeLittleEndian32(trailer,
+		    ~of_crc32(~0, input.items, input.count));
+		writeLittleEndian32(trailer + 4, (uint32_t)input.count);
+		[output addItems: trailer
+			   count: sizeof(trailer)];
+
+		writeLittleEndian32((uint8_t *)output.mutableItems + 16,
+		    (uint32_t)output.count);
+
+		member->_output = [output retain];
+	} @catch (id e) {
+		member->_exception = [e retain];
+	}
+}
+
+- (void)of_decompressMember: (OFGZIPStreamMember *)member
+{
+	@try {
+		OFMutableData *output = [OFMutableData data];
+		OFGZIPStreamDataStream *inputStream = [[[OFGZIPStreamDataStream
+		    alloc] initWithData: member->_input] autorelease];
+		OFGZIPStream *stream = [OFGZIPStream
+		    streamWithStream: inputStream
+				mode: @"r"];
+		char buffer[4096];
+
+		while (!stream.atEndOfStream) {
+			size_t length = [stream readIntoBuffer: buffer
+							length: sizeof(buffer)];
+
+			[output addItems: buffer
+				   count: length];
+		}
+
+		member->_output = [output retain];
+		member->_modificationDate = [stream.modificationDate retain];
+		member->_operatingSystemMadeOn = stream.operatingSystemMadeOn;
+	} @catch (id e) {
+		member->_exception = [e retain];
+	}
+}
+#endif
+
 - (size_t)lowlevelReadIntoBuffer: (void *)buffer
 			  length: (size_t)length
 {
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+	if (_writing)
+		@throw [OFInvalidArgumentException exception];
+
+#ifdef OF_HAVE_THREADS
+	_started = true;
+
+	if (_threadPool != nil) {
+		size_t bytesRead = readParallel(self, buffer, length);
+
+		/* Once reading in parallel is impossible, continue below. */
+		if (bytesRead > 0 || !_parallelReadingImpossible)
+			return bytesRead;
+	}
+#endif
+
 	for (;;) {
 		uint8_t byte;
 		uint32_t CRC32, uncompressedSize;
@@ -310,16 +760,87 @@
 	}
 }
 
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	if (_stream == nil)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+	if (!_writing)
+		@throw [OFInvalidArgumentException exception];
+
+#ifdef OF_HAVE_THREADS
+	_started = true;
+
+	if (_threadPool != nil) {
+		const unsigned char *bytes = buffer;
+		size_t remaining = length;
+
+		while (remaining > 0) {
+			size_t toCopy;
+
+			if (_parallelInput == nil)
+				_parallelInput = [[OFMutableData alloc]
+				    initWithCapacity:
+				    OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE];
+
+			toCopy = OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE -
+			    _parallelInput.count;
+			if (toCopy > remaining)
+				toCopy = remaining;
+
+			[_parallelInput addItems: bytes
+					   count: toCopy];
+			bytes += toCopy;
+			remaining -= toCopy;
+
+			if (_parallelInput.count ==
+			    OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE) {
+				queueParallelInput(self);
+
+				if (_parallelMembers.count >=
+				    2 * _threadPool.size)
+					writeParallelMembers(self);
+			}
+		}
+
+		return length;
+	}
+#endif
+
+	if (!_headerWritten)
+		writeHeader(self);
+
+	[_deflateStream writeBuffer: buffer
+			     length: length];
+
+	_CRC32 = of_crc32(_CRC32, buffer, length);
+	/* The size is stored modulo 2^32. */
+	_uncompressedSize += (uint32_t)length;
+
+	return length;
+}
+
 - (bool)lowlevelIsAtEndOfStream
 {
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+#ifdef OF_HAVE_THREADS
+	if (_parallelMembersIndex < _parallelMembers.count)
+		return false;
+#endif
+
 	return _stream.atEndOfStream;
 }
 
 - (bool)hasDataInReadBuffer
 {
+#ifdef OF_HAVE_THREADS
+	if (_parallelMembersIndex < _parallelMembers.count)
+		return true;
+#endif
+
 	if (_state == OF_GZIP_STREAM_DATA)
 		return (super.hasDataInReadBuffer ||
 		    _inflateStream.hasDataInReadBuffer);
@@ -332,9 +853,78 @@
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+	if (_writing) {
+#ifdef OF_HAVE_THREADS
+		if (_threadPool != nil)
+			finishParallelWriting(self);
+		else
+#endif
+			finishWriting(self);
+	}
+
 	[_stream release];
 	_stream = nil;
 
 	[super close];
 }
 @end
+
+#ifdef OF_HAVE_THREADS
+@implementation OFGZIPStreamMember
+- (void)dealloc
+{
+	[_input release];
+	[_output release];
+	[_modificationDate release];
+	[_exception release];
+
+	[super dealloc];
+}
+@end
+
+@implementation OFGZIPStreamDataStream
+- (instancetype)initWithData: (OFMutableData *)data
+{
+	self = [super init];
+
+	_data = [data retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= _data.count);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	size_t remaining = _data.count - _position;
+
+	if (length > remaining)
+		length = remaining;
+
+	memcpy(buffer, (const char *)_data.items + _position, length);
+	_position += length;
+
+	return length;
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	[_data addItems: buffer
+		  count: length];
+
+	return length;
+}
+@end
+#endif
@@ -25,8 +25,11 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFDictionary OF_GENERIC(KeyType, ObjectType);
 @class OFHTTPClient;
+@class OFHTTPClientConnection;
 @class OFHTTPRequest;
 @class OFHTTPResponse;
+@class OFMutableArray OF_GENERIC(ObjectType);
+@class OFMutableDictionary OF_GENERIC(KeyType, ObjectType);
 @class OFStream;
 @class OFTCPSocket;
 @class OFURL;
@@ -125,10 +128,36 @@ OF_ASSUME_NONNULL_BEGIN
 	      response: (OFHTTPResponse *)response;
 @end
 
+/**
+ * @brief The default for @ref OFHTTPClient::maxIdleConnectionsPerHost.
+ */
+#define OF_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS_PER_HOST 6
+
+/**
+ * @brief The default for @ref OFHTTPClient::maxIdleConnections.
+ */
+#define OF_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS 32
+
+/**
+ * @brief The default for @ref OFHTTPClient::idleTimeout.
+ */
+#define OF_HTTP_CLIENT_DEFAULT_IDLE_TIMEOUT 30
+
+/**
+ * @brief The default for @ref OFHTTPClient::maxConnections.
+ */
+#define OF_HTTP_CLIENT_DEFAULT_MAX_CONNECTIONS 0
+
 /**
  * @class OFHTTPClient OFHTTPClient.h ObjFW/OFHTTPClient.h
  *
  * @brief A class for performing HTTP requests.
+ *
+ * Connections to servers that support keep-alive are kept in a pool, keyed by
+ * scheme, host and port, and are reused by later requests to the same server.
+ * A connection is returned to the pool once the body of its response has been
+ * read entirely. Several requests can be performed at the same time, each
+ * using its own connection.
  */
 OF_SUBCLASSING_RESTRICTED
 @interface OFHTTPClient: OFObject
@@ -137,11 +166,16 @@ OF_SUBCLASSING_RESTRICTED
 @public
 #endif
 	OFObject <OFHTTPClientDelegate> *_Nullable _delegate;
-	bool _allowsInsecureRedirects, _inProgress;
-	OFTCPSocket *_Nullable _socket;
-	OFURL *_Nullable _lastURL;
-	bool _lastWasHEAD;
-	OFHTTPResponse *_Nullable _lastResponse;
+	bool _allowsInsecureRedirects;
+	OFMutableDictionary OF_GENERIC(OFString *,
+	    OFMutableArray OF_GENERIC(OFHTTPClientConnection *) *)
+	    *_idleConnections;
+	size_t _numIdleConnections, _numConnectionsInUse;
+	size_t _maxIdleConnectionsPerHost, _maxIdleConnections;
+	size_t _maxConnections;
+	of_time_interval_t _idleTimeout;
+	OFMutableArray *_pendingRequests;
+	unsigned long long _reusedConnections, _evictedConnections;
 }
 
 /**
@@ -155,6 +189,62 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property (nonatomic) bool allowsInsecureRedirects;
 
+/**
+ * @brief The maximum number of idle connections that are kept open per
+ *	  scheme, host and port.
+ *
+ * If a connection is returned to a full pool, the connection that has been
+ * idle the longest is closed. Connections that are in use are not counted.
+ * Setting this to 0 disables keeping connections open.
+ */
+@property (nonatomic) size_t maxIdleConnectionsPerHost;
+
+/**
+ * @brief The maximum number of idle connections that are kept open in total.
+ *
+ * If a connection is returned to a full pool, the connection that has been
+ * idle the longest is closed. Connections that are in use are not counted.
+ * Setting this to 0 disables keeping connections open.
+ */
+@property (nonatomic) size_t maxIdleConnections;
+
+/**
+ * @brief The maximum number of connections that are open at the same time,
+ *	  both in use and idle, or 0 for no limit.
+ *
+ * If the limit is reached, the connection that has been idle the longest is
+ * closed to make room. If all connections are in use, requests are queued
+ * until a response has been read entirely or closed.
+ */
+@property (nonatomic) size_t maxConnections;
+
+/**
+ * @brief The number of connections that are currently used by a request or
+ *	  by a response that has not been read entirely or closed yet.
+ */
+@property (readonly, nonatomic) size_t connectionsInUse;
+
+/**
+ * @brief The time in seconds after which an idle connection is closed.
+ *
+ * The time starts when the connection is returned to the pool. This is driven
+ * by a timer in the run loop of the thread that finished reading the
+ * response. Setting this to 0 keeps idle connections open until they are
+ * evicted or closed by the server.
+ */
+@property (nonatomic) of_time_interval_t idleTimeout;
+
+/**
+ * @brief The number of requests that reused a connection from the pool.
+ */
+@property (readonly, nonatomic) unsigned long long reusedConnections;
+
+/**
+ * @brief The number of idle connections that were closed to make room in the
+ *	  pool or because they exceeded the idle timeout.
+ */
+@property (readonly, nonatomic) unsigned long long evictedConnections;
+
 /**
  * @brief Creates a new OFHTTPClient.
  *
@@ -162,6 +252,13 @@ OF_SUBCLASSING_RESTRICTED
  */
 + (instancetype)client;
 
+/**
+ * @brief Initializes an already allocated OFHTTPClient.
+ *
+ * @return An initialized OFHTTPClient
+ */
+- (instancetype)init;
+
 /**
  * @brief Synchronously performs the specified HTTP request.
  *
@@ -209,7 +306,7 @@ OF_SUBCLASSING_RESTRICTED
 		  redirects: (unsigned int)redirects;
 
 /**
- * @brief Closes connections that are still open due to keep-alive.
+ * @brief Closes all idle connections that are still open due to keep-alive.
  */
 - (void)close;
 @end
@@ -20,10 +20,13 @@
 #include "config.h"
 
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 
 #import "OFHTTPClient.h"
+#import "OFArray.h"
 #import "OFData.h"
+#import "OFDate.h"
 #import "OFDictionary.h"
 #import "OFHTTPRequest.h"
 #import "OFHTTPResponse.h"
@@ -32,9 +35,9 @@
 #import "OFRunLoop.h"
 #import "OFString.h"
 #import "OFTCPSocket.h"
+#import "OFTimer.h"
 #import "OFURL.h"
 
-#import "OFAlreadyConnectedException.h"
 #import "OFHTTPRequestFailedException.h"
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidEncodingException.h"
@@ -53,6 +56,36 @@
 
 #define REDIRECTS_DEFAULT 10
 
+@class OFHTTPClientRequestHandler;
+
+@interface OFHTTPClient ()
+- (void)of_startRequestHandler: (OFHTTPClientRequestHandler *)handler;
+- (bool)of_tryStartRequestHandler: (OFHTTPClientRequestHandler *)handler;
+- (void)of_startPendingRequests;
+- (void)of_releaseConnectionWithSocket: (OFTCPSocket *)sock
+				forKey: (OFString *)key;
+- (OFTCPSocket *)of_takeIdleSocketForURL: (OFURL *)URL;
+- (void)of_addIdleSocket: (OFTCPSocket *)sock
+		  forKey: (OFString *)key;
+- (void)of_evictOldestIdleConnectionForKey: (OFString *)key;
+- (void)of_closeIdleConnection: (OFHTTPClientConnection *)connection;
+- (void)of_idleConnectionTimedOut: (OFHTTPClientConnection *)connection;
+@end
+
+OF_DIRECT_MEMBERS
+@interface OFHTTPClientConnection: OFObject
+{
+@public
+	OFHTTPClient *_client;
+	OFString *_key;
+	OFTCPSocket *_socket;
+	of_time_interval_t _idleSince;
+	OFTimer *_idleTimer;
+}
+
+- (void)idleTimerFired;
+@end
+
 OF_DIRECT_MEMBERS
 @interface OFHTTPClientRequestHandler: OFObject <OFTCPSocketDelegate>
 {
@@ -60,7 +93,7 @@ OF_DIRECT_MEMBERS
 	OFHTTPClient *_client;
 	OFHTTPRequest *_request;
 	unsigned int _redirects;
-	bool _firstLine;
+	bool _holdsConnection, _firstLine;
 	OFString *_version;
 	short _status;
 	OFMutableDictionary OF_GENERIC(OFString *, OFString *) *_serverHeaders;
@@ -69,8 +102,8 @@ OF_DIRECT_MEMBERS
 - (instancetype)initWithClient: (OFHTTPClient *)client
 		       request: (OFHTTPRequest *)request
 		     redirects: (unsigned int)redirects;
-- (void)start;
-- (void)closeAndReconnect;
+- (void)startWithSocket: (OFTCPSocket *)sock;
+- (void)connect;
 @end
 
 OF_DIRECT_MEMBERS
@@ -91,14 +124,21 @@ OF_DIRECT_MEMBERS
 @interface OFHTTPClientResponse: OFHTTPResponse <OFReadyForReadingObserving>
 {
 	OFTCPSocket *_socket;
+	OFHTTPClient *_client;
+	OFString *_connectionKey;
+	int _returnedFileDescriptor;
 	bool _hasContentLength, _chunked, _keepAlive;
-	bool _atEndOfStream, _setAtEndOfStream;
+	bool _atEndOfStream, _setAtEndOfStream, _returnedSocket;
 	long long _toRead;
 }
 
 @property (nonatomic, setter=of_setKeepAlive:) bool of_keepAlive;
 
-- (instancetype)initWithSocket: (OFTCPSocket *)sock;
+- (instancetype)initWithSocket: (OFTCPSocket *)sock
+			client: (OFHTTPClient *)client
+			   URL: (OFURL *)URL;
+- (void)of_finishIfBodyIsEmpty: (bool)isHEAD;
+- (void)of_returnSocket;
 @end
 
 OF_DIRECT_MEMBERS
@@ -218,6 +258,28 @@ constructRequestString(OFHTTPRequest *request)
 	return [requestString autorelease];
 }
 
+static uint16_t
+portForURL(OFURL *URL)
+{
+	OFNumber *port = URL.port;
+
+	if (port != nil)
+		return port.unsignedShortValue;
+
+	if ([URL.scheme caseInsensitiveCompare: @"https"] == OF_ORDERED_SAME)
+		return 443;
+
+	return 80;
+}
+
+static OFString *
+connectionKey(OFURL *URL)
+{
+	return [OFString stringWithFormat: @"%@://%@:%" @PRIu16,
+	    URL.scheme.lowercaseString, URL.host.lowercaseString,
+	    portForURL(URL)];
+}
+
 static OF_INLINE void
 normalizeKey(char *str_)
 {
@@ -262,6 +324,22 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 	return follow;
 }
 
+@implementation OFHTTPClientConnection
+- (void)dealloc
+{
+	[_key release];
+	[_socket release];
+	[_idleTimer release];
+
+	[super dealloc];
+}
+
+- (void)idleTimerFired
+{
+	[_client of_idleConnectionTimedOut: self];
+}
+@end
+
 @implementation OFHTTPClientRequestHandler
 - (instancetype)initWithClient: (OFHTTPClient *)client
 		       request: (OFHTTPRequest *)request
@@ -284,6 +362,10 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 
 - (void)dealloc
 {
+	if (_holdsConnection)
+		[_client of_releaseConnectionWithSocket: nil
+						 forKey: nil];
+
 	[_client release];
 	[_request release];
 	[_version release];
@@ -294,8 +376,11 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 
 - (void)raiseException: (id)exception
 {
-	[_client close];
-	_client->_inProgress = false;
+	if (_holdsConnection) {
+		_holdsConnection = false;
+		[_client of_releaseConnectionWithSocket: nil
+						 forKey: nil];
+	}
 
 	[_client->_delegate client: _client
 		 didPerformRequest: _request
@@ -312,8 +397,13 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 	OFString *location;
 	id exception;
 
-	response = [[[OFHTTPClientResponse alloc] initWithSocket: sock]
-	    autorelease];
+	/* From now on, the response owns the connection. */
+	response = [[[OFHTTPClientResponse alloc]
+	    initWithSocket: sock
+		    client: _client
+		       URL: URL] autorelease];
+	_holdsConnection = false;
+
 	response.protocolVersionString = _version;
 	response.statusCode = _status;
 	response.headers = _serverHeaders;
@@ -321,7 +411,8 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 	connectionHeader = [_serverHeaders objectForKey: @"Connection"];
 	if ([_version isEqual: @"1.1"]) {
 		if (connectionHeader != nil)
-			keepAlive = [connectionHeader isEqual: @"close"];
+			keepAlive = ([connectionHeader caseInsensitiveCompare:
+			    @"close"] != OF_ORDERED_SAME);
 		else
 			keepAlive = true;
 	} else {
@@ -332,15 +423,9 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 			keepAlive = false;
 	}
 
-	if (keepAlive) {
-		response.of_keepAlive = true;
-
-		_client->_socket = [sock retain];
-		_client->_lastURL = [URL copy];
-		_client->_lastWasHEAD =
-		    (_request.method == OF_HTTP_REQUEST_METHOD_HEAD);
-		_client->_lastResponse = [response retain];
-	}
+	response.of_keepAlive = keepAlive;
+	[response of_finishIfBodyIsEmpty:
+	    (_request.method == OF_HTTP_REQUEST_METHOD_HEAD)];
 
 	if (_redirects > 0 && (_status == 301 || _status == 302 ||
 	    _status == 303 || _status == 307) &&
@@ -413,7 +498,11 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 			newRequest.URL = newURL;
 			newRequest.headers = newHeaders;
 
-			_client->_inProgress = false;
+			/*
+			 * Nobody is going to read the body, so release the
+			 * connection before the redirect might need it.
+			 */
+			[response close];
 
 			[_client asyncPerformRequest: newRequest
 					   redirects: _redirects - 1];
@@ -421,8 +510,6 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		}
 	}
 
-	_client->_inProgress = false;
-
 	if (_status / 100 != 2)
 		exception = [OFHTTPRequestFailedException
 		    exceptionWithRequest: _request
@@ -458,7 +545,7 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 	 * end due to a timeout. In this case, we need to reconnect.
 	 */
 	if (line == nil) {
-		[self closeAndReconnect];
+		[self connect];
 		return false;
 	}
 
@@ -588,7 +675,7 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		    ([exception errNo] == ECONNRESET ||
 		    [exception errNo] == EPIPE)) {
 			/* In case a keep-alive connection timed out */
-			[self closeAndReconnect];
+			[self connect];
 			return nil;
 		}
 
@@ -662,50 +749,28 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		   afterDelay: 0];
 }
 
-- (void)start
+- (void)startWithSocket: (OFTCPSocket *)sock
 {
-	OFURL *URL = _request.URL;
-	OFTCPSocket *sock;
-
-	/* Can we reuse the last socket? */
-	if (_client->_socket != nil && !_client->_socket.atEndOfStream &&
-	    [_client->_lastURL.scheme isEqual: URL.scheme] &&
-	    [_client->_lastURL.host isEqual: URL.host] &&
-	    (_client->_lastURL.port == URL.port ||
-	    [_client->_lastURL.port isEqual: URL.port]) &&
-	    (_client->_lastWasHEAD || _client->_lastResponse.atEndOfStream)) {
-		/*
-		 * Set _socket to nil, so that in case of an error it won't be
-		 * reused. If everything is successful, we set _socket again
-		 * at the end.
-		 */
-		sock = [_client->_socket autorelease];
-		_client->_socket = nil;
-
-		[_client->_lastURL release];
-		_client->_lastURL = nil;
-
-		[_client->_lastResponse release];
-		_client->_lastResponse = nil;
-
+	/*
+	 * The socket is taken out of the pool while it is in use, so that in
+	 * case of an error it won't be reused. If everything is successful, it
+	 * is returned to the pool once the response has been read entirely.
+	 */
+	if (sock != nil) {
 		sock.delegate = self;
 
 		[self performSelector: @selector(handleSocket:)
 			   withObject: sock
 			   afterDelay: 0];
 	} else
-		[self closeAndReconnect];
+		[self connect];
 }
 
-- (void)closeAndReconnect
+- (void)connect
 {
 	@try {
 		OFURL *URL = _request.URL;
 		OFTCPSocket *sock;
-		uint16_t port;
-		OFNumber *URLPort;
-
-		[_client close];
 
 		if ([URL.scheme caseInsensitiveCompare: @"https"] ==
 		    OF_ORDERED_SAME) {
@@ -714,19 +779,12 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 				    exceptionWithURL: URL];
 
 			sock = [[[of_tls_socket_class alloc] init] autorelease];
-			port = 443;
-		} else {
+		} else
 			sock = [OFTCPSocket socket];
-			port = 80;
-		}
-
-		URLPort = URL.port;
-		if (URLPort != nil)
-			port = URLPort.unsignedShortValue;
 
 		sock.delegate = self;
 		[sock asyncConnectToHost: URL.host
-				    port: port];
+				    port: portForURL(URL)];
 	} @catch (id e) {
 		[self raiseException: e];
 	}
@@ -866,22 +924,76 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 @synthesize of_keepAlive = _keepAlive;
 
 - (instancetype)initWithSocket: (OFTCPSocket *)sock
+			client: (OFHTTPClient *)client
+			   URL: (OFURL *)URL
 {
 	self = [super init];
 
+	@try {
+		_connectionKey = [connectionKey(URL) copy];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
 	_socket = [sock retain];
+	_client = [client retain];
 
 	return self;
 }
 
 - (void)dealloc
 {
-	if (_socket != nil)
+	if (_socket != nil || _returnedSocket)
 		[self close];
 
+	[_connectionKey release];
+
 	[super dealloc];
 }
 
+- (void)of_finishIfBodyIsEmpty: (bool)isHEAD
+{
+	short statusCode = self.statusCode;
+
+	if (isHEAD || statusCode / 100 == 1 || statusCode == 204 ||
+	    statusCode == 304 || (_hasContentLength && _toRead == 0))
+		[self of_returnSocket];
+}
+
+- (void)of_returnSocket
+{
+	OFTCPSocket *sock = _socket;
+	OFHTTPClient *client = _client;
+	bool reusable;
+
+	_atEndOfStream = true;
+
+	if (sock == nil)
+		return;
+
+	/*
+	 * The response might still be observed by a run loop, which needs the
+	 * same file descriptor to stop observing it.
+	 */
+	_returnedFileDescriptor = sock.fileDescriptorForReading;
+	_returnedSocket = true;
+	_socket = nil;
+	_client = nil;
+
+	/* Anything left on the socket belongs to no request. */
+	reusable = (_keepAlive && !sock.atEndOfStream &&
+	    !sock.hasDataInReadBuffer);
+
+	@try {
+		[client of_releaseConnectionWithSocket: (reusable ? sock : nil)
+						forKey: _connectionKey];
+	} @finally {
+		[sock release];
+		[client release];
+	}
+}
+
 - (void)setHeaders: (OFDictionary *)headers
 {
 	OFString *contentLength;
@@ -915,15 +1027,21 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 - (size_t)lowlevelReadIntoBuffer: (void *)buffer
 			  length: (size_t)length
 {
+	if (_atEndOfStream)
+		return 0;
+
 	if (_socket == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
-	if (_atEndOfStream)
-		return 0;
+	if (!_hasContentLength && !_chunked) {
+		size_t ret = [_socket readIntoBuffer: buffer
+					      length: length];
 
-	if (!_hasContentLength && !_chunked)
-		return [_socket readIntoBuffer: buffer
-					length: length];
+		if (_socket.atEndOfStream)
+			[self of_returnSocket];
+
+		return ret;
+	}
 
 	if (_socket.atEndOfStream)
 		@throw [OFTruncatedDataException exception];
@@ -944,7 +1062,7 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		_toRead -= ret;
 
 		if (_toRead == 0)
-			_atEndOfStream = true;
+			[self of_returnSocket];
 
 		return ret;
 	}
@@ -968,7 +1086,7 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		}
 
 		if (_setAtEndOfStream && _toRead == 0)
-			_atEndOfStream = true;
+			[self of_returnSocket];
 
 		return 0;
 	} else if (_toRead == -1) {
@@ -983,7 +1101,7 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 		}
 
 		if (_setAtEndOfStream && _toRead == 0)
-			_atEndOfStream = true;
+			[self of_returnSocket];
 
 		return 0;
 	} else if (_toRead > 0) {
@@ -1068,6 +1186,9 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 
 - (int)fileDescriptorForReading
 {
+	if (_returnedSocket)
+		return _returnedFileDescriptor;
+
 	if (_socket == nil)
 		return -1;
 
@@ -1076,18 +1197,40 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 
 - (bool)hasDataInReadBuffer
 {
-	return (super.hasDataInReadBuffer || _socket.hasDataInReadBuffer);
+	/*
+	 * Once the socket has been returned, there is nothing left to wait
+	 * for, so asynchronous reads are told about the end of the stream
+	 * right away.
+	 */
+	return (super.hasDataInReadBuffer || _socket.hasDataInReadBuffer ||
+	    _returnedSocket);
 }
 
 - (void)close
 {
-	if (_socket == nil)
+	OFTCPSocket *sock = _socket;
+	OFHTTPClient *client = _client;
+
+	if (sock == nil && !_returnedSocket)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	_atEndOfStream = false;
-
-	[_socket release];
+	_returnedSocket = false;
 	_socket = nil;
+	_client = nil;
+
+	/*
+	 * If the response was closed before it was read entirely, the rest of
+	 * it is still on the connection, which makes it unusable.
+	 */
+	@try {
+		if (sock != nil)
+			[client of_releaseConnectionWithSocket: nil
+							forKey: _connectionKey];
+	} @finally {
+		[sock release];
+		[client release];
+	}
 
 	[super close];
 }
@@ -1213,19 +1356,233 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 @implementation OFHTTPClient
 @synthesize delegate = _delegate;
 @synthesize allowsInsecureRedirects = _allowsInsecureRedirects;
+@synthesize maxIdleConnectionsPerHost = _maxIdleConnectionsPerHost;
+@synthesize maxIdleConnections = _maxIdleConnections;
+@synthesize maxConnections = _maxConnections;
+@synthesize connectionsInUse = _numConnectionsInUse;
+@synthesize idleTimeout = _idleTimeout;
+@synthesize reusedConnections = _reusedConnections;
+@synthesize evictedConnections = _evictedConnections;
 
 + (instancetype)client
 {
 	return [[[self alloc] init] autorelease];
 }
 
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_idleConnections = [[OFMutableDictionary alloc] init];
+		_pendingRequests = [[OFMutableArray alloc] init];
+		_maxIdleConnectionsPerHost =
+		    OF_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS_PER_HOST;
+		_maxIdleConnections =
+		    OF_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS;
+		_maxConnections = OF_HTTP_CLIENT_DEFAULT_MAX_CONNECTIONS;
+		_idleTimeout = OF_HTTP_CLIENT_DEFAULT_IDLE_TIMEOUT;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
 - (void)dealloc
 {
 	[self close];
 
+	[_idleConnections release];
+	[_pendingRequests release];
+
 	[super dealloc];
 }
 
+- (void)of_startRequestHandler: (OFHTTPClientRequestHandler *)handler
+{
+	/* Queued requests are started first, in the order they were made. */
+	if (_pendingRequests.count > 0 ||
+	    ![self of_tryStartRequestHandler: handler])
+		[_pendingRequests addObject: handler];
+}
+
+- (bool)of_tryStartRequestHandler: (OFHTTPClientRequestHandler *)handler
+{
+	OFTCPSocket *sock = [self of_takeIdleSocketForURL:
+	    handler->_request.URL];
+
+	if (sock == nil && _maxConnections > 0 &&
+	    _numConnectionsInUse + _numIdleConnections >= _maxConnections) {
+		if (_numIdleConnections == 0)
+			return false;
+
+		[self of_evictOldestIdleConnectionForKey: nil];
+	}
+
+	_numConnectionsInUse++;
+	handler->_holdsConnection = true;
+
+	[handler startWithSocket: sock];
+
+	return true;
+}
+
+- (void)of_startPendingRequests
+{
+	while (_pendingRequests.count > 0) {
+		OFHTTPClientRequestHandler *handler =
+		    [_pendingRequests objectAtIndex: 0];
+
+		if (![self of_tryStartRequestHandler: handler])
+			break;
+
+		[_pendingRequests removeObjectAtIndex: 0];
+	}
+}
+
+- (void)of_releaseConnectionWithSocket: (OFTCPSocket *)sock
+				forKey: (OFString *)key
+{
+	_numConnectionsInUse--;
+
+	if (sock != nil)
+		[self of_addIdleSocket: sock
+				forKey: key];
+
+	[self of_startPendingRequests];
+}
+
+- (OFTCPSocket *)of_takeIdleSocketForURL: (OFURL *)URL
+{
+	OFString *key = connectionKey(URL);
+	OFMutableArray OF_GENERIC(OFHTTPClientConnection *) *connections =
+	    [[[_idleConnections objectForKey: key] retain] autorelease];
+	OFTCPSocket *sock = nil;
+	size_t i;
+
+	/*
+	 * Prefer the connection that was used most recently, as it is the
+	 * least likely to have been closed by the server. Closed ones are
+	 * removed.
+	 */
+	i = connections.count;
+	while (i-- > 0) {
+		OFHTTPClientConnection *connection =
+		    [connections objectAtIndex: i];
+
+		if (connection->_socket.atEndOfStream) {
+			[self of_closeIdleConnection: connection];
+			continue;
+		}
+
+		sock = [[connection->_socket retain] autorelease];
+		[connection->_idleTimer invalidate];
+		[connections removeObjectAtIndex: i];
+		_numIdleConnections--;
+		_reusedConnections++;
+		break;
+	}
+
+	if (connections.count == 0)
+		[_idleConnections removeObjectForKey: key];
+
+	return sock;
+}
+
+- (void)of_idleConnectionTimedOut: (OFHTTPClientConnection *)connection
+{
+	[self of_closeIdleConnection: connection];
+	_evictedConnections++;
+}
+
+- (void)of_evictOldestIdleConnectionForKey: (OFString *)key
+{
+	OFHTTPClientConnection *oldest = nil;
+
+	if (key != nil)
+		oldest = [[_idleConnections objectForKey: key] firstObject];
+	else {
+		for (OFArray *connections in _idleConnections.objectEnumerator)
+			for (OFHTTPClientConnection *connection in connections)
+				if (oldest == nil || connection->_idleSince <
+				    oldest->_idleSince)
+					oldest = connection;
+	}
+
+	if (oldest == nil)
+		return;
+
+	[self of_closeIdleConnection: oldest];
+	_evictedConnections++;
+}
+
+- (void)of_addIdleSocket: (OFTCPSocket *)sock
+		  forKey: (OFString *)key
+{
+	void *pool;
+	OFMutableArray OF_GENERIC(OFHTTPClientConnection *) *connections;
+	OFHTTPClientConnection *connection;
+
+	if (_maxIdleConnectionsPerHost == 0 || _maxIdleConnections == 0)
+		return;
+
+	pool = objc_autoreleasePoolPush();
+
+	while ([[_idleConnections objectForKey: key] count] >=
+	    _maxIdleConnectionsPerHost)
+		[self of_evictOldestIdleConnectionForKey: key];
+
+	while (_numIdleConnections >= _maxIdleConnections)
+		[self of_evictOldestIdleConnectionForKey: nil];
+
+	connections = [_idleConnections objectForKey: key];
+	if (connections == nil) {
+		connections = [OFMutableArray array];
+		[_idleConnections setObject: connections
+				     forKey: key];
+	}
+
+	connection = [[[OFHTTPClientConnection alloc] init] autorelease];
+	connection->_client = self;
+	connection->_key = [key copy];
+	connection->_socket = [sock retain];
+	connection->_idleSince = [OFDate date].timeIntervalSince1970;
+
+	if (_idleTimeout > 0)
+		connection->_idleTimer = [[OFTimer
+		    scheduledTimerWithTimeInterval: _idleTimeout
+					    target: connection
+					  selector: @selector(idleTimerFired)
+					   repeats: false] retain];
+
+	[connections addObject: connection];
+	_numIdleConnections++;
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)of_closeIdleConnection: (OFHTTPClientConnection *)connection
+{
+	OFMutableArray *connections =
+	    [_idleConnections objectForKey: connection->_key];
+	size_t idx = [connections indexOfObjectIdenticalTo: connection];
+
+	if (idx == OF_NOT_FOUND)
+		return;
+
+	/* The pool and the timer might hold the last references. */
+	[[connection retain] autorelease];
+
+	[connection->_idleTimer invalidate];
+	[connections removeObjectAtIndex: idx];
+	_numIdleConnections--;
+
+	if (connections.count == 0)
+		[_idleConnections removeObjectForKey: connection->_key];
+}
+
 - (OFHTTPResponse *)performRequest: (OFHTTPRequest *)request
 {
 	return [self performRequest: request
@@ -1266,29 +1623,21 @@ defaultShouldFollow(of_http_request_method_t method, short statusCode)
 	    [scheme caseInsensitiveCompare: @"https"] != OF_ORDERED_SAME)
 		@throw [OFUnsupportedProtocolException exceptionWithURL: URL];
 
-	if (_inProgress)
-		/* TODO: Find a better exception */
-		@throw [OFAlreadyConnectedException exception];
-
-	_inProgress = true;
-
-	[[[[OFHTTPClientRequestHandler alloc]
+	[self of_startRequestHandler: [[[OFHTTPClientRequestHandler alloc]
 	    initWithClient: self
 		   request: request
-		 redirects: redirects] autorelease] start];
+		 redirects: redirects] autorelease]];
 
 	objc_autoreleasePoolPop(pool);
 }
 
 - (void)close
 {
-	[_socket release];
-	_socket = nil;
-
-	[_lastURL release];
-	_lastURL = nil;
+	for (OFArray *connections in _idleConnections.objectEnumerator)
+		for (OFHTTPClientConnection *connection in connections)
+			[connection->_idleTimer invalidate];
 
-	[_lastResponse release];
-	_lastResponse = nil;
+	[_idleConnections removeAllObjects];
+	_numIdleConnections = 0;
 }
 @end
@@ -23,13 +23,23 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
-@class OFArray;
+@class OFArray OF_GENERIC(ObjectType);
+@class OFData;
+@class OFDictionary OF_GENERIC(KeyType, ObjectType);
 @class OFHTTPRequest;
 @class OFHTTPResponse;
 @class OFHTTPServer;
+@class OFNumber;
 @class OFStream;
 @class OFTCPSocket;
 
+struct of_http_server_counters;
+
+/**
+ * @brief The default for @ref OFHTTPServer::maxQueuedResponseLength.
+ */
+#define OF_HTTP_SERVER_DEFAULT_MAX_QUEUED_RESPONSE_LENGTH (1024 * 1024)
+
 /**
  * @protocol OFHTTPServerDelegate OFHTTPServer.h ObjFW/OFHTTPServer.h
  *
@@ -44,6 +54,13 @@ OF_ASSUME_NONNULL_BEGIN
  * @param request The request the HTTP server received
  * @param requestBody A stream to read the body of the request from, if any
  * @param response The response the server will send to the client
+ *
+ * @note Data written to the response that cannot be sent to the client right
+ *	 away is queued on the current thread's run loop, so the run loop needs
+ *	 to keep running until the response has been sent. Writing only blocks
+ *	 if more than @ref OFHTTPServer::maxQueuedResponseLength bytes are
+ *	 queued, in which case the run loop is run until enough of them have
+ *	 been sent.
  */
 -      (void)server: (OFHTTPServer *)server
   didReceiveRequest: (OFHTTPRequest *)request
@@ -104,7 +121,17 @@ OF_SUBCLASSING_RESTRICTED
 #ifdef OF_HAVE_THREADS
 	size_t _numberOfThreads, _nextThreadIndex;
 	OFArray *_threadPool;
+	bool _listensOnEachThread;
 #endif
+#ifdef OF_HTTP_SERVER_M
+@public
+#endif
+	struct of_http_server_counters *_Nullable _counters;
+	size_t _countersCount;
+	size_t _maxQueuedResponseLength;
+	OFDictionary OF_GENERIC(OFString *, OFString *) *_Nullable
+	    _defaultHeaders;
+	OFData *_Nullable _serverHeaderBlock, *_Nullable _defaultHeadersBlock;
 }
 
 /**
@@ -178,8 +205,60 @@ OF_SUBCLASSING_RESTRICTED
  * @ref OFAlreadyConnectedException.
  */
 @property (nonatomic) size_t numberOfThreads;
+
+/**
+ * @brief Whether each thread listens on its own socket.
+ *
+ * If this is true and @ref numberOfThreads is larger than 1, every thread,
+ * including the one that called @ref start, binds its own listening socket to
+ * the same port using `SO_REUSEPORT` and handles the connections it accepted
+ * itself. The kernel then distributes the incoming connections among the
+ * threads, so that no connection needs to be handed over to another thread.
+ *
+ * Setting this on a platform that does not support `SO_REUSEPORT` raises an
+ * @ref OFNotImplementedException.
+ *
+ * Setting this after @ref start has been called raises an
+ * @ref OFAlreadyConnectedException.
+ */
+@property (nonatomic) bool listensOnEachThread;
 #endif
 
+/**
+ * @brief The maximum number of bytes written to a response that are queued
+ *	  because the client does not receive them fast enough, or 0 for no
+ *	  limit.
+ *
+ * Once more bytes are queued, a write to the response runs the current run
+ * loop until the client received enough of them to get below the limit again.
+ * This way, a response that is generated faster than the client can receive
+ * it does not need an unbounded amount of memory.
+ */
+@property (nonatomic) size_t maxQueuedResponseLength;
+
+/**
+ * @brief The number of connections each thread handled so far, as an array
+ *	  of OFNumbers.
+ *
+ * The first element is for the thread that called @ref start, the others are
+ * for the additional threads if @ref numberOfThreads is larger than 1.
+ *
+ * This can be read at any time from any thread.
+ */
+@property (readonly, nonatomic)
+    OFArray OF_GENERIC(OFNumber *) *numbersOfHandledConnections;
+
+/**
+ * @brief The number of connections each thread currently has open, as an
+ *	  array of OFNumbers.
+ *
+ * The order is the same as for @ref numbersOfHandledConnections.
+ *
+ * This can be read at any time from any thread.
+ */
+@property (readonly, nonatomic)
+    OFArray OF_GENERIC(OFNumber *) *numbersOfOpenConnections;
+
 /**
  * @brief The server name the server presents to clients.
  *
@@ -188,6 +267,19 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property OF_NULLABLE_PROPERTY (copy, nonatomic) OFString *name;
 
+/**
+ * @brief Headers which are sent with every response.
+ *
+ * The headers are serialized once when they are set and the serialized block
+ * is copied into every response as is. If a response specifies a header with
+ * the same name itself, the header of the response is used instead.
+ *
+ * Setting this after @ref start has been called raises an
+ * @ref OFAlreadyConnectedException.
+ */
+@property OF_NULLABLE_PROPERTY (copy, nonatomic)
+    OFDictionary OF_GENERIC(OFString *, OFString *) *defaultHeaders;
+
 /**
  * @brief Creates a new HTTP server.
  *
@@ -15,19 +15,24 @@
  * file.
  */
 
+#define OF_HTTP_SERVER_M
+
 #include "config.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #import "OFHTTPServer.h"
 #import "OFArray.h"
 #import "OFData.h"
-#import "OFDate.h"
 #import "OFDictionary.h"
 #import "OFHTTPRequest.h"
 #import "OFHTTPResponse.h"
 #import "OFNumber.h"
+#import "OFRunLoop+Private.h"
+#import "OFStreamSocket+Private.h"
 #import "OFTCPSocket.h"
 #import "OFTLSSocket.h"
 #import "OFThread.h"
@@ -38,6 +43,7 @@
 #import "OFInvalidArgumentException.h"
 #import "OFInvalidEncodingException.h"
 #import "OFInvalidFormatException.h"
+#import "OFNotImplementedException.h"
 #import "OFNotOpenException.h"
 #import "OFOutOfMemoryException.h"
 #import "OFOutOfRangeException.h"
@@ -48,6 +54,7 @@
 #import "socket_helpers.h"
 
 #define BUFFER_SIZE 1024
+#define DATE_LINE_SIZE 64
 
 /*
  * FIXME: Key normalization replaces headers like "DNT" with "Dnt".
@@ -58,12 +65,14 @@
 @end
 
 OF_DIRECT_MEMBERS
-@interface OFHTTPServerResponse: OFHTTPResponse <OFReadyForWritingObserving>
+@interface OFHTTPServerResponse: OFHTTPResponse <OFReadyForWritingObserving,
+    OFStreamDelegate>
 {
 	OFStreamSocket *_socket;
 	OFHTTPServer *_server;
 	OFHTTPRequest *_request;
-	bool _chunked, _headersSent;
+	bool _chunked, _headersSent, _deallocating;
+	size_t _pendingWrites, _pendingWriteLength;
 }
 
 - (instancetype)initWithSocket: (OFStreamSocket *)sock
@@ -90,6 +99,7 @@ OF_DIRECT_MEMBERS
 	OFMutableDictionary *_headers;
 	size_t _contentLength;
 	OFStream *_requestBody;
+	size_t _threadIndex;
 }
 
 - (instancetype)initWithSocket: (OFStreamSocket *)sock
@@ -114,9 +124,21 @@ OF_DIRECT_MEMBERS
 		 contentLength: (unsigned long long)contentLength;
 @end
 
+/* Only written by the thread they belong to, but read by any thread */
+struct of_http_server_counters {
+	volatile size_t handledConnections, openConnections;
+};
+
 #ifdef OF_HAVE_THREADS
 OF_DIRECT_MEMBERS
 @interface OFHTTPServerThread: OFThread
+{
+@public
+	size_t _index;
+	OFHTTPServer *_server;
+	OFTCPSocket *_listeningSocket;
+}
+
 - (void)stop;
 @end
 #endif
@@ -156,6 +178,145 @@ normalizedKey(OFString *key)
 	}
 }
 
+static size_t
+formatDateLine(char *buffer, time_t seconds)
+{
+	/* 1970-01-01 was a Thursday. */
+	static const char weekdays[] = "ThuFriSatSunMonTueWed";
+	/* Years are counted from March, so that leap days are at the end. */
+	static const char months[] = "MarAprMayJunJulAugSepOctNovDecJanFeb";
+	long long days = (long long)seconds / 86400;
+	long long secondsOfDay = (long long)seconds % 86400;
+	long long era, dayOfEra, yearOfEra, dayOfYear, year;
+	int weekday, month, day, ret;
+
+	if (secondsOfDay < 0) {
+		secondsOfDay += 86400;
+		days--;
+	}
+
+	weekday = (int)(days % 7);
+	if (weekday < 0)
+		weekday += 7;
+
+	/* Shift the epoch to 0000-03-01 and split into 400 year eras. */
+	days += 719468;
+	era = (days >= 0 ? days : days - 146096) / 146097;
+	dayOfEra = days - era * 146097;
+	yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 -
+	    dayOfEra / 146096) / 365;
+	dayOfYear = dayOfEra -
+	    (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+	month = (int)((5 * dayOfYear + 2) / 153);
+	day = (int)(dayOfYear - (153 * month + 2) / 5 + 1);
+	year = yearOfEra + era * 400 + (month >= 10 ? 1 : 0);
+
+	ret = snprintf(buffer, DATE_LINE_SIZE,
+	    "Date: %.3s, %02d %.3s %04lld %02d:%02d:%02d GMT\r\n",
+	    weekdays + weekday * 3, day, months + month * 3, year,
+	    (int)(secondsOfDay / 3600), (int)(secondsOfDay / 60 % 60),
+	    (int)(secondsOfDay % 60));
+
+	if (ret < 0 || ret >= DATE_LINE_SIZE)
+		@throw [OFOutOfRangeException exception];
+
+	return ret;
+}
+
+/*
+ * Returns the Date header line for the current second. With compiler TLS (or
+ * without threads), it is only formatted once per second and thread.
+ * Otherwise, it is formatted into the passed buffer every time.
+ */
+static const char *
+dateLine(char *buffer, size_t *length)
+{
+#if defined(OF_HAVE_COMPILER_TLS)
+	static thread_local char cachedLine[DATE_LINE_SIZE];
+	static thread_local size_t cachedLineLength = 0;
+	static thread_local time_t cachedTime = 0;
+#elif !defined(OF_HAVE_THREADS)
+	static char cachedLine[DATE_LINE_SIZE];
+	static size_t cachedLineLength = 0;
+	static time_t cachedTime = 0;
+#endif
+	time_t seconds = time(NULL);
+
+#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
+	if (cachedLineLength == 0 || seconds != cachedTime) {
+		cachedLineLength = formatDateLine(cachedLine, seconds);
+		cachedTime = seconds;
+	}
+
+	*length = cachedLineLength;
+	return cachedLine;
+#else
+	*length = formatDateLine(buffer, seconds);
+	return buffer;
+#endif
+}
+
+static void
+appendDateLine(OFMutableData *data)
+{
+	char buffer[DATE_LINE_SIZE];
+	size_t length;
+	const char *line = dateLine(buffer, &length);
+
+	[data addItems: line
+		 count: length];
+}
+
+static void
+appendStatusLine(OFMutableData *data,
+    of_http_request_protocol_version_t protocolVersion, short statusCode)
+{
+	OFString *reason = of_http_status_code_to_string(statusCode);
+	char buffer[32];
+	int length = snprintf(buffer, sizeof(buffer), "HTTP/%u.%u %hd ",
+	    protocolVersion.major, protocolVersion.minor, statusCode);
+
+	if (length < 0 || (size_t)length >= sizeof(buffer))
+		@throw [OFOutOfRangeException exception];
+
+	[data addItems: buffer
+		 count: length];
+	[data addItems: reason.UTF8String
+		 count: reason.UTF8StringLength];
+	[data addItems: "\r\n"
+		 count: 2];
+}
+
+static void
+appendHeader(OFMutableData *data, OFString *key, OFString *value)
+{
+	[data addItems: key.UTF8String
+		 count: key.UTF8StringLength];
+	[data addItems: ": "
+		 count: 2];
+	[data addItems: value.UTF8String
+		 count: value.UTF8StringLength];
+	[data addItems: "\r\n"
+		 count: 2];
+}
+
+static OFData *
+headerBlock(OFDictionary OF_GENERIC(OFString *, OFString *) *headers)
+{
+	OFMutableData *data = [OFMutableData data];
+	OFEnumerator *keyEnumerator = [headers keyEnumerator];
+	OFEnumerator *valueEnumerator = [headers objectEnumerator];
+	OFString *key, *value;
+
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (value = [valueEnumerator nextObject]) != nil)
+		appendHeader(data, key, value);
+
+	[data makeImmutable];
+
+	return data;
+}
+
 @implementation OFHTTPServerResponse
 - (instancetype)initWithSocket: (OFStreamSocket *)sock
 			server: (OFHTTPServer *)server
@@ -173,8 +334,10 @@ normalizedKey(OFString *key)
 
 - (void)dealloc
 {
-	if (_socket != nil)
+	if (_socket != nil) {
+		_deallocating = true;
 		[self close];
+	}
 
 	[_server release];
 	[_request release];
@@ -182,100 +345,269 @@ normalizedKey(OFString *key)
 	[super dealloc];
 }
 
-- (void)of_sendHeaders
+- (OFData *)of_headers
 {
-	void *pool = objc_autoreleasePoolPush();
-	OFMutableDictionary OF_GENERIC(OFString *, OFString *) *headers;
+	OFDictionary OF_GENERIC(OFString *, OFString *) *defaultHeaders =
+	    _server->_defaultHeaders;
+	OFData *serverHeaderBlock = _server->_serverHeaderBlock;
+	OFMutableData *data = [OFMutableData dataWithCapacity: 512];
+	bool hasDate = false, hasServer = false, overridesDefaults = false;
 	OFEnumerator *keyEnumerator, *valueEnumerator;
 	OFString *key, *value;
 
-	[_socket writeFormat: @"HTTP/%@ %hd %@\r\n",
-			      self.protocolVersionString, _statusCode,
-			      of_http_status_code_to_string(_statusCode)];
+	appendStatusLine(data, _protocolVersion, _statusCode);
 
-	headers = [[_headers mutableCopy] autorelease];
+	/* A Date or Server default header replaces the generated one. */
+	if (defaultHeaders != nil) {
+		hasDate = ([defaultHeaders objectForKey: @"Date"] != nil);
+		hasServer = ([defaultHeaders objectForKey: @"Server"] != nil);
+	}
 
-	if ([headers objectForKey: @"Date"] == nil) {
-		OFString *date = [[OFDate date]
-		    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
+	keyEnumerator = [_headers keyEnumerator];
+	valueEnumerator = [_headers objectEnumerator];
+	while ((key = [keyEnumerator nextObject]) != nil &&
+	    (value = [valueEnumerator nextObject]) != nil) {
+		if ([key isEqual: @"Date"])
+			hasDate = true;
+		else if ([key isEqual: @"Server"])
+			hasServer = true;
+
+		if (!overridesDefaults &&
+		    [defaultHeaders objectForKey: key] != nil)
+			overridesDefaults = true;
 
-		[headers setObject: date
-			    forKey: @"Date"];
+		appendHeader(data, key, value);
 	}
 
-	if ([headers objectForKey: @"Server"] == nil) {
-		OFString *name = _server.name;
+	if (!hasDate)
+		appendDateLine(data);
 
-		if (name != nil)
-			[headers setObject: name
-				    forKey: @"Server"];
-	}
+	if (!hasServer && serverHeaderBlock != nil)
+		[data addItems: serverHeaderBlock.items
+			 count: serverHeaderBlock.count];
 
-	keyEnumerator = [headers keyEnumerator];
-	valueEnumerator = [headers objectEnumerator];
-	while ((key = [keyEnumerator nextObject]) != nil &&
-	    (value = [valueEnumerator nextObject]) != nil)
-		[_socket writeFormat: @"%@: %@\r\n", key, value];
+	if (!overridesDefaults) {
+		OFData *defaultHeadersBlock = _server->_defaultHeadersBlock;
+
+		if (defaultHeadersBlock != nil)
+			[data addItems: defaultHeadersBlock.items
+				 count: defaultHeadersBlock.count];
+	} else {
+		keyEnumerator = [defaultHeaders keyEnumerator];
+		valueEnumerator = [defaultHeaders objectEnumerator];
+		while ((key = [keyEnumerator nextObject]) != nil &&
+		    (value = [valueEnumerator nextObject]) != nil)
+			if ([_headers objectForKey: key] == nil)
+				appendHeader(data, key, value);
+	}
 
-	[_socket writeString: @"\r\n"];
+	[data addItems: "\r\n"
+		 count: 2];
 
 	_headersSent = true;
-	_chunked = [[headers objectForKey: @"Transfer-Encoding"]
+	_chunked = [[_headers objectForKey: @"Transfer-Encoding"]
 	    isEqual: @"chunked"];
 
-	objc_autoreleasePoolPop(pool);
+	return data;
+}
+
+- (void)of_reportException: (id)exception
+{
+	id <OFHTTPServerDelegate> delegate = _server.delegate;
+
+	if ([delegate respondsToSelector: @selector(server:
+	    didReceiveExceptionForResponse:request:exception:)])
+		[delegate		    server: _server
+		    didReceiveExceptionForResponse: self
+					   request: _request
+					 exception: exception];
+}
+
+- (void)of_writeBuffers: (const void *const *)buffers
+		lengths: (const size_t *)lengths
+		  count: (size_t)count
+{
+	size_t bytesWritten = 0, maxQueuedLength;
+	OFMutableData *remaining = nil;
+	OFRunLoop *runLoop;
+
+	/*
+	 * Try to send everything with a single non-blocking gather write. If
+	 * there are still writes queued, everything needs to be queued behind
+	 * them to keep the order.
+	 */
+	if (_pendingWrites == 0)
+		bytesWritten = [_socket of_writeBuffers: buffers
+						lengths: lengths
+						  count: count];
+
+	for (size_t i = 0; i < count; i++) {
+		if (bytesWritten >= lengths[i]) {
+			bytesWritten -= lengths[i];
+			continue;
+		}
+
+		if (remaining == nil)
+			remaining = [OFMutableData data];
+
+		[remaining addItems: (const char *)buffers[i] + bytesWritten
+			      count: lengths[i] - bytesWritten];
+		bytesWritten = 0;
+	}
+
+	if (remaining == nil)
+		return;
+
+	/*
+	 * A queued write would retain us, which is not possible anymore once
+	 * we are being deallocated. For the same reason, no earlier writes can
+	 * still be queued, so the rest can be written synchronously.
+	 */
+	if (_deallocating) {
+		[_socket writeBuffer: remaining.items
+			      length: remaining.count];
+		return;
+	}
+
+	[remaining makeImmutable];
+
+	/* The queue item retains us until the write finished. */
+	[OFRunLoop of_addAsyncWriteForStream: _socket
+					data: remaining
+					mode: of_run_loop_mode_default
+#ifdef OF_HAVE_BLOCKS
+				       block: NULL
+#endif
+				    delegate: self];
+	_pendingWrites++;
+	_pendingWriteLength += remaining.count;
+
+	/*
+	 * Block a writer that is faster than the client by sending the queued
+	 * data before accepting more. Every queued write either finishes or
+	 * fails, so this always ends.
+	 */
+	maxQueuedLength = _server->_maxQueuedResponseLength;
+	if (maxQueuedLength == 0 || _pendingWriteLength <= maxQueuedLength)
+		return;
+
+	runLoop = [OFRunLoop currentRunLoop];
+	while (_pendingWriteLength > maxQueuedLength)
+		[runLoop runMode: of_run_loop_mode_default
+		      beforeDate: nil];
 }
 
 - (size_t)lowlevelWriteBuffer: (const void *)buffer
 		       length: (size_t)length
 {
-	/* TODO: Use non-blocking writes */
-
 	void *pool;
+	const void *buffers[4];
+	size_t lengths[4], count = 0;
+	char chunkLength[sizeof(size_t) * 2 + 2];
 
 	if (_socket == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
-	if (!_headersSent)
-		[self of_sendHeaders];
+	pool = objc_autoreleasePoolPush();
 
-	if (!_chunked)
-		return [_socket writeBuffer: buffer
-				     length: length];
+	if (!_headersSent) {
+		OFData *headers = [self of_headers];
 
-	pool = objc_autoreleasePoolPush();
-	[_socket writeString: [OFString stringWithFormat: @"%zX\r\n", length]];
-	objc_autoreleasePoolPop(pool);
+		buffers[count] = headers.items;
+		lengths[count++] = headers.count;
+	}
 
-	[_socket writeBuffer: buffer
-		      length: length];
-	[_socket writeString: @"\r\n"];
+	if (!_chunked) {
+		buffers[count] = buffer;
+		lengths[count++] = length;
+	} else if (length > 0) {
+		/* A chunk of size 0 would end the response. */
+		size_t chunkLengthLength = 0;
+		char tmp[sizeof(size_t) * 2];
+		size_t i = sizeof(tmp);
+		size_t remainingLength = length;
+
+		do {
+			tmp[--i] = "0123456789ABCDEF"[remainingLength & 0xF];
+			remainingLength >>= 4;
+		} while (remainingLength > 0);
+
+		while (i < sizeof(tmp))
+			chunkLength[chunkLengthLength++] = tmp[i++];
+
+		chunkLength[chunkLengthLength++] = '\r';
+		chunkLength[chunkLengthLength++] = '\n';
+
+		buffers[count] = chunkLength;
+		lengths[count++] = chunkLengthLength;
+		buffers[count] = buffer;
+		lengths[count++] = length;
+		buffers[count] = "\r\n";
+		lengths[count++] = 2;
+	}
+
+	[self of_writeBuffers: buffers
+		      lengths: lengths
+			count: count];
+
+	objc_autoreleasePoolPop(pool);
 
 	return length;
 }
 
+- (OFData *)stream: (OFStream *)stream
+      didWriteData: (OFData *)data
+      bytesWritten: (size_t)bytesWritten
+	 exception: (id)exception
+{
+	_pendingWrites--;
+	_pendingWriteLength -= data.count;
+
+	if (exception != nil)
+		[self of_reportException: exception];
+
+	return nil;
+}
+
 - (void)close
 {
+	void *pool;
+
 	if (_socket == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+	pool = objc_autoreleasePoolPush();
+
 	@try {
-		if (!_headersSent)
-			[self of_sendHeaders];
+		const void *buffers[2];
+		size_t lengths[2], count = 0;
+
+		if (!_headersSent) {
+			OFData *headers = [self of_headers];
+
+			buffers[count] = headers.items;
+			lengths[count++] = headers.count;
+		}
 
-		if (_chunked)
-			[_socket writeString: @"0\r\n\r\n"];
+		if (_chunked) {
+			buffers[count] = "0\r\n\r\n";
+			lengths[count++] = 5;
+		}
+
+		if (count > 0)
+			[self of_writeBuffers: buffers
+				      lengths: lengths
+					count: count];
 	} @catch (OFWriteFailedException *e) {
-		id <OFHTTPServerDelegate> delegate = _server.delegate;
-
-		if ([delegate respondsToSelector: @selector(server:
-		  didReceiveExceptionForResponse:request:exception:)])
-			[delegate		    server: _server
-			    didReceiveExceptionForResponse: self
-						   request: _request
-						 exception: e];
+		[self of_reportException: e];
 	}
 
+	objc_autoreleasePoolPop(pool);
+
+	/*
+	 * Writes that are still queued keep the socket alive until they are
+	 * finished, so it is safe to release it here.
+	 */
 	[_socket release];
 	_socket = nil;
 
@@ -298,14 +630,28 @@ normalizedKey(OFString *key)
 	self = [super init];
 
 	@try {
+#ifdef OF_HAVE_THREADS
+		OFThread *thread = [OFThread currentThread];
+
+		if ([thread isKindOfClass: [OFHTTPServerThread class]])
+			_threadIndex = ((OFHTTPServerThread *)thread)->_index;
+#endif
+
 		_socket = [sock retain];
 		_server = [server retain];
+
+		/* Counted as open for as long as _server is set. */
+		_server->_counters[_threadIndex].handledConnections++;
+		_server->_counters[_threadIndex].openConnections++;
+
 		_timer = [[OFTimer
 		    scheduledTimerWithTimeInterval: 10
 					    target: _socket
 					  selector: @selector(
 							cancelAsyncRequests)
 					   repeats: false] retain];
+		/* Idle timeouts need not be precise, allow batching them. */
+		_timer.tolerance = 1;
 		_state = AWAITING_PROLOG;
 	} @catch (id e) {
 		[self release];
@@ -317,6 +663,9 @@ normalizedKey(OFString *key)
 
 - (void)dealloc
 {
+	if (_server != nil)
+		_server->_counters[_threadIndex].openConnections--;
+
 	[_socket release];
 	[_server release];
 
@@ -503,16 +852,25 @@ normalizedKey(OFString *key)
 
 - (bool)sendErrorAndClose: (short)statusCode
 {
-	OFString *date = [[OFDate date]
-	    dateStringWithFormat: @"%a, %d %b %Y %H:%M:%S GMT"];
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableData *data = [OFMutableData dataWithCapacity: 256];
+	OFData *serverHeaderBlock = _server->_serverHeaderBlock;
+
+	appendStatusLine(data, (of_http_request_protocol_version_t){ 1, 1 },
+	    statusCode);
+	appendDateLine(data);
 
-	[_socket writeFormat: @"HTTP/1.1 %hd %@\r\n"
-			      @"Date: %@\r\n"
-			      @"Server: %@\r\n"
-			      @"\r\n",
-			      statusCode,
-			      of_http_status_code_to_string(statusCode),
-			      date, _server.name];
+	if (serverHeaderBlock != nil)
+		[data addItems: serverHeaderBlock.items
+			 count: serverHeaderBlock.count];
+
+	[data addItems: "\r\n"
+		 count: 2];
+
+	[_socket writeBuffer: data.items
+		      length: data.count];
+
+	objc_autoreleasePoolPop(pool);
 
 	return false;
 }
@@ -765,16 +1123,42 @@ normalizedKey(OFString *key)
 
 #ifdef OF_HAVE_THREADS
 @implementation OFHTTPServerThread
+- (void)dealloc
+{
+	[_listeningSocket release];
+
+	[super dealloc];
+}
+
+- (id)main
+{
+	if (_listeningSocket != nil) {
+		/*
+		 * The listening sockets of all threads share the port using
+		 * SO_REUSEPORT. Observe them exclusively (EPOLLEXCLUSIVE) so
+		 * that a connection only wakes up a single waiter.
+		 */
+		[OFRunLoop currentRunLoop].observesListeningSocketsExclusively =
+		    true;
+
+		_listeningSocket.delegate = _server;
+		[_listeningSocket asyncAccept];
+	}
+
+	return [super main];
+}
+
 - (void)stop
 {
-	[[OFRunLoop currentRunLoop] stop];
+	[self.runLoop stop];
 	[self join];
 }
 @end
 #endif
 
 @implementation OFHTTPServer
-@synthesize delegate = _delegate, name = _name;
+@synthesize delegate = _delegate;
+@synthesize maxQueuedResponseLength = _maxQueuedResponseLength;
 
 + (instancetype)server
 {
@@ -785,11 +1169,18 @@ normalizedKey(OFString *key)
 {
 	self = [super init];
 
-	_name = @"OFHTTPServer (ObjFW's HTTP server class "
-	    @"<https://objfw.nil.im/>)";
+	@try {
+		self.name = @"OFHTTPServer (ObjFW's HTTP server class "
+		    @"<https://objfw.nil.im/>)";
+		_maxQueuedResponseLength =
+		    OF_HTTP_SERVER_DEFAULT_MAX_QUEUED_RESPONSE_LENGTH;
 #ifdef OF_HAVE_THREADS
-	_numberOfThreads = 1;
+		_numberOfThreads = 1;
 #endif
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
 
 	return self;
 }
@@ -801,6 +1192,11 @@ normalizedKey(OFString *key)
 	[_host release];
 	[_listeningSocket release];
 	[_name release];
+	[_defaultHeaders release];
+	[_serverHeaderBlock release];
+	[_defaultHeadersBlock release];
+
+	free(_counters);
 
 	[super dealloc];
 }
@@ -895,6 +1291,61 @@ normalizedKey(OFString *key)
 	return _privateKeyPassphrase;
 }
 
+- (void)setName: (OFString *)name
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *oldName = _name;
+	OFData *oldBlock = _serverHeaderBlock;
+
+	if (name != nil)
+		_serverHeaderBlock = [headerBlock(
+		    [OFDictionary dictionaryWithObject: name
+						forKey: @"Server"]) retain];
+	else
+		_serverHeaderBlock = nil;
+
+	_name = [name copy];
+
+	[oldName release];
+	[oldBlock release];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFString *)name
+{
+	return _name;
+}
+
+- (void)setDefaultHeaders:
+    (OFDictionary OF_GENERIC(OFString *, OFString *) *)defaultHeaders
+{
+	void *pool;
+	OFDictionary *oldHeaders;
+	OFData *oldBlock;
+
+	if (_listeningSocket != nil)
+		@throw [OFAlreadyConnectedException exception];
+
+	pool = objc_autoreleasePoolPush();
+	oldHeaders = _defaultHeaders;
+	oldBlock = _defaultHeadersBlock;
+
+	_defaultHeadersBlock = (defaultHeaders != nil
+	    ? [headerBlock(defaultHeaders) retain] : nil);
+	_defaultHeaders = [defaultHeaders copy];
+
+	[oldHeaders release];
+	[oldBlock release];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (OFDictionary OF_GENERIC(OFString *, OFString *) *)defaultHeaders
+{
+	return _defaultHeaders;
+}
+
 #ifdef OF_HAVE_THREADS
 - (void)setNumberOfThreads: (size_t)numberOfThreads
 {
@@ -911,36 +1362,114 @@ normalizedKey(OFString *key)
 {
 	return _numberOfThreads;
 }
-#endif
 
-- (void)start
+- (void)setListensOnEachThread: (bool)listensOnEachThread
 {
-	void *pool = objc_autoreleasePoolPush();
-
-	if (_host == nil)
-		@throw [OFInvalidArgumentException exception];
+# ifndef SO_REUSEPORT
+	if (listensOnEachThread)
+		@throw [OFNotImplementedException exceptionWithSelector: _cmd
+								 object: self];
+# endif
 
 	if (_listeningSocket != nil)
 		@throw [OFAlreadyConnectedException exception];
 
+	_listensOnEachThread = listensOnEachThread;
+}
+
+- (bool)listensOnEachThread
+{
+	return _listensOnEachThread;
+}
+#endif
+
+- (OFArray *)numbersOfHandledConnections
+{
+	OFMutableArray *ret =
+	    [OFMutableArray arrayWithCapacity: _countersCount];
+
+	for (size_t i = 0; i < _countersCount; i++)
+		[ret addObject: [OFNumber
+		    numberWithSize: _counters[i].handledConnections]];
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+- (OFArray *)numbersOfOpenConnections
+{
+	OFMutableArray *ret =
+	    [OFMutableArray arrayWithCapacity: _countersCount];
+
+	for (size_t i = 0; i < _countersCount; i++)
+		[ret addObject: [OFNumber
+		    numberWithSize: _counters[i].openConnections]];
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+- (OFTCPSocket *)of_listeningSocket OF_DIRECT
+{
+	OFTCPSocket *sock;
+
 	if (_usesTLS) {
 		OFTCPSocket <OFTLSSocket> *TLSSocket;
 
 		if (of_tls_socket_class == Nil)
 			@throw [OFUnsupportedProtocolException exception];
 
-		TLSSocket = [[of_tls_socket_class alloc] init];
-		_listeningSocket = TLSSocket;
-
+		TLSSocket = [[[of_tls_socket_class alloc] init] autorelease];
 		TLSSocket.certificateFile = _certificateFile;
 		TLSSocket.privateKeyFile = _privateKeyFile;
 		TLSSocket.privateKeyPassphrase = _privateKeyPassphrase;
+
+		sock = TLSSocket;
 	} else
-		_listeningSocket = [[OFTCPSocket alloc] init];
+		sock = [OFTCPSocket socket];
 
-	_port = [_listeningSocket bindToHost: _host
-					port: _port];
-	[_listeningSocket listen];
+#ifdef OF_HAVE_THREADS
+	if (_listensOnEachThread && _numberOfThreads > 1)
+		sock.reusesPort = true;
+#endif
+
+	_port = [sock bindToHost: _host
+			    port: _port];
+	[sock listen];
+
+	return sock;
+}
+
+- (void)start
+{
+	void *pool = objc_autoreleasePoolPush();
+	size_t countersCount = 1;
+
+	if (_host == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	if (_listeningSocket != nil)
+		@throw [OFAlreadyConnectedException exception];
+
+#ifdef OF_HAVE_THREADS
+	countersCount = _numberOfThreads;
+#endif
+
+	/*
+	 * Connections from a previous start might still be open, so the
+	 * counters are kept and only ever grow.
+	 */
+	if (countersCount > _countersCount) {
+		_counters = of_realloc(_counters, countersCount,
+		    sizeof(*_counters));
+		memset(_counters + _countersCount, 0,
+		    (countersCount - _countersCount) * sizeof(*_counters));
+		_countersCount = countersCount;
+	}
+
+	_listeningSocket = [[self of_listeningSocket] retain];
 
 #ifdef OF_HAVE_THREADS
 	if (_numberOfThreads > 1) {
@@ -951,16 +1480,39 @@ normalizedKey(OFString *key)
 			OFHTTPServerThread *thread =
 			    [OFHTTPServerThread thread];
 			thread.supportsSockets = true;
+			thread->_index = i;
+			thread->_server = self;
 
-			[thread start];
 			[threads addObject: thread];
+
+			if (!_listensOnEachThread)
+				continue;
+
+			@try {
+				thread->_listeningSocket =
+				    [[self of_listeningSocket] retain];
+			} @catch (id e) {
+				[_listeningSocket release];
+				_listeningSocket = nil;
+				@throw e;
+			}
 		}
 
+		/* Only start the threads once all sockets could be bound. */
+		for (OFHTTPServerThread *thread in threads)
+			[thread start];
+
 		[threads makeImmutable];
 		_threadPool = [threads copy];
 	}
 #endif
 
+#ifdef OF_HAVE_THREADS
+	if (_listensOnEachThread && _numberOfThreads > 1)
+		[OFRunLoop currentRunLoop].observesListeningSocketsExclusively =
+		    true;
+#endif
+
 	_listeningSocket.delegate = self;
 	[_listeningSocket asyncAccept];
 
@@ -1006,7 +1558,8 @@ normalizedKey(OFString *key)
 	}
 
 #ifdef OF_HAVE_THREADS
-	if (_numberOfThreads > 1) {
+	/* Each thread handles what it accepted on its own socket. */
+	if (_numberOfThreads > 1 && !_listensOnEachThread) {
 		OFHTTPServerThread *thread =
 		    [_threadPool objectAtIndex: _nextThreadIndex];
 
@@ -37,9 +37,8 @@ OF_SUBCLASSING_RESTRICTED
 	OFStream *_stream;
 	unsigned char _buffer[OF_INFLATE64_STREAM_BUFFER_SIZE];
 	uint16_t _bufferIndex, _bufferLength;
-	uint8_t _byte;
-	uint8_t _bitIndex, _savedBitsLength;
-	uint16_t _savedBits;
+	uint64_t _bits;
+	uint8_t _bitsLength;
 	unsigned char *_Nullable _slidingWindow;
 	uint16_t _slidingWindowIndex, _slidingWindowMask;
 	int _state;
@@ -55,7 +54,6 @@ OF_SUBCLASSING_RESTRICTED
 			struct of_huffman_tree *_Nullable litLenTree;
 			struct of_huffman_tree *_Nullable distTree;
 			struct of_huffman_tree *_Nullable codeLenTree;
-			struct of_huffman_tree *_Nullable treeIter;
 			uint8_t *_Nullable lengths;
 			uint16_t receivedCount;
 			uint8_t value, litLenCodesCount, distCodesCount;
@@ -64,9 +62,9 @@ OF_SUBCLASSING_RESTRICTED
 		struct {
 			struct of_huffman_tree *_Nullable litLenTree;
 			struct of_huffman_tree *_Nullable distTree;
-			struct of_huffman_tree *_Nullable treeIter;
 			int state;
-			uint16_t value, length, distance, extraBits;
+			uint16_t value, distance, extraBits;
+			uint32_t length;
 		} huffman;
 	} _context;
 	bool _inLastBlock, _atEndOfStream;
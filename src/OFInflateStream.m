@@ -20,8 +20,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <assert.h>
-
 #ifndef OF_INFLATE64_STREAM_M
 # import "OFInflateStream.h"
 #else
@@ -105,46 +103,161 @@ static const uint8_t codeLengthsOrder[19] = {
 static struct of_huffman_tree *fixedLitLenTree, *fixedDistTree;
 
 @implementation OFInflateStream
+static OF_INLINE void
+refillBits(OFInflateStream *stream)
+{
+	/*
+	 * If enough input is available, load a whole word at once. This also
+	 * puts the bytes following the whole bytes that fit into the upper
+	 * bits, but as those are exactly the bytes that are loaded next, this
+	 * is harmless.
+	 */
+	if OF_LIKELY (stream->_bufferLength - stream->_bufferIndex >= 8) {
+		uint64_t word;
+
+		memcpy(&word, stream->_buffer + stream->_bufferIndex, 8);
+		stream->_bits |= OF_BSWAP64_IF_BE(word) << stream->_bitsLength;
+		stream->_bufferIndex += (63 - stream->_bitsLength) >> 3;
+		stream->_bitsLength |= 56;
+
+		return;
+	}
+
+	while (stream->_bitsLength < 56 &&
+	    stream->_bufferIndex < stream->_bufferLength) {
+		stream->_bits |= (uint64_t)
+		    stream->_buffer[stream->_bufferIndex++] <<
+		    stream->_bitsLength;
+		stream->_bitsLength += 8;
+	}
+}
+
+static OF_INLINE bool
+ensureBits(OFInflateStream *stream, uint8_t count)
+{
+	if OF_LIKELY (stream->_bitsLength >= count)
+		return true;
+
+	refillBits(stream);
+
+	while (stream->_bitsLength < count) {
+		size_t length = [stream->_stream readIntoBuffer: stream->_buffer
+							 length: BUFFER_SIZE];
+
+		if OF_UNLIKELY (length < 1)
+			return false;
+
+		stream->_bufferIndex = 0;
+		stream->_bufferLength = (uint16_t)length;
+
+		refillBits(stream);
+	}
+
+	return true;
+}
+
 static OF_INLINE bool
 tryReadBits(OFInflateStream *stream, uint16_t *bits, uint8_t count)
 {
-	uint16_t ret = stream->_savedBits;
-
-	assert(stream->_savedBitsLength < count);
-
-	for (uint_fast8_t i = stream->_savedBitsLength; i < count; i++) {
-		if OF_UNLIKELY (stream->_bitIndex == 8) {
-			if OF_LIKELY (stream->_bufferIndex <
-			    stream->_bufferLength)
-				stream->_byte =
-				    stream->_buffer[stream->_bufferIndex++];
-			else {
-				size_t length = [stream->_stream
-				    readIntoBuffer: stream->_buffer
-					    length: BUFFER_SIZE];
-
-				if OF_UNLIKELY (length < 1) {
-					stream->_savedBits = ret;
-					stream->_savedBitsLength = i;
-					return false;
-				}
+	if OF_UNLIKELY (!ensureBits(stream, count))
+		return false;
 
-				stream->_byte = stream->_buffer[0];
-				stream->_bufferIndex = 1;
-				stream->_bufferLength = (uint16_t)length;
-			}
+	*bits = (uint16_t)(stream->_bits & ((UINT64_C(1) << count) - 1));
+	stream->_bits >>= count;
+	stream->_bitsLength -= count;
+
+	return true;
+}
+
+static OF_INLINE bool
+tryReadSymbol(OFInflateStream *stream, struct of_huffman_tree *tree,
+    uint16_t *value)
+{
+	uint8_t length;
+
+	if (stream->_bitsLength < OF_HUFFMAN_TREE_MAX_BITS)
+		refillBits(stream);
+
+	while (!of_huffman_tree_lookup(tree, (uint32_t)stream->_bits,
+	    stream->_bitsLength, value, &length))
+		if OF_UNLIKELY (!ensureBits(stream, stream->_bitsLength + 1))
+			return false;
+
+	stream->_bits >>= length;
+	stream->_bitsLength -= length;
+
+	return true;
+}
+
+/* Gives back all input not consumed yet, skipping to a byte boundary. */
+static void
+unreadBits(OFInflateStream *stream)
+{
+	unsigned char bytes[8];
+	uint8_t count = stream->_bitsLength / 8;
+	uint64_t bits = stream->_bits >> (stream->_bitsLength % 8);
+
+	for (uint_fast8_t i = 0; i < count; i++)
+		bytes[i] = (unsigned char)(bits >> (i * 8));
+
+	[stream->_stream
+	    unreadFromBuffer: stream->_buffer + stream->_bufferIndex
+		      length: stream->_bufferLength - stream->_bufferIndex];
+	[stream->_stream unreadFromBuffer: bytes
+				   length: count];
+
+	stream->_bufferIndex = stream->_bufferLength = 0;
+	stream->_bits = 0;
+	stream->_bitsLength = 0;
+}
 
-			stream->_bitIndex = 0;
+static OF_INLINE void
+copyMatch(OFInflateStream *stream, unsigned char *output, size_t length,
+    uint16_t distance)
+{
+	unsigned char *slidingWindow = stream->_slidingWindow;
+	uint16_t mask = stream->_slidingWindowMask;
+	uint_fast32_t destination = stream->_slidingWindowIndex;
+	uint_fast32_t source = (destination - distance) & mask;
+
+	/*
+	 * If neither source nor destination wrap around and the distance
+	 * (where 0 means 65536 for Inflate64) is at least 8, copy a word at a
+	 * time, as every word then only depends on bytes written before.
+	 */
+	if OF_LIKELY (source + length <= (uint_fast32_t)mask + 1 &&
+	    destination + length <= (uint_fast32_t)mask + 1 &&
+	    (uint16_t)(distance - 1) >= 7) {
+		size_t i = 0;
+
+		for (; i + 8 <= length; i += 8) {
+			uint64_t word;
+
+			memcpy(&word, slidingWindow + source + i, 8);
+			memcpy(slidingWindow + destination + i, &word, 8);
 		}
 
-		ret |= ((stream->_byte >> stream->_bitIndex++) & 1) << i;
+		for (; i < length; i++)
+			slidingWindow[destination + i] =
+			    slidingWindow[source + i];
+
+		memcpy(output, slidingWindow + destination, length);
+		stream->_slidingWindowIndex = (destination + length) & mask;
+
+		return;
 	}
 
-	stream->_savedBits = 0;
-	stream->_savedBitsLength = 0;
-	*bits = ret;
+	for (size_t i = 0; i < length; i++) {
+		unsigned char value = slidingWindow[source];
 
-	return true;
+		output[i] = value;
+		slidingWindow[destination] = value;
+
+		source = (source + 1) & mask;
+		destination = (destination + 1) & mask;
+	}
+
+	stream->_slidingWindowIndex = destination;
 }
 
 + (void)initialize
@@ -188,9 +301,6 @@ tryReadBits(OFInflateStream *stream, uint16_t *bits, uint8_t count)
 	@try {
 		_stream = [stream retain];
 
-		/* 0-7 address the bit, 8 means fetch next byte */
-		_bitIndex = 8;
-
 #ifdef OF_INFLATE64_STREAM_M
 		_slidingWindowMask = 0xFFFF;
 #else
@@ -249,10 +359,7 @@ start:
 	switch ((enum state)_state) {
 	case BLOCK_HEADER:
 		if OF_UNLIKELY (_inLastBlock) {
-			[_stream unreadFromBuffer: _buffer + _bufferIndex
-					   length: _bufferLength -
-						   _bufferIndex];
-			_bufferIndex = _bufferLength = 0;
+			unreadBits(self);
 
 			_atEndOfStream = true;
 			return bytesWritten;
@@ -266,7 +373,7 @@ start:
 		switch (bits >> 1) {
 		case 0: /* No compression */
 			_state = UNCOMPRESSED_BLOCK_HEADER;
-			_bitIndex = 8;
+			unreadBits(self);
 			_context.uncompressedHeader.position = 0;
 			memset(_context.uncompressedHeader.length, 0, 4);
 			break;
@@ -275,10 +382,12 @@ start:
 			_context.huffman.state = AWAIT_CODE;
 			_context.huffman.litLenTree = fixedLitLenTree;
 			_context.huffman.distTree = fixedDistTree;
-			_context.huffman.treeIter = fixedLitLenTree;
 			break;
 		case 2: /* Dynamic Huffman */
 			_state = HUFFMAN_TREE;
+			_context.huffmanTree.litLenTree = NULL;
+			_context.huffmanTree.distTree = NULL;
+			_context.huffmanTree.codeLenTree = NULL;
 			_context.huffmanTree.lengths = NULL;
 			_context.huffmanTree.receivedCount = 0;
 			_context.huffmanTree.value = 0xFE;
@@ -293,11 +402,6 @@ start:
 		goto start;
 	case UNCOMPRESSED_BLOCK_HEADER:
 #define CTX _context.uncompressedHeader
-		/* FIXME: This can be done more efficiently than unreading */
-		[_stream unreadFromBuffer: _buffer + _bufferIndex
-				   length: _bufferLength - _bufferIndex];
-		_bufferIndex = _bufferLength = 0;
-
 		CTX.position += [_stream
 		    readIntoBuffer: CTX.length + CTX.position
 			    length: 4 - CTX.position];
@@ -394,7 +498,6 @@ start:
 
 			CTX.codeLenTree = of_huffman_tree_construct(
 			    CTX.lengths, 19);
-			CTX.treeIter = CTX.codeLenTree;
 
 			free(CTX.lengths);
 			CTX.lengths = NULL;
@@ -411,14 +514,12 @@ start:
 			uint8_t j, count;
 
 			if OF_LIKELY (CTX.value == 0xFF) {
-				if OF_UNLIKELY (!of_huffman_tree_walk(self,
-				    tryReadBits, &CTX.treeIter, &value)) {
+				if OF_UNLIKELY (!tryReadSymbol(self,
+				    CTX.codeLenTree, &value)) {
 					CTX.receivedCount = i;
 					return bytesWritten;
 				}
 
-				CTX.treeIter = CTX.codeLenTree;
-
 				if (value < 16) {
 					CTX.lengths[i++] = value;
 					continue;
@@ -488,6 +589,7 @@ start:
 		    CTX.distCodesCount + 1);
 
 		free(CTX.lengths);
+		CTX.lengths = NULL;
 
 		/*
 		 * litLenTree and distTree are at the same location in
@@ -496,7 +598,6 @@ start:
 		 */
 		_state = HUFFMAN_BLOCK;
 		_context.huffman.state = AWAIT_CODE;
-		_context.huffman.treeIter = CTX.litLenTree;
 
 		goto start;
 #undef CTX
@@ -518,7 +619,6 @@ start:
 				    _slidingWindowMask;
 
 				CTX.state = AWAIT_CODE;
-				CTX.treeIter = CTX.litLenTree;
 			}
 
 			if OF_UNLIKELY (CTX.state == AWAIT_LENGTH_EXTRA_BITS) {
@@ -529,13 +629,12 @@ start:
 				CTX.length += bits;
 
 				CTX.state = AWAIT_DISTANCE;
-				CTX.treeIter = CTX.distTree;
 			}
 
 			/* Distance of length distance pair */
 			if (CTX.state == AWAIT_DISTANCE) {
-				if OF_UNLIKELY (!of_huffman_tree_walk(self,
-				    tryReadBits, &CTX.treeIter, &value))
+				if OF_UNLIKELY (!tryReadSymbol(self,
+				    CTX.distTree, &value))
 					return bytesWritten;
 
 				if OF_UNLIKELY (value >= numDistanceCodes)
@@ -570,34 +669,25 @@ start:
 
 			/* Length distance pair */
 			if (CTX.state == PROCESS_PAIR) {
-				for (uint_fast16_t j = 0; j < CTX.length; j++) {
-					uint16_t idx;
-
-					if OF_UNLIKELY (length == 0) {
-						CTX.length -= j;
-						return bytesWritten;
-					}
+				/* Inflate64 allows lengths of up to 65538. */
+				size_t toCopy = (length < CTX.length
+				    ? length : CTX.length);
 
-					idx = (_slidingWindowIndex -
-					    CTX.distance) & _slidingWindowMask;
-					value = _slidingWindow[idx];
+				copyMatch(self, buffer + bytesWritten, toCopy,
+				    CTX.distance);
 
-					buffer[bytesWritten++] = value;
-					length--;
+				bytesWritten += toCopy;
+				length -= toCopy;
 
-					_slidingWindow[_slidingWindowIndex] =
-					    value;
-					_slidingWindowIndex =
-					    (_slidingWindowIndex + 1) &
-					    _slidingWindowMask;
-				}
+				CTX.length -= (uint32_t)toCopy;
+				if OF_UNLIKELY (CTX.length > 0)
+					return bytesWritten;
 
 				CTX.state = AWAIT_CODE;
-				CTX.treeIter = CTX.litLenTree;
 			}
 
-			if OF_UNLIKELY (!of_huffman_tree_walk(self, tryReadBits,
-			    &CTX.treeIter, &value))
+			if OF_UNLIKELY (!tryReadSymbol(self, CTX.litLenTree,
+			    &value))
 				return bytesWritten;
 
 			/* End of block */
@@ -627,7 +717,6 @@ start:
 				    (_slidingWindowIndex + 1) &
 				    _slidingWindowMask;
 
-				CTX.treeIter = CTX.litLenTree;
 				continue;
 			}
 
@@ -650,7 +739,6 @@ start:
 				CTX.length += bits;
 			}
 
-			CTX.treeIter = CTX.distTree;
 			CTX.state = AWAIT_DISTANCE;
 		}
 
@@ -678,7 +766,7 @@ start:
 - (bool)hasDataInReadBuffer
 {
 	return (super.hasDataInReadBuffer || _stream.hasDataInReadBuffer ||
-	    _bufferLength - _bufferIndex > 0);
+	    _bufferLength - _bufferIndex > 0 || _bitsLength >= 8);
 }
 
 - (void)close
@@ -687,9 +775,7 @@ start:
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	/* Give back our buffer to the stream, in case it's shared */
-	[_stream unreadFromBuffer: _buffer + _bufferIndex
-			   length: _bufferLength - _bufferIndex];
-	_bufferIndex = _bufferLength = 0;
+	unreadBits(self);
 
 	[_stream release];
 	_stream = nil;
@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include <string.h>
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/** @file */
+
+@class OFData;
+@class OFMutableData;
+@class OFNumber;
+@class OFStream;
+@class OFString;
+
+/**
+ * @brief A token returned by an OFJSONReader.
+ */
+typedef enum {
+	/** The reader has not read any token yet. */
+	OF_JSON_READER_TOKEN_NONE,
+	/** An object was started. */
+	OF_JSON_READER_TOKEN_BEGIN_OBJECT,
+	/** An object was ended. */
+	OF_JSON_READER_TOKEN_END_OBJECT,
+	/** An array was started. */
+	OF_JSON_READER_TOKEN_BEGIN_ARRAY,
+	/** An array was ended. */
+	OF_JSON_READER_TOKEN_END_ARRAY,
+	/** The key of a member of an object was read. */
+	OF_JSON_READER_TOKEN_KEY,
+	/** A string was read. */
+	OF_JSON_READER_TOKEN_STRING,
+	/** A number was read. */
+	OF_JSON_READER_TOKEN_NUMBER,
+	/** The literal `true` was read. */
+	OF_JSON_READER_TOKEN_TRUE,
+	/** The literal `false` was read. */
+	OF_JSON_READER_TOKEN_FALSE,
+	/** The literal `null` was read. */
+	OF_JSON_READER_TOKEN_NULL,
+	/** The end of the document was reached. */
+	OF_JSON_READER_TOKEN_END_OF_DOCUMENT
+} of_json_reader_token_t;
+
+/**
+ * @struct of_json_reader_range_t OFJSONReader.h ObjFW/OFJSONReader.h
+ *
+ * @brief A range of bytes borrowed from an OFJSONReader.
+ *
+ * The bytes are not terminated and are only valid until the next token is
+ * read.
+ */
+struct OF_BOXABLE of_json_reader_range_t {
+	/** The first byte of the range, or NULL if the range is empty */
+	const char *_Nullable items;
+	/** The length of the range in bytes */
+	size_t length;
+};
+typedef struct of_json_reader_range_t of_json_reader_range_t;
+
+/**
+ * @brief Returns whether the specified range is equal to the specified C
+ *	  string.
+ *
+ * @param range The range to compare
+ * @param string The C string to compare the range with
+ * @return Whether the range is equal to the C string
+ */
+static OF_INLINE bool
+of_json_reader_range_is_equal(of_json_reader_range_t range, const char *string)
+{
+	size_t length = strlen(string);
+
+	return (range.length == length &&
+	    (length == 0 || memcmp(range.items, string, length) == 0));
+}
+
+/**
+ * @class OFJSONReader OFJSONReader.h ObjFW/OFJSONReader.h
+ *
+ * @brief A streaming reader for JSON that does not build objects.
+ *
+ * Unlike `-[OFString objectByParsingJSON]`, which needs the whole document
+ * as a string and creates objects for everything in it, an OFJSONReader reads
+ * from an OFData or an OFStream and returns one token at a time using
+ * @ref nextToken. Keys, strings and numbers are returned as ranges of bytes
+ * pointing into the reader's buffer, which are only valid until the next
+ * token is read. Values that are not of interest can be skipped using
+ * @ref skipValue, and values that are of interest can be turned into objects
+ * on demand using @ref readObject.
+ *
+ * OFJSONReader only accepts strict JSON as specified by RFC 8259, but
+ * optionally accepts a sequence of values as used by newline-delimited JSON.
+ * Strings are expected to be UTF-8.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFJSONReader: OFObject
+{
+	OFStream *_Nullable _stream;
+	OFData *_Nullable _data;
+	char *_Nullable _storage;
+	const char *_Nullable _buffer;
+	size_t _bufferLength, _storageSize, _position;
+	of_json_reader_token_t _token;
+	of_json_reader_range_t _range;
+	bool _hasEscapes, _allowsMultipleValues;
+	OFMutableData *_containers;
+	size_t _depthLimit, _line;
+	int _state;
+}
+
+/**
+ * @brief The last token that was read.
+ */
+@property (readonly, nonatomic) of_json_reader_token_t token;
+
+/**
+ * @brief The number of arrays and objects that are currently open.
+ */
+@property (readonly, nonatomic) size_t depth;
+
+/**
+ * @brief The line the reader is currently in.
+ */
+@property (readonly, nonatomic) size_t line;
+
+/**
+ * @brief The maximum depth the reader accepts.
+ *
+ * Defaults to 32. 0 means no limit (insecure!).
+ */
+@property (nonatomic) size_t depthLimit;
+
+/**
+ * @brief Whether the reader accepts a sequence of values instead of a single
+ *	  value, as used by newline-delimited JSON.
+ *
+ * Defaults to false.
+ */
+@property (nonatomic) bool allowsMultipleValues;
+
+/**
+ * @brief The raw bytes of the current key, string, number or literal.
+ *
+ * For keys and strings, this excludes the quotes and escape sequences have not
+ * been resolved.
+ */
+@property (readonly, nonatomic) of_json_reader_range_t range;
+
+/**
+ * @brief Whether the current key or string contains escape sequences.
+ *
+ * If it does not, @ref range can be used as UTF-8 as is.
+ */
+@property (readonly, nonatomic) bool hasEscapes;
+
+/**
+ * @brief The current key or string with escape sequences resolved, or the raw
+ *	  text of the current number or literal.
+ */
+@property (readonly, nonatomic) OFString *stringValue;
+
+/**
+ * @brief The current number or boolean literal as an OFNumber, or nil if the
+ *	  current token is neither.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFNumber *numberValue;
+
+/**
+ * @brief The current number as a long long.
+ *
+ * Integers are converted without creating any objects.
+ */
+@property (readonly, nonatomic) long long longLongValue;
+
+/**
+ * @brief Creates a new JSON reader that reads from the specified stream.
+ *
+ * @param stream The stream to read the JSON from
+ * @return A new, autoreleased OFJSONReader
+ */
++ (instancetype)readerWithStream: (OFStream *)stream;
+
+/**
+ * @brief Creates a new JSON reader that reads from the specified data.
+ *
+ * @param data The data to read the JSON from. The data is retained and the
+ *	       ranges returned by the reader point directly into it.
+ * @return A new, autoreleased OFJSONReader
+ */
++ (instancetype)readerWithData: (OFData *)data;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated JSON reader to read from the
+ *	  specified stream.
+ *
+ * @param stream The stream to read the JSON from
+ * @return An initialized OFJSONReader
+ */
+- (instancetype)initWithStream: (OFStream *)stream;
+
+/**
+ * @brief Initializes an already allocated JSON reader to read from the
+ *	  specified data.
+ *
+ * @param data The data to read the JSON from. The data is retained and the
+ *	       ranges returned by the reader point directly into it.
+ * @return An initialized OFJSONReader
+ */
+- (instancetype)initWithData: (OFData *)data;
+
+/**
+ * @brief Reads the next token.
+ *
+ * All ranges returned for the previous token become invalid.
+ *
+ * @return The token that was read
+ * @throw OFInvalidJSONException The document is not valid JSON
+ */
+- (of_json_reader_token_t)nextToken;
+
+/**
+ * @brief Skips the value that was just started, or the value of the key that
+ *	  was just read.
+ *
+ * Arrays and objects are skipped by only looking at the characters that
+ * structure the document, which is considerably faster than reading all of
+ * their tokens, but only checks that brackets and braces are balanced.
+ * Afterwards, the current token is the last token of the skipped value.
+ *
+ * If the current token neither starts a value nor is a key, this does
+ * nothing.
+ */
+- (void)skipValue;
+
+/**
+ * @brief Reads the value that was just started, or the value of the key that
+ *	  was just read, as an object.
+ *
+ * Arrays and objects are read as OFMutableArray and OFMutableDictionary,
+ * strings as OFString, numbers and booleans as OFNumber and null as OFNull,
+ * just like `-[OFString objectByParsingJSON]` does. Afterwards, the current
+ * token is the last token of the value.
+ *
+ * @return The value as an object
+ * @throw OFInvalidJSONException The document is not valid JSON
+ */
+- (id)readObject;
+@end
+
+OF_ASSUME_NONNULL_END
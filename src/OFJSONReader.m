@@ -0,0 +1,1023 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFJSONReader.h"
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDictionary.h"
+#import "OFNull.h"
+#import "OFNumber.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFInvalidJSONException.h"
+#import "OFOutOfRangeException.h"
+
+#if defined(__SSE2__) && (defined(OF_X86_64) || defined(OF_X86))
+# include <emmintrin.h>
+# define USE_SSE2
+#elif defined(__ARM_NEON) && defined(OF_ARM64)
+# include <arm_neon.h>
+# define USE_NEON
+#endif
+
+#define MIN_BUFFER_SIZE 16384
+
+enum {
+	STATE_VALUE,
+	STATE_FIRST_VALUE,
+	STATE_KEY,
+	STATE_FIRST_KEY,
+	STATE_COLON,
+	STATE_COMMA,
+	STATE_END
+};
+
+#define ONES UINT64_C(0x0101010101010101)
+#define HIGH_BITS UINT64_C(0x8080808080808080)
+/* Non-zero if any byte of x is zero. */
+#define HAS_ZERO(x) (((x) - ONES) & ~(x) & HIGH_BITS)
+/* Non-zero if any byte of x is less than n, for n <= 128. */
+#define HAS_LESS(x, n) (((x) - ONES * (n)) & ~(x) & HIGH_BITS)
+
+@interface OFJSONReader ()
+- (instancetype)of_init OF_METHOD_FAMILY(init);
+- (void)of_compact;
+- (bool)of_readMore;
+- (bool)of_parseString: (const char *)start
+		   end: (const char *)end;
+- (bool)of_parseValue: (of_json_reader_token_t *)token
+		atEnd: (bool)atEnd;
+- (void)of_endContainer: (char)character
+		  token: (of_json_reader_token_t *)token;
+- (bool)of_parseToken: (of_json_reader_token_t *)token
+		atEnd: (bool)atEnd;
+- (void)of_skipContainer;
+@end
+
+static OF_INLINE of_json_reader_range_t
+makeRange(const char *items, size_t length)
+{
+	of_json_reader_range_t range;
+
+	range.items = (length > 0 ? items : NULL);
+	range.length = length;
+
+	return range;
+}
+
+/*
+ * Returns the first quote, backslash or control character, looking at 16 bytes
+ * at a time with SIMD and then at a whole word at a time until one contains
+ * any of them.
+ */
+static const char *
+findStringSpecial(const char *p, const char *end)
+{
+#if defined(USE_SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+		/* Unsigned v <= 0x1F if max(v, 0x1F) is 0x1F. */
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+		    _mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+		    _mm_cmpeq_epi8(_mm_max_epu8(v, control), control)));
+
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+
+		p += 16;
+	}
+#elif defined(USE_NEON)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	const uint8x16_t space = vdupq_n_u8(0x20);
+
+	while (end - p >= 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)p);
+
+		/* In these 16 bytes, the loops below find where. */
+		if (vmaxvq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, quote),
+		    vceqq_u8(v, backslash)), vcltq_u8(v, space))) != 0)
+			break;
+
+		p += 16;
+	}
+#endif
+
+	while (end - p >= 8) {
+		uint64_t word;
+
+		memcpy(&word, p, 8);
+
+		if (HAS_ZERO(word ^ (ONES * '"')) |
+		    HAS_ZERO(word ^ (ONES * '\\')) | HAS_LESS(word, 0x20))
+			break;
+
+		p += 8;
+	}
+
+	for (; p < end; p++)
+		if (*p == '"' || *p == '\\' || (unsigned char)*p < 0x20)
+			return p;
+
+	return NULL;
+}
+
+/*
+ * Returns the first quote, bracket, brace or newline, looking at 16 bytes at a
+ * time with SIMD and then at a whole word at a time until one contains any of
+ * them. Setting bit 5 maps '[' to '{' and ']' to '}'.
+ */
+static const char *
+findStructural(const char *p, const char *end)
+{
+#if defined(USE_SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i openBrace = _mm_set1_epi8('{');
+	const __m128i closeBrace = _mm_set1_epi8('}');
+	const __m128i newline = _mm_set1_epi8('\n');
+	const __m128i bit5 = _mm_set1_epi8(0x20);
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+		__m128i folded = _mm_or_si128(v, bit5);
+		int mask = _mm_movemask_epi8(_mm_or_si128(
+		    _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+		    _mm_cmpeq_epi8(v, newline)),
+		    _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace),
+		    _mm_cmpeq_epi8(folded, closeBrace))));
+
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+
+		p += 16;
+	}
+#elif defined(USE_NEON)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t openBrace = vdupq_n_u8('{');
+	const uint8x16_t closeBrace = vdupq_n_u8('}');
+	const uint8x16_t newline = vdupq_n_u8('\n');
+	const uint8x16_t bit5 = vdupq_n_u8(0x20);
+
+	while (end - p >= 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)p);
+		uint8x16_t folded = vorrq_u8(v, bit5);
+
+		/* In these 16 bytes, the loops below find where. */
+		if (vmaxvq_u8(vorrq_u8(
+		    vorrq_u8(vceqq_u8(v, quote), vceqq_u8(v, newline)),
+		    vorrq_u8(vceqq_u8(folded, openBrace),
+		    vceqq_u8(folded, closeBrace)))) != 0)
+			break;
+
+		p += 16;
+	}
+#endif
+
+	while (end - p >= 8) {
+		uint64_t word, folded;
+
+		memcpy(&word, p, 8);
+		folded = word | (ONES * 0x20);
+
+		if (HAS_ZERO(word ^ (ONES * '"')) |
+		    HAS_ZERO(folded ^ (ONES * '{')) |
+		    HAS_ZERO(folded ^ (ONES * '}')) |
+		    HAS_ZERO(word ^ (ONES * '\n')))
+			break;
+
+		p += 8;
+	}
+
+	for (; p < end; p++)
+		if (*p == '"' || *p == '[' || *p == ']' || *p == '{' ||
+		    *p == '}' || *p == '\n')
+			return p;
+
+	return NULL;
+}
+
+static OF_INLINE bool
+isDigit(char c)
+{
+	return (c >= '0' && c <= '9');
+}
+
+static OF_INLINE bool
+isHexDigit(char c)
+{
+	return ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+	    (c >= 'A' && c <= 'F'));
+}
+
+static bool
+isValidNumber(const char *items, size_t length)
+{
+	size_t i = 0;
+
+	if (i < length && items[i] == '-')
+		i++;
+
+	if (i == length)
+		return false;
+
+	if (items[i] == '0')
+		i++;
+	else if (items[i] >= '1' && items[i] <= '9')
+		while (i < length && isDigit(items[i]))
+			i++;
+	else
+		return false;
+
+	if (i < length && items[i] == '.') {
+		if (++i == length || !isDigit(items[i]))
+			return false;
+
+		while (i < length && isDigit(items[i]))
+			i++;
+	}
+
+	if (i < length && (items[i] == 'e' || items[i] == 'E')) {
+		if (++i < length && (items[i] == '+' || items[i] == '-'))
+			i++;
+
+		if (i == length || !isDigit(items[i]))
+			return false;
+
+		while (i < length && isDigit(items[i]))
+			i++;
+	}
+
+	return (i == length);
+}
+
+static of_char16_t
+parseUnicodeEscape(const char *items)
+{
+	of_char16_t ret = 0;
+
+	for (uint8_t i = 0; i < 4; i++) {
+		char c = items[i];
+		ret <<= 4;
+
+		if (c >= '0' && c <= '9')
+			ret |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			ret |= c + 10 - 'a';
+		else
+			ret |= c + 10 - 'A';
+	}
+
+	return ret;
+}
+
+@implementation OFJSONReader
+@synthesize token = _token, line = _line, depthLimit = _depthLimit;
+@synthesize allowsMultipleValues = _allowsMultipleValues, range = _range;
+@synthesize hasEscapes = _hasEscapes;
+
++ (instancetype)readerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
++ (instancetype)readerWithData: (OFData *)data
+{
+	return [[[self alloc] initWithData: data] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)of_init
+{
+	self = [super init];
+
+	@try {
+		_containers = [[OFMutableData alloc] init];
+		_depthLimit = 32;
+		_line = 1;
+		_state = STATE_VALUE;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [self of_init];
+
+	@try {
+		_stream = [stream retain];
+		_storageSize = MIN_BUFFER_SIZE;
+		_storage = of_alloc(_storageSize, 1);
+		_buffer = _storage;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [self of_init];
+
+	@try {
+		if (data.itemSize != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		_data = [data copy];
+		_buffer = _data.items;
+		_bufferLength = _data.count;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_stream release];
+	[_data release];
+	free(_storage);
+	[_containers release];
+
+	[super dealloc];
+}
+
+- (size_t)depth
+{
+	return _containers.count;
+}
+
+- (void)of_compact
+{
+	if (_storage == NULL || _position == 0)
+		return;
+
+	memmove(_storage, _storage + _position, _bufferLength - _position);
+	_bufferLength -= _position;
+	_position = 0;
+}
+
+- (bool)of_readMore
+{
+	if (_stream == nil)
+		return false;
+
+	/*
+	 * This is only called when the rest of the buffer is not enough to
+	 * finish the current token, so the rest is short and everything before
+	 * the position can't be referenced anymore.
+	 */
+	[self of_compact];
+
+	if (_bufferLength == _storageSize) {
+		if (_storageSize > SIZE_MAX / 2)
+			@throw [OFOutOfRangeException exception];
+
+		_storage = of_realloc(_storage, _storageSize * 2, 1);
+		_storageSize *= 2;
+		_buffer = _storage;
+	}
+
+	while (!_stream.atEndOfStream) {
+		size_t length = [_stream
+		    readIntoBuffer: _storage + _bufferLength
+			    length: _storageSize - _bufferLength];
+
+		if (length > 0) {
+			_bufferLength += length;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static OF_INLINE int
+stateAfterValue(OFJSONReader *self)
+{
+	return (self->_containers.count > 0 ? STATE_COMMA : STATE_END);
+}
+
+- (bool)of_parseString: (const char *)start
+		   end: (const char *)end
+{
+	const char *p = start + 1;
+	bool hasEscapes = false;
+
+	for (;;) {
+		if ((p = findStringSpecial(p, end)) == NULL)
+			return false;
+
+		if (*p == '"')
+			break;
+
+		if (*p != '\\')
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		hasEscapes = true;
+
+		if (end - p < 2)
+			return false;
+
+		switch (p[1]) {
+		case '"':
+		case '\\':
+		case '/':
+		case 'b':
+		case 'f':
+		case 'n':
+		case 'r':
+		case 't':
+			p += 2;
+			break;
+		case 'u':
+			if (end - p < 6)
+				return false;
+
+			for (uint8_t i = 2; i < 6; i++)
+				if (!isHexDigit(p[i]))
+					@throw [OFInvalidJSONException
+					    exceptionWithString: nil
+							   line: _line];
+
+			p += 6;
+			break;
+		default:
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+		}
+	}
+
+	_range = makeRange(start + 1, p - start - 1);
+	_hasEscapes = hasEscapes;
+	_position = p + 1 - _buffer;
+
+	return true;
+}
+
+- (bool)of_parseValue: (of_json_reader_token_t *)token
+		atEnd: (bool)atEnd
+{
+	const char *start = _buffer + _position;
+	const char *end = _buffer + _bufferLength;
+	const char *literal = NULL, *p;
+	of_json_reader_token_t literalToken = OF_JSON_READER_TOKEN_NONE;
+	size_t literalLength;
+
+	switch (*start) {
+	case '{':
+	case '[':
+		if (_depthLimit > 0 && _containers.count >= _depthLimit)
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		[_containers addItem: start];
+		_position++;
+
+		if (*start == '{') {
+			_state = STATE_FIRST_KEY;
+			*token = OF_JSON_READER_TOKEN_BEGIN_OBJECT;
+		} else {
+			_state = STATE_FIRST_VALUE;
+			*token = OF_JSON_READER_TOKEN_BEGIN_ARRAY;
+		}
+
+		return true;
+	case '"':
+		if (![self of_parseString: start
+				      end: end])
+			return false;
+
+		_state = stateAfterValue(self);
+		*token = OF_JSON_READER_TOKEN_STRING;
+		return true;
+	case 't':
+		literal = "true";
+		literalToken = OF_JSON_READER_TOKEN_TRUE;
+		break;
+	case 'f':
+		literal = "false";
+		literalToken = OF_JSON_READER_TOKEN_FALSE;
+		break;
+	case 'n':
+		literal = "null";
+		literalToken = OF_JSON_READER_TOKEN_NULL;
+		break;
+	}
+
+	if (literal != NULL) {
+		literalLength = strlen(literal);
+
+		if ((size_t)(end - start) < literalLength) {
+			if (!atEnd)
+				return false;
+
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+		}
+
+		if (memcmp(start, literal, literalLength) != 0)
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		_range = makeRange(start, literalLength);
+		_position += literalLength;
+		_state = stateAfterValue(self);
+		*token = literalToken;
+		return true;
+	}
+
+	/* Everything else has to be a number. */
+	for (p = start; p < end; p++)
+		if (!isDigit(*p) && *p != '-' && *p != '+' && *p != '.' &&
+		    *p != 'e' && *p != 'E')
+			break;
+
+	if (p == end && !atEnd)
+		return false;
+
+	if (!isValidNumber(start, p - start))
+		@throw [OFInvalidJSONException exceptionWithString: nil
+							      line: _line];
+
+	_range = makeRange(start, p - start);
+	_position = p - _buffer;
+	_state = stateAfterValue(self);
+	*token = OF_JSON_READER_TOKEN_NUMBER;
+	return true;
+}
+
+- (void)of_endContainer: (char)character
+		  token: (of_json_reader_token_t *)token
+{
+	const char *open = _containers.lastItem;
+
+	if ((character == ']' && *open != '[') ||
+	    (character == '}' && *open != '{') ||
+	    (character != ']' && character != '}'))
+		@throw [OFInvalidJSONException exceptionWithString: nil
+							      line: _line];
+
+	[_containers removeLastItem];
+	_position++;
+	_state = stateAfterValue(self);
+	*token = (character == ']'
+	    ? OF_JSON_READER_TOKEN_END_ARRAY : OF_JSON_READER_TOKEN_END_OBJECT);
+}
+
+- (bool)of_parseToken: (of_json_reader_token_t *)token
+		atEnd: (bool)atEnd
+{
+	const char *p = _buffer + _position;
+	const char *end = _buffer + _bufferLength;
+
+	*token = OF_JSON_READER_TOKEN_NONE;
+
+	while (p < end &&
+	    (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+		if (*p == '\n')
+			_line++;
+
+		p++;
+	}
+
+	_position = p - _buffer;
+
+	if (p == end) {
+		if (!atEnd)
+			return false;
+
+		if (_state != STATE_END &&
+		    !(_allowsMultipleValues && _state == STATE_VALUE &&
+		    _containers.count == 0))
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		*token = OF_JSON_READER_TOKEN_END_OF_DOCUMENT;
+		return true;
+	}
+
+	switch (_state) {
+	case STATE_END:
+		if (!_allowsMultipleValues)
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		_state = STATE_VALUE;
+		return true;
+	case STATE_COLON:
+		if (*p != ':')
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		_position++;
+		_state = STATE_VALUE;
+		return true;
+	case STATE_COMMA:
+		if (*p == ',') {
+			const char *open = _containers.lastItem;
+
+			_position++;
+			_state = (*open == '{' ? STATE_KEY : STATE_VALUE);
+			return true;
+		}
+
+		[self of_endContainer: *p
+				token: token];
+		return true;
+	case STATE_FIRST_KEY:
+		if (*p == '}') {
+			[self of_endContainer: *p
+					token: token];
+			return true;
+		}
+		/* Fall through */
+	case STATE_KEY:
+		if (*p != '"')
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		if (![self of_parseString: p
+				      end: end])
+			return false;
+
+		_state = STATE_COLON;
+		*token = OF_JSON_READER_TOKEN_KEY;
+		return true;
+	case STATE_FIRST_VALUE:
+		if (*p == ']') {
+			[self of_endContainer: *p
+					token: token];
+			return true;
+		}
+		/* Fall through */
+	default:
+		return [self of_parseValue: token
+				     atEnd: atEnd];
+	}
+}
+
+- (of_json_reader_token_t)nextToken
+{
+	bool atEnd = false;
+
+	if (_token == OF_JSON_READER_TOKEN_END_OF_DOCUMENT)
+		return _token;
+
+	_range = makeRange(NULL, 0);
+	_hasEscapes = false;
+
+	for (;;) {
+		of_json_reader_token_t token;
+
+		if ([self of_parseToken: &token
+				  atEnd: atEnd]) {
+			if (token != OF_JSON_READER_TOKEN_NONE)
+				return (_token = token);
+
+			continue;
+		}
+
+		if (atEnd)
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+
+		if (![self of_readMore])
+			atEnd = true;
+	}
+}
+
+- (void)of_skipContainer
+{
+	size_t level = 1;
+	bool inString = false;
+
+	_range = makeRange(NULL, 0);
+	_hasEscapes = false;
+
+	for (;;) {
+		const char *p = _buffer + _position;
+		const char *end = _buffer + _bufferLength;
+
+		while (p < end) {
+			if (inString) {
+				if ((p = findStringSpecial(p, end)) == NULL) {
+					p = end;
+					break;
+				}
+
+				if (*p == '"') {
+					inString = false;
+					p++;
+				} else if (*p == '\\') {
+					/* Keep it for the next read. */
+					if (end - p < 2)
+						break;
+
+					p += 2;
+				} else
+					@throw [OFInvalidJSONException
+					    exceptionWithString: nil
+							   line: _line];
+
+				continue;
+			}
+
+			if ((p = findStructural(p, end)) == NULL) {
+				p = end;
+				break;
+			}
+
+			switch (*p) {
+			case '"':
+				inString = true;
+				break;
+			case '\n':
+				_line++;
+				break;
+			case '[':
+			case '{':
+				level++;
+				break;
+			default:
+				if (--level > 0)
+					break;
+
+				_position = p - _buffer;
+				[self of_endContainer: *p
+						token: &_token];
+				return;
+			}
+
+			p++;
+		}
+
+		_position = p - _buffer;
+
+		if (![self of_readMore])
+			@throw [OFInvalidJSONException
+			    exceptionWithString: nil
+					   line: _line];
+	}
+}
+
+- (void)skipValue
+{
+	if (_token == OF_JSON_READER_TOKEN_KEY)
+		[self nextToken];
+
+	if (_token == OF_JSON_READER_TOKEN_BEGIN_OBJECT ||
+	    _token == OF_JSON_READER_TOKEN_BEGIN_ARRAY)
+		[self of_skipContainer];
+}
+
+- (OFString *)stringValue
+{
+	const char *items = _range.items;
+	size_t length = _range.length;
+	char *buffer;
+	size_t i = 0;
+	OFString *ret;
+
+	if (length == 0)
+		return @"";
+
+	if (!_hasEscapes)
+		return [OFString stringWithUTF8String: items
+					       length: length];
+
+	buffer = of_alloc(length, 1);
+
+	@try {
+		for (size_t j = 0; j < length; j++) {
+			of_char16_t c1, c2;
+			of_unichar_t c;
+			size_t l;
+
+			if (items[j] != '\\') {
+				buffer[i++] = items[j];
+				continue;
+			}
+
+			switch (items[++j]) {
+			case 'b':
+				buffer[i++] = '\b';
+				break;
+			case 'f':
+				buffer[i++] = '\f';
+				break;
+			case 'n':
+				buffer[i++] = '\n';
+				break;
+			case 'r':
+				buffer[i++] = '\r';
+				break;
+			case 't':
+				buffer[i++] = '\t';
+				break;
+			case 'u':
+				c = c1 = parseUnicodeEscape(items + j + 1);
+				j += 4;
+
+				/* Low surrogate */
+				if ((c1 & 0xFC00) == 0xDC00)
+					@throw [OFInvalidJSONException
+					    exceptionWithString: nil
+							   line: _line];
+
+				/* High surrogate, needs the low surrogate */
+				if ((c1 & 0xFC00) == 0xD800) {
+					if (length - j < 7 ||
+					    items[j + 1] != '\\' ||
+					    items[j + 2] != 'u')
+						@throw [OFInvalidJSONException
+						    exceptionWithString: nil
+								   line: _line];
+
+					c2 = parseUnicodeEscape(items + j + 3);
+					if ((c2 & 0xFC00) != 0xDC00)
+						@throw [OFInvalidJSONException
+						    exceptionWithString: nil
+								   line: _line];
+
+					c = (((c1 & 0x3FF) << 10) |
+					    (c2 & 0x3FF)) + 0x10000;
+					j += 6;
+				}
+
+				l = of_string_utf8_encode(c, buffer + i);
+				if (l == 0)
+					@throw [OFInvalidJSONException
+					    exceptionWithString: nil
+							   line: _line];
+
+				i += l;
+				break;
+			default:
+				/* '"', '\\' and '/' */
+				buffer[i++] = items[j];
+				break;
+			}
+		}
+
+		ret = [OFString stringWithUTF8String: buffer
+					      length: i];
+	} @finally {
+		free(buffer);
+	}
+
+	return ret;
+}
+
+- (OFNumber *)numberValue
+{
+	OFString *string;
+
+	switch (_token) {
+	case OF_JSON_READER_TOKEN_TRUE:
+		return [OFNumber numberWithBool: true];
+	case OF_JSON_READER_TOKEN_FALSE:
+		return [OFNumber numberWithBool: false];
+	case OF_JSON_READER_TOKEN_NUMBER:
+		break;
+	default:
+		return nil;
+	}
+
+	string = self.stringValue;
+
+	if (memchr(_range.items, '.', _range.length) != NULL ||
+	    memchr(_range.items, 'e', _range.length) != NULL ||
+	    memchr(_range.items, 'E', _range.length) != NULL)
+		return [OFNumber numberWithDouble: string.doubleValue];
+
+	if (_range.items[0] == '-')
+		return [OFNumber numberWithLongLong:
+		    [string longLongValueWithBase: 10]];
+
+	return [OFNumber numberWithUnsignedLongLong:
+	    [string unsignedLongLongValueWithBase: 10]];
+}
+
+- (long long)longLongValue
+{
+	const char *items = _range.items;
+	size_t length = _range.length;
+	bool isNegative;
+	unsigned long long value = 0;
+
+	if (_token != OF_JSON_READER_TOKEN_NUMBER ||
+	    memchr(items, '.', length) != NULL ||
+	    memchr(items, 'e', length) != NULL ||
+	    memchr(items, 'E', length) != NULL)
+		return self.numberValue.longLongValue;
+
+	isNegative = (items[0] == '-');
+
+	for (size_t i = (isNegative ? 1 : 0); i < length; i++) {
+		if (value > (ULLONG_MAX - (items[i] - '0')) / 10)
+			@throw [OFOutOfRangeException exception];
+
+		value = value * 10 + (items[i] - '0');
+	}
+
+	if (isNegative) {
+		if (value > (unsigned long long)LLONG_MAX + 1)
+			@throw [OFOutOfRangeException exception];
+
+		return (long long)(0 - value);
+	}
+
+	if (value > LLONG_MAX)
+		@throw [OFOutOfRangeException exception];
+
+	return (long long)value;
+}
+
+- (id)readObject
+{
+	switch (_token) {
+	case OF_JSON_READER_TOKEN_KEY:
+		[self nextToken];
+		return [self readObject];
+	case OF_JSON_READER_TOKEN_STRING:
+		return self.stringValue;
+	case OF_JSON_READER_TOKEN_NUMBER:
+	case OF_JSON_READER_TOKEN_TRUE:
+	case OF_JSON_READER_TOKEN_FALSE:
+		return self.numberValue;
+	case OF_JSON_READER_TOKEN_NULL:
+		return [OFNull null];
+	case OF_JSON_READER_TOKEN_BEGIN_ARRAY:;
+		OFMutableArray *array = [OFMutableArray array];
+
+		while ([self nextToken] != OF_JSON_READER_TOKEN_END_ARRAY)
+			[array addObject: [self readObject]];
+
+		return array;
+	case OF_JSON_READER_TOKEN_BEGIN_OBJECT:;
+		OFMutableDictionary *dictionary =
+		    [OFMutableDictionary dictionary];
+
+		while ([self nextToken] != OF_JSON_READER_TOKEN_END_OBJECT) {
+			OFString *key = self.stringValue;
+
+			[self nextToken];
+			[dictionary setObject: [self readObject]
+				       forKey: key];
+		}
+
+		return dictionary;
+	default:
+		@throw [OFInvalidArgumentException exception];
+	}
+}
+@end
@@ -17,6 +17,7 @@
 
 #import "OFObject.h"
 
+@class OFJSONWriter;
 @class OFString;
 
 OF_ASSUME_NONNULL_BEGIN
@@ -57,6 +58,15 @@ enum {
  * @return The JSON representation of the object as a string
  */
 - (OFString *)JSONRepresentationWithOptions: (int)options;
+
+@optional
+/**
+ * @brief Writes the JSON representation of the object to the specified
+ *	  writer, using the writer's options.
+ *
+ * @param writer The writer to write the JSON representation to
+ */
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFObject.h"
+#import "OFJSONRepresentation.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFData;
+@class OFStream;
+@class OFString;
+
+/**
+ * @class OFJSONWriter OFJSONWriter.h ObjFW/OFJSONWriter.h
+ *
+ * @brief A writer that creates JSON incrementally.
+ *
+ * An OFJSONWriter either writes to an OFStream, in which case it only buffers
+ * a small amount of data before writing it to the stream, or into a buffer
+ * that can be retrieved using @ref data or @ref string and reused using
+ * @ref reset.
+ *
+ * Arrays and objects are written by calling @ref beginArray or
+ * @ref beginObject, writing the values (and for objects, a key using
+ * @ref writeKey: before each value) and then calling @ref endArray or
+ * @ref endObject. OFArray, OFDictionary, OFNumber, OFString and OFNull write
+ * themselves into the writer when passed to @ref writeObject:, without
+ * creating intermediate strings.
+ *
+ * Only a single value can be written, unless @ref reset is called after it.
+ * Calling the methods in an order that would result in invalid JSON throws an
+ * OFInvalidArgumentException.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFJSONWriter: OFObject
+{
+	OFStream *_Nullable _stream;
+	char *_buffer;
+	size_t _bufferLength, _bufferSize;
+	int _options;
+	struct of_json_writer_container *_Nullable _containers;
+	size_t _containersCount, _containersSize;
+	bool _wroteKey, _wroteValue;
+}
+
+/**
+ * @brief The stream the writer writes to, or nil if it writes into a buffer.
+ */
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFStream *stream;
+
+/**
+ * @brief The options to use, see
+ *	  @ref OFJSONRepresentation::JSONRepresentationWithOptions:.
+ *
+ * Changing the options while writing a value results in a mix of both styles.
+ */
+@property (nonatomic) int options;
+
+/**
+ * @brief The number of arrays and objects that are currently open.
+ */
+@property (readonly, nonatomic) size_t depth;
+
+/**
+ * @brief The data that has been written into the buffer.
+ *
+ * If the writer writes to a stream, this is the data that has not been
+ * written to the stream yet.
+ */
+@property (readonly, nonatomic) OFData *data;
+
+/**
+ * @brief The data that has been written into the buffer as a string.
+ *
+ * If the writer writes to a stream, this is the data that has not been
+ * written to the stream yet.
+ */
+@property (readonly, nonatomic) OFString *string;
+
+/**
+ * @brief Creates a new JSON writer that writes into a buffer.
+ *
+ * @return A new, autoreleased OFJSONWriter
+ */
++ (instancetype)writer;
+
+/**
+ * @brief Creates a new JSON writer that writes to the specified stream.
+ *
+ * @param stream The stream to write the JSON to
+ * @return A new, autoreleased OFJSONWriter
+ */
++ (instancetype)writerWithStream: (OFStream *)stream;
+
+/**
+ * @brief Initializes an already allocated JSON writer to write into a buffer.
+ *
+ * @return An initialized OFJSONWriter
+ */
+- (instancetype)init;
+
+/**
+ * @brief Initializes an already allocated JSON writer to write to the
+ *	  specified stream.
+ *
+ * @param stream The stream to write the JSON to
+ * @return An initialized OFJSONWriter
+ */
+- (instancetype)initWithStream: (nullable OFStream *)stream
+    OF_DESIGNATED_INITIALIZER;
+
+/**
+ * @brief Starts an array.
+ */
+- (void)beginArray;
+
+/**
+ * @brief Ends the current array.
+ */
+- (void)endArray;
+
+/**
+ * @brief Starts an object.
+ */
+- (void)beginObject;
+
+/**
+ * @brief Ends the current object.
+ */
+- (void)endObject;
+
+/**
+ * @brief Writes the key for the next value of the current object.
+ *
+ * @param key The key to write
+ */
+- (void)writeKey: (OFString *)key;
+
+/**
+ * @brief Writes the specified string.
+ *
+ * @param string The string to write
+ */
+- (void)writeString: (OFString *)string;
+
+/**
+ * @brief Writes the specified UTF-8 string without creating an OFString.
+ *
+ * @param UTF8String The UTF-8 string to write
+ * @param length The length of the UTF-8 string in bytes
+ */
+- (void)writeUTF8String: (const char *)UTF8String
+		 length: (size_t)length;
+
+/**
+ * @brief Writes the specified integer.
+ *
+ * @param value The integer to write
+ */
+- (void)writeLongLong: (long long)value;
+
+/**
+ * @brief Writes the specified unsigned integer.
+ *
+ * @param value The unsigned integer to write
+ */
+- (void)writeUnsignedLongLong: (unsigned long long)value;
+
+/**
+ * @brief Writes the specified double.
+ *
+ * @param value The double to write. Infinity is only allowed for JSON5.
+ */
+- (void)writeDouble: (double)value;
+
+/**
+ * @brief Writes the specified boolean.
+ *
+ * @param value The boolean to write
+ */
+- (void)writeBool: (bool)value;
+
+/**
+ * @brief Writes null.
+ */
+- (void)writeNull;
+
+/**
+ * @brief Writes the specified object.
+ *
+ * Objects that do not implement
+ * @ref OFJSONRepresentation::writeJSONRepresentationToWriter: are written
+ * using their @ref OFJSONRepresentation::JSONRepresentationWithOptions:.
+ *
+ * @param object The object to write
+ */
+- (void)writeObject: (id <OFJSONRepresentation>)object;
+
+/**
+ * @brief Writes everything that is still buffered to the stream.
+ *
+ * This happens automatically once a complete value has been written and does
+ * nothing if the writer writes into a buffer.
+ */
+- (void)flush;
+
+/**
+ * @brief Discards everything in the buffer and all open arrays and objects,
+ *	  keeping the allocated memory for reuse.
+ */
+- (void)reset;
+@end
+
+OF_ASSUME_NONNULL_END
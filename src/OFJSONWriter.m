@@ -0,0 +1,659 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#import "OFJSONWriter.h"
+#import "OFData.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFOutOfRangeException.h"
+
+#if defined(__SSE2__) && (defined(OF_X86_64) || defined(OF_X86))
+# include <emmintrin.h>
+# define USE_SSE2
+#elif defined(__ARM_NEON) && defined(OF_ARM64)
+# include <arm_neon.h>
+# define USE_NEON
+#endif
+
+/* The amount of data buffered before it is written to the stream. */
+#define STREAM_BUFFER_SIZE 16384
+#define MIN_BUFFER_SIZE 256
+/* Strings shorter than this are copied to the stack instead. */
+#define SHORT_STRING_SIZE 64
+
+#define ONES UINT64_C(0x0101010101010101)
+#define HIGH_BITS UINT64_C(0x8080808080808080)
+/* Non-zero if any byte of x is zero. */
+#define HAS_ZERO(x) (((x) - ONES) & ~(x) & HIGH_BITS)
+/* Non-zero if any byte of x is less than n, for n <= 128. */
+#define HAS_LESS(x, n) (((x) - ONES * (n)) & ~(x) & HIGH_BITS)
+
+struct of_json_writer_container {
+	bool isObject;
+	size_t count;
+};
+
+static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+static const char hexDigits[] = "0123456789abcdef";
+
+@interface OFJSONWriter ()
+- (void)of_appendSlow: (const char *)bytes
+	       length: (size_t)length;
+- (void)of_writeIndentation: (size_t)depth;
+- (void)of_beginValue;
+- (void)of_endValue;
+- (void)of_beginContainer: (bool)isObject;
+- (void)of_endContainer: (bool)isObject;
+- (void)of_writeString: (const char *)UTF8String
+		length: (size_t)length
+	    identifier: (bool)identifier;
+- (void)of_writeOFString: (OFString *)string
+	      identifier: (bool)identifier;
+- (void)of_writeRaw: (const char *)bytes
+	     length: (size_t)length;
+@end
+
+/*
+ * Returns the first byte that needs to be escaped, looking at 16 bytes at a
+ * time with SIMD and then at a whole word at a time until one contains any.
+ */
+static const char *
+findSpecial(const char *p, const char *end)
+{
+#if defined(USE_SSE2)
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i control = _mm_set1_epi8(0x1F);
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(const void *)p);
+		/* Unsigned v <= 0x1F if max(v, 0x1F) is 0x1F. */
+		int mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+		    _mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)),
+		    _mm_cmpeq_epi8(_mm_max_epu8(v, control), control)));
+
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+
+		p += 16;
+	}
+#elif defined(USE_NEON)
+	const uint8x16_t quote = vdupq_n_u8('"');
+	const uint8x16_t backslash = vdupq_n_u8('\\');
+	const uint8x16_t space = vdupq_n_u8(0x20);
+
+	while (end - p >= 16) {
+		uint8x16_t v = vld1q_u8((const uint8_t *)p);
+
+		/* In these 16 bytes, the loops below find where. */
+		if (vmaxvq_u8(vorrq_u8(vorrq_u8(vceqq_u8(v, quote),
+		    vceqq_u8(v, backslash)), vcltq_u8(v, space))) != 0)
+			break;
+
+		p += 16;
+	}
+#endif
+
+	while (end - p >= 8) {
+		uint64_t word;
+
+		memcpy(&word, p, 8);
+
+		if (HAS_ZERO(word ^ (ONES * '"')) |
+		    HAS_ZERO(word ^ (ONES * '\\')) | HAS_LESS(word, 0x20))
+			break;
+
+		p += 8;
+	}
+
+	for (; p < end; p++)
+		if (*p == '"' || *p == '\\' || (unsigned char)*p < 0x20)
+			return p;
+
+	return end;
+}
+
+/* The rules -[OFString JSONRepresentationWithOptions:] used for JSON5 keys. */
+static bool
+isIdentifier(const char *UTF8String, size_t length)
+{
+	if (length == 0)
+		return false;
+
+	if (!of_ascii_isalpha(UTF8String[0]) && UTF8String[0] != '_' &&
+	    UTF8String[0] != '$')
+		return false;
+
+	for (size_t i = 0; i < length; i++) {
+		switch (UTF8String[i]) {
+		case '\0':
+		case ' ':
+		case '\n':
+		case '\r':
+		case '\t':
+		case '\b':
+		case '\f':
+		case '\\':
+		case '"':
+		case '\'':
+			return false;
+		}
+	}
+
+	return true;
+}
+
+@implementation OFJSONWriter
+@synthesize stream = _stream, options = _options;
+
+static OF_INLINE void
+append(OFJSONWriter *self, const char *bytes, size_t length)
+{
+	if OF_UNLIKELY (self->_bufferSize - self->_bufferLength < length) {
+		[self of_appendSlow: bytes
+			     length: length];
+		return;
+	}
+
+	memcpy(self->_buffer + self->_bufferLength, bytes, length);
+	self->_bufferLength += length;
+}
+
++ (instancetype)writer
+{
+	return [[[self alloc] init] autorelease];
+}
+
++ (instancetype)writerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
+- (instancetype)init
+{
+	return [self initWithStream: nil];
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [super init];
+
+	@try {
+		_stream = [stream retain];
+		_bufferSize = (stream != nil ? STREAM_BUFFER_SIZE
+		    : MIN_BUFFER_SIZE);
+		_buffer = of_alloc(_bufferSize, 1);
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_stream release];
+	free(_buffer);
+	free(_containers);
+
+	[super dealloc];
+}
+
+- (size_t)depth
+{
+	return _containersCount;
+}
+
+- (OFData *)data
+{
+	return [OFData dataWithItems: _buffer
+			       count: _bufferLength];
+}
+
+- (OFString *)string
+{
+	return [OFString stringWithUTF8String: _buffer
+				       length: _bufferLength];
+}
+
+- (void)of_appendSlow: (const char *)bytes
+	       length: (size_t)length
+{
+	if (_stream != nil) {
+		[self flush];
+
+		if (length > _bufferSize) {
+			[_stream writeBuffer: bytes
+				      length: length];
+			return;
+		}
+	} else {
+		size_t size = _bufferSize;
+
+		if (SIZE_MAX - _bufferLength < length)
+			@throw [OFOutOfRangeException exception];
+
+		while (size - _bufferLength < length)
+			size = (size <= SIZE_MAX / 2
+			    ? size * 2 : _bufferLength + length);
+
+		_buffer = of_realloc(_buffer, size, 1);
+		_bufferSize = size;
+	}
+
+	memcpy(_buffer + _bufferLength, bytes, length);
+	_bufferLength += length;
+}
+
+- (void)of_writeIndentation: (size_t)depth
+{
+	while (depth > 0) {
+		size_t length = (depth < sizeof(tabs) - 1
+		    ? depth : sizeof(tabs) - 1);
+
+		append(self, tabs, length);
+		depth -= length;
+	}
+}
+
+- (void)of_beginValue
+{
+	struct of_json_writer_container *container;
+
+	if (_containersCount == 0) {
+		if (_wroteValue)
+			@throw [OFInvalidArgumentException exception];
+
+		_wroteValue = true;
+		return;
+	}
+
+	container = &_containers[_containersCount - 1];
+
+	if (container->isObject) {
+		if (!_wroteKey)
+			@throw [OFInvalidArgumentException exception];
+
+		_wroteKey = false;
+		return;
+	}
+
+	if (container->count++ > 0)
+		append(self, ",", 1);
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY) {
+		append(self, "\n", 1);
+		[self of_writeIndentation: _containersCount];
+	}
+}
+
+- (void)of_endValue
+{
+	if (_containersCount == 0)
+		[self flush];
+}
+
+- (void)of_beginContainer: (bool)isObject
+{
+	[self of_beginValue];
+
+	if (_containersCount == _containersSize) {
+		size_t size = (_containersSize > 0 ? _containersSize * 2 : 8);
+
+		_containers = of_realloc(_containers, size,
+		    sizeof(*_containers));
+		_containersSize = size;
+	}
+
+	_containers[_containersCount].isObject = isObject;
+	_containers[_containersCount].count = 0;
+	_containersCount++;
+
+	append(self, (isObject ? "{" : "["), 1);
+}
+
+- (void)of_endContainer: (bool)isObject
+{
+	struct of_json_writer_container *container;
+
+	if (_containersCount == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	container = &_containers[_containersCount - 1];
+	if (container->isObject != isObject || _wroteKey)
+		@throw [OFInvalidArgumentException exception];
+
+	_containersCount--;
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY) {
+		append(self, "\n", 1);
+		[self of_writeIndentation: _containersCount];
+	}
+
+	append(self, (isObject ? "}" : "]"), 1);
+
+	[self of_endValue];
+}
+
+- (void)beginArray
+{
+	[self of_beginContainer: false];
+}
+
+- (void)endArray
+{
+	[self of_endContainer: false];
+}
+
+- (void)beginObject
+{
+	[self of_beginContainer: true];
+}
+
+- (void)endObject
+{
+	[self of_endContainer: true];
+}
+
+- (void)of_writeString: (const char *)UTF8String
+		length: (size_t)length
+	    identifier: (bool)identifier
+{
+	const char *p = UTF8String, *end = UTF8String + length;
+	bool quoted = !(identifier && (_options & OF_JSON_REPRESENTATION_JSON5)
+	    && isIdentifier(UTF8String, length));
+
+	if (quoted)
+		append(self, "\"", 1);
+
+	for (;;) {
+		const char *special = findSpecial(p, end);
+		char escape[6];
+
+		append(self, p, special - p);
+
+		if (special == end)
+			break;
+
+		escape[0] = '\\';
+
+		switch (*special) {
+		case '"':
+		case '\\':
+			escape[1] = *special;
+			break;
+		case '\b':
+			escape[1] = 'b';
+			break;
+		case '\f':
+			escape[1] = 'f';
+			break;
+		case '\r':
+			escape[1] = 'r';
+			break;
+		case '\t':
+			escape[1] = 't';
+			break;
+		case '\n':
+			escape[1] = (_options & OF_JSON_REPRESENTATION_JSON5
+			    ? '\n' : 'n');
+			break;
+		default:
+			escape[1] = 'u';
+			escape[2] = '0';
+			escape[3] = '0';
+			escape[4] = hexDigits[(unsigned char)*special >> 4];
+			escape[5] = hexDigits[*special & 0xF];
+			break;
+		}
+
+		append(self, escape, (escape[1] == 'u' ? 6 : 2));
+		p = special + 1;
+	}
+
+	if (quoted)
+		append(self, "\"", 1);
+}
+
+- (void)writeKey: (OFString *)key
+{
+	struct of_json_writer_container *container;
+
+	if (_containersCount == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	container = &_containers[_containersCount - 1];
+	if (!container->isObject || _wroteKey)
+		@throw [OFInvalidArgumentException exception];
+
+	if (container->count++ > 0)
+		append(self, ",", 1);
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY) {
+		append(self, "\n", 1);
+		[self of_writeIndentation: _containersCount];
+	}
+
+	[self of_writeOFString: key
+		    identifier: true];
+
+	if (_options & OF_JSON_REPRESENTATION_PRETTY)
+		append(self, ": ", 2);
+	else
+		append(self, ":", 1);
+
+	_wroteKey = true;
+}
+
+- (void)of_writeOFString: (OFString *)string
+	      identifier: (bool)identifier
+{
+	size_t length = string.UTF8StringLength;
+	void *pool;
+
+	/* Avoids creating a C string for strings that do not store one. */
+	if (length < SHORT_STRING_SIZE) {
+		char buffer[SHORT_STRING_SIZE];
+
+		[string getCString: buffer
+			 maxLength: SHORT_STRING_SIZE
+			  encoding: OF_STRING_ENCODING_UTF_8];
+		[self of_writeString: buffer
+			      length: length
+			  identifier: identifier];
+
+		return;
+	}
+
+	pool = objc_autoreleasePoolPush();
+
+	[self of_writeString: string.UTF8String
+		      length: length
+		  identifier: identifier];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)writeString: (OFString *)string
+{
+	[self of_beginValue];
+	[self of_writeOFString: string
+		    identifier: false];
+	[self of_endValue];
+}
+
+- (void)writeUTF8String: (const char *)UTF8String
+		 length: (size_t)length
+{
+	[self of_beginValue];
+	[self of_writeString: UTF8String
+		      length: length
+		  identifier: false];
+	[self of_endValue];
+}
+
+- (void)of_writeRaw: (const char *)bytes
+	     length: (size_t)length
+{
+	[self of_beginValue];
+	append(self, bytes, length);
+	[self of_endValue];
+}
+
+- (void)writeLongLong: (long long)value
+{
+	char buffer[24], *p = buffer + sizeof(buffer);
+	unsigned long long tmp = (value < 0
+	    ? -(unsigned long long)value : (unsigned long long)value);
+
+	do {
+		*--p = '0' + tmp % 10;
+		tmp /= 10;
+	} while (tmp > 0);
+
+	if (value < 0)
+		*--p = '-';
+
+	[self of_writeRaw: p
+		   length: buffer + sizeof(buffer) - p];
+}
+
+- (void)writeUnsignedLongLong: (unsigned long long)value
+{
+	char buffer[24], *p = buffer + sizeof(buffer);
+
+	do {
+		*--p = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	[self of_writeRaw: p
+		   length: buffer + sizeof(buffer) - p];
+}
+
+- (void)writeDouble: (double)value
+{
+	char buffer[32];
+	int length;
+	size_t j;
+
+	if (isinf(value) || isnan(value)) {
+		if (!(_options & OF_JSON_REPRESENTATION_JSON5))
+			@throw [OFInvalidArgumentException exception];
+
+		if (isnan(value))
+			[self of_writeRaw: "NaN"
+				   length: 3];
+		else if (value > 0)
+			[self of_writeRaw: "Infinity"
+				   length: 8];
+		else
+			[self of_writeRaw: "-Infinity"
+				   length: 9];
+
+		return;
+	}
+
+	length = snprintf(buffer, sizeof(buffer), "%g", value);
+	if (length < 0 || (size_t)length >= sizeof(buffer))
+		@throw [OFOutOfRangeException exception];
+
+	/*
+	 * snprintf() uses the locale's decimal point, which can be more than
+	 * one byte. Everything else %g prints for a finite number is a digit,
+	 * a sign or an exponent.
+	 */
+	j = 0;
+	for (int i = 0; i < length; i++) {
+		char c = buffer[i];
+
+		if (of_ascii_isdigit(c) || c == '-' || c == '+' || c == 'e')
+			buffer[j++] = c;
+		else if (j == 0 || buffer[j - 1] != '.')
+			buffer[j++] = '.';
+	}
+
+	[self of_writeRaw: buffer
+		   length: j];
+}
+
+- (void)writeBool: (bool)value
+{
+	if (value)
+		[self of_writeRaw: "true"
+			   length: 4];
+	else
+		[self of_writeRaw: "false"
+			   length: 5];
+}
+
+- (void)writeNull
+{
+	[self of_writeRaw: "null"
+		   length: 4];
+}
+
+- (void)writeObject: (id <OFJSONRepresentation>)object
+{
+	void *pool;
+	OFString *JSON;
+
+	if (object == nil)
+		@throw [OFInvalidArgumentException exception];
+
+	if ([(id)object respondsToSelector:
+	    @selector(writeJSONRepresentationToWriter:)]) {
+		[object writeJSONRepresentationToWriter: self];
+		return;
+	}
+
+	pool = objc_autoreleasePoolPush();
+
+	JSON = [object JSONRepresentationWithOptions: _options];
+	[self of_writeRaw: JSON.UTF8String
+		   length: JSON.UTF8StringLength];
+
+	objc_autoreleasePoolPop(pool);
+}
+
+- (void)flush
+{
+	if (_stream == nil || _bufferLength == 0)
+		return;
+
+	[_stream writeBuffer: _buffer
+		      length: _bufferLength];
+	_bufferLength = 0;
+}
+
+- (void)reset
+{
+	_bufferLength = 0;
+	_containersCount = 0;
+	_wroteKey = false;
+	_wroteValue = false;
+}
+@end
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFKernelEventObserver.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+@class OFStream;
+
+OF_DIRECT_MEMBERS
+@interface OFKernelEventObserver ()
+/*
+ * Called by a stream observed for reading when data was added to its read
+ * buffer, so that only streams with buffered data need to be checked.
+ */
+- (void)of_streamDidFillReadBuffer: (OFStream *)stream;
+@end
+
+@interface OFKernelEventObserver ()
+/*
+ * Called by a stream socket when a read returned less than requested, which
+ * means that there is no more data to read for now.
+ */
+- (void)of_objectDidDrainForReading: (id)object;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -30,6 +30,7 @@ OF_ASSUME_NONNULL_BEGIN
 
 @class OFMutableArray OF_GENERIC(ObjectType);
 @class OFDate;
+@class OFStream;
 #ifdef OF_HAVE_THREADS
 @class OFMutex;
 #endif
@@ -123,6 +124,9 @@ OF_ASSUME_NONNULL_BEGIN
 	    *_readObjects;
 	OFMutableArray OF_GENERIC(id <OFReadyForWritingObserving>)
 	    *_writeObjects;
+	OFMutableArray OF_GENERIC(OFStream *) *_readBufferStreams;
+	OFMutableArray OF_GENERIC(OFStream *) *_processedReadBufferStreams;
+	OFMutableArray OF_GENERIC(OFStream *) *_polledReadBufferStreams;
 	id <OFKernelEventObserverDelegate> _Nullable _delegate;
 #if defined(OF_AMIGAOS)
 	struct Task *_waitingTask;
@@ -136,6 +140,7 @@ OF_ASSUME_NONNULL_BEGIN
 #ifdef OF_AMIGAOS
 	ULONG _execSignalMask;
 #endif
+	size_t _maximumEventsPerObserve;
 	OF_RESERVE_IVARS(OFKernelEventObserver, 4)
 }
 
@@ -145,6 +150,42 @@ OF_ASSUME_NONNULL_BEGIN
 @property OF_NULLABLE_PROPERTY (assign, nonatomic)
     id <OFKernelEventObserverDelegate> delegate;
 
+/**
+ * @brief The maximum number of events to retrieve from the kernel in one
+ *	  observe call, or 0 for the default.
+ *
+ * A lower value makes the observer return to the run loop more often, e.g. to
+ * handle timers, while a higher value reduces the number of system calls if
+ * there are many active connections.
+ *
+ * @note This is only used by back ends which retrieve events in batches
+ *	 (currently epoll).
+ */
+@property (nonatomic) size_t maximumEventsPerObserve;
+
+/**
+ * @brief Whether file descriptors are registered with the kernel only once
+ *	  for both reading and writing using edge triggering.
+ *
+ * The observer then keeps track of which file descriptors are ready itself,
+ * which means that adding and removing objects, e.g. for each asynchronous
+ * read or write, does not need a system call.
+ *
+ * This only affects objects added afterwards. Back ends that do not support
+ * edge triggering ignore this, in which case it is always false.
+ */
+@property (nonatomic) bool usesEdgeTriggering;
+
+/**
+ * @brief Whether listening sockets are observed in a way that only one
+ *	  observer is woken up if the same listening socket is observed by
+ *	  several observers, e.g. one per thread.
+ *
+ * This only affects objects added afterwards. Back ends that do not support
+ * this ignore it, in which case it is always false.
+ */
+@property (nonatomic) bool observesListeningSocketsExclusively;
+
 #ifdef OF_AMIGAOS
 /**
  * @brief A mask of Exec Signals to wait for.
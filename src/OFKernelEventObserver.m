@@ -22,6 +22,7 @@
 #include <errno.h>
 
 #import "OFKernelEventObserver.h"
+#import "OFKernelEventObserver+Private.h"
 #import "OFArray.h"
 #import "OFData.h"
 #import "OFDate.h"
@@ -63,8 +64,11 @@ enum {
 };
 #define QUEUE_ACTION (QUEUE_ADD | QUEUE_REMOVE)
 
+static IMP hasDataInReadBufferIMP;
+
 @implementation OFKernelEventObserver
 @synthesize delegate = _delegate;
+@synthesize maximumEventsPerObserve = _maximumEventsPerObserve;
 #ifdef OF_AMIGAOS
 @synthesize execSignalMask = _execSignalMask;
 #endif
@@ -74,6 +78,9 @@ enum {
 	if (self != [OFKernelEventObserver class])
 		return;
 
+	hasDataInReadBufferIMP = [OFStream
+	    instanceMethodForSelector: @selector(hasDataInReadBuffer)];
+
 	if (!of_socket_init())
 		@throw [OFInitializationFailedException
 		    exceptionWithClass: self];
@@ -114,6 +121,9 @@ enum {
 
 		_readObjects = [[OFMutableArray alloc] init];
 		_writeObjects = [[OFMutableArray alloc] init];
+		_readBufferStreams = [[OFMutableArray alloc] init];
+		_processedReadBufferStreams = [[OFMutableArray alloc] init];
+		_polledReadBufferStreams = [[OFMutableArray alloc] init];
 
 #if defined(OF_HAVE_PIPE) && !defined(OF_AMIGAOS)
 		if (pipe(_cancelFD))
@@ -186,8 +196,16 @@ enum {
 		closesocket(_cancelFD[1]);
 #endif
 
+	for (id object in _readObjects)
+		if ([object isKindOfClass: [OFStream class]] &&
+		    [object of_readBufferObserver] == self)
+			[object of_setReadBufferObserver: nil];
+
 	[_readObjects release];
 	[_writeObjects release];
+	[_readBufferStreams release];
+	[_processedReadBufferStreams release];
+	[_polledReadBufferStreams release];
 
 	[super dealloc];
 }
@@ -195,6 +213,32 @@ enum {
 - (void)addObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	[_readObjects addObject: object];
+
+	if ([object isKindOfClass: [OFStream class]]) {
+		OFStream *stream = (OFStream *)object;
+
+		/*
+		 * Streams tell us when their read buffer is filled, unless a
+		 * subclass has data buffered elsewhere, which we then need to
+		 * poll for.
+		 */
+		if (stream.of_readBufferObserver == self)
+			return;
+
+		if (stream.of_readBufferObserver == nil &&
+		    [stream methodForSelector: @selector(hasDataInReadBuffer)]
+		    == hasDataInReadBufferIMP) {
+			/*
+			 * A stream that was moved here from another observer
+			 * might still be pending there, where it is skipped
+			 * now, so it needs to be queued here instead.
+			 */
+			stream.of_readBufferObserver = self;
+			stream.of_readBufferPending = false;
+			[stream of_readBufferDidFill];
+		} else
+			[_polledReadBufferStreams addObject: stream];
+	}
 }
 
 - (void)addObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -205,6 +249,21 @@ enum {
 - (void)removeObjectForReading: (id <OFReadyForReadingObserving>)object
 {
 	[_readObjects removeObjectIdenticalTo: object];
+
+	if ([object isKindOfClass: [OFStream class]]) {
+		OFStream *stream = (OFStream *)object;
+
+		/*
+		 * Pending streams are skipped by of_processReadBuffers once
+		 * they are no longer observed, and queued again by the next
+		 * observer they are added to.
+		 */
+		if (stream.of_readBufferObserver == self)
+			stream.of_readBufferObserver = nil;
+		else
+			[_polledReadBufferStreams
+			    removeObjectIdenticalTo: stream];
+	}
 }
 
 - (void)removeObjectForWriting: (id <OFReadyForWritingObserving>)object
@@ -212,20 +271,108 @@ enum {
 	[_writeObjects removeObjectIdenticalTo: object];
 }
 
+- (bool)usesEdgeTriggering
+{
+	return false;
+}
+
+- (void)setUsesEdgeTriggering: (bool)usesEdgeTriggering
+{
+}
+
+- (bool)observesListeningSocketsExclusively
+{
+	return false;
+}
+
+- (void)setObservesListeningSocketsExclusively: (bool)exclusively
+{
+}
+
+- (void)of_objectDidDrainForReading: (id)object
+{
+}
+
+- (void)of_streamDidFillReadBuffer: (OFStream *)stream
+{
+	[_readBufferStreams addObject: stream];
+}
+
 - (bool)of_processReadBuffers
 {
-	void *pool = objc_autoreleasePoolPush();
+	void *pool;
+	OFMutableArray OF_GENERIC(OFStream *) *streams;
+	size_t i = 0, count;
 	bool foundInReadBuffer = false;
 
-	for (id object in [[_readObjects copy] autorelease]) {
+	if (_readBufferStreams.count == 0 &&
+	    _polledReadBufferStreams.count == 0)
+		return false;
+
+	pool = objc_autoreleasePoolPush();
+
+	/*
+	 * Only visit the streams that got data in their read buffer. Streams
+	 * that get more data while being handled are added to the other array
+	 * again and will be visited on the next call.
+	 */
+	streams = _readBufferStreams;
+	_readBufferStreams = _processedReadBufferStreams;
+	_processedReadBufferStreams = streams;
+	count = streams.count;
+
+	@try {
+		for (; i < count; i++) {
+			OFStream *stream = [streams objectAtIndex: i];
+			void *pool2;
+
+			/* The stream might be pending in another observer. */
+			if (stream.of_readBufferObserver != self)
+				continue;
+
+			stream.of_readBufferPending = false;
+
+			if (!stream.hasDataInReadBuffer ||
+			    stream.of_waitingForDelimiter)
+				continue;
+
+			pool2 = objc_autoreleasePoolPush();
+
+			if ([_delegate respondsToSelector:
+			    @selector(objectIsReadyForReading:)])
+				[_delegate objectIsReadyForReading: stream];
+
+			foundInReadBuffer = true;
+
+			/* Keep it if the handler did not drain the buffer. */
+			[stream of_readBufferDidFill];
+
+			objc_autoreleasePoolPop(pool2);
+		}
+	} @finally {
+		/* If a handler threw, requeue the streams not handled yet. */
+		for (; i < count; i++) {
+			OFStream *stream = [streams objectAtIndex: i];
+
+			if (stream.of_readBufferObserver != self)
+				continue;
+
+			stream.of_readBufferPending = false;
+			[stream of_readBufferDidFill];
+		}
+
+		[streams removeAllObjects];
+	}
+
+	for (OFStream *stream in
+	    [[_polledReadBufferStreams copy] autorelease]) {
 		void *pool2 = objc_autoreleasePoolPush();
 
-		if ([object isKindOfClass: [OFStream class]] &&
-		    [object hasDataInReadBuffer] &&
-		    ![(OFStream *)object of_isWaitingForDelimiter]) {
+		if (stream.hasDataInReadBuffer &&
+		    !stream.of_waitingForDelimiter) {
 			if ([_delegate respondsToSelector:
 			    @selector(objectIsReadyForReading:)])
-				[_delegate objectIsReadyForReading: object];
+				[_delegate objectIsReadyForReading: stream];
 
 			foundInReadBuffer = true;
 		}
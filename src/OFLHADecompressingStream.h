@@ -29,15 +29,14 @@ OF_DIRECT_MEMBERS
 	unsigned char _buffer[OF_LHA_DECOMPRESSING_STREAM_BUFFER_SIZE];
 	uint32_t _bytesConsumed;
 	uint16_t _bufferIndex, _bufferLength;
-	uint8_t _byte;
-	uint8_t _bitIndex, _savedBitsLength;
-	uint16_t _savedBits;
+	uint64_t _bits;
+	uint8_t _bitsLength;
 	unsigned char *_slidingWindow;
 	uint32_t _slidingWindowIndex, _slidingWindowMask;
 	int _state;
 	uint16_t _symbolsLeft;
 	struct of_huffman_tree *_Nullable _codeLenTree, *_Nullable _litLenTree;
-	struct of_huffman_tree *_Nullable _distTree, *_Nullable _treeIter;
+	struct of_huffman_tree *_Nullable _distTree;
 	uint16_t _codesCount, _codesReceived;
 	bool _currentIsExtendedLength, _skip;
 	uint8_t *_Nullable _codesLengths;
@@ -17,7 +17,7 @@
 
 #include "config.h"
 
-#include <assert.h>
+#include <string.h>
 
 #import "OFLHADecompressingStream.h"
 #import "OFKernelEventObserver.h"
@@ -47,53 +47,147 @@ enum state {
 @implementation OFLHADecompressingStream
 @synthesize bytesConsumed = _bytesConsumed;
 
+/*
+ * LHA stores bits starting with the most significant bit of each byte, while
+ * the Huffman decoder expects them starting with the least significant one. So
+ * the bits of each byte are reversed when loading them.
+ */
+static OF_INLINE uint64_t
+reverseBitsInBytes(uint64_t word)
+{
+	word = ((word >> 1) & UINT64_C(0x5555555555555555)) |
+	    ((word & UINT64_C(0x5555555555555555)) << 1);
+	word = ((word >> 2) & UINT64_C(0x3333333333333333)) |
+	    ((word & UINT64_C(0x3333333333333333)) << 2);
+	word = ((word >> 4) & UINT64_C(0x0F0F0F0F0F0F0F0F)) |
+	    ((word & UINT64_C(0x0F0F0F0F0F0F0F0F)) << 4);
+
+	return word;
+}
+
+static OF_INLINE void
+refillBits(OFLHADecompressingStream *stream)
+{
+	/*
+	 * See OFInflateStream for why loading more bytes than fit is
+	 * harmless.
+	 */
+	if OF_LIKELY (stream->_bufferLength - stream->_bufferIndex >= 8) {
+		uint64_t word;
+
+		memcpy(&word, stream->_buffer + stream->_bufferIndex, 8);
+		stream->_bits |= reverseBitsInBytes(OF_BSWAP64_IF_BE(word)) <<
+		    stream->_bitsLength;
+		stream->_bufferIndex += (63 - stream->_bitsLength) >> 3;
+		stream->_bitsLength |= 56;
+
+		return;
+	}
+
+	while (stream->_bitsLength < 56 &&
+	    stream->_bufferIndex < stream->_bufferLength) {
+		stream->_bits |= reverseBitsInBytes(
+		    stream->_buffer[stream->_bufferIndex++]) <<
+		    stream->_bitsLength;
+		stream->_bitsLength += 8;
+	}
+}
+
 static OF_INLINE bool
-tryReadBits(OFLHADecompressingStream *stream, uint16_t *bits, uint8_t count)
+ensureBits(OFLHADecompressingStream *stream, uint8_t count)
 {
-	uint16_t ret = stream->_savedBits;
-
-	assert(stream->_savedBitsLength < count);
-
-	for (uint_fast8_t i = stream->_savedBitsLength; i < count; i++) {
-		if OF_UNLIKELY (stream->_bitIndex == 8) {
-			if OF_LIKELY (stream->_bufferIndex <
-			    stream->_bufferLength)
-				stream->_byte =
-				    stream->_buffer[stream->_bufferIndex++];
-			else {
-				const size_t bufferLength =
-				    OF_LHA_DECOMPRESSING_STREAM_BUFFER_SIZE;
-				size_t length = [stream->_stream
-				    readIntoBuffer: stream->_buffer
-					    length: bufferLength];
-
-				stream->_bytesConsumed += (uint32_t)length;
-
-				if OF_UNLIKELY (length < 1) {
-					stream->_savedBits = ret;
-					stream->_savedBitsLength = i;
-					return false;
-				}
+	if OF_LIKELY (stream->_bitsLength >= count)
+		return true;
 
-				stream->_byte = stream->_buffer[0];
-				stream->_bufferIndex = 1;
-				stream->_bufferLength = (uint16_t)length;
-			}
+	refillBits(stream);
 
-			stream->_bitIndex = 0;
-		}
+	while (stream->_bitsLength < count) {
+		size_t length = [stream->_stream
+		    readIntoBuffer: stream->_buffer
+			    length: OF_LHA_DECOMPRESSING_STREAM_BUFFER_SIZE];
+
+		stream->_bytesConsumed += (uint32_t)length;
+
+		if OF_UNLIKELY (length < 1)
+			return false;
 
-		ret = (ret << 1) |
-		    ((stream->_byte >> (7 - stream->_bitIndex++)) & 1);
+		stream->_bufferIndex = 0;
+		stream->_bufferLength = (uint16_t)length;
+
+		refillBits(stream);
 	}
 
-	stream->_savedBits = 0;
-	stream->_savedBitsLength = 0;
-	*bits = ret;
+	return true;
+}
+
+static OF_INLINE bool
+tryReadBits(OFLHADecompressingStream *stream, uint16_t *bits, uint8_t count)
+{
+	uint16_t ret;
+
+	if OF_UNLIKELY (!ensureBits(stream, count))
+		return false;
+
+	ret = (uint16_t)(stream->_bits & ((UINT64_C(1) << count) - 1));
+	stream->_bits >>= count;
+	stream->_bitsLength -= count;
+
+	/* Undo the reversal, as the first bit is the most significant one. */
+	ret = (uint16_t)reverseBitsInBytes(ret);
+	*bits = (uint16_t)(((ret & 0xFF) << 8 | ret >> 8) >> (16 - count));
 
 	return true;
 }
 
+static OF_INLINE bool
+tryReadSymbol(OFLHADecompressingStream *stream, struct of_huffman_tree *tree,
+    uint16_t *value)
+{
+	uint8_t length;
+
+	if (stream->_bitsLength < OF_HUFFMAN_TREE_MAX_BITS)
+		refillBits(stream);
+
+	while (!of_huffman_tree_lookup(tree, (uint32_t)stream->_bits,
+	    stream->_bitsLength, value, &length))
+		if OF_UNLIKELY (!ensureBits(stream, stream->_bitsLength + 1))
+			return false;
+
+	stream->_bits >>= length;
+	stream->_bitsLength -= length;
+
+	return true;
+}
+
+/*
+ * Gives back all whole bytes that have not been consumed yet. The bits left of
+ * a partially consumed byte are kept, as the next block starts right after the
+ * end of this one.
+ */
+static void
+unreadBits(OFLHADecompressingStream *stream)
+{
+	unsigned char bytes[8];
+	uint8_t remainder = stream->_bitsLength % 8;
+	uint8_t count = stream->_bitsLength / 8;
+	uint64_t bits = reverseBitsInBytes(stream->_bits >> remainder);
+
+	for (uint_fast8_t i = 0; i < count; i++)
+		bytes[i] = (unsigned char)(bits >> (i * 8));
+
+	[stream->_stream
+	    unreadFromBuffer: stream->_buffer + stream->_bufferIndex
+		      length: stream->_bufferLength - stream->_bufferIndex];
+	[stream->_stream unreadFromBuffer: bytes
+				   length: count];
+	stream->_bytesConsumed -=
+	    stream->_bufferLength - stream->_bufferIndex + count;
+
+	stream->_bufferIndex = stream->_bufferLength = 0;
+	stream->_bits &= (UINT64_C(1) << remainder) - 1;
+	stream->_bitsLength = remainder;
+}
+
 - (instancetype)of_initWithStream: (OFStream *)stream
 		     distanceBits: (uint8_t)distanceBits
 		   dictionaryBits: (uint8_t)dictionaryBits
@@ -103,9 +197,6 @@ tryReadBits(OFLHADecompressingStream *stream, uint16_t *bits, uint8_t count)
 	@try {
 		_stream = [stream retain];
 
-		/* 0-7 address the bit, 8 means fetch next byte */
-		_bitIndex = 8;
-
 		_distanceBits = distanceBits;
 		_dictionaryBits = dictionaryBits;
 
@@ -261,7 +352,6 @@ start:
 		_codesLengths = of_alloc_zeroed(bits, 1);
 		_skip = false;
 
-		_treeIter = _codeLenTree;
 		_state = STATE_LITLEN_TREE;
 		goto start;
 	case STATE_LITLEN_TREE:
@@ -303,12 +393,9 @@ start:
 				continue;
 			}
 
-			if (!of_huffman_tree_walk(self, tryReadBits,
-			    &_treeIter, &value))
+			if (!tryReadSymbol(self, _codeLenTree, &value))
 				return bytesWritten;
 
-			_treeIter = _codeLenTree;
-
 			if (value < 3) {
 				_codesLengths[_codesReceived] = value;
 				_skip = true;
@@ -350,7 +437,6 @@ start:
 		_codesReceived = 0;
 		_codesLengths = of_alloc_zeroed(bits, 1);
 
-		_treeIter = _codeLenTree;
 		_state = STATE_DIST_TREE;
 		goto start;
 	case STATE_DIST_TREE:
@@ -386,7 +472,6 @@ start:
 		free(_codesLengths);
 		_codesLengths = NULL;
 
-		_treeIter = _litLenTree;
 		_state = STATE_BLOCK_LITLEN;
 		goto start;
 	case STATE_DIST_TREE_SINGLE:
@@ -395,7 +480,6 @@ start:
 
 		_distTree = of_huffman_tree_construct_single(bits);
 
-		_treeIter = _litLenTree;
 		_state = STATE_BLOCK_LITLEN;
 		goto start;
 	case STATE_BLOCK_LITLEN:
@@ -417,11 +501,7 @@ start:
 			 * last block and something else follows, e.g. another
 			 * LHA header.
 			 */
-			[_stream unreadFromBuffer: _buffer + _bufferIndex
-					   length: _bufferLength -
-						   _bufferIndex];
-			_bytesConsumed -= _bufferLength - _bufferIndex;
-			_bufferIndex = _bufferLength = 0;
+			unreadBits(self);
 
 			return bytesWritten;
 		}
@@ -429,8 +509,7 @@ start:
 		if OF_UNLIKELY (length == 0)
 			return bytesWritten;
 
-		if OF_UNLIKELY (!of_huffman_tree_walk(self, tryReadBits,
-		    &_treeIter, &value))
+		if OF_UNLIKELY (!tryReadSymbol(self, _litLenTree, &value))
 			return bytesWritten;
 
 		if OF_LIKELY (value < 256) {
@@ -442,17 +521,14 @@ start:
 			    _slidingWindowMask;
 
 			_symbolsLeft--;
-			_treeIter = _litLenTree;
 		} else {
 			_length = value - 253;
-			_treeIter = _distTree;
 			_state = STATE_BLOCK_DIST_LENGTH;
 		}
 
 		goto start;
 	case STATE_BLOCK_DIST_LENGTH:
-		if OF_UNLIKELY (!of_huffman_tree_walk(self, tryReadBits,
-		    &_treeIter, &value))
+		if OF_UNLIKELY (!tryReadSymbol(self, _distTree, &value))
 			return bytesWritten;
 
 		_distance = value;
@@ -492,7 +568,6 @@ start:
 
 		_symbolsLeft--;
 
-		_treeIter = _litLenTree;
 		_state = STATE_BLOCK_LITLEN;
 		goto start;
 	}
@@ -518,7 +593,7 @@ start:
 - (bool)hasDataInReadBuffer
 {
 	return (super.hasDataInReadBuffer || _stream.hasDataInReadBuffer ||
-	    _bufferLength - _bufferIndex > 0);
+	    _bufferLength - _bufferIndex > 0 || _bitsLength >= 8);
 }
 
 - (void)close
@@ -527,10 +602,7 @@ start:
 		@throw [OFNotOpenException exceptionWithObject: self];
 
 	/* Give back our buffer to the stream, in case it's shared */
-	[_stream unreadFromBuffer: _buffer + _bufferIndex
-			   length: _bufferLength - _bufferIndex];
-	_bytesConsumed -= _bufferLength - _bufferIndex;
-	_bufferIndex = _bufferLength = 0;
+	unreadBits(self);
 
 	[_stream release];
 	_stream = nil;
@@ -75,7 +75,7 @@ OF_SUBCLASSING_RESTRICTED
 @interface OFMapTable: OFObject <OFCopying, OFFastEnumeration>
 {
 	of_map_table_functions_t _keyFunctions, _objectFunctions;
-	struct of_map_table_bucket *_Nonnull *_Nullable _buckets;
+	struct of_map_table_bucket *_Nullable _buckets;
 	unsigned long _count, _capacity;
 	unsigned char _rotate;
 	unsigned long _mutations;
@@ -241,7 +241,7 @@ OF_SUBCLASSING_RESTRICTED
 @interface OFMapTableEnumerator: OFObject
 {
 	OFMapTable *_mapTable;
-	struct of_map_table_bucket *_Nonnull *_Nullable _buckets;
+	struct of_map_table_bucket *_Nullable _buckets;
 	unsigned long _capacity, _mutations, *_Nullable _mutationsPtr;
 	unsigned long _position;
 }
@@ -32,11 +32,23 @@
 
 #define MIN_CAPACITY 16
 
+/*
+ * The buckets are stored inline and use Robin Hood hashing: A bucket is empty
+ * if its key is NULL, and on insertion, a key that is further away from its
+ * home bucket takes the place of one that is closer to its home bucket. This
+ * keeps probe sequences short and allows removing without tombstones by
+ * shifting the following buckets back.
+ *
+ * A Swiss table would need a separate array of control bytes next to the
+ * buckets, which only pays off when probing them 16 at a time with SIMD. Robin
+ * Hood hashing finds a key within a few adjacent inline buckets anyway, and
+ * the stored hash already filters out most mismatches before the equal
+ * function is called.
+ */
 struct of_map_table_bucket {
 	void *key, *object;
 	unsigned long hash;
 };
-static struct of_map_table_bucket deleted = { 0 };
 
 static void *
 defaultRetain(void *object)
@@ -61,6 +73,42 @@ defaultEqual(void *object1, void *object2)
 	return (object1 == object2);
 }
 
+static OF_INLINE unsigned long
+distanceFromHome(const struct of_map_table_bucket *bucket, unsigned long idx,
+    unsigned long capacity)
+{
+	return (idx - bucket->hash) & (capacity - 1);
+}
+
+static void
+insertBucket(struct of_map_table_bucket *buckets, unsigned long capacity,
+    struct of_map_table_bucket bucket)
+{
+	unsigned long mask = capacity - 1;
+	unsigned long distance = 0;
+
+	for (unsigned long i = bucket.hash & mask;; i = (i + 1) & mask) {
+		unsigned long otherDistance;
+
+		if (buckets[i].key == NULL) {
+			buckets[i] = bucket;
+			return;
+		}
+
+		otherDistance = distanceFromHome(&buckets[i], i, capacity);
+
+		if (otherDistance < distance) {
+			struct of_map_table_bucket tmp = buckets[i];
+
+			buckets[i] = bucket;
+			bucket = tmp;
+			distance = otherDistance;
+		}
+
+		distance++;
+	}
+}
+
 OF_DIRECT_MEMBERS
 @interface OFMapTable ()
 - (void)of_setObject: (void *)object
@@ -71,7 +119,7 @@ OF_DIRECT_MEMBERS
 OF_DIRECT_MEMBERS
 @interface OFMapTableEnumerator ()
 - (instancetype)of_initWithMapTable: (OFMapTable *)mapTable
-			    buckets: (struct of_map_table_bucket **)buckets
+			    buckets: (struct of_map_table_bucket *)buckets
 			   capacity: (unsigned long)capacity
 		   mutationsPointer: (unsigned long *)mutationsPtr
     OF_METHOD_FAMILY(init);
@@ -178,11 +226,9 @@ OF_DIRECT_MEMBERS
 - (void)dealloc
 {
 	for (unsigned long i = 0; i < _capacity; i++) {
-		if (_buckets[i] != NULL && _buckets[i] != &deleted) {
-			_keyFunctions.release(_buckets[i]->key);
-			_objectFunctions.release(_buckets[i]->object);
-
-			free(_buckets[i]);
+		if (_buckets[i].key != NULL) {
+			_keyFunctions.release(_buckets[i].key);
+			_objectFunctions.release(_buckets[i].object);
 		}
 	}
 
@@ -209,12 +255,12 @@ OF_DIRECT_MEMBERS
 		return false;
 
 	for (unsigned long i = 0; i < _capacity; i++) {
-		if (_buckets[i] != NULL && _buckets[i] != &deleted) {
+		if (_buckets[i].key != NULL) {
 			void *objectIter =
-			    [mapTable objectForKey: _buckets[i]->key];
+			    [mapTable objectForKey: _buckets[i].key];
 
 			if (!_objectFunctions.equal(objectIter,
-			    _buckets[i]->object))
+			    _buckets[i].object))
 				return false;
 		}
 	}
@@ -227,9 +273,9 @@ OF_DIRECT_MEMBERS
 	unsigned long hash = 0;
 
 	for (unsigned long i = 0; i < _capacity; i++) {
-		if (_buckets[i] != NULL && _buckets[i] != &deleted) {
-			hash ^= OF_ROR(_buckets[i]->hash, _rotate);
-			hash ^= _objectFunctions.hash(_buckets[i]->object);
+		if (_buckets[i].key != NULL) {
+			hash ^= OF_ROR(_buckets[i].hash, _rotate);
+			hash ^= _objectFunctions.hash(_buckets[i].object);
 		}
 	}
 
@@ -245,10 +291,10 @@ OF_DIRECT_MEMBERS
 
 	@try {
 		for (unsigned long i = 0; i < _capacity; i++)
-			if (_buckets[i] != NULL && _buckets[i] != &deleted)
-				[copy of_setObject: _buckets[i]->object
-					    forKey: _buckets[i]->key
-					      hash: OF_ROR(_buckets[i]->hash,
+			if (_buckets[i].key != NULL)
+				[copy of_setObject: _buckets[i].object
+					    forKey: _buckets[i].key
+					      hash: OF_ROR(_buckets[i].hash,
 							_rotate)];
 	} @catch (id e) {
 		[copy release];
@@ -263,37 +309,41 @@ OF_DIRECT_MEMBERS
 	return _count;
 }
 
-- (void *)objectForKey: (void *)key
+- (unsigned long)of_indexForKey: (void *)key
+			    hash: (unsigned long)hash OF_DIRECT
 {
-	unsigned long i, hash, last;
+	unsigned long mask = _capacity - 1;
+	unsigned long distance = 0;
 
-	if (key == NULL)
-		@throw [OFInvalidArgumentException exception];
-
-	hash = OF_ROL(_keyFunctions.hash(key), _rotate);
-	last = _capacity;
+	for (unsigned long i = hash & mask;; i = (i + 1) & mask) {
+		/*
+		 * The key would have taken the place of any key that is closer
+		 * to its home bucket, so it can't be in the map table.
+		 */
+		if (_buckets[i].key == NULL ||
+		    distanceFromHome(&_buckets[i], i, _capacity) < distance)
+			return _capacity;
 
-	for (i = hash & (_capacity - 1); i < last && _buckets[i] != NULL; i++) {
-		if (_buckets[i] == &deleted)
-			continue;
+		if (_buckets[i].hash == hash &&
+		    _keyFunctions.equal(_buckets[i].key, key))
+			return i;
 
-		if (_keyFunctions.equal(_buckets[i]->key, key))
-			return _buckets[i]->object;
+		distance++;
 	}
+}
 
-	if (i < last)
-		return nil;
+- (void *)objectForKey: (void *)key
+{
+	unsigned long i;
 
-	/* In case the last bucket is already used */
-	last = hash & (_capacity - 1);
+	if (key == NULL)
+		@throw [OFInvalidArgumentException exception];
 
-	for (i = 0; i < last && _buckets[i] != NULL; i++) {
-		if (_buckets[i] == &deleted)
-			continue;
+	i = [self of_indexForKey: key
+			    hash: OF_ROL(_keyFunctions.hash(key), _rotate)];
 
-		if (_keyFunctions.equal(_buckets[i]->key, key))
-			return _buckets[i]->object;
-	}
+	if (i < _capacity)
+		return _buckets[i].object;
 
 	return NULL;
 }
@@ -301,7 +351,7 @@ OF_DIRECT_MEMBERS
 - (void)of_resizeForCount: (unsigned long)count OF_DIRECT
 {
 	unsigned long fullness, capacity;
-	struct of_map_table_bucket **buckets;
+	struct of_map_table_bucket *buckets;
 
 	if (count > ULONG_MAX / sizeof(*_buckets) || count > ULONG_MAX / 8)
 		@throw [OFOutOfRangeException exception];
@@ -327,29 +377,9 @@ OF_DIRECT_MEMBERS
 
 	buckets = of_alloc_zeroed(capacity, sizeof(*buckets));
 
-	for (unsigned long i = 0; i < _capacity; i++) {
-		if (_buckets[i] != NULL && _buckets[i] != &deleted) {
-			unsigned long j, last;
-
-			last = capacity;
-
-			for (j = _buckets[i]->hash & (capacity - 1);
-			    j < last && buckets[j] != NULL; j++);
-
-			/* In case the last bucket is already used */
-			if (j >= last) {
-				last = _buckets[i]->hash & (capacity - 1);
-
-				for (j = 0; j < last &&
-				    buckets[j] != NULL; j++);
-			}
-
-			if (j >= last)
-				@throw [OFOutOfRangeException exception];
-
-			buckets[j] = _buckets[i];
-		}
-	}
+	for (unsigned long i = 0; i < _capacity; i++)
+		if (_buckets[i].key != NULL)
+			insertBucket(buckets, capacity, _buckets[i]);
 
 	free(_buckets);
 	_buckets = buckets;
@@ -360,88 +390,42 @@ OF_DIRECT_MEMBERS
 	      forKey: (void *)key
 		hash: (unsigned long)hash
 {
-	unsigned long i, last;
+	struct of_map_table_bucket bucket;
+	unsigned long i;
 	void *old;
 
 	if (key == NULL || object == NULL)
 		@throw [OFInvalidArgumentException exception];
 
 	hash = OF_ROL(hash, _rotate);
-	last = _capacity;
+	i = [self of_indexForKey: key
+			    hash: hash];
 
-	for (i = hash & (_capacity - 1); i < last && _buckets[i] != NULL; i++) {
-		if (_buckets[i] == &deleted)
-			continue;
+	if (i < _capacity) {
+		old = _buckets[i].object;
+		_buckets[i].object = _objectFunctions.retain(object);
+		_objectFunctions.release(old);
 
-		if (_keyFunctions.equal(_buckets[i]->key, key))
-			break;
-	}
-
-	/* In case the last bucket is already used */
-	if (i >= last) {
-		last = hash & (_capacity - 1);
-
-		for (i = 0; i < last && _buckets[i] != NULL; i++) {
-			if (_buckets[i] == &deleted)
-				continue;
-
-			if (_keyFunctions.equal(_buckets[i]->key, key))
-				break;
-		}
+		return;
 	}
 
 	/* Key not in map table */
-	if (i >= last || _buckets[i] == NULL || _buckets[i] == &deleted ||
-	    !_keyFunctions.equal(_buckets[i]->key, key)) {
-		struct of_map_table_bucket *bucket;
-
-		[self of_resizeForCount: _count + 1];
-
-		_mutations++;
-		last = _capacity;
-
-		for (i = hash & (_capacity - 1); i < last &&
-		    _buckets[i] != NULL && _buckets[i] != &deleted; i++);
-
-		/* In case the last bucket is already used */
-		if (i >= last) {
-			last = hash & (_capacity - 1);
-
-			for (i = 0; i < last && _buckets[i] != NULL &&
-			    _buckets[i] != &deleted; i++);
-		}
-
-		if (i >= last)
-			@throw [OFOutOfRangeException exception];
+	[self of_resizeForCount: _count + 1];
 
-		bucket = of_alloc(1, sizeof(*bucket));
+	bucket.key = _keyFunctions.retain(key);
 
-		@try {
-			bucket->key = _keyFunctions.retain(key);
-		} @catch (id e) {
-			free(bucket);
-			@throw e;
-		}
-
-		@try {
-			bucket->object = _objectFunctions.retain(object);
-		} @catch (id e) {
-			_keyFunctions.release(bucket->key);
-			free(bucket);
-			@throw e;
-		}
-
-		bucket->hash = hash;
-
-		_buckets[i] = bucket;
-		_count++;
-
-		return;
+	@try {
+		bucket.object = _objectFunctions.retain(object);
+	} @catch (id e) {
+		_keyFunctions.release(bucket.key);
+		@throw e;
 	}
 
-	old = _buckets[i]->object;
-	_buckets[i]->object = _objectFunctions.retain(object);
-	_objectFunctions.release(old);
+	bucket.hash = hash;
+
+	insertBucket(_buckets, _capacity, bucket);
+	_count++;
+	_mutations++;
 }
 
 - (void)setObject: (void *)object
@@ -454,80 +438,52 @@ OF_DIRECT_MEMBERS
 
 - (void)removeObjectForKey: (void *)key
 {
-	unsigned long i, hash, last;
+	unsigned long i, j, mask;
 
 	if (key == NULL)
 		@throw [OFInvalidArgumentException exception];
 
-	hash = OF_ROL(_keyFunctions.hash(key), _rotate);
-	last = _capacity;
-
-	for (i = hash & (_capacity - 1); i < last && _buckets[i] != NULL; i++) {
-		if (_buckets[i] == &deleted)
-			continue;
-
-		if (_keyFunctions.equal(_buckets[i]->key, key)) {
-			_mutations++;
-
-			_keyFunctions.release(_buckets[i]->key);
-			_objectFunctions.release(_buckets[i]->object);
+	i = [self of_indexForKey: key
+			    hash: OF_ROL(_keyFunctions.hash(key), _rotate)];
 
-			free(_buckets[i]);
-			_buckets[i] = &deleted;
-
-			_count--;
-			[self of_resizeForCount: _count];
-
-			return;
-		}
-	}
-
-	if (i < last)
+	if (i >= _capacity)
 		return;
 
-	/* In case the last bucket is already used */
-	last = hash & (_capacity - 1);
-
-	for (i = 0; i < last && _buckets[i] != NULL; i++) {
-		if (_buckets[i] == &deleted)
-			continue;
+	_mutations++;
 
-		if (_keyFunctions.equal(_buckets[i]->key, key)) {
-			_keyFunctions.release(_buckets[i]->key);
-			_objectFunctions.release(_buckets[i]->object);
+	_keyFunctions.release(_buckets[i].key);
+	_objectFunctions.release(_buckets[i].object);
 
-			free(_buckets[i]);
-			_buckets[i] = &deleted;
+	/*
+	 * Shift back all following buckets until one that is empty or already
+	 * in its home bucket, so that no tombstone is needed.
+	 */
+	mask = _capacity - 1;
+	for (j = (i + 1) & mask; _buckets[j].key != NULL &&
+	    distanceFromHome(&_buckets[j], j, _capacity) > 0;
+	    i = j, j = (j + 1) & mask)
+		_buckets[i] = _buckets[j];
 
-			_count--;
-			_mutations++;
-			[self of_resizeForCount: _count];
+	memset(&_buckets[i], 0, sizeof(*_buckets));
 
-			return;
-		}
-	}
+	_count--;
+	[self of_resizeForCount: _count];
 }
 
 - (void)removeAllObjects
 {
 	for (unsigned long i = 0; i < _capacity; i++) {
-		if (_buckets[i] != NULL) {
-			if (_buckets[i] == &deleted) {
-				_buckets[i] = NULL;
-				continue;
-			}
-
-			_keyFunctions.release(_buckets[i]->key);
-			_objectFunctions.release(_buckets[i]->object);
-
-			free(_buckets[i]);
-			_buckets[i] = NULL;
+		if (_buckets[i].key != NULL) {
+			_keyFunctions.release(_buckets[i].key);
+			_objectFunctions.release(_buckets[i].object);
 		}
 	}
 
+	_mutations++;
 	_count = 0;
 	_capacity = MIN_CAPACITY;
 	_buckets = of_realloc(_buckets, _capacity, sizeof(*_buckets));
+	memset(_buckets, 0, _capacity * sizeof(*_buckets));
 
 	/*
 	 * Get a new random value for _rotate, so that it is not less secure
@@ -543,8 +499,8 @@ OF_DIRECT_MEMBERS
 		return false;
 
 	for (unsigned long i = 0; i < _capacity; i++)
-		if (_buckets[i] != NULL && _buckets[i] != &deleted)
-			if (_objectFunctions.equal(_buckets[i]->object, object))
+		if (_buckets[i].key != NULL)
+			if (_objectFunctions.equal(_buckets[i].object, object))
 				return true;
 
 	return false;
@@ -556,8 +512,8 @@ OF_DIRECT_MEMBERS
 		return false;
 
 	for (unsigned long i = 0; i < _capacity; i++)
-		if (_buckets[i] != NULL && _buckets[i] != &deleted)
-			if (_buckets[i]->object == object)
+		if (_buckets[i].key != NULL)
+			if (_buckets[i].object == object)
 				return true;
 
 	return false;
@@ -589,11 +545,10 @@ OF_DIRECT_MEMBERS
 	int i;
 
 	for (i = 0; i < count; i++) {
-		for (; j < _capacity && (_buckets[j] == NULL ||
-		    _buckets[j] == &deleted); j++);
+		for (; j < _capacity && _buckets[j].key == NULL; j++);
 
 		if (j < _capacity) {
-			objects[i] = _buckets[j]->key;
+			objects[i] = _buckets[j].key;
 			j++;
 		} else
 			break;
@@ -618,8 +573,8 @@ OF_DIRECT_MEMBERS
 			@throw [OFEnumerationMutationException
 			    exceptionWithObject: self];
 
-		if (_buckets[i] != NULL && _buckets[i] != &deleted)
-			block(_buckets[i]->key, _buckets[i]->object, &stop);
+		if (_buckets[i].key != NULL)
+			block(_buckets[i].key, _buckets[i].object, &stop);
 	}
 }
 
@@ -632,16 +587,16 @@ OF_DIRECT_MEMBERS
 			@throw [OFEnumerationMutationException
 			    exceptionWithObject: self];
 
-		if (_buckets[i] != NULL && _buckets[i] != &deleted) {
+		if (_buckets[i].key != NULL) {
 			void *new;
 
-			new = block(_buckets[i]->key, _buckets[i]->object);
+			new = block(_buckets[i].key, _buckets[i].object);
 			if (new == NULL)
 				@throw [OFInvalidArgumentException exception];
 
-			if (new != _buckets[i]->object) {
-				_objectFunctions.release(_buckets[i]->object);
-				_buckets[i]->object =
+			if (new != _buckets[i].object) {
+				_objectFunctions.release(_buckets[i].object);
+				_buckets[i].object =
 				    _objectFunctions.retain(new);
 			}
 		}
@@ -657,7 +612,7 @@ OF_DIRECT_MEMBERS
 }
 
 - (instancetype)of_initWithMapTable: (OFMapTable *)mapTable
-			    buckets: (struct of_map_table_bucket **)buckets
+			    buckets: (struct of_map_table_bucket *)buckets
 			   capacity: (unsigned long)capacity
 		   mutationsPointer: (unsigned long *)mutationsPtr
 {
@@ -692,11 +647,11 @@ OF_DIRECT_MEMBERS
 		@throw [OFEnumerationMutationException
 		    exceptionWithObject: _mapTable];
 
-	for (; _position < _capacity && (_buckets[_position] == NULL ||
-	    _buckets[_position] == &deleted); _position++);
+	for (; _position < _capacity && _buckets[_position].key == NULL;
+	    _position++);
 
 	if (_position < _capacity)
-		return &_buckets[_position++]->key;
+		return &_buckets[_position++].key;
 	else
 		return NULL;
 }
@@ -709,11 +664,11 @@ OF_DIRECT_MEMBERS
 		@throw [OFEnumerationMutationException
 		    exceptionWithObject: _mapTable];
 
-	for (; _position < _capacity && (_buckets[_position] == NULL ||
-	    _buckets[_position] == &deleted); _position++);
+	for (; _position < _capacity && _buckets[_position].key == NULL;
+	    _position++);
 
 	if (_position < _capacity)
-		return &_buckets[_position++]->object;
+		return &_buckets[_position++].object;
 	else
 		return NULL;
 }
@@ -356,6 +356,21 @@
 	_s->hashed = false;
 	_s->cString = of_realloc(_s->cString,
 	    _s->cStringLength + UTF8StringLength + 1, 1);
+
+#ifdef OF_OBJFW_RUNTIME
+	/* Tagged pointer strings are ASCII and have no C string to copy. */
+	if (object_isTaggedPointer(string)) {
+		[string getCString: _s->cString + _s->cStringLength
+			 maxLength: UTF8StringLength + 1
+			  encoding: OF_STRING_ENCODING_UTF_8];
+
+		_s->cStringLength += UTF8StringLength;
+		_s->length += UTF8StringLength;
+
+		return;
+	}
+#endif
+
 	memcpy(_s->cString + _s->cStringLength, string.UTF8String,
 	    UTF8StringLength);
 
@@ -18,17 +18,13 @@
 #include "config.h"
 
 #import "OFNull.h"
+#import "OFJSONWriter.h"
 #import "OFString.h"
 #import "OFXMLElement.h"
 #import "OFData.h"
 
 #import "OFInvalidArgumentException.h"
 
-@interface OFNull ()
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth;
-@end
-
 static OFNull *null = nil;
 
 @implementation OFNull
@@ -86,20 +82,27 @@ static OFNull *null = nil;
 
 - (OFString *)JSONRepresentation
 {
-	return [self of_JSONRepresentationWithOptions: 0
-						depth: 0];
+	return [self JSONRepresentationWithOptions: 0];
 }
 
 - (OFString *)JSONRepresentationWithOptions: (int)options
 {
-	return [self of_JSONRepresentationWithOptions: options
-						depth: 0];
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONWriter *writer = [OFJSONWriter writer];
+	OFString *JSON;
+
+	writer.options = options;
+	[self writeJSONRepresentationToWriter: writer];
+	JSON = [writer.string retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [JSON autorelease];
 }
 
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer
 {
-	return @"null";
+	[writer writeNull];
 }
 
 - (OFData *)messagePackRepresentation
@@ -22,6 +22,7 @@
 #include <math.h>
 
 #import "OFNumber.h"
+#import "OFJSONWriter.h"
 #import "OFString.h"
 #import "OFXMLElement.h"
 #import "OFXMLAttribute.h"
@@ -33,8 +34,6 @@
 
 @interface OFNumber ()
 + (instancetype)of_alloc;
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth;
 @end
 
 @interface OFNumberPlaceholder: OFNumber
@@ -1080,36 +1079,36 @@ isFloat(OFNumber *number)
 
 - (OFString *)JSONRepresentation
 {
-	return [self of_JSONRepresentationWithOptions: 0
-						depth: 0];
+	return [self JSONRepresentationWithOptions: 0];
 }
 
 - (OFString *)JSONRepresentationWithOptions: (int)options
 {
-	return [self of_JSONRepresentationWithOptions: options
-						depth: 0];
-}
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONWriter *writer = [OFJSONWriter writer];
+	OFString *JSON;
 
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth
-{
-	double doubleValue;
+	writer.options = options;
+	[self writeJSONRepresentationToWriter: writer];
+	JSON = [writer.string retain];
 
-	if (*self.objCType == 'B')
-		return (self.boolValue ? @"true" : @"false");
+	objc_autoreleasePoolPop(pool);
 
-	doubleValue = self.doubleValue;
-	if (isinf(doubleValue)) {
-		if (options & OF_JSON_REPRESENTATION_JSON5) {
-			if (doubleValue > 0)
-				return @"Infinity";
-			else
-				return @"-Infinity";
-		} else
-			@throw [OFInvalidArgumentException exception];
-	}
+	return [JSON autorelease];
+}
 
-	return self.description;
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer
+{
+	if (*self.objCType == 'B')
+		[writer writeBool: self.boolValue];
+	else if (isFloat(self))
+		[writer writeDouble: self.doubleValue];
+	else if (isSigned(self))
+		[writer writeLongLong: self.longLongValue];
+	else if (isUnsigned(self))
+		[writer writeUnsignedLongLong: self.unsignedLongLongValue];
+	else
+		@throw [OFInvalidFormatException exception];
 }
 
 - (OFData *)messagePackRepresentation
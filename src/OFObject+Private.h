@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#if defined(ENABLE_BIASED_REFCOUNTING) && defined(OF_HAVE_THREADS) && \
+    defined(OF_HAVE_ATOMIC_OPS) && defined(OF_HAVE_COMPILER_TLS)
+# define OF_BIASED_REFCOUNTING
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#ifdef OF_BIASED_REFCOUNTING
+/*
+ * Makes the calling thread the owner of the objects it allocates from now on.
+ * Must be called by a thread when it starts, and only by threads that call
+ * of_biased_refcount_thread_exit() before they exit.
+ */
+extern void of_biased_refcount_thread_start(void);
+
+/*
+ * Merges the reference counts of all objects queued for the calling thread
+ * and makes the thread's ownership record available to threads started later.
+ * Must be called by a thread before it exits.
+ */
+extern void of_biased_refcount_thread_exit(void);
+#endif
+#ifdef __cplusplus
+}
+#endif
+
+OF_ASSUME_NONNULL_END
@@ -32,6 +32,7 @@
 #endif
 
 #import "OFObject.h"
+#import "OFObject+Private.h"
 #import "OFArray.h"
 #import "OFLocale.h"
 #import "OFMethodSignature.h"
@@ -66,9 +67,22 @@
 
 #if defined(OF_HAVE_ATOMIC_OPS)
 # import "atomic.h"
-#elif defined(OF_HAVE_THREADS)
+#endif
+#if defined(OF_HAVE_THREADS)
 # import "mutex.h"
 #endif
+#import "siphash.h"
+#ifdef OF_BIASED_REFCOUNTING
+# import "once.h"
+#endif
+
+#if !defined(OF_HAVE_ATOMIC_OPS) && !defined(OF_AMIGAOS)
+# ifdef DISABLE_OBJECT_SPINLOCKS
+#  define RETAIN_COUNT_SPINLOCKS_SIZE 64
+# else
+#  define OBJECT_SPINLOCKS
+# endif
+#endif
 
 #ifdef OF_APPLE_RUNTIME
 extern id _Nullable _objc_rootAutorelease(id _Nullable object);
@@ -81,9 +95,39 @@ extern struct stret of_forward_stret(id, SEL, ...);
 # define of_forward_stret of_method_not_found_stret
 #endif
 
+#ifdef OF_BIASED_REFCOUNTING
+/*
+ * With biased reference counting, retainCount is the shared reference count,
+ * which is only modified atomically. It is stored in units of SHARED_ONE, as
+ * the lower bits are used for flags. It can become negative if other threads
+ * release references that were retained by the owner.
+ *
+ * biasedRetainCount is only accessed by the owner thread, and only as long as
+ * SHARED_MERGED is not set. Once the owner drops its last reference or merges
+ * an object from its queue, the biased reference count is added to the shared
+ * one and SHARED_MERGED is set, after which all threads use the shared count.
+ */
+# define SHARED_MERGED 1
+# define SHARED_QUEUED 2
+# define SHARED_FLAGS (SHARED_MERGED | SHARED_QUEUED)
+# define SHARED_ONE 4
+
+struct biased_owner {
+	struct pre_ivar *volatile queue;
+	struct biased_owner *next;
+	/* Set while no thread uses the owner. */
+	volatile bool exited;
+};
+#endif
+
 struct pre_ivar {
 	int retainCount;
-#if !defined(OF_HAVE_ATOMIC_OPS) && !defined(OF_AMIGAOS)
+#ifdef OF_BIASED_REFCOUNTING
+	int biasedRetainCount;
+	struct biased_owner *owner;
+	struct pre_ivar *nextQueued;
+#endif
+#ifdef OBJECT_SPINLOCKS
 	of_spinlock_t retainCountSpinlock;
 #endif
 };
@@ -92,6 +136,31 @@ struct pre_ivar {
     (OF_BIGGEST_ALIGNMENT - 1)) & ~(OF_BIGGEST_ALIGNMENT - 1))
 #define PRE_IVARS ((struct pre_ivar *)(void *)((char *)self - PRE_IVARS_ALIGN))
 
+#ifdef OF_BIASED_REFCOUNTING
+/*
+ * Only threads started by OFThread have an owner, as only they merge their
+ * queue before they exit. Objects allocated by other threads start out with a
+ * shared count.
+ *
+ * Owners are never freed, as objects keep pointing to them. Instead, the owner
+ * of an exited thread is reused by the next new thread, which then also owns
+ * the objects that were still biased towards the exited thread. Until then,
+ * objects queued for it are merged by the thread that queued them.
+ */
+static thread_local struct biased_owner *currentOwner = NULL;
+static struct biased_owner *freeOwners = NULL;
+static of_spinlock_t freeOwnersSpinlock;
+static of_once_t freeOwnersSpinlockOnce = OF_ONCE_INIT;
+#endif
+
+#ifdef RETAIN_COUNT_SPINLOCKS_SIZE
+static of_spinlock_t retainCountSpinlocks[RETAIN_COUNT_SPINLOCKS_SIZE];
+# define RETAIN_COUNT_SPINLOCK &retainCountSpinlocks[			\
+    ((uintptr_t)self / OF_BIGGEST_ALIGNMENT) % RETAIN_COUNT_SPINLOCKS_SIZE]
+#elif defined(OBJECT_SPINLOCKS)
+# define RETAIN_COUNT_SPINLOCK &PRE_IVARS->retainCountSpinlock
+#endif
+
 static struct {
 	Class isa;
 } allocFailedException;
@@ -287,6 +356,175 @@ of_method_not_found_stret(void *stret, id object, SEL selector)
 	of_method_not_found(object, selector);
 }
 
+#ifdef OF_BIASED_REFCOUNTING
+static void
+initFreeOwnersSpinlock(void)
+{
+	OF_ENSURE(of_spinlock_new(&freeOwnersSpinlock));
+}
+
+/*
+ * Takes the queue of the owner and merges the biased reference count of each
+ * object into the shared one. Returns the objects that are now dead, linked by
+ * nextQueued, which have to be deallocated with deallocDeadObjects().
+ */
+static struct pre_ivar *
+mergeQueue(struct biased_owner *owner)
+{
+	struct pre_ivar *queue, *dead = NULL;
+
+	do {
+		queue = owner->queue;
+	} while (!of_atomic_ptr_cmpswap((void *volatile *)&owner->queue,
+	    queue, NULL));
+
+	of_memory_barrier_acquire();
+
+	while (queue != NULL) {
+		struct pre_ivar *next = queue->nextQueued;
+		int delta = -SHARED_QUEUED;
+
+		if (!(queue->retainCount & SHARED_MERGED)) {
+			delta += queue->biasedRetainCount * SHARED_ONE +
+			    SHARED_MERGED;
+			queue->biasedRetainCount = 0;
+		}
+
+		of_memory_barrier_release();
+
+		if (of_atomic_int_add(&queue->retainCount, delta) ==
+		    SHARED_MERGED) {
+			queue->nextQueued = dead;
+			dead = queue;
+		}
+
+		queue = next;
+	}
+
+	return dead;
+}
+
+static void
+deallocDeadObjects(struct pre_ivar *dead)
+{
+	while (dead != NULL) {
+		struct pre_ivar *next = dead->nextQueued;
+
+		of_memory_barrier_acquire();
+
+		[(id)(void *)((char *)dead + PRE_IVARS_ALIGN) dealloc];
+
+		dead = next;
+	}
+}
+
+static void
+mergeQueuedObjects(struct biased_owner *owner)
+{
+	deallocDeadObjects(mergeQueue(owner));
+}
+
+/*
+ * Called by a non-owner thread after it released a reference and the shared
+ * count became negative, meaning the object might be dead and only the owner
+ * can tell.
+ */
+static void
+queueForOwner(struct pre_ivar *preIvars, int retainCount)
+{
+	struct biased_owner *owner = preIvars->owner;
+	struct pre_ivar *head;
+
+	for (;;) {
+		if (retainCount >= 0 || retainCount & SHARED_FLAGS)
+			return;
+
+		if (of_atomic_int_cmpswap(&preIvars->retainCount, retainCount,
+		    retainCount | SHARED_QUEUED))
+			break;
+
+		retainCount = preIvars->retainCount;
+	}
+
+	do {
+		head = owner->queue;
+		preIvars->nextQueued = head;
+		of_memory_barrier_release();
+	} while (!of_atomic_ptr_cmpswap((void *volatile *)&owner->queue,
+	    head, preIvars));
+
+	/*
+	 * Either the exiting owner sees the object in its queue or we see that
+	 * it exited, in which case nobody else would merge the object.
+	 */
+	of_memory_barrier();
+
+	if OF_UNLIKELY (owner->exited) {
+		struct pre_ivar *dead = NULL;
+
+		/*
+		 * The lock keeps a new thread from taking over the owner while
+		 * the biased reference counts are merged.
+		 */
+		OF_ENSURE(of_spinlock_lock(&freeOwnersSpinlock));
+		if (owner->exited)
+			dead = mergeQueue(owner);
+		OF_ENSURE(of_spinlock_unlock(&freeOwnersSpinlock));
+
+		deallocDeadObjects(dead);
+	}
+}
+
+void
+of_biased_refcount_thread_start(void)
+{
+	struct biased_owner *owner;
+
+	of_once(&freeOwnersSpinlockOnce, initFreeOwnersSpinlock);
+
+	OF_ENSURE(of_spinlock_lock(&freeOwnersSpinlock));
+	if ((owner = freeOwners) != NULL) {
+		freeOwners = owner->next;
+		owner->exited = false;
+	}
+	OF_ENSURE(of_spinlock_unlock(&freeOwnersSpinlock));
+
+	/* If this fails, objects simply start out with a shared count. */
+	if (owner == NULL && (owner = calloc(1, sizeof(*owner))) == NULL)
+		return;
+
+	owner->next = NULL;
+	currentOwner = owner;
+
+	if (owner->queue != NULL)
+		mergeQueuedObjects(owner);
+}
+
+void
+of_biased_refcount_thread_exit(void)
+{
+	struct biased_owner *owner = currentOwner;
+
+	if (owner == NULL)
+		return;
+
+	/*
+	 * Objects released while merging must not use the biased count
+	 * anymore, as other threads can merge it from now on.
+	 */
+	currentOwner = NULL;
+	owner->exited = true;
+	of_memory_barrier();
+
+	mergeQueuedObjects(owner);
+
+	OF_ENSURE(of_spinlock_lock(&freeOwnersSpinlock));
+	owner->next = freeOwners;
+	freeOwners = owner;
+	OF_ENSURE(of_spinlock_unlock(&freeOwnersSpinlock));
+}
+#endif
+
 id
 of_alloc_object(Class class, size_t extraSize, size_t extraAlignment,
     void **extra)
@@ -308,9 +546,18 @@ of_alloc_object(Class class, size_t extraSize, size_t extraAlignment,
 		@throw (id)&allocFailedException;
 	}
 
+#ifdef OF_BIASED_REFCOUNTING
+	if OF_LIKELY ((((struct pre_ivar *)instance)->owner =
+	    currentOwner) != NULL)
+		((struct pre_ivar *)instance)->biasedRetainCount = 1;
+	else
+		((struct pre_ivar *)instance)->retainCount =
+		    SHARED_ONE | SHARED_MERGED;
+#else
 	((struct pre_ivar *)instance)->retainCount = 1;
+#endif
 
-#if !defined(OF_HAVE_ATOMIC_OPS) && !defined(OF_AMIGAOS)
+#ifdef OBJECT_SPINLOCKS
 	if OF_UNLIKELY (!of_spinlock_new(
 	    &((struct pre_ivar *)instance)->retainCountSpinlock)) {
 		free(instance);
@@ -377,6 +624,14 @@ _references_to_categories_of_OFObject(void)
 		of_hash_seed = of_random32();
 	} while (of_hash_seed == 0);
 
+	of_hash_key[0] = of_random64();
+	of_hash_key[1] = of_random64();
+
+#ifdef RETAIN_COUNT_SPINLOCKS_SIZE
+	for (size_t i = 0; i < RETAIN_COUNT_SPINLOCKS_SIZE; i++)
+		OF_ENSURE(of_spinlock_new(&retainCountSpinlocks[i]));
+#endif
+
 #ifdef OF_OBJFW_RUNTIME
 	objc_setTaggedPointerSecret(sizeof(uintptr_t) == 4
 	    ? (uintptr_t)of_random32() : (uintptr_t)of_random64());
@@ -1105,7 +1360,15 @@ _references_to_categories_of_OFObject(void)
 
 - (instancetype)retain
 {
-#if defined(OF_HAVE_ATOMIC_OPS)
+#if defined(OF_BIASED_REFCOUNTING)
+	struct pre_ivar *preIvars = PRE_IVARS;
+
+	if OF_LIKELY (preIvars->owner == currentOwner &&
+	    !(preIvars->retainCount & SHARED_MERGED))
+		preIvars->biasedRetainCount++;
+	else
+		of_atomic_int_add(&preIvars->retainCount, SHARED_ONE);
+#elif defined(OF_HAVE_ATOMIC_OPS)
 	of_atomic_int_inc(&PRE_IVARS->retainCount);
 #elif defined(OF_AMIGAOS)
 	/*
@@ -1121,9 +1384,9 @@ _references_to_categories_of_OFObject(void)
 	Permit();
 # endif
 #else
-	OF_ENSURE(of_spinlock_lock(&PRE_IVARS->retainCountSpinlock));
+	OF_ENSURE(of_spinlock_lock(RETAIN_COUNT_SPINLOCK));
 	PRE_IVARS->retainCount++;
-	OF_ENSURE(of_spinlock_unlock(&PRE_IVARS->retainCountSpinlock));
+	OF_ENSURE(of_spinlock_unlock(RETAIN_COUNT_SPINLOCK));
 #endif
 
 	return self;
@@ -1131,13 +1394,59 @@ _references_to_categories_of_OFObject(void)
 
 - (unsigned int)retainCount
 {
+#ifdef OF_BIASED_REFCOUNTING
+	/* Only exact on the owner thread or without other threads. */
+	int retainCount = PRE_IVARS->retainCount;
+	int shared = (retainCount - (retainCount & SHARED_FLAGS)) / SHARED_ONE;
+
+	if (!(retainCount & SHARED_MERGED))
+		shared += PRE_IVARS->biasedRetainCount;
+
+	assert(shared >= 0);
+	return shared;
+#else
 	assert(PRE_IVARS->retainCount >= 0);
 	return PRE_IVARS->retainCount;
+#endif
 }
 
 - (void)release
 {
-#if defined(OF_HAVE_ATOMIC_OPS)
+#if defined(OF_BIASED_REFCOUNTING)
+	struct pre_ivar *preIvars = PRE_IVARS;
+	struct biased_owner *owner = currentOwner;
+	int retainCount;
+
+	if OF_LIKELY (preIvars->owner == owner &&
+	    !(preIvars->retainCount & SHARED_MERGED)) {
+		if (--preIvars->biasedRetainCount == 0) {
+			of_memory_barrier_release();
+
+			if (of_atomic_int_add(&preIvars->retainCount,
+			    SHARED_MERGED) == SHARED_MERGED) {
+				of_memory_barrier_acquire();
+
+				[self dealloc];
+			}
+		}
+
+		if OF_UNLIKELY (owner->queue != NULL)
+			mergeQueuedObjects(owner);
+
+		return;
+	}
+
+	of_memory_barrier_release();
+
+	retainCount = of_atomic_int_add(&preIvars->retainCount, -SHARED_ONE);
+
+	if (retainCount == SHARED_MERGED) {
+		of_memory_barrier_acquire();
+
+		[self dealloc];
+	} else if OF_UNLIKELY (retainCount < 0)
+		queueForOwner(preIvars, retainCount);
+#elif defined(OF_HAVE_ATOMIC_OPS)
 	of_memory_barrier_release();
 
 	if (of_atomic_int_dec(&PRE_IVARS->retainCount) <= 0) {
@@ -1157,9 +1466,9 @@ _references_to_categories_of_OFObject(void)
 #else
 	int retainCount;
 
-	OF_ENSURE(of_spinlock_lock(&PRE_IVARS->retainCountSpinlock));
+	OF_ENSURE(of_spinlock_lock(RETAIN_COUNT_SPINLOCK));
 	retainCount = --PRE_IVARS->retainCount;
-	OF_ENSURE(of_spinlock_unlock(&PRE_IVARS->retainCountSpinlock));
+	OF_ENSURE(of_spinlock_unlock(RETAIN_COUNT_SPINLOCK));
 
 	if (retainCount == 0)
 		[self dealloc];
@@ -68,6 +68,10 @@ OF_SUBCLASSING_RESTRICTED
 #endif
 	of_run_loop_mode_t _Nullable _currentMode;
 	volatile bool _stop;
+#ifdef OF_HAVE_SOCKETS
+	bool _usesEdgeTriggering, _observesListeningSocketsExclusively;
+	size_t _maximumEventsPerObserve;
+#endif
 }
 
 #ifdef OF_HAVE_CLASS_PROPERTIES
@@ -77,6 +81,43 @@ OF_SUBCLASSING_RESTRICTED
 @property OF_NULLABLE_PROPERTY (readonly, nonatomic)
     of_run_loop_mode_t currentMode;
 
+#ifdef OF_HAVE_SOCKETS
+/**
+ * @brief Whether the kernel event observers of the run loop use edge
+ *	  triggering.
+ *
+ * See @ref OFKernelEventObserver.usesEdgeTriggering.
+ *
+ * This applies to the observers of all modes, but only to objects added
+ * afterwards, so it should be set before any asynchronous requests are made
+ * on the run loop, and only from the thread of the run loop.
+ */
+@property (nonatomic) bool usesEdgeTriggering;
+
+/**
+ * @brief Whether the kernel event observers of the run loop observe listening
+ *	  sockets exclusively.
+ *
+ * See @ref OFKernelEventObserver.observesListeningSocketsExclusively.
+ *
+ * This applies to the observers of all modes, but only to objects added
+ * afterwards, so it should be set before any asynchronous accepts are made
+ * on the run loop, and only from the thread of the run loop.
+ */
+@property (nonatomic) bool observesListeningSocketsExclusively;
+
+/**
+ * @brief The maximum number of events the kernel event observers of the run
+ *	  loop retrieve in one observe call, or 0 for the default.
+ *
+ * See @ref OFKernelEventObserver.maximumEventsPerObserve.
+ *
+ * This applies to the observers of all modes and should only be set from the
+ * thread of the run loop.
+ */
+@property (nonatomic) size_t maximumEventsPerObserve;
+#endif
+
 /**
  * @brief Returns the run loop for the main thread.
  *
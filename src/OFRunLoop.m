@@ -15,6 +15,8 @@
  * file.
  */
 
+#define OF_RUN_LOOP_M
+
 #include "config.h"
 
 #include <assert.h>
@@ -38,7 +40,7 @@
 # import "OFMutex.h"
 # import "OFCondition.h"
 #endif
-#import "OFSortedList.h"
+#import "OFList.h"
 #import "OFTimer.h"
 #import "OFTimer+Private.h"
 #import "OFDate.h"
@@ -54,7 +56,8 @@ static OFRunLoop *mainRunLoop = nil;
 #endif
 {
 @public
-	OFSortedList OF_GENERIC(OFTimer *) *_timersQueue;
+	OFTimer *_timersQueue;
+	unsigned long long _timersQueueSequence;
 #ifdef OF_HAVE_THREADS
 	OFMutex *_timersQueueMutex;
 #endif
@@ -82,6 +85,10 @@ OF_DIRECT_MEMBERS
 @interface OFRunLoop ()
 - (OFRunLoopState *)of_stateForMode: (of_run_loop_mode_t)mode
 			     create: (bool)create;
+#ifdef OF_HAVE_SOCKETS
+- (void)of_configureKernelEventObserverOfState: (OFRunLoopState *)state;
+- (void)of_configureKernelEventObservers;
+#endif
 @end
 
 #ifdef OF_HAVE_SOCKETS
@@ -207,13 +214,174 @@ OF_DIRECT_MEMBERS
 @end
 #endif
 
+/*
+ * The timers are kept in a pairing heap ordered by the latest date at which
+ * they need to fire. Inserting and rescheduling are O(1) and removing is
+ * O(log n) amortized. The nodes are the timers themselves.
+ */
+static bool
+timerFiresBefore(OFTimer *timer1, OFTimer *timer2)
+{
+	if (timer1->_queueDeadline != timer2->_queueDeadline)
+		return (timer1->_queueDeadline < timer2->_queueDeadline);
+
+	/* Timers with the same deadline fire in the order they were added. */
+	return (timer1->_queueSequence < timer2->_queueSequence);
+}
+
+static OFTimer *
+meldTimers(OFTimer *timer1, OFTimer *timer2)
+{
+	OFTimer *tmp;
+
+	if (timer1 == nil)
+		return timer2;
+	if (timer2 == nil)
+		return timer1;
+
+	if (timerFiresBefore(timer2, timer1)) {
+		tmp = timer1;
+		timer1 = timer2;
+		timer2 = tmp;
+	}
+
+	timer2->_queuePrevious = timer1;
+	timer2->_queueSibling = timer1->_queueChild;
+	if (timer1->_queueChild != nil)
+		timer1->_queueChild->_queuePrevious = timer2;
+	timer1->_queueChild = timer2;
+
+	timer1->_queuePrevious = nil;
+	timer1->_queueSibling = nil;
+
+	return timer1;
+}
+
+static OFTimer *
+meldTimerPairs(OFTimer *first)
+{
+	OFTimer *pairs = nil, *root = nil;
+
+	/* First pass: Meld pairs from left to right. */
+	while (first != nil) {
+		OFTimer *timer1 = first, *timer2 = first->_queueSibling;
+
+		first = (timer2 != nil ? timer2->_queueSibling : nil);
+
+		timer1->_queuePrevious = timer1->_queueSibling = nil;
+		if (timer2 != nil)
+			timer2->_queuePrevious = timer2->_queueSibling = nil;
+
+		timer1 = meldTimers(timer1, timer2);
+		timer1->_queueSibling = pairs;
+		pairs = timer1;
+	}
+
+	/* Second pass: Meld the pairs from right to left. */
+	while (pairs != nil) {
+		OFTimer *next = pairs->_queueSibling;
+
+		pairs->_queueSibling = nil;
+		root = meldTimers(pairs, root);
+		pairs = next;
+	}
+
+	return root;
+}
+
+static void
+insertTimer(OFRunLoopState *state, OFTimer *timer)
+{
+	timer->_queue = state;
+	timer->_queueDeadline =
+	    timer.fireDate.timeIntervalSince1970 + timer.tolerance;
+	timer->_queueSequence = state->_timersQueueSequence++;
+	timer->_queueChild = timer->_queueSibling = nil;
+	timer->_queuePrevious = nil;
+
+	state->_timersQueue = meldTimers(state->_timersQueue,
+	    [timer retain]);
+}
+
+static bool
+removeTimer(OFRunLoopState *state, OFTimer *timer)
+{
+	OFTimer *children;
+
+	if (timer->_queue != state)
+		return false;
+
+	children = meldTimerPairs(timer->_queueChild);
+
+	if (timer == state->_timersQueue)
+		state->_timersQueue = children;
+	else {
+		if (timer->_queuePrevious->_queueChild == timer)
+			timer->_queuePrevious->_queueChild =
+			    timer->_queueSibling;
+		else
+			timer->_queuePrevious->_queueSibling =
+			    timer->_queueSibling;
+
+		if (timer->_queueSibling != nil)
+			timer->_queueSibling->_queuePrevious =
+			    timer->_queuePrevious;
+
+		state->_timersQueue = meldTimers(state->_timersQueue,
+		    children);
+	}
+
+	timer->_queue = nil;
+	timer->_queueChild = timer->_queueSibling = nil;
+	timer->_queuePrevious = nil;
+
+	return true;
+}
+
+/* Removes the timer, leaving the reference of the queue to the caller. */
+static bool
+unscheduleTimer(OFRunLoopState *state, OFTimer *timer)
+{
+	bool removed;
+
+#ifdef OF_HAVE_THREADS
+	[state->_timersQueueMutex lock];
+	@try {
+#endif
+		removed = removeTimer(state, timer);
+#ifdef OF_HAVE_THREADS
+	} @finally {
+		[state->_timersQueueMutex unlock];
+	}
+#endif
+
+	return removed;
+}
+
+/*
+ * Removes the timer from whichever queue it is in, leaving the reference of
+ * the queue to the caller. The queue of the timer can only be trusted while
+ * the lock of that queue is held, so it is checked again under the lock and
+ * this is retried if another thread moved the timer in the meantime.
+ */
+static bool
+unscheduleTimerFromAnyQueue(OFTimer *timer)
+{
+	OFRunLoopState *state;
+
+	while ((state = timer->_queue) != nil)
+		if (unscheduleTimer(state, timer))
+			return true;
+
+	return false;
+}
+
 @implementation OFRunLoopState
 - (instancetype)init
 {
 	self = [super init];
 
 	@try {
-		_timersQueue = [[OFSortedList alloc] init];
 #ifdef OF_HAVE_THREADS
 		_timersQueueMutex = [[OFMutex alloc] init];
 #endif
@@ -247,7 +415,12 @@ OF_DIRECT_MEMBERS
 
 - (void)dealloc
 {
-	[_timersQueue release];
+	while (_timersQueue != nil) {
+		OFTimer *timer = _timersQueue;
+
+		removeTimer(self, timer);
+		[timer release];
+	}
 #ifdef OF_HAVE_THREADS
 	[_timersQueueMutex release];
 #endif
@@ -576,8 +749,18 @@ OF_DIRECT_MEMBERS
 	@try {
 		const char *dataItems = _data.items;
 
-		length = [object writeBuffer: dataItems + _writtenLength
-				      length: dataLength - _writtenLength];
+		if ([object isKindOfClass: [OFStreamSocket class]]) {
+			/* Never block the run loop on a slow peer. */
+			const void *buffer = dataItems + _writtenLength;
+			size_t bufferLength = dataLength - _writtenLength;
+
+			length = [object of_writeBuffers: &buffer
+						 lengths: &bufferLength
+						   count: 1];
+		} else
+			length = [object
+			    writeBuffer: dataItems + _writtenLength
+				 length: dataLength - _writtenLength];
 	} @catch (id e) {
 		length = 0;
 		exception = e;
@@ -648,8 +831,17 @@ OF_DIRECT_MEMBERS
 	@try {
 		const char *cString = [_string cStringWithEncoding: _encoding];
 
-		length = [object writeBuffer: cString + _writtenLength
-				      length: cStringLength - _writtenLength];
+		if ([object isKindOfClass: [OFStreamSocket class]]) {
+			const void *buffer = cString + _writtenLength;
+			size_t bufferLength = cStringLength - _writtenLength;
+
+			length = [object of_writeBuffers: &buffer
+						 lengths: &bufferLength
+						   count: 1];
+		} else
+			length = [object
+			    writeBuffer: cString + _writtenLength
+				 length: cStringLength - _writtenLength];
 	} @catch (id e) {
 		length = 0;
 		exception = e;
@@ -1372,6 +1564,66 @@ OF_DIRECT_MEMBERS
 	[super dealloc];
 }
 
+#ifdef OF_HAVE_SOCKETS
+- (bool)usesEdgeTriggering
+{
+	return _usesEdgeTriggering;
+}
+
+- (void)setUsesEdgeTriggering: (bool)usesEdgeTriggering
+{
+	_usesEdgeTriggering = usesEdgeTriggering;
+	[self of_configureKernelEventObservers];
+}
+
+- (bool)observesListeningSocketsExclusively
+{
+	return _observesListeningSocketsExclusively;
+}
+
+- (void)setObservesListeningSocketsExclusively: (bool)exclusively
+{
+	_observesListeningSocketsExclusively = exclusively;
+	[self of_configureKernelEventObservers];
+}
+
+- (size_t)maximumEventsPerObserve
+{
+	return _maximumEventsPerObserve;
+}
+
+- (void)setMaximumEventsPerObserve: (size_t)maximumEventsPerObserve
+{
+	_maximumEventsPerObserve = maximumEventsPerObserve;
+	[self of_configureKernelEventObservers];
+}
+
+- (void)of_configureKernelEventObserverOfState: (OFRunLoopState *)state
+{
+	OFKernelEventObserver *observer = state->_kernelEventObserver;
+
+	observer.usesEdgeTriggering = _usesEdgeTriggering;
+	observer.observesListeningSocketsExclusively =
+	    _observesListeningSocketsExclusively;
+	observer.maximumEventsPerObserve = _maximumEventsPerObserve;
+}
+
+- (void)of_configureKernelEventObservers
+{
+# ifdef OF_HAVE_THREADS
+	[_statesMutex lock];
+	@try {
+# endif
+		for (OFRunLoopState *state in [_states objectEnumerator])
+			[self of_configureKernelEventObserverOfState: state];
+# ifdef OF_HAVE_THREADS
+	} @finally {
+		[_statesMutex unlock];
+	}
+# endif
+}
+#endif
+
 - (OFRunLoopState *)of_stateForMode: (of_run_loop_mode_t)mode
 			     create: (bool)create
 {
@@ -1386,6 +1638,10 @@ OF_DIRECT_MEMBERS
 		if (create && state == nil) {
 			state = [[OFRunLoopState alloc] init];
 			@try {
+#ifdef OF_HAVE_SOCKETS
+				[self of_configureKernelEventObserverOfState:
+				    state];
+#endif
 				[_states setObject: state
 					    forKey: mode];
 			} @finally {
@@ -1413,11 +1669,15 @@ OF_DIRECT_MEMBERS
 	OFRunLoopState *state = [self of_stateForMode: mode
 					       create: true];
 
+	/* A timer can only be scheduled once. */
+	if (unscheduleTimerFromAnyQueue(timer))
+		[timer autorelease];
+
 #ifdef OF_HAVE_THREADS
 	[state->_timersQueueMutex lock];
 	@try {
 #endif
-		[state->_timersQueue insertObject: timer];
+		insertTimer(state, timer);
 #ifdef OF_HAVE_THREADS
 	} @finally {
 		[state->_timersQueueMutex unlock];
@@ -1443,24 +1703,11 @@ OF_DIRECT_MEMBERS
 	if (state == nil)
 		return;
 
-#ifdef OF_HAVE_THREADS
-	[state->_timersQueueMutex lock];
-	@try {
-#endif
-		of_list_object_t *iter;
-
-		for (iter = state->_timersQueue.firstListObject; iter != NULL;
-		    iter = iter->next) {
-			if ([iter->object isEqual: timer]) {
-				[state->_timersQueue removeListObject: iter];
-				break;
-			}
-		}
-#ifdef OF_HAVE_THREADS
-	} @finally {
-		[state->_timersQueueMutex unlock];
+	if (unscheduleTimer(state, timer)) {
+		[timer of_setInRunLoop: nil
+				  mode: nil];
+		[timer release];
 	}
-#endif
 }
 
 #ifdef OF_AMIGAOS
@@ -1601,7 +1848,8 @@ OF_DIRECT_MEMBERS
 
 	_currentMode = mode;
 	@try {
-		OFDate *nextTimer;
+		of_time_interval_t now, nextTimer = 0;
+		bool hasNextTimer;
 #if defined(OF_AMIGAOS) && !defined(OF_HAVE_SOCKETS) && defined(OF_HAVE_THREADS)
 		ULONG signalMask;
 #endif
@@ -1609,20 +1857,24 @@ OF_DIRECT_MEMBERS
 		for (;;) {
 			OFTimer *timer;
 
+			now = [OFDate date].timeIntervalSince1970;
+
 #ifdef OF_HAVE_THREADS
 			[state->_timersQueueMutex lock];
 			@try {
 #endif
-				of_list_object_t *listObject =
-				    state->_timersQueue.firstListObject;
-
-				if (listObject != NULL && [listObject->object
-				    fireDate].timeIntervalSinceNow <= 0) {
-					timer = [[listObject->object
-					    retain] autorelease];
+				/*
+				 * Fire the timer with the earliest deadline as
+				 * soon as its fire date has passed. This way,
+				 * timers with a tolerance are fired together
+				 * with the timer that caused the wakeup.
+				 */
+				timer = state->_timersQueue;
 
-					[state->_timersQueue
-					    removeListObject: listObject];
+				if (timer != nil && timer->_queueDeadline -
+				    timer.tolerance <= now) {
+					removeTimer(state, timer);
+					[timer autorelease];
 
 					[timer of_setInRunLoop: nil
 							  mode: nil];
@@ -1644,8 +1896,9 @@ OF_DIRECT_MEMBERS
 		[state->_timersQueueMutex lock];
 		@try {
 #endif
-			nextTimer = [[state->_timersQueue
-			    firstObject] fireDate];
+			hasNextTimer = (state->_timersQueue != nil);
+			if (hasNextTimer)
+				nextTimer = state->_timersQueue->_queueDeadline;
 #ifdef OF_HAVE_THREADS
 		} @finally {
 			[state->_timersQueueMutex unlock];
@@ -1653,16 +1906,19 @@ OF_DIRECT_MEMBERS
 #endif
 
 		/* Watch for I/O events until the next timer is due */
-		if (nextTimer != nil || deadline != nil) {
+		if (hasNextTimer || deadline != nil) {
 			of_time_interval_t timeout;
 
-			if (nextTimer != nil && deadline == nil)
-				timeout = nextTimer.timeIntervalSinceNow;
-			else if (nextTimer == nil && deadline != nil)
+			if (hasNextTimer && deadline == nil)
+				timeout = nextTimer - now;
+			else if (!hasNextTimer && deadline != nil)
 				timeout = deadline.timeIntervalSinceNow;
-			else
-				timeout = [nextTimer earlierDate: deadline]
-				    .timeIntervalSinceNow;
+			else {
+				timeout = nextTimer - now;
+
+				if (deadline.timeIntervalSinceNow < timeout)
+					timeout = deadline.timeIntervalSinceNow;
+			}
 
 			if (timeout < 0)
 				timeout = 0;
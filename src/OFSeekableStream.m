@@ -55,8 +55,8 @@
 	offset = [self lowlevelSeekToOffset: offset
 				     whence: whence];
 
-	free(_readBufferMemory);
-	_readBuffer = _readBufferMemory = NULL;
+	/* Keep the memory of the read buffer around for reuse */
+	_readBuffer = _readBufferMemory;
 	_readBufferLength = 0;
 
 	return offset;
@@ -19,10 +19,33 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+#ifdef OF_HAVE_SOCKETS
+@class OFKernelEventObserver;
+#endif
+
 OF_DIRECT_MEMBERS
 @interface OFStream ()
 @property (readonly, nonatomic, getter=of_isWaitingForDelimiter)
     bool of_waitingForDelimiter;
+
+- (void)of_reserveReadBufferSpace: (size_t)length;
+- (void)of_consumeReadBuffer: (size_t)length;
+- (size_t)of_fillReadBuffer;
+- (OFString *)of_takeStringWithLength: (size_t)length
+			     skipping: (size_t)skip
+			     encoding: (of_string_encoding_t)encoding;
+- (OFString *)of_takeLineWithLength: (size_t)length
+			   skipping: (size_t)skip
+			   encoding: (of_string_encoding_t)encoding;
+#ifdef OF_HAVE_SOCKETS
+@property OF_NULLABLE_PROPERTY (assign, nonatomic,
+    setter=of_setReadBufferObserver:)
+    OFKernelEventObserver *of_readBufferObserver;
+@property (nonatomic, getter=of_isReadBufferPending,
+    setter=of_setReadBufferPending:) bool of_readBufferPending;
+
+- (void)of_readBufferDidFill;
+#endif
 @end
 
 OF_ASSUME_NONNULL_END
@@ -198,7 +198,12 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
 	char *_Nullable _readBuffer, *_Nullable _readBufferMemory;
 	char *_Nullable _writeBuffer;
 	size_t _readBufferLength, _writeBufferLength;
+	size_t _readBufferCapacity, _readBufferSize;
 	bool _buffersWrites, _waitingForDelimiter;
+#ifdef OF_HAVE_SOCKETS
+	id _Nullable _readBufferObserver;
+	bool _readBufferPending;
+#endif
 	OF_RESERVE_IVARS(OFStream, 4)
 }
 
@@ -217,6 +222,19 @@ typedef OFString *_Nullable (^of_stream_async_write_string_block_t)(
  */
 @property (readonly, nonatomic) bool hasDataInReadBuffer;
 
+/**
+ * @brief The size in bytes of the read buffer the stream keeps allocated.
+ *
+ * Data read ahead by the stream, for example while looking for the end of a
+ * line, is stored in a buffer that is reused for the whole lifetime of the
+ * stream. This is also the number of bytes requested from the underlying
+ * stream at once while looking for a delimiter. The buffer grows as needed for
+ * longer lines and shrinks back to this size once it has been drained.
+ *
+ * By default, this is the page size.
+ */
+@property (nonatomic) size_t readBufferSize;
+
 /**
  * @brief Whether the stream can block.
  *
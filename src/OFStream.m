@@ -44,6 +44,9 @@
 #import "OFStream+Private.h"
 #import "OFData.h"
 #import "OFKernelEventObserver.h"
+#ifdef OF_HAVE_SOCKETS
+# import "OFKernelEventObserver+Private.h"
+#endif
 #import "OFRunLoop+Private.h"
 #import "OFRunLoop.h"
 #import "OFString.h"
@@ -62,9 +65,80 @@
 
 #define MIN_READ_SIZE 512
 
+/* Returns the index of the first \n or \0 in the range, or SIZE_MAX. */
+static size_t
+findLineEnd(const char *buffer, size_t start, size_t end)
+{
+	const char *newline, *nul;
+
+	if (start >= end)
+		return SIZE_MAX;
+
+	newline = memchr(buffer + start, '\n', end - start);
+	nul = memchr(buffer + start, '\0',
+	    (newline != NULL ? (size_t)(newline - buffer) : end) - start);
+
+	if (nul != NULL)
+		return nul - buffer;
+	if (newline != NULL)
+		return newline - buffer;
+
+	return SIZE_MAX;
+}
+
+/*
+ * Returns the index of the first delimiter or \0 in the range, whichever comes
+ * first, or SIZE_MAX. The length of what was found is returned in matchLength.
+ */
+static size_t
+findDelimiter(const char *buffer, size_t start, size_t end,
+    const char *delimiter, size_t delimiterLength, size_t *matchLength)
+{
+	const char *iter = buffer + start, *last = buffer + end;
+	const char *found = NULL, *nul;
+
+	if (start >= end)
+		return SIZE_MAX;
+
+	while ((size_t)(last - iter) >= delimiterLength) {
+		iter = memchr(iter, delimiter[0],
+		    last - iter - delimiterLength + 1);
+
+		if (iter == NULL)
+			break;
+
+		if (memcmp(iter + 1, delimiter + 1, delimiterLength - 1) == 0) {
+			found = iter;
+			break;
+		}
+
+		iter++;
+	}
+
+	/* The delimiter cannot contain \0, so only look before it. */
+	nul = memchr(buffer + start, '\0',
+	    (found != NULL ? found : last) - (buffer + start));
+
+	if (nul != NULL) {
+		*matchLength = 1;
+		return nul - buffer;
+	}
+
+	if (found != NULL) {
+		*matchLength = delimiterLength;
+		return found - buffer;
+	}
+
+	return SIZE_MAX;
+}
+
 @implementation OFStream
 @synthesize buffersWrites = _buffersWrites;
 @synthesize of_waitingForDelimiter = _waitingForDelimiter, delegate = _delegate;
+#ifdef OF_HAVE_SOCKETS
+@synthesize of_readBufferObserver = _readBufferObserver;
+@synthesize of_readBufferPending = _readBufferPending;
+#endif
 
 #if defined(SIGPIPE) && defined(SIG_IGN)
 + (void)initialize
@@ -85,6 +159,7 @@
 		}
 
 		_canBlock = true;
+		_readBufferSize = [OFSystemInfo pageSize];
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -135,57 +210,127 @@
 		  length: (size_t)length
 {
 	if (_readBufferLength == 0) {
+		size_t bytesRead;
+
 		/*
 		 * For small sizes, it is cheaper to read more and cache the
 		 * remainder - even if that means more copying of data - than
 		 * to do a syscall for every read.
 		 */
-		if (length < MIN_READ_SIZE) {
-			char tmp[MIN_READ_SIZE], *readBuffer;
-			size_t bytesRead;
+		if (length >= MIN_READ_SIZE)
+			return [self lowlevelReadIntoBuffer: buffer
+						     length: length];
 
-			bytesRead = [self
-			    lowlevelReadIntoBuffer: tmp
-					    length: MIN_READ_SIZE];
+		bytesRead = [self of_fillReadBuffer];
 
-			if (bytesRead > length) {
-				memcpy(buffer, tmp, length);
+		if (bytesRead <= length) {
+			memcpy(buffer, _readBuffer, bytesRead);
+			[self of_consumeReadBuffer: bytesRead];
 
-				readBuffer = of_alloc(bytesRead - length, 1);
-				memcpy(readBuffer, tmp + length,
-				    bytesRead - length);
+			return bytesRead;
+		}
 
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bytesRead - length;
+		memcpy(buffer, _readBuffer, length);
+		[self of_consumeReadBuffer: length];
+#ifdef OF_HAVE_SOCKETS
+		[self of_readBufferDidFill];
+#endif
 
-				return length;
-			} else {
-				memcpy(buffer, tmp, bytesRead);
-				return bytesRead;
-			}
-		}
+		return length;
+	}
+
+	if (length > _readBufferLength)
+		length = _readBufferLength;
+
+	memcpy(buffer, _readBuffer, length);
+	[self of_consumeReadBuffer: length];
+
+	return length;
+}
+
+- (void)setReadBufferSize: (size_t)readBufferSize
+{
+	if (readBufferSize == 0)
+		@throw [OFInvalidArgumentException exception];
+
+	_readBufferSize = readBufferSize;
+}
 
-		return [self lowlevelReadIntoBuffer: buffer
-					     length: length];
+- (size_t)readBufferSize
+{
+	return _readBufferSize;
+}
+
+- (void)of_reserveReadBufferSpace: (size_t)length
+{
+	size_t offset = (_readBufferMemory != NULL
+	    ? (size_t)(_readBuffer - _readBufferMemory) : 0);
+	size_t capacity;
+
+	if (_readBufferCapacity - offset - _readBufferLength >= length)
+		return;
+
+	if (length > SIZE_MAX - _readBufferLength)
+		@throw [OFOutOfRangeException exception];
+
+	/* Move the buffered data to the front first, this might be enough. */
+	if (offset > 0) {
+		memmove(_readBufferMemory, _readBuffer, _readBufferLength);
+		_readBuffer = _readBufferMemory;
 	}
 
-	if (length >= _readBufferLength) {
-		size_t ret = _readBufferLength;
-		memcpy(buffer, _readBuffer, _readBufferLength);
+	if (_readBufferCapacity - _readBufferLength >= length)
+		return;
 
-		free(_readBufferMemory);
-		_readBuffer = _readBufferMemory = NULL;
-		_readBufferLength = 0;
+	capacity = (_readBufferCapacity > _readBufferSize
+	    ? _readBufferCapacity : _readBufferSize);
+	while (capacity - _readBufferLength < length)
+		capacity = (capacity <= SIZE_MAX / 2
+		    ? capacity * 2 : _readBufferLength + length);
 
-		return ret;
-	} else {
-		memcpy(buffer, _readBuffer, length);
+	_readBuffer = _readBufferMemory =
+	    of_realloc(_readBufferMemory, capacity, 1);
+	_readBufferCapacity = capacity;
+}
 
-		_readBuffer += length;
-		_readBufferLength -= length;
+- (void)of_consumeReadBuffer: (size_t)length
+{
+	_readBuffer += length;
+	_readBufferLength -= length;
 
-		return length;
+	if (_readBufferLength > 0)
+		return;
+
+	/*
+	 * Give back memory that was only needed for a long line. Up to twice
+	 * the read buffer size is kept, as that is what a full read of the
+	 * read buffer size needs if there is still a partial line left.
+	 */
+	if (_readBufferCapacity / 2 > _readBufferSize) {
+		free(_readBufferMemory);
+		_readBufferMemory = NULL;
+		_readBufferCapacity = 0;
 	}
+
+	_readBuffer = _readBufferMemory;
+}
+
+- (size_t)of_fillReadBuffer
+{
+	size_t length, bytesRead;
+	char *buffer;
+
+	[self of_reserveReadBufferSpace: _readBufferSize];
+
+	/* Use all the space there is. */
+	buffer = _readBuffer + _readBufferLength;
+	length = _readBufferMemory + _readBufferCapacity - buffer;
+
+	bytesRead = [self lowlevelReadIntoBuffer: buffer
+					  length: length];
+	_readBufferLength += bytesRead;
+
+	return bytesRead;
 }
 
 - (void)readIntoBuffer: (void *)buffer
@@ -710,148 +855,82 @@
 	return ret;
 }
 
-- (OFString *)tryReadLineWithEncoding: (of_string_encoding_t)encoding
+- (OFString *)of_takeStringWithLength: (size_t)length
+			     skipping: (size_t)skip
+			     encoding: (of_string_encoding_t)encoding
 {
-	size_t pageSize, bufferLength;
-	char *buffer, *readBuffer;
 	OFString *ret;
 
-	/* Look if there's a line or \0 in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if OF_UNLIKELY (_readBuffer[i] == '\n' ||
-			    _readBuffer[i] == '\0') {
-				size_t retLength = i;
-
-				if (i > 0 && _readBuffer[i - 1] == '\r')
-					retLength--;
-
-				ret = [OFString stringWithCString: _readBuffer
-							 encoding: encoding
-							   length: retLength];
-
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
+	_waitingForDelimiter = false;
 
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	/* If this fails, the data stays in the read buffer. */
+	@try {
+		ret = [OFString stringWithCString: _readBuffer
+					 encoding: encoding
+					   length: length];
+	} @catch (id e) {
+#ifdef OF_HAVE_SOCKETS
+		[self of_readBufferDidFill];
+#endif
+		@throw e;
 	}
 
-	/* Read and see if we got a newline or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = of_alloc(1, pageSize);
+	[self of_consumeReadBuffer: length + skip];
+#ifdef OF_HAVE_SOCKETS
+	[self of_readBufferDidFill];
+#endif
 
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			size_t retLength;
+	return ret;
+}
 
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
+- (OFString *)of_takeLineWithLength: (size_t)length
+			   skipping: (size_t)skip
+			   encoding: (of_string_encoding_t)encoding
+{
+	if (length > 0 && _readBuffer[length - 1] == '\r')
+		return [self of_takeStringWithLength: length - 1
+					    skipping: skip + 1
+					    encoding: encoding];
 
-			retLength = _readBufferLength;
+	return [self of_takeStringWithLength: length
+				    skipping: skip
+				    encoding: encoding];
+}
 
-			if (retLength > 0 && _readBuffer[retLength - 1] == '\r')
-				retLength--;
+- (OFString *)tryReadLineWithEncoding: (of_string_encoding_t)encoding
+{
+	size_t searchStart, lineEnd;
 
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: retLength];
+	/* Look if there's a line or \0 in our buffer */
+	if (!_waitingForDelimiter) {
+		lineEnd = findLineEnd(_readBuffer, 0, _readBufferLength);
 
-			free(_readBufferMemory);
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
+		if (lineEnd != SIZE_MAX)
+			return [self of_takeLineWithLength: lineEnd
+						  skipping: 1
+						  encoding: encoding];
+	}
 
-			_waitingForDelimiter = false;
-			return ret;
-		}
+	if ([self lowlevelIsAtEndOfStream]) {
+		_waitingForDelimiter = false;
 
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a newline or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if OF_UNLIKELY (buffer[i] == '\n' ||
-			    buffer[i] == '\0') {
-				size_t retLength = _readBufferLength + i;
-				char *retCString = of_alloc(retLength, 1);
-
-				if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				memcpy(retCString + _readBufferLength,
-				    buffer, i);
-
-				if (retLength > 0 &&
-				    retCString[retLength - 1] == '\r')
-					retLength--;
-
-				@try {
-					ret = [OFString
-					    stringWithCString: retCString
-						     encoding: encoding
-						       length: retLength];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = of_alloc(
-						    _readBufferLength +
-						    bufferLength, 1);
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						free(_readBufferMemory);
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					free(retCString);
-				}
-
-				readBuffer = of_alloc(bufferLength - i - 1, 1);
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				free(_readBufferMemory);
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+		if (_readBufferLength == 0)
+			return nil;
 
-		/* There was no newline or \0 */
-		if (bufferLength > 0) {
-			readBuffer = of_alloc(_readBufferLength + bufferLength,
-			    1);
+		return [self of_takeLineWithLength: _readBufferLength
+					  skipping: 0
+					  encoding: encoding];
+	}
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+	/* Read and see if we got a newline or \0 */
+	searchStart = _readBufferLength;
+	[self of_fillReadBuffer];
 
-			free(_readBufferMemory);
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		free(buffer);
-	}
+	lineEnd = findLineEnd(_readBuffer, searchStart, _readBufferLength);
+	if (lineEnd != SIZE_MAX)
+		return [self of_takeLineWithLength: lineEnd
+					  skipping: 1
+					  encoding: encoding];
 
 	_waitingForDelimiter = true;
 	return nil;
@@ -942,163 +1021,55 @@
 			  encoding: (of_string_encoding_t)encoding
 {
 	const char *delimiterCString;
-	size_t j, delimiterLength, pageSize, bufferLength;
-	char *buffer, *readBuffer;
-	OFString *ret;
+	size_t delimiterLength, searchStart, matchLength, end;
 
 	delimiterCString = [delimiter cStringWithEncoding: encoding];
 	delimiterLength = [delimiter cStringLengthWithEncoding: encoding];
-	j = 0;
 
 	if (delimiterLength == 0)
 		@throw [OFInvalidArgumentException exception];
 
 	/* Look if there's something in our buffer */
-	if (!_waitingForDelimiter && _readBuffer != NULL) {
-		for (size_t i = 0; i < _readBufferLength; i++) {
-			if (_readBuffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || _readBuffer[i] == '\0') {
-				if (_readBuffer[i] == '\0')
-					delimiterLength = 1;
-
-				ret = [OFString
-				    stringWithCString: _readBuffer
-					     encoding: encoding
-					      length: i + 1 - delimiterLength];
-
-				_readBuffer += i + 1;
-				_readBufferLength -= i + 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
+	if (!_waitingForDelimiter) {
+		end = findDelimiter(_readBuffer, 0, _readBufferLength,
+		    delimiterCString, delimiterLength, &matchLength);
+
+		if (end != SIZE_MAX)
+			return [self of_takeStringWithLength: end
+						    skipping: matchLength
+						    encoding: encoding];
 	}
 
-	/* Read and see if we got a delimiter or \0 */
-	pageSize = [OFSystemInfo pageSize];
-	buffer = of_alloc(1, pageSize);
-
-	@try {
-		if ([self lowlevelIsAtEndOfStream]) {
-			if (_readBuffer == NULL) {
-				_waitingForDelimiter = false;
-				return nil;
-			}
-
-			ret = [OFString stringWithCString: _readBuffer
-						 encoding: encoding
-						   length: _readBufferLength];
-
-			free(_readBufferMemory);
-			_readBuffer = _readBufferMemory = NULL;
-			_readBufferLength = 0;
-
-			_waitingForDelimiter = false;
-			return ret;
-		}
-
-		bufferLength = [self lowlevelReadIntoBuffer: buffer
-						     length: pageSize];
-
-		/* Look if there's a delimiter or \0 */
-		for (size_t i = 0; i < bufferLength; i++) {
-			if (buffer[i] != delimiterCString[j++])
-				j = 0;
-
-			if (j == delimiterLength || buffer[i] == '\0') {
-				size_t retLength;
-				char *retCString;
-
-				if (buffer[i] == '\0')
-					delimiterLength = 1;
-
-				retLength = _readBufferLength + i + 1 -
-				    delimiterLength;
-				retCString = of_alloc(retLength, 1);
-
-				if (_readBuffer != NULL &&
-				    _readBufferLength <= retLength)
-					memcpy(retCString, _readBuffer,
-					    _readBufferLength);
-				else if (_readBuffer != NULL)
-					memcpy(retCString, _readBuffer,
-					    retLength);
-				if (i >= delimiterLength)
-					memcpy(retCString + _readBufferLength,
-					    buffer, i + 1 - delimiterLength);
-
-				@try {
-					ret = [OFString
-					    stringWithCString: retCString
-						     encoding: encoding
-						       length: retLength];
-				} @catch (id e) {
-					if (bufferLength > 0) {
-						/*
-						 * Append data to _readBuffer
-						 * to prevent loss of data.
-						 */
-						readBuffer = of_alloc(
-						    _readBufferLength +
-						    bufferLength, 1);
-
-						memcpy(readBuffer, _readBuffer,
-						    _readBufferLength);
-						memcpy(readBuffer +
-						    _readBufferLength,
-						    buffer, bufferLength);
-
-						free(_readBufferMemory);
-						_readBuffer = readBuffer;
-						_readBufferMemory = readBuffer;
-						_readBufferLength +=
-						    bufferLength;
-					}
-
-					@throw e;
-				} @finally {
-					free(retCString);
-				}
-
-				readBuffer = of_alloc(bufferLength - i - 1, 1);
-				if (readBuffer != NULL)
-					memcpy(readBuffer, buffer + i + 1,
-					    bufferLength - i - 1);
-
-				free(_readBufferMemory);
-				_readBuffer = _readBufferMemory = readBuffer;
-				_readBufferLength = bufferLength - i - 1;
-
-				_waitingForDelimiter = false;
-				return ret;
-			}
-		}
-
-		/* Neither the delimiter nor \0 was found */
-		if (bufferLength > 0) {
-			readBuffer = of_alloc(_readBufferLength + bufferLength,
-			    1);
+	if ([self lowlevelIsAtEndOfStream]) {
+		_waitingForDelimiter = false;
 
-			memcpy(readBuffer, _readBuffer, _readBufferLength);
-			memcpy(readBuffer + _readBufferLength,
-			    buffer, bufferLength);
+		if (_readBufferLength == 0)
+			return nil;
 
-			free(_readBufferMemory);
-			_readBuffer = _readBufferMemory = readBuffer;
-			_readBufferLength += bufferLength;
-		}
-	} @finally {
-		free(buffer);
+		return [self of_takeStringWithLength: _readBufferLength
+					    skipping: 0
+					    encoding: encoding];
 	}
 
+	/*
+	 * Read and see if we got a delimiter or \0. The delimiter might
+	 * start in the data that was already in the buffer.
+	 */
+	searchStart = (_readBufferLength >= delimiterLength - 1
+	    ? _readBufferLength - (delimiterLength - 1) : 0);
+	[self of_fillReadBuffer];
+
+	end = findDelimiter(_readBuffer, searchStart, _readBufferLength,
+	    delimiterCString, delimiterLength, &matchLength);
+	if (end != SIZE_MAX)
+		return [self of_takeStringWithLength: end
+					    skipping: matchLength
+					    encoding: encoding];
+
 	_waitingForDelimiter = true;
 	return nil;
 }
 
-
 - (OFString *)readTillDelimiter: (OFString *)delimiter
 {
 	return [self readTillDelimiter: delimiter
@@ -1869,25 +1840,42 @@
 - (void)unreadFromBuffer: (const void *)buffer
 		  length: (size_t)length
 {
-	char *readBuffer;
+	if (length == 0)
+		return;
 
-	if (length > SIZE_MAX - _readBufferLength)
-		@throw [OFOutOfRangeException exception];
+	if (_readBufferMemory == NULL ||
+	    (size_t)(_readBuffer - _readBufferMemory) < length) {
+		[self of_reserveReadBufferSpace: length];
 
-	readBuffer = of_alloc(_readBufferLength + length, 1);
-	memcpy(readBuffer, buffer, length);
-	memcpy(readBuffer + length, _readBuffer, _readBufferLength);
+		memmove(_readBuffer + length, _readBuffer, _readBufferLength);
+		_readBuffer += length;
+	}
 
-	free(_readBufferMemory);
-	_readBuffer = _readBufferMemory = readBuffer;
+	_readBuffer -= length;
 	_readBufferLength += length;
+	memcpy(_readBuffer, buffer, length);
+#ifdef OF_HAVE_SOCKETS
+	[self of_readBufferDidFill];
+#endif
+}
+
+#ifdef OF_HAVE_SOCKETS
+- (void)of_readBufferDidFill
+{
+	if (_readBufferObserver == nil || _readBufferPending ||
+	    _readBufferLength == 0)
+		return;
+
+	_readBufferPending = true;
+	[_readBufferObserver of_streamDidFillReadBuffer: self];
 }
+#endif
 
 - (void)close
 {
 	free(_readBufferMemory);
 	_readBuffer = _readBufferMemory = NULL;
-	_readBufferLength = 0;
+	_readBufferLength = _readBufferCapacity = 0;
 
 	free(_writeBuffer);
 	_writeBuffer = NULL;
@@ -23,6 +23,14 @@ OF_ASSUME_NONNULL_BEGIN
 #ifndef OF_WII
 @property (readonly, nonatomic) int of_socketError;
 #endif
+
+/*
+ * Writes as much of the specified buffers as possible without blocking, using
+ * a single gather write if possible, and returns the number of bytes written.
+ */
+- (size_t)of_writeBuffers: (const void *const _Nonnull *_Nonnull)buffers
+		  lengths: (const size_t *)lengths
+		    count: (size_t)count;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -23,10 +23,17 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef HAVE_SYS_UIO_H
+# include <sys/uio.h>
+#endif
+
 #import "OFStreamSocket.h"
 #import "OFStreamSocket+Private.h"
+#import "OFKernelEventObserver.h"
+#import "OFKernelEventObserver+Private.h"
 #import "OFRunLoop.h"
 #import "OFRunLoop+Private.h"
+#import "OFStream+Private.h"
 
 #import "OFAcceptFailedException.h"
 #import "OFInitializationFailedException.h"
@@ -41,6 +48,8 @@
 
 #import "socket_helpers.h"
 
+#define MAX_WRITE_BUFFERS 16
+
 @implementation OFStreamSocket
 @dynamic delegate;
 @synthesize listening = _listening;
@@ -123,6 +132,9 @@
 	if (ret == 0)
 		_atEndOfStream = true;
 
+	if ((size_t)ret < length)
+		[self.of_readBufferObserver of_objectDidDrainForReading: self];
+
 	return ret;
 }
 
@@ -161,6 +173,82 @@
 	return (size_t)bytesWritten;
 }
 
+- (size_t)of_writeBuffers: (const void *const *)buffers
+		  lengths: (const size_t *)lengths
+		    count: (size_t)count
+{
+#if defined(HAVE_SENDMSG) && defined(MSG_DONTWAIT)
+	static IMP lowlevelWriteBufferIMP = NULL;
+	struct iovec iov[MAX_WRITE_BUFFERS];
+	struct msghdr msg;
+	size_t requestedLength = 0;
+	ssize_t bytesWritten;
+#endif
+	size_t totalWritten = 0;
+
+	if (_socket == INVALID_SOCKET)
+		@throw [OFNotOpenException exceptionWithObject: self];
+
+#if defined(HAVE_SENDMSG) && defined(MSG_DONTWAIT)
+	if (lowlevelWriteBufferIMP == NULL)
+		lowlevelWriteBufferIMP = [OFStreamSocket
+		    instanceMethodForSelector: @selector(lowlevelWriteBuffer:
+						   length:)];
+
+	/*
+	 * Subclasses that override the lowlevel write (e.g. TLS sockets) need
+	 * to see every buffer, so only write directly to the socket if the
+	 * lowlevel write is ours.
+	 */
+	if (!self.buffersWrites && [self methodForSelector:
+	    @selector(lowlevelWriteBuffer:length:)] == lowlevelWriteBufferIMP) {
+		if (count > MAX_WRITE_BUFFERS)
+			count = MAX_WRITE_BUFFERS;
+
+		for (size_t i = 0; i < count; i++) {
+			iov[i].iov_base = (void *)buffers[i];
+			iov[i].iov_len = lengths[i];
+
+			if (lengths[i] > SSIZE_MAX - requestedLength)
+				@throw [OFOutOfRangeException exception];
+
+			requestedLength += lengths[i];
+		}
+
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		msg.msg_iovlen = (int)count;
+
+		if ((bytesWritten = sendmsg(_socket, &msg, MSG_DONTWAIT)) < 0) {
+			int errNo = of_socket_errno();
+
+			if (errNo == EWOULDBLOCK || errNo == EAGAIN)
+				return 0;
+
+			@throw [OFWriteFailedException
+			    exceptionWithObject: self
+				requestedLength: requestedLength
+				   bytesWritten: 0
+					  errNo: errNo];
+		}
+
+		return (size_t)bytesWritten;
+	}
+#endif
+
+	for (size_t i = 0; i < count; i++) {
+		size_t written = [self writeBuffer: buffers[i]
+					    length: lengths[i]];
+
+		totalWritten += written;
+
+		if (written < lengths[i])
+			break;
+	}
+
+	return totalWritten;
+}
+
 #if defined(OF_WINDOWS) || defined(OF_AMIGAOS)
 - (void)setCanBlock: (bool)canBlock
 {
@@ -40,9 +40,11 @@
 # import "OFFile.h"
 # import "OFFileManager.h"
 #endif
+#import "OFJSONWriter.h"
 #import "OFLocale.h"
 #import "OFStream.h"
 #import "OFSystemInfo.h"
+#import "OFTaggedPointerString.h"
 #import "OFURL.h"
 #import "OFURLHandler.h"
 #import "OFUTF8String.h"
@@ -62,6 +64,7 @@
 #import "OFUnsupportedProtocolException.h"
 
 #import "of_asprintf.h"
+#import "siphash.h"
 #import "unicode.h"
 
 /*
@@ -92,8 +95,6 @@ static locale_t cLocale;
 		  lossy: (bool)lossy OF_DIRECT;
 - (const char *)of_cStringWithEncoding: (of_string_encoding_t)encoding
 				 lossy: (bool)lossy OF_DIRECT;
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth;
 @end
 
 @interface OFStringPlaceholder: OFString
@@ -372,6 +373,13 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 @implementation OFStringPlaceholder
 - (instancetype)init
 {
+#ifdef OF_OBJFW_RUNTIME
+	id ret;
+
+	if ((ret = of_tagged_pointer_string_new("", 0)) != nil)
+		return ret;
+#endif
+
 	return (id)[[OFUTF8String alloc] init];
 }
 
@@ -382,6 +390,13 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 	void *storage;
 
 	length = strlen(UTF8String);
+
+#ifdef OF_OBJFW_RUNTIME
+	if ((string = (id)of_tagged_pointer_string_new(UTF8String,
+	    length)) != nil)
+		return (id)string;
+#endif
+
 	string = of_alloc_object([OFUTF8String class], length + 1, 1, &storage);
 
 	return (id)[string of_initWithUTF8String: UTF8String
@@ -395,6 +410,12 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 	OFUTF8String *string;
 	void *storage;
 
+#ifdef OF_OBJFW_RUNTIME
+	if ((string = (id)of_tagged_pointer_string_new(UTF8String,
+	    UTF8StringLength)) != nil)
+		return (id)string;
+#endif
+
 	string = of_alloc_object([OFUTF8String class], UTF8StringLength + 1, 1,
 	    &storage);
 
@@ -406,6 +427,18 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 - (instancetype)initWithUTF8StringNoCopy: (char *)UTF8String
 			    freeWhenDone: (bool)freeWhenDone
 {
+#ifdef OF_OBJFW_RUNTIME
+	id ret;
+
+	if ((ret = of_tagged_pointer_string_new(UTF8String,
+	    strlen(UTF8String))) != nil) {
+		if (freeWhenDone)
+			free(UTF8String);
+
+		return ret;
+	}
+#endif
+
 	return (id)[[OFUTF8String alloc]
 	    initWithUTF8StringNoCopy: UTF8String
 			freeWhenDone: freeWhenDone];
@@ -415,6 +448,18 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 				  length: (size_t)UTF8StringLength
 			    freeWhenDone: (bool)freeWhenDone
 {
+#ifdef OF_OBJFW_RUNTIME
+	id ret;
+
+	if ((ret = of_tagged_pointer_string_new(UTF8String,
+	    UTF8StringLength)) != nil) {
+		if (freeWhenDone)
+			free(UTF8String);
+
+		return ret;
+	}
+#endif
+
 	return (id)[[OFUTF8String alloc]
 	    initWithUTF8StringNoCopy: UTF8String
 			      length: UTF8StringLength
@@ -430,6 +475,13 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 		void *storage;
 
 		length = strlen(cString);
+
+#ifdef OF_OBJFW_RUNTIME
+		if ((string = (id)of_tagged_pointer_string_new(cString,
+		    length)) != nil)
+			return (id)string;
+#endif
+
 		string = of_alloc_object([OFUTF8String class], length + 1, 1,
 		    &storage);
 
@@ -450,6 +502,12 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 		OFUTF8String *string;
 		void *storage;
 
+#ifdef OF_OBJFW_RUNTIME
+		if ((string = (id)of_tagged_pointer_string_new(cString,
+		    cStringLength)) != nil)
+			return (id)string;
+#endif
+
 		string = of_alloc_object([OFUTF8String class],
 		    cStringLength + 1, 1, &storage);
 
@@ -472,6 +530,19 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 
 - (instancetype)initWithString: (OFString *)string
 {
+#ifdef OF_OBJFW_RUNTIME
+	if (object_isTaggedPointer(string))
+		return [string retain];
+
+	if (string.length <= OF_TAGGED_POINTER_STRING_MAX_LENGTH) {
+		id ret = of_tagged_pointer_string_new(string.UTF8String,
+		    string.UTF8StringLength);
+
+		if (ret != nil)
+			return ret;
+	}
+#endif
+
 	return (id)[[OFUTF8String alloc] initWithString: string];
 }
 
@@ -619,6 +690,11 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 
 	placeholder.isa = [OFStringPlaceholder class];
 
+#ifdef OF_OBJFW_RUNTIME
+	of_tagged_pointer_string_tag =
+	    objc_registerTaggedPointerClass([OFTaggedPointerString class]);
+#endif
+
 #if defined(HAVE_STRTOF_L) || defined(HAVE_STRTOD_L)
 	if ((cLocale = newlocale(LC_ALL_MASK, "C", NULL)) == NULL)
 		@throw [OFInitializationFailedException
@@ -1673,21 +1749,15 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 
 - (unsigned long)hash
 {
-	const of_unichar_t *characters = self.characters;
-	size_t length = self.length;
-	uint32_t hash;
-
-	OF_HASH_INIT(hash);
-
-	for (size_t i = 0; i < length; i++) {
-		const of_unichar_t c = characters[i];
-
-		OF_HASH_ADD(hash, (c & 0xFF0000) >> 16);
-		OF_HASH_ADD(hash, (c & 0x00FF00) >> 8);
-		OF_HASH_ADD(hash, c & 0x0000FF);
-	}
+	/*
+	 * All subclasses need to hash the UTF-8 representation, as that is
+	 * what OFUTF8String can hash without decoding anything.
+	 */
+	void *pool = objc_autoreleasePoolPush();
+	unsigned long hash = of_hash_bytes(self.UTF8String,
+	    self.UTF8StringLength);
 
-	OF_HASH_FINALIZE(hash);
+	objc_autoreleasePoolPop(pool);
 
 	return hash;
 }
@@ -1721,63 +1791,27 @@ decomposedString(OFString *self, const char *const *const *table, size_t size)
 
 - (OFString *)JSONRepresentation
 {
-	return [self of_JSONRepresentationWithOptions: 0
-						depth: 0];
+	return [self JSONRepresentationWithOptions: 0];
 }
 
 - (OFString *)JSONRepresentationWithOptions: (int)options
 {
-	return [self of_JSONRepresentationWithOptions: options
-						depth: 0];
-}
-
-- (OFString *)of_JSONRepresentationWithOptions: (int)options
-					 depth: (size_t)depth
-{
-	OFMutableString *JSON = [[self mutableCopy] autorelease];
-
-	/* FIXME: This is slow! Write it in pure C! */
-	[JSON replaceOccurrencesOfString: @"\\"
-			      withString: @"\\\\"];
-	[JSON replaceOccurrencesOfString: @"\""
-			      withString: @"\\\""];
-	[JSON replaceOccurrencesOfString: @"\b"
-			      withString: @"\\b"];
-	[JSON replaceOccurrencesOfString: @"\f"
-			      withString: @"\\f"];
-	[JSON replaceOccurrencesOfString: @"\r"
-			      withString: @"\\r"];
-	[JSON replaceOccurrencesOfString: @"\t"
-			      withString: @"\\t"];
-
-	if (options & OF_JSON_REPRESENTATION_JSON5) {
-		[JSON replaceOccurrencesOfString: @"\n"
-				      withString: @"\\\n"];
-
-		if (options & OF_JSON_REPRESENTATION_IDENTIFIER) {
-			const char *cString = self.UTF8String;
-
-			if ((!of_ascii_isalpha(cString[0]) &&
-			    cString[0] != '_' && cString[0] != '$') ||
-			    strpbrk(cString, " \n\r\t\b\f\\\"'") != NULL) {
-				[JSON prependString: @"\""];
-				[JSON appendString: @"\""];
-			}
-		} else {
-			[JSON prependString: @"\""];
-			[JSON appendString: @"\""];
-		}
-	} else {
-		[JSON replaceOccurrencesOfString: @"\n"
-				      withString: @"\\n"];
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONWriter *writer = [OFJSONWriter writer];
+	OFString *JSON;
 
-		[JSON prependString: @"\""];
-		[JSON appendString: @"\""];
-	}
+	writer.options = options;
+	[self writeJSONRepresentationToWriter: writer];
+	JSON = [writer.string retain];
+
+	objc_autoreleasePoolPop(pool);
 
-	[JSON makeImmutable];
+	return [JSON autorelease];
+}
 
-	return JSON;
+- (void)writeJSONRepresentationToWriter: (OFJSONWriter *)writer
+{
+	[writer writeString: self];
 }
 
 - (OFData *)messagePackRepresentation
@@ -636,6 +636,11 @@ x86_cpuid(uint32_t eax, uint32_t ecx)
 	return (x86_cpuid(1, 0).ecx & (1u << 25));
 }
 
++ (bool)supportsPCLMULQDQ
+{
+	return (x86_cpuid(1, 0).ecx & (1u << 1));
+}
+
 + (bool)supportsSHAExtensions
 {
 	return (x86_cpuid(7, 0).ebx & (1u << 29));
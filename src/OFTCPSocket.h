@@ -72,6 +72,7 @@ typedef void (^of_tcp_socket_async_connect_block_t)(id _Nullable exception);
 #ifdef OF_WII
 	uint16_t _port;
 #endif
+	bool _reusesPort;
 	OF_RESERVE_IVARS(OFTCPSocket, 4)
 }
 
@@ -99,6 +100,18 @@ typedef void (^of_tcp_socket_async_connect_block_t)(id _Nullable exception);
 @property (nonatomic) bool canDelaySendingSegments;
 #endif
 
+/**
+ * @brief Whether the socket is bound with `SO_REUSEPORT`, allowing several
+ *	  sockets to listen on the same port and letting the kernel distribute
+ *	  the incoming connections among them.
+ *
+ * This needs to be set before @ref bindToHost:port: is called.
+ *
+ * Setting this on a platform that does not support `SO_REUSEPORT` raises an
+ * @ref OFNotImplementedException.
+ */
+@property (nonatomic) bool reusesPort;
+
 /**
  * @brief The host to use as a SOCKS5 proxy.
  */
@@ -88,6 +88,7 @@ static uint16_t defaultSOCKS5Port = 1080;
 
 @implementation OFTCPSocket
 @synthesize SOCKS5Host = _SOCKS5Host, SOCKS5Port = _SOCKS5Port;
+@synthesize reusesPort = _reusesPort;
 @dynamic delegate;
 
 + (void)setSOCKS5Host: (OFString *)host
@@ -342,6 +343,21 @@ static uint16_t defaultSOCKS5Port = 1080;
 	setsockopt(_socket, SOL_SOCKET, SO_REUSEADDR,
 	    (char *)&one, (socklen_t)sizeof(one));
 
+#ifdef SO_REUSEPORT
+	if (_reusesPort && setsockopt(_socket, SOL_SOCKET, SO_REUSEPORT,
+	    (char *)&one, (socklen_t)sizeof(one)) != 0) {
+		int errNo = of_socket_errno();
+
+		closesocket(_socket);
+		_socket = INVALID_SOCKET;
+
+		@throw [OFBindFailedException exceptionWithHost: host
+							   port: port
+							 socket: self
+							  errNo: errNo];
+	}
+#endif
+
 #if defined(OF_WII) || defined(OF_NINTENDO_3DS)
 	if (port != 0) {
 #endif
@@ -437,6 +453,20 @@ static uint16_t defaultSOCKS5Port = 1080;
 #endif
 }
 
+- (void)setReusesPort: (bool)reusesPort
+{
+#ifdef SO_REUSEPORT
+	if (_socket != INVALID_SOCKET)
+		@throw [OFAlreadyConnectedException exceptionWithSocket: self];
+
+	_reusesPort = reusesPort;
+#else
+	if (reusesPort)
+		@throw [OFNotImplementedException exceptionWithSelector: _cmd
+								 object: self];
+#endif
+}
+
 #if !defined(OF_WII) && !defined(OF_NINTENDO_3DS)
 - (void)setSendsKeepAlives: (bool)sendsKeepAlives
 {
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#import "OFString.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+#ifdef OF_OBJFW_RUNTIME
+/*
+ * A string of up to 8 (3 on 32 bit systems) ASCII characters that is stored
+ * in the pointer itself instead of being allocated.
+ */
+@interface OFTaggedPointerString: OFString
+@end
+
+/*
+ * The runtime uses 4 bits of the pointer for the tag and the length needs
+ * another 4 bits, leaving 7 bits per character.
+ */
+# define OF_TAGGED_POINTER_STRING_MAX_LENGTH \
+	((sizeof(uintptr_t) * 8 - 4 - 4) / 7)
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+extern int of_tagged_pointer_string_tag;
+
+/*
+ * Returns a tagged pointer string with the specified contents, or nil if they
+ * do not fit into a tagged pointer.
+ */
+extern OFString *_Nullable of_tagged_pointer_string_new(
+    const char *UTF8String, size_t UTF8StringLength);
+# ifdef __cplusplus
+}
+# endif
+#endif
+
+OF_ASSUME_NONNULL_END
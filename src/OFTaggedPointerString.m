@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFTaggedPointerString.h"
+#import "OFData.h"
+
+#import "OFOutOfRangeException.h"
+
+#import "siphash.h"
+
+#ifdef OF_OBJFW_RUNTIME
+/*
+ * The value of the tagged pointer is the length in the lowest 4 bits followed
+ * by 7 bits per character, starting with the first character.
+ */
+# define LENGTH_BITS 4
+# define LENGTH_MASK 0xF
+# define CHARACTER_BITS 7
+# define CHARACTER_MASK 0x7F
+# define MAX_LENGTH OF_TAGGED_POINTER_STRING_MAX_LENGTH
+
+int of_tagged_pointer_string_tag = -1;
+
+OFString *
+of_tagged_pointer_string_new(const char *UTF8String, size_t UTF8StringLength)
+{
+	uintptr_t value = 0;
+
+	if (UTF8StringLength > MAX_LENGTH)
+		return nil;
+
+	for (size_t i = UTF8StringLength; i > 0; i--) {
+		unsigned char character = UTF8String[i - 1];
+
+		if (character == 0 || character & 0x80)
+			return nil;
+
+		value = (value << CHARACTER_BITS) | character;
+	}
+
+	value = (value << LENGTH_BITS) | UTF8StringLength;
+
+	return objc_createTaggedPointer(of_tagged_pointer_string_tag, value);
+}
+
+@implementation OFTaggedPointerString
+static size_t
+unpack(OFTaggedPointerString *self, char *cString)
+{
+	uintptr_t value = object_getTaggedPointerValue(self);
+	size_t length = value & LENGTH_MASK;
+
+	value >>= LENGTH_BITS;
+
+	for (size_t i = 0; i < length; i++) {
+		cString[i] = value & CHARACTER_MASK;
+		value >>= CHARACTER_BITS;
+	}
+
+	cString[length] = '\0';
+
+	return length;
+}
+
+- (instancetype)autorelease
+{
+	return self;
+}
+
+- (instancetype)retain
+{
+	return self;
+}
+
+- (void)release
+{
+}
+
+- (unsigned int)retainCount
+{
+	return OF_RETAIN_COUNT_MAX;
+}
+
+- (size_t)length
+{
+	return object_getTaggedPointerValue(self) & LENGTH_MASK;
+}
+
+- (of_unichar_t)characterAtIndex: (size_t)idx
+{
+	uintptr_t value = object_getTaggedPointerValue(self);
+
+	if (idx >= (value & LENGTH_MASK))
+		@throw [OFOutOfRangeException exception];
+
+	return (value >> (LENGTH_BITS + idx * CHARACTER_BITS)) &
+	    CHARACTER_MASK;
+}
+
+- (void)getCharacters: (of_unichar_t *)buffer
+	      inRange: (of_range_t)range
+{
+	uintptr_t value = object_getTaggedPointerValue(self);
+
+	if (range.length > SIZE_MAX - range.location ||
+	    range.location + range.length > (value & LENGTH_MASK))
+		@throw [OFOutOfRangeException exception];
+
+	value >>= LENGTH_BITS + range.location * CHARACTER_BITS;
+
+	for (size_t i = 0; i < range.length; i++) {
+		buffer[i] = value & CHARACTER_MASK;
+		value >>= CHARACTER_BITS;
+	}
+}
+
+- (size_t)cStringLengthWithEncoding: (of_string_encoding_t)encoding
+{
+	switch (encoding) {
+	case OF_STRING_ENCODING_UTF_8:
+	case OF_STRING_ENCODING_ASCII:
+		return object_getTaggedPointerValue(self) & LENGTH_MASK;
+	default:
+		return [super cStringLengthWithEncoding: encoding];
+	}
+}
+
+- (size_t)UTF8StringLength
+{
+	return object_getTaggedPointerValue(self) & LENGTH_MASK;
+}
+
+- (size_t)getCString: (char *)cString
+	   maxLength: (size_t)maxLength
+	    encoding: (of_string_encoding_t)encoding
+{
+	switch (encoding) {
+	case OF_STRING_ENCODING_UTF_8:
+	case OF_STRING_ENCODING_ASCII:
+		if ((object_getTaggedPointerValue(self) & LENGTH_MASK) + 1 >
+		    maxLength)
+			@throw [OFOutOfRangeException exception];
+
+		return unpack(self, cString);
+	default:
+		return [super getCString: cString
+			       maxLength: maxLength
+				encoding: encoding];
+	}
+}
+
+- (const char *)cStringWithEncoding: (of_string_encoding_t)encoding
+{
+	char *cString;
+	size_t length;
+
+	switch (encoding) {
+	case OF_STRING_ENCODING_UTF_8:
+	case OF_STRING_ENCODING_ASCII:
+		break;
+	default:
+		return [super cStringWithEncoding: encoding];
+	}
+
+	/* There is no storage to point into, so this has to allocate. */
+	cString = of_alloc(MAX_LENGTH + 1, 1);
+	length = unpack(self, cString);
+
+	@try {
+		return [[OFData dataWithItemsNoCopy: cString
+					      count: length + 1
+				       freeWhenDone: true] items];
+	} @catch (id e) {
+		free(cString);
+		@throw e;
+	}
+}
+
+- (const char *)UTF8String
+{
+	return [self cStringWithEncoding: OF_STRING_ENCODING_UTF_8];
+}
+
+- (bool)isEqual: (id)object
+{
+	OFString *otherString;
+	char cString[MAX_LENGTH + 1];
+	size_t length;
+
+	if (object == self)
+		return true;
+
+	/*
+	 * Equal strings that fit into a tagged pointer always are the same
+	 * tagged pointer.
+	 */
+	if (object_isTaggedPointer(object))
+		return false;
+
+	if (![object isKindOfClass: [OFString class]])
+		return false;
+
+	otherString = object;
+	length = unpack(self, cString);
+
+	if (otherString.UTF8StringLength != length)
+		return false;
+
+	return (memcmp(otherString.UTF8String, cString, length) == 0);
+}
+
+- (unsigned long)hash
+{
+	char cString[MAX_LENGTH + 1];
+	size_t length = unpack(self, cString);
+
+	return of_hash_bytes(cString, length);
+}
+@end
+#endif
@@ -56,6 +56,7 @@
 # import "OFDNSResolver.h"
 #endif
 #import "OFLocale.h"
+#import "OFObject+Private.h"
 #import "OFRunLoop.h"
 #import "OFString.h"
 
@@ -103,6 +104,10 @@ callMain(id object)
 	OFThread *thread = (OFThread *)object;
 	OFString *name;
 
+#ifdef OF_BIASED_REFCOUNTING
+	of_biased_refcount_thread_start();
+#endif
+
 	if (!of_tlskey_set(threadSelfKey, thread))
 		@throw [OFInitializationFailedException
 		    exceptionWithClass: thread.class];
@@ -154,6 +159,10 @@ callMain(id object)
 	thread->_running = OF_THREAD_WAITING_FOR_JOIN;
 
 	[thread release];
+
+#ifdef OF_BIASED_REFCOUNTING
+	of_biased_refcount_thread_exit();
+#endif
 }
 
 @synthesize name = _name;
@@ -28,16 +28,21 @@ OF_ASSUME_NONNULL_BEGIN
 typedef void (^of_thread_pool_block_t)(void);
 #endif
 
-@class OFCondition;
-@class OFList OF_GENERIC(ObjectType);
+@class OFArray OF_GENERIC(ObjectType);
 @class OFMutableArray OF_GENERIC(ObjectType);
-@class OFThreadPoolJob;
+@class OFThreadPoolQueue;
 
 /**
  * @class OFThreadPool OFThreadPool.h ObjFW/OFThreadPool.h
  *
  * @brief A class providing a pool of reusable threads.
  *
+ * By default, all jobs are put into a single queue shared by all threads. If
+ * the thread pool is created with work stealing, each thread additionally has
+ * its own queue: jobs dispatched from a job running in the pool go to the
+ * queue of the thread running that job and idle threads steal jobs from the
+ * queues of the other threads. This scales a lot better with many small jobs.
+ *
  * @note When the thread pool is released, all threads will terminate after
  *	 they finish the job they are currently processing.
  */
@@ -46,14 +51,7 @@ OF_SUBCLASSING_RESTRICTED
 {
 	size_t _size;
 	OFMutableArray *_threads;
-	volatile int _count;
-#ifdef OF_THREAD_POOL_M
-@public
-#endif
-	OFList *_queue;
-	OFCondition *_queueCondition;
-	volatile int _doneCount;
-	OFCondition *_countCondition;
+	OFThreadPoolQueue *_queue;
 }
 
 /**
@@ -61,6 +59,11 @@ OF_SUBCLASSING_RESTRICTED
  */
 @property (readonly, nonatomic) size_t size;
 
+/**
+ * @brief Whether the thread pool uses a queue per thread and work stealing.
+ */
+@property (readonly, nonatomic) bool usesWorkStealing;
+
 /**
  * @brief Returns a new thread pool with one thread for each core in the system.
  *
@@ -79,14 +82,39 @@ OF_SUBCLASSING_RESTRICTED
  */
 + (instancetype)threadPoolWithSize: (size_t)size;
 
+/**
+ * @brief Returns a new thread pool with the specified number of threads.
+ *
+ * @param size The number of threads for the pool
+ * @param usesWorkStealing Whether to use a queue per thread and work stealing.
+ *			   This is ignored if the platform has no atomic
+ *			   operations.
+ * @return A new thread pool with the specified number of threads
+ */
++ (instancetype)threadPoolWithSize: (size_t)size
+		  usesWorkStealing: (bool)usesWorkStealing;
+
+/**
+ * @brief Initializes an already allocated OFThreadPool with the specified
+ *	  number of threads.
+ *
+ * @param size The number of threads for the pool
+ * @return An initialized OFThreadPool with the specified number of threads
+ */
+- (instancetype)initWithSize: (size_t)size;
+
 /**
  * @brief Initializes an already allocated OFThreadPool with the specified
  *	  number of threads.
  *
  * @param size The number of threads for the pool
+ * @param usesWorkStealing Whether to use a queue per thread and work stealing.
+ *			   This is ignored if the platform has no atomic
+ *			   operations.
  * @return An initialized OFThreadPool with the specified number of threads
  */
-- (instancetype)initWithSize: (size_t)size OF_DESIGNATED_INITIALIZER;
+- (instancetype)initWithSize: (size_t)size
+	    usesWorkStealing: (bool)usesWorkStealing OF_DESIGNATED_INITIALIZER;
 
 /**
  * @brief Execute the specified selector on the specified target with the
@@ -100,6 +128,22 @@ OF_SUBCLASSING_RESTRICTED
 		  selector: (SEL)selector
 		    object: (nullable id)object;
 
+/**
+ * @brief Executes the specified selector on the specified target once for
+ *	  each of the specified objects as soon as a thread is ready.
+ *
+ * This is cheaper than dispatching each object separately, as all jobs are
+ * queued at once.
+ *
+ * @param target The target on which to perform the selector
+ * @param selector The selector to perform on the target
+ * @param objects The objects with which the selector is performed on the
+ *		  target, one job per object
+ */
+- (void)dispatchWithTarget: (id)target
+		  selector: (SEL)selector
+		   objects: (OFArray *)objects;
+
 #ifdef OF_HAVE_BLOCKS
 /**
  * @brief Executes the specified block as soon as a thread is ready.
@@ -111,6 +155,8 @@ OF_SUBCLASSING_RESTRICTED
 
 /**
  * @brief Waits until all jobs are done.
+ *
+ * While waiting, the calling thread helps executing queued jobs.
  */
 - (void)waitUntilDone;
 @end
@@ -17,123 +17,482 @@
 
 #include "config.h"
 
-#define OF_THREAD_POOL_M
+#include <stdlib.h>
+#include <string.h>
 
 #import "OFThreadPool.h"
 #import "OFArray.h"
-#import "OFList.h"
 #import "OFThread.h"
 #import "OFCondition.h"
 #import "OFSystemInfo.h"
 
+#import "OFOutOfRangeException.h"
+
+#ifdef OF_HAVE_ATOMIC_OPS
+# import "atomic.h"
+#endif
+
+/* Must be a power of 2 */
+#define DEQUE_SIZE 1024
+#define MAX_LOCAL_FREE_JOBS 64
+#define MAX_FREE_JOBS 1024
+
+struct of_thread_pool_job {
+	struct of_thread_pool_job *next;
+	id target;
+	SEL selector;
+	id object;
+#ifdef OF_HAVE_BLOCKS
+	of_thread_pool_block_t block;
+#endif
+};
+
+#ifdef OF_HAVE_ATOMIC_OPS
+/*
+ * A fixed-size Chase-Lev deque. The owning thread pushes and pops at the
+ * bottom, all other threads steal from the top. The indices are only ever
+ * compared by their difference, so they are allowed to wrap around.
+ */
+struct deque {
+	volatile int top, bottom;
+	struct of_thread_pool_job *volatile jobs[DEQUE_SIZE];
+};
+#endif
+
+/*
+ * The state shared between the pool and its threads. The threads retain it,
+ * so that it outlives the pool until the last thread terminated.
+ */
 OF_DIRECT_MEMBERS
-@interface OFThreadPoolJob: OFObject
+@interface OFThreadPoolQueue: OFObject
 {
-	id _target;
-	SEL _selector;
-	id _object;
-#ifdef OF_HAVE_BLOCKS
-	of_thread_pool_block_t _block;
+@public
+	size_t _size;
+	bool _usesWorkStealing;
+	volatile bool _terminate;
+	OFCondition *_queueCondition, *_countCondition;
+	struct of_thread_pool_job *_first, *_last, *_freeJobs;
+	size_t _numFreeJobs;
+	volatile int _pendingCount, _numIdleThreads;
+#ifdef OF_HAVE_ATOMIC_OPS
+	struct deque *_deques;
 #endif
 }
 
-- (instancetype)initWithTarget: (id)target
-		      selector: (SEL)selector
-			object: (id)object;
+- (instancetype)initWithSize: (size_t)size
+	    usesWorkStealing: (bool)usesWorkStealing;
+@end
+
+OF_DIRECT_MEMBERS
+@interface OFThreadPoolThread: OFThread
+{
+@public
+	OFThreadPoolQueue *_queue;
+	size_t _index;
+	struct of_thread_pool_job *_freeJobs;
+	size_t _numFreeJobs;
+}
+
+- (instancetype)initWithQueue: (OFThreadPoolQueue *)queue
+			index: (size_t)index;
+@end
+
+static void
+releaseJob(struct of_thread_pool_job *job)
+{
+	[job->target release];
+	[job->object release];
 #ifdef OF_HAVE_BLOCKS
-- (instancetype)initWithBlock: (of_thread_pool_block_t)block;
+	[job->block release];
 #endif
-- (void)perform;
-@end
+}
 
-@implementation OFThreadPoolJob
-- (instancetype)initWithTarget: (id)target
-		      selector: (SEL)selector
-			object: (id)object
+static void
+freeJobList(struct of_thread_pool_job *job)
 {
-	self = [super init];
+	while (job != NULL) {
+		struct of_thread_pool_job *next = job->next;
 
-	@try {
-		_target = [target retain];
-		_selector = selector;
-		_object = [object retain];
-	} @catch (id e) {
-		[self release];
-		@throw e;
+		free(job);
+		job = next;
 	}
+}
 
-	return self;
+#ifdef OF_HAVE_ATOMIC_OPS
+static bool
+dequePush(struct deque *deque, struct of_thread_pool_job *job)
+{
+	int bottom = deque->bottom;
+	int top = deque->top;
+
+	of_memory_barrier_acquire();
+
+	if ((unsigned int)bottom - (unsigned int)top >= DEQUE_SIZE)
+		return false;
+
+	deque->jobs[(unsigned int)bottom % DEQUE_SIZE] = job;
+	of_memory_barrier_release();
+	deque->bottom = (int)((unsigned int)bottom + 1);
+
+	return true;
 }
 
-#ifdef OF_HAVE_BLOCKS
-- (instancetype)initWithBlock: (of_thread_pool_block_t)block
+static struct of_thread_pool_job *
+dequePop(struct deque *deque)
 {
-	self = [super init];
+	int bottom = (int)((unsigned int)deque->bottom - 1);
+	int top;
+	struct of_thread_pool_job *job;
 
-	@try {
-		_block = [block copy];
-	} @catch (id e) {
-		[self release];
-		@throw e;
+	deque->bottom = bottom;
+	of_memory_barrier();
+	top = deque->top;
+
+	if ((int)((unsigned int)bottom - (unsigned int)top) < 0) {
+		deque->bottom = (int)((unsigned int)bottom + 1);
+		return NULL;
 	}
 
-	return self;
+	job = deque->jobs[(unsigned int)bottom % DEQUE_SIZE];
+
+	if (bottom != top)
+		return job;
+
+	/* This is the last job, so we might race with a thief. */
+	if (!of_atomic_int_cmpswap(&deque->top, top,
+	    (int)((unsigned int)top + 1)))
+		job = NULL;
+
+	deque->bottom = (int)((unsigned int)bottom + 1);
+
+	return job;
+}
+
+static struct of_thread_pool_job *
+dequeSteal(struct deque *deque)
+{
+	int top = deque->top;
+	int bottom;
+	struct of_thread_pool_job *job;
+
+	of_memory_barrier();
+	bottom = deque->bottom;
+	of_memory_barrier_acquire();
+
+	if ((int)((unsigned int)bottom - (unsigned int)top) <= 0)
+		return NULL;
+
+	job = deque->jobs[(unsigned int)top % DEQUE_SIZE];
+
+	/* Make sure the job is read before we take it. */
+	of_memory_barrier();
+
+	if (!of_atomic_int_cmpswap(&deque->top, top,
+	    (int)((unsigned int)top + 1)))
+		return NULL;
+
+	return job;
+}
+
+static bool
+hasStealableJobs(OFThreadPoolQueue *queue)
+{
+	for (size_t i = 0; i < queue->_size; i++) {
+		struct deque *deque = &queue->_deques[i];
+
+		if ((int)((unsigned int)deque->bottom -
+		    (unsigned int)deque->top) > 0)
+			return true;
+	}
+
+	return false;
+}
+
+static struct of_thread_pool_job *
+stealJob(OFThreadPoolQueue *queue, size_t ownIndex)
+{
+	for (size_t i = 0; i < queue->_size; i++) {
+		size_t index = (ownIndex + 1 + i) % queue->_size;
+		struct of_thread_pool_job *job;
+
+		if (index == ownIndex)
+			continue;
+
+		if ((job = dequeSteal(&queue->_deques[index])) != NULL)
+			return job;
+	}
+
+	return NULL;
 }
 #endif
 
-- (void)dealloc
+static OFThreadPoolThread *
+currentThreadForQueue(OFThreadPoolQueue *queue)
 {
-	[_target release];
-	[_object release];
-#ifdef OF_HAVE_BLOCKS
-	[_block release];
+	OFThread *thread = [OFThread currentThread];
+
+	if ([thread isKindOfClass: [OFThreadPoolThread class]] &&
+	    ((OFThreadPoolThread *)thread)->_queue == queue)
+		return (OFThreadPoolThread *)thread;
+
+	return nil;
+}
+
+static struct of_thread_pool_job *
+newJob(OFThreadPoolQueue *queue, OFThreadPoolThread *thread)
+{
+	struct of_thread_pool_job *job;
+
+	if (thread != nil && thread->_freeJobs != NULL) {
+		job = thread->_freeJobs;
+		thread->_freeJobs = job->next;
+		thread->_numFreeJobs--;
+	} else {
+		[queue->_queueCondition lock];
+		job = queue->_freeJobs;
+		if (job != NULL) {
+			queue->_freeJobs = job->next;
+			queue->_numFreeJobs--;
+		}
+		[queue->_queueCondition unlock];
+
+		if (job == NULL)
+			job = of_alloc(1, sizeof(*job));
+	}
+
+	memset(job, 0, sizeof(*job));
+
+	return job;
+}
+
+static void
+recycleJob(OFThreadPoolQueue *queue, OFThreadPoolThread *thread,
+    struct of_thread_pool_job *job)
+{
+	releaseJob(job);
+
+	if (thread != nil && thread->_numFreeJobs < MAX_LOCAL_FREE_JOBS) {
+		job->next = thread->_freeJobs;
+		thread->_freeJobs = job;
+		thread->_numFreeJobs++;
+		return;
+	}
+
+	[queue->_queueCondition lock];
+	if (queue->_numFreeJobs < MAX_FREE_JOBS) {
+		job->next = queue->_freeJobs;
+		queue->_freeJobs = job;
+		queue->_numFreeJobs++;
+		job = NULL;
+	}
+	[queue->_queueCondition unlock];
+
+	free(job);
+}
+
+static void
+increasePendingCount(OFThreadPoolQueue *queue, size_t count)
+{
+	if (count > INT_MAX)
+		@throw [OFOutOfRangeException exception];
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	of_atomic_int_add(&queue->_pendingCount, (int)count);
+#else
+	[queue->_countCondition lock];
+	queue->_pendingCount += (int)count;
+	[queue->_countCondition unlock];
 #endif
+}
 
-	[super dealloc];
+static void
+jobDone(OFThreadPoolQueue *queue)
+{
+#ifdef OF_HAVE_ATOMIC_OPS
+	of_memory_barrier_release();
+
+	if (of_atomic_int_dec(&queue->_pendingCount) > 0)
+		return;
+
+	[queue->_countCondition lock];
+	[queue->_countCondition broadcast];
+	[queue->_countCondition unlock];
+#else
+	[queue->_countCondition lock];
+	if (--queue->_pendingCount == 0)
+		[queue->_countCondition broadcast];
+	[queue->_countCondition unlock];
+#endif
 }
 
-- (void)perform
+static void
+enqueueJobs(OFThreadPoolQueue *queue, OFThreadPoolThread *thread,
+    struct of_thread_pool_job *first, struct of_thread_pool_job *last,
+    size_t count)
 {
-#ifdef OF_HAVE_BLOCKS
-	if (_block != NULL)
-		_block();
-	else
+	increasePendingCount(queue, count);
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	/* Jobs dispatched from within a job go to the thread's own deque. */
+	if (queue->_usesWorkStealing && thread != nil) {
+		struct deque *deque = &queue->_deques[thread->_index];
+		bool pushed = false;
+
+		while (first != NULL) {
+			struct of_thread_pool_job *next = first->next;
+
+			if (!dequePush(deque, first))
+				break;
+
+			pushed = true;
+			first = next;
+		}
+
+		/*
+		 * Pairs with the barrier in waitForJob() so that either we see
+		 * the idle thread or it sees the pushed jobs.
+		 */
+		of_memory_barrier();
+
+		if (pushed && queue->_numIdleThreads > 0) {
+			[queue->_queueCondition lock];
+			if (count > 1)
+				[queue->_queueCondition broadcast];
+			else
+				[queue->_queueCondition signal];
+			[queue->_queueCondition unlock];
+		}
+
+		/* If the deque is full, the rest goes to the shared queue. */
+		if (first == NULL)
+			return;
+	}
 #endif
-		[_target performSelector: _selector
-			      withObject: _object];
+
+	[queue->_queueCondition lock];
+	@try {
+		if (queue->_last != NULL)
+			queue->_last->next = first;
+		else
+			queue->_first = first;
+
+		queue->_last = last;
+
+		if (count > 1)
+			[queue->_queueCondition broadcast];
+		else
+			[queue->_queueCondition signal];
+	} @finally {
+		[queue->_queueCondition unlock];
+	}
 }
-@end
 
-OF_DIRECT_MEMBERS
-@interface OFThreadPoolThread: OFThread
+static struct of_thread_pool_job *
+dequeueJob(OFThreadPoolQueue *queue)
 {
-	OFList *_queue;
-	OFCondition *_queueCondition, *_countCondition;
-@public
-	volatile bool _terminate;
-	volatile int *_doneCount;
+	struct of_thread_pool_job *job;
+
+	/* Racy check to avoid taking the lock if the queue is empty. */
+	if (queue->_first == NULL)
+		return NULL;
+
+	[queue->_queueCondition lock];
+	job = queue->_first;
+	if (job != NULL) {
+		queue->_first = job->next;
+
+		if (queue->_first == NULL)
+			queue->_last = NULL;
+	}
+	[queue->_queueCondition unlock];
+
+	return job;
 }
 
-+ (instancetype)threadWithThreadPool: (OFThreadPool *)threadPool;
-- (instancetype)initWithThreadPool: (OFThreadPool *)threadPool;
-@end
+static struct of_thread_pool_job *
+nextJob(OFThreadPoolQueue *queue, OFThreadPoolThread *thread)
+{
+	struct of_thread_pool_job *job = NULL;
 
-@implementation OFThreadPoolThread
-+ (instancetype)threadWithThreadPool: (OFThreadPool *)threadPool
+#ifdef OF_HAVE_ATOMIC_OPS
+	if (queue->_usesWorkStealing && thread != nil)
+		job = dequePop(&queue->_deques[thread->_index]);
+#endif
+
+	if (job == NULL)
+		job = dequeueJob(queue);
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	if (job == NULL && queue->_usesWorkStealing)
+		job = stealJob(queue,
+		    (thread != nil ? thread->_index : SIZE_MAX));
+#endif
+
+	return job;
+}
+
+static void
+waitForJob(OFThreadPoolQueue *queue)
+{
+	[queue->_queueCondition lock];
+	@try {
+#ifdef OF_HAVE_ATOMIC_OPS
+		of_atomic_int_inc(&queue->_numIdleThreads);
+		of_memory_barrier();
+#endif
+
+		while (!queue->_terminate && queue->_first == NULL) {
+#ifdef OF_HAVE_ATOMIC_OPS
+			if (queue->_usesWorkStealing && hasStealableJobs(queue))
+				break;
+#endif
+
+			[queue->_queueCondition wait];
+		}
+	} @finally {
+#ifdef OF_HAVE_ATOMIC_OPS
+		of_atomic_int_dec(&queue->_numIdleThreads);
+#endif
+		[queue->_queueCondition unlock];
+	}
+}
+
+static void
+performJob(OFThreadPoolQueue *queue, OFThreadPoolThread *thread,
+    struct of_thread_pool_job *job)
 {
-	return [[(OFThreadPoolThread *)[self alloc]
-	    initWithThreadPool: threadPool] autorelease];
+	void *pool = objc_autoreleasePoolPush();
+
+#ifdef OF_HAVE_BLOCKS
+	if (job->block != NULL)
+		job->block();
+	else
+#endif
+		[job->target performSelector: job->selector
+				  withObject: job->object];
+
+	objc_autoreleasePoolPop(pool);
+
+	recycleJob(queue, thread, job);
+	jobDone(queue);
 }
 
-- (instancetype)initWithThreadPool: (OFThreadPool *)threadPool
+@implementation OFThreadPoolQueue
+- (instancetype)initWithSize: (size_t)size
+	    usesWorkStealing: (bool)usesWorkStealing
 {
 	self = [super init];
 
 	@try {
-		_queue = [threadPool->_queue retain];
-		_queueCondition = [threadPool->_queueCondition retain];
-		_countCondition = [threadPool->_countCondition retain];
-		_doneCount = &threadPool->_doneCount;
+		_size = size;
+		_queueCondition = [[OFCondition alloc] init];
+		_countCondition = [[OFCondition alloc] init];
+#ifdef OF_HAVE_ATOMIC_OPS
+		_usesWorkStealing = usesWorkStealing;
+
+		if (_usesWorkStealing)
+			_deques = of_alloc_zeroed(size, sizeof(*_deques));
+#endif
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -144,82 +503,76 @@ OF_DIRECT_MEMBERS
 
 - (void)dealloc
 {
-	[_queue release];
+	/* Jobs that were never executed still hold their targets. */
+	for (struct of_thread_pool_job *job = _first; job != NULL;
+	    job = job->next)
+		releaseJob(job);
+
+	freeJobList(_first);
+	freeJobList(_freeJobs);
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	if (_deques != NULL) {
+		for (size_t i = 0; i < _size; i++) {
+			struct deque *deque = &_deques[i];
+
+			for (unsigned int j = (unsigned int)deque->top;
+			    j != (unsigned int)deque->bottom; j++) {
+				struct of_thread_pool_job *job =
+				    deque->jobs[j % DEQUE_SIZE];
+
+				releaseJob(job);
+				free(job);
+			}
+		}
+
+		free(_deques);
+	}
+#endif
+
 	[_queueCondition release];
 	[_countCondition release];
 
 	[super dealloc];
 }
+@end
 
-- (id)main
+@implementation OFThreadPoolThread
+- (instancetype)initWithQueue: (OFThreadPoolQueue *)queue
+			index: (size_t)index
 {
-	void *pool;
-
-	if (_terminate)
-		return nil;
-
-	pool = objc_autoreleasePoolPush();
-
-	for (;;) {
-		OFThreadPoolJob *job;
-
-		[_queueCondition lock];
-		@try {
-			of_list_object_t *listObject;
-
-			if (_terminate) {
-				objc_autoreleasePoolPop(pool);
-				return nil;
-			}
-
-			listObject = _queue.firstListObject;
+	self = [super init];
 
-			while (listObject == NULL) {
-				[_queueCondition wait];
+	_queue = [queue retain];
+	_index = index;
 
-				if (_terminate) {
-					objc_autoreleasePoolPop(pool);
-					return nil;
-				}
+	return self;
+}
 
-				listObject = _queue.firstListObject;
-			}
+- (void)dealloc
+{
+	freeJobList(_freeJobs);
+	[_queue release];
 
-			job = [[listObject->object retain] autorelease];
-			[_queue removeListObject: listObject];
-		} @finally {
-			[_queueCondition unlock];
-		}
+	[super dealloc];
+}
 
-		if (_terminate) {
-			objc_autoreleasePoolPop(pool);
-			return nil;
-		}
+- (id)main
+{
+	OFThreadPoolQueue *queue = _queue;
 
-		[job perform];
+	while (!queue->_terminate) {
+		struct of_thread_pool_job *job = nextJob(queue, self);
 
-		if (_terminate) {
-			objc_autoreleasePoolPop(pool);
-			return nil;
+		if (job == NULL) {
+			waitForJob(queue);
+			continue;
 		}
 
-		objc_autoreleasePoolPop(pool);
-		pool = objc_autoreleasePoolPush();
-
-		[_countCondition lock];
-		@try {
-			if (_terminate) {
-				objc_autoreleasePoolPop(pool);
-				return nil;
-			}
-
-			(*_doneCount)++;
-
-			[_countCondition signal];
-		} @finally {
-			[_countCondition unlock];
-		}
+		performJob(queue, self, job);
 	}
+
+	return nil;
 }
 @end
 
@@ -234,27 +587,42 @@ OF_DIRECT_MEMBERS
 	return [[[self alloc] initWithSize: size] autorelease];
 }
 
++ (instancetype)threadPoolWithSize: (size_t)size
+		  usesWorkStealing: (bool)usesWorkStealing
+{
+	return [[[self alloc] initWithSize: size
+			  usesWorkStealing: usesWorkStealing] autorelease];
+}
+
 - (instancetype)init
 {
 	return [self initWithSize: [OFSystemInfo numberOfCPUs]];
 }
 
 - (instancetype)initWithSize: (size_t)size
+{
+	return [self initWithSize: size
+		 usesWorkStealing: false];
+}
+
+- (instancetype)initWithSize: (size_t)size
+	    usesWorkStealing: (bool)usesWorkStealing
 {
 	self = [super init];
 
 	@try {
 		_size = size;
 		_threads = [[OFMutableArray alloc] init];
-		_queue = [[OFList alloc] init];
-		_queueCondition = [[OFCondition alloc] init];
-		_countCondition = [[OFCondition alloc] init];
+		_queue = [[OFThreadPoolQueue alloc]
+		    initWithSize: size
+		usesWorkStealing: usesWorkStealing];
 
 		for (size_t i = 0; i < size; i++) {
 			void *pool = objc_autoreleasePoolPush();
 
-			OFThreadPoolThread *thread =
-			    [OFThreadPoolThread threadWithThreadPool: self];
+			OFThreadPoolThread *thread = [[[OFThreadPoolThread
+			    alloc] initWithQueue: _queue
+					   index: i] autorelease];
 
 			[_threads addObject: thread];
 
@@ -277,55 +645,43 @@ OF_DIRECT_MEMBERS
 
 - (void)dealloc
 {
-	[_queueCondition lock];
-	@try {
-		[_countCondition lock];
+	if (_queue != nil) {
+		[_queue->_queueCondition lock];
 		@try {
-			for (OFThreadPoolThread *thread in _threads)
-				thread->_terminate = true;
+			_queue->_terminate = true;
+			[_queue->_queueCondition broadcast];
 		} @finally {
-			[_countCondition unlock];
+			[_queue->_queueCondition unlock];
 		}
-
-		[_queueCondition broadcast];
-	} @finally {
-		[_queueCondition unlock];
 	}
 
 	[_threads release];
 	[_queue release];
-	[_queueCondition release];
-	[_countCondition release];
 
 	[super dealloc];
 }
 
-- (void)of_dispatchJob: (OFThreadPoolJob *)job OF_DIRECT
-{
-	[_countCondition lock];
-	_count++;
-	[_countCondition unlock];
-
-	[_queueCondition lock];
-	@try {
-		[_queue appendObject: job];
-		[_queueCondition signal];
-	} @finally {
-		[_queueCondition unlock];
-	}
-}
-
 - (void)waitUntilDone
 {
+	OFThreadPoolThread *thread = currentThreadForQueue(_queue);
+
 	for (;;) {
-		[_countCondition lock];
+		struct of_thread_pool_job *job;
+
+		/* Help executing jobs instead of just sleeping. */
+		if ((job = nextJob(_queue, thread)) != NULL) {
+			performJob(_queue, thread, job);
+			continue;
+		}
+
+		[_queue->_countCondition lock];
 		@try {
-			if (_doneCount == _count)
+			if (_queue->_pendingCount == 0)
 				return;
 
-			[_countCondition wait];
+			[_queue->_countCondition wait];
 		} @finally {
-			[_countCondition unlock];
+			[_queue->_countCondition unlock];
 		}
 	}
 }
@@ -334,24 +690,74 @@ OF_DIRECT_MEMBERS
 		  selector: (SEL)selector
 		    object: (id)object
 {
-	OFThreadPoolJob *job = [[OFThreadPoolJob alloc] initWithTarget: target
-							      selector: selector
-								object: object];
+	OFThreadPoolThread *thread = currentThreadForQueue(_queue);
+	struct of_thread_pool_job *job = newJob(_queue, thread);
+
+	job->target = [target retain];
+	job->selector = selector;
+	job->object = [object retain];
+
 	@try {
-		[self of_dispatchJob: job];
-	} @finally {
-		[job release];
+		enqueueJobs(_queue, thread, job, job, 1);
+	} @catch (id e) {
+		recycleJob(_queue, thread, job);
+		@throw e;
+	}
+}
+
+- (void)dispatchWithTarget: (id)target
+		  selector: (SEL)selector
+		   objects: (OFArray *)objects
+{
+	OFThreadPoolThread *thread = currentThreadForQueue(_queue);
+	struct of_thread_pool_job *first = NULL, *last = NULL;
+	size_t count = 0;
+
+	@try {
+		for (id object in objects) {
+			struct of_thread_pool_job *job =
+			    newJob(_queue, thread);
+
+			job->target = [target retain];
+			job->selector = selector;
+			job->object = [object retain];
+
+			if (last != NULL)
+				last->next = job;
+			else
+				first = job;
+
+			last = job;
+			count++;
+		}
+
+		if (count > 0)
+			enqueueJobs(_queue, thread, first, last, count);
+	} @catch (id e) {
+		while (first != NULL) {
+			struct of_thread_pool_job *next = first->next;
+
+			recycleJob(_queue, thread, first);
+			first = next;
+		}
+
+		@throw e;
 	}
 }
 
 #ifdef OF_HAVE_BLOCKS
 - (void)dispatchWithBlock: (of_thread_pool_block_t)block
 {
-	OFThreadPoolJob *job = [[OFThreadPoolJob alloc] initWithBlock: block];
+	OFThreadPoolThread *thread = currentThreadForQueue(_queue);
+	struct of_thread_pool_job *job = newJob(_queue, thread);
+
+	job->block = [block copy];
+
 	@try {
-		[self of_dispatchJob: job];
-	} @finally {
-		[job release];
+		enqueueJobs(_queue, thread, job, job, 1);
+	} @catch (id e) {
+		recycleJob(_queue, thread, job);
+		@throw e;
 	}
 }
 #endif
@@ -360,4 +766,9 @@ OF_DIRECT_MEMBERS
 {
 	return _size;
 }
+
+- (bool)usesWorkStealing
+{
+	return _queue->_usesWorkStealing;
+}
 @end
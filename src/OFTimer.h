@@ -46,7 +46,7 @@ OF_SUBCLASSING_RESTRICTED
 @interface OFTimer: OFObject <OFComparing>
 {
 	OFDate *_fireDate;
-	of_time_interval_t _interval;
+	of_time_interval_t _interval, _tolerance;
 	id _target;
 	id _Nullable _object1, _object2, _object3, _object4;
 	SEL _selector;
@@ -62,6 +62,15 @@ OF_SUBCLASSING_RESTRICTED
 #endif
 	OFRunLoop *_Nullable _inRunLoop;
 	of_run_loop_mode_t _Nullable _inRunLoopMode;
+#ifdef OF_RUN_LOOP_M
+@public
+#endif
+	/* Managed by the run loop, which keeps its timers in a pairing heap */
+	OFTimer *_Nullable _queueChild, *_Nullable _queueSibling;
+	OFTimer *_Nullable _queuePrevious;
+	id _Nullable _queue;
+	of_time_interval_t _queueDeadline;
+	unsigned long long _queueSequence;
 }
 
 /**
@@ -84,12 +93,23 @@ OF_SUBCLASSING_RESTRICTED
  * @brief The next date at which the timer will fire.
  *
  * If the timer is already scheduled in a run loop, it will be rescheduled.
- * Note that rescheduling is an expensive operation, though it still might be
- * preferable to reschedule instead of invalidating the timer and creating a
- * new one.
+ * Rescheduling is cheap, so it is preferable to reschedule instead of
+ * invalidating the timer and creating a new one.
  */
 @property (copy, nonatomic) OFDate *fireDate;
 
+/**
+ * @brief The amount of time after the fire date by which the timer may be
+ *	  late.
+ *
+ * A run loop can fire several timers with a tolerance with a single wakeup,
+ * which reduces the number of wakeups if there are many timers, e.g. for
+ * connection timeouts. The default is 0.
+ *
+ * If the timer is already scheduled in a run loop, it will be rescheduled.
+ */
+@property (nonatomic) of_time_interval_t tolerance;
+
 /**
  * @brief Creates and schedules a new timer with the specified time interval.
  *
@@ -626,17 +626,59 @@
 	[self retain];
 	@try {
 		@synchronized (self) {
-			OFDate *old;
+			OFRunLoop *runLoop = [_inRunLoop retain];
+			of_run_loop_mode_t mode = [_inRunLoopMode retain];
 
-			[_inRunLoop of_removeTimer: self
-					   forMode: _inRunLoopMode];
+			@try {
+				OFDate *old;
+
+				[runLoop of_removeTimer: self
+						forMode: mode];
 
-			old = _fireDate;
-			_fireDate = [fireDate copy];
-			[old release];
+				old = _fireDate;
+				_fireDate = [fireDate copy];
+				[old release];
 
-			[_inRunLoop addTimer: self
-				     forMode: _inRunLoopMode];
+				[runLoop addTimer: self
+					  forMode: mode];
+			} @finally {
+				[runLoop release];
+				[mode release];
+			}
+		}
+	} @finally {
+		[self release];
+	}
+}
+
+- (of_time_interval_t)tolerance
+{
+	return _tolerance;
+}
+
+- (void)setTolerance: (of_time_interval_t)tolerance
+{
+	if (tolerance < 0)
+		@throw [OFInvalidArgumentException exception];
+
+	[self retain];
+	@try {
+		@synchronized (self) {
+			OFRunLoop *runLoop = [_inRunLoop retain];
+			of_run_loop_mode_t mode = [_inRunLoopMode retain];
+
+			@try {
+				[runLoop of_removeTimer: self
+						forMode: mode];
+
+				_tolerance = tolerance;
+
+				[runLoop addTimer: self
+					  forMode: mode];
+			} @finally {
+				[runLoop release];
+				[mode release];
+			}
 		}
 	} @finally {
 		[self release];
@@ -647,6 +689,20 @@
 {
 	_valid = false;
 
+	/*
+	 * Remove the timer from the run loop right away so that invalidated
+	 * timers do not pile up until their fire date.
+	 */
+	[self retain];
+	@try {
+		@synchronized (self) {
+			[_inRunLoop of_removeTimer: self
+					   forMode: _inRunLoopMode];
+		}
+	} @finally {
+		[self release];
+	}
+
 	[_target release];
 	[_object1 release];
 	[_object2 release];
@@ -39,6 +39,7 @@
 #import "OFOutOfRangeException.h"
 
 #import "of_asprintf.h"
+#import "siphash.h"
 #import "unicode.h"
 
 extern const of_char16_t of_iso_8859_2_table[];
@@ -781,6 +782,12 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 	if (object == self)
 		return true;
 
+#ifdef OF_OBJFW_RUNTIME
+	/* Compares without creating a C string for the tagged pointer. */
+	if (object_isTaggedPointer(object))
+		return [object isEqual: self];
+#endif
+
 	if (![object isKindOfClass: [OFString class]])
 		return false;
 
@@ -924,34 +931,14 @@ of_string_utf8_get_position(const char *string, size_t idx, size_t length)
 
 - (unsigned long)hash
 {
-	uint32_t hash;
-
 	if (_s->hashed)
 		return _s->hash;
 
-	OF_HASH_INIT(hash);
-
-	for (size_t i = 0; i < _s->cStringLength; i++) {
-		of_unichar_t c;
-		ssize_t length;
-
-		if ((length = of_string_utf8_decode(_s->cString + i,
-		    _s->cStringLength - i, &c)) <= 0)
-			@throw [OFInvalidEncodingException exception];
-
-		OF_HASH_ADD(hash, (c & 0xFF0000) >> 16);
-		OF_HASH_ADD(hash, (c & 0x00FF00) >> 8);
-		OF_HASH_ADD(hash, c & 0x0000FF);
-
-		i += length - 1;
-	}
-
-	OF_HASH_FINALIZE(hash);
-
-	_s->hash = hash;
+	/* The C string is already the UTF-8 representation that is hashed. */
+	_s->hash = of_hash_bytes(_s->cString, _s->cStringLength);
 	_s->hashed = true;
 
-	return hash;
+	return _s->hash;
 }
 
 - (of_unichar_t)characterAtIndex: (size_t)idx
@@ -242,14 +242,93 @@ resolveAttributeNamespace(OFXMLAttribute *attribute, OFArray *namespaces,
 	[super dealloc];
 }
 
+/*
+ * Returns the only byte the current state reacts to, or '\0' if the state
+ * needs to look at every byte. In states that have such a byte, everything up
+ * to it can be skipped without calling the state function.
+ */
+static OF_INLINE char
+scanDelimiter(OFXMLParser *self)
+{
+	switch (self->_state) {
+	case OF_XMLPARSER_OUTSIDE_TAG:
+		/* Outside of the root element, only whitespace is allowed. */
+		if (self->_finishedParsing || self->_previous.count < 1)
+			return '\0';
+
+		return '<';
+	case OF_XMLPARSER_IN_ATTRIBUTE_VALUE:
+		return self->_delimiter;
+	case OF_XMLPARSER_IN_CDATA:
+		return (self->_level == 0 ? ']' : '\0');
+	case OF_XMLPARSER_IN_COMMENT_1:
+		return (self->_level == 0 ? '-' : '\0');
+	default:
+		return '\0';
+	}
+}
+
+static void
+countLines(OFXMLParser *self, const char *data, size_t length)
+{
+	const char *end = data + length;
+
+	if (length == 0)
+		return;
+
+	if (memchr(data, '\r', length) == NULL) {
+		const char *LF = data;
+
+		/* An LF right after a CR was already counted with the CR. */
+		if (self->_lastCarriageReturn && *data == '\n')
+			LF++;
+
+		while ((LF = memchr(LF, '\n', end - LF)) != NULL) {
+			self->_lineNumber++;
+			LF++;
+		}
+
+		self->_lastCarriageReturn = false;
+		return;
+	}
+
+	for (; data < end; data++) {
+		if (*data == '\r' || (*data == '\n' &&
+		    !self->_lastCarriageReturn))
+			self->_lineNumber++;
+
+		self->_lastCarriageReturn = (*data == '\r');
+	}
+}
+
 - (void)parseBuffer: (const char *)buffer
 	     length: (size_t)length
 {
 	_data = buffer;
 
 	for (_i = _last = 0; _i < length; _i++) {
-		size_t j = _i;
+		char delimiter;
+		size_t j;
+
+		/*
+		 * The skipped bytes stay between _last and _i, so that the
+		 * state function copies them to _buffer in one block once the
+		 * delimiter is found, or they are copied at the end of this
+		 * buffer.
+		 */
+		if ((delimiter = scanDelimiter(self)) != '\0') {
+			const char *found = memchr(_data + _i, delimiter,
+			    length - _i);
+			size_t end = (found != NULL
+			    ? (size_t)(found - _data) : length);
+
+			countLines(self, _data + _i, end - _i);
+
+			if ((_i = end) == length)
+				break;
+		}
 
+		j = _i;
 		lookupTable[_state](self);
 
 		/* Ensure we don't count this character twice */
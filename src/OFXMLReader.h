@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include <string.h>
+
+#import "OFObject.h"
+
+OF_ASSUME_NONNULL_BEGIN
+
+/** @file */
+
+@class OFData;
+@class OFMutableData;
+@class OFStream;
+@class OFString;
+
+/**
+ * @brief An event returned by an OFXMLReader.
+ */
+typedef enum {
+	/** The reader has not read any event yet. */
+	OF_XML_READER_EVENT_NONE,
+	/** An element was started. */
+	OF_XML_READER_EVENT_START_ELEMENT,
+	/** An element was ended. */
+	OF_XML_READER_EVENT_END_ELEMENT,
+	/** Characters were read. */
+	OF_XML_READER_EVENT_CHARACTERS,
+	/** A CDATA section was read. */
+	OF_XML_READER_EVENT_CDATA,
+	/** A comment was read. */
+	OF_XML_READER_EVENT_COMMENT,
+	/** Processing instructions were read. */
+	OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS,
+	/** The end of the document was reached. */
+	OF_XML_READER_EVENT_END_OF_DOCUMENT
+} of_xml_reader_event_t;
+
+/**
+ * @struct of_xml_reader_range_t OFXMLReader.h ObjFW/OFXMLReader.h
+ *
+ * @brief A range of bytes borrowed from an OFXMLReader.
+ *
+ * The bytes are not terminated and are only valid until the next event is
+ * read.
+ */
+struct OF_BOXABLE of_xml_reader_range_t {
+	/** The first byte of the range, or NULL if the range is empty */
+	const char *_Nullable items;
+	/** The length of the range in bytes */
+	size_t length;
+};
+typedef struct of_xml_reader_range_t of_xml_reader_range_t;
+
+/**
+ * @brief Returns whether the specified range is equal to the specified C
+ *	  string.
+ *
+ * @param range The range to compare
+ * @param string The C string to compare the range with
+ * @return Whether the range is equal to the C string
+ */
+static OF_INLINE bool
+of_xml_reader_range_is_equal(of_xml_reader_range_t range, const char *string)
+{
+	size_t length = strlen(string);
+
+	return (range.length == length &&
+	    (length == 0 || memcmp(range.items, string, length) == 0));
+}
+
+/**
+ * @class OFXMLReader OFXMLReader.h ObjFW/OFXMLReader.h
+ *
+ * @brief A pull parser for XML.
+ *
+ * Unlike OFXMLParser, which calls a delegate for everything it parses, the
+ * caller asks an OFXMLReader for one event at a time using @ref nextEvent.
+ * Names, prefixes, namespaces, attributes and text are not returned as
+ * objects, but as ranges of bytes pointing into the reader's buffer, which
+ * are only valid until the next event is read. Elements that are not of
+ * interest can be skipped using @ref skipSubtree.
+ *
+ * Text and attribute values are returned as they appear in the document, so
+ * entities are not resolved and line endings are not normalized. Use
+ * @ref string and @ref stringValueOfAttributeAtIndex: to get an unescaped
+ * OFString.
+ *
+ * OFXMLReader only supports documents encoded in UTF-8. DTDs are skipped.
+ */
+OF_SUBCLASSING_RESTRICTED
+@interface OFXMLReader: OFObject
+{
+	OFStream *_Nullable _stream;
+	OFData *_Nullable _data;
+	char *_Nullable _storage;
+	const char *_Nullable _buffer;
+	size_t _bufferLength, _storageSize, _position;
+	of_xml_reader_event_t _event;
+	of_xml_reader_range_t _name, _prefix, _namespace, _text;
+	OFMutableData *_attributes, *_elements, *_names;
+	OFMutableData *_namespaces, *_namespaceData;
+	size_t _depth;
+	bool _checkedByteOrderMark, _emptyElement, _popElement;
+	bool _sawRootElement, _finishedRootElement;
+}
+
+/**
+ * @brief The last event that was read.
+ */
+@property (readonly, nonatomic) of_xml_reader_event_t event;
+
+/**
+ * @brief The number of elements that are currently open.
+ *
+ * For @ref OF_XML_READER_EVENT_START_ELEMENT, this includes the element that
+ * was just started, while for @ref OF_XML_READER_EVENT_END_ELEMENT, this
+ * includes the element that was just ended.
+ */
+@property (readonly, nonatomic) size_t depth;
+
+/**
+ * @brief The name of the element that was started or ended, without prefix.
+ */
+@property (readonly, nonatomic) of_xml_reader_range_t name;
+
+/**
+ * @brief The prefix of the element that was started or ended.
+ */
+@property (readonly, nonatomic) of_xml_reader_range_t prefix;
+
+/**
+ * @brief The namespace of the element that was started or ended.
+ */
+@property (readonly, nonatomic) of_xml_reader_range_t namespace;
+
+/**
+ * @brief The raw text of the characters, CDATA section, comment or
+ *	  processing instructions that were read.
+ */
+@property (readonly, nonatomic) of_xml_reader_range_t text;
+
+/**
+ * @brief The text that was read as a string, with entities resolved for
+ *	  characters.
+ */
+@property (readonly, nonatomic) OFString *string;
+
+/**
+ * @brief The number of attributes of the element that was started.
+ */
+@property (readonly, nonatomic) size_t attributesCount;
+
+/**
+ * @brief Creates a new XML reader that reads from the specified stream.
+ *
+ * @param stream The stream to read the XML from
+ * @return A new, autoreleased OFXMLReader
+ */
++ (instancetype)readerWithStream: (OFStream *)stream;
+
+/**
+ * @brief Creates a new XML reader that reads from the specified data.
+ *
+ * @param data The data to read the XML from. The data is retained and the
+ *	       ranges returned by the reader point directly into it.
+ * @return A new, autoreleased OFXMLReader
+ */
++ (instancetype)readerWithData: (OFData *)data;
+
+- (instancetype)init OF_UNAVAILABLE;
+
+/**
+ * @brief Initializes an already allocated XML reader to read from the
+ *	  specified stream.
+ *
+ * @param stream The stream to read the XML from
+ * @return An initialized OFXMLReader
+ */
+- (instancetype)initWithStream: (OFStream *)stream;
+
+/**
+ * @brief Initializes an already allocated XML reader to read from the
+ *	  specified data.
+ *
+ * @param data The data to read the XML from. The data is retained and the
+ *	       ranges returned by the reader point directly into it.
+ * @return An initialized OFXMLReader
+ */
+- (instancetype)initWithData: (OFData *)data;
+
+/**
+ * @brief Reads the next event.
+ *
+ * All ranges returned for the previous event become invalid.
+ *
+ * @return The event that was read
+ * @throw OFMalformedXMLException The document is not well-formed
+ * @throw OFUnboundPrefixException An element or attribute uses a prefix that
+ *				   has not been bound to a namespace
+ */
+- (of_xml_reader_event_t)nextEvent;
+
+/**
+ * @brief Skips everything up to and including the end of the element that was
+ *	  just started.
+ *
+ * If the last event was not @ref OF_XML_READER_EVENT_START_ELEMENT, this does
+ * nothing. Afterwards, the event is @ref OF_XML_READER_EVENT_END_ELEMENT.
+ */
+- (void)skipSubtree;
+
+/**
+ * @brief Returns the name of the attribute at the specified index, without
+ *	  prefix.
+ *
+ * @param index The index of the attribute
+ * @return The name of the attribute at the specified index
+ */
+- (of_xml_reader_range_t)nameOfAttributeAtIndex: (size_t)index;
+
+/**
+ * @brief Returns the prefix of the attribute at the specified index.
+ *
+ * @param index The index of the attribute
+ * @return The prefix of the attribute at the specified index
+ */
+- (of_xml_reader_range_t)prefixOfAttributeAtIndex: (size_t)index;
+
+/**
+ * @brief Returns the namespace of the attribute at the specified index.
+ *
+ * Attributes without a prefix have no namespace.
+ *
+ * @param index The index of the attribute
+ * @return The namespace of the attribute at the specified index
+ */
+- (of_xml_reader_range_t)namespaceOfAttributeAtIndex: (size_t)index;
+
+/**
+ * @brief Returns the raw value of the attribute at the specified index.
+ *
+ * @param index The index of the attribute
+ * @return The raw value of the attribute at the specified index
+ */
+- (of_xml_reader_range_t)valueOfAttributeAtIndex: (size_t)index;
+
+/**
+ * @brief Returns the value of the attribute at the specified index as a
+ *	  string with entities resolved.
+ *
+ * @param index The index of the attribute
+ * @return The value of the attribute at the specified index as a string
+ */
+- (OFString *)stringValueOfAttributeAtIndex: (size_t)index;
+
+/**
+ * @brief Returns the index of the attribute with the specified name and
+ *	  namespace.
+ *
+ * @param name The name of the attribute
+ * @param namespace_ The namespace of the attribute or NULL for attributes
+ *		     without a namespace
+ * @return The index of the attribute or OF_NOT_FOUND
+ */
+- (size_t)indexOfAttributeWithName: (const char *)name
+			 namespace: (nullable const char *)namespace_;
+@end
+
+OF_ASSUME_NONNULL_END
@@ -0,0 +1,822 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#import "OFXMLReader.h"
+#import "OFData.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "OFInvalidArgumentException.h"
+#import "OFMalformedXMLException.h"
+#import "OFOutOfRangeException.h"
+#import "OFUnboundPrefixException.h"
+
+#define MIN_BUFFER_SIZE 16384
+
+struct attribute {
+	const char *name, *prefix, *value;
+	size_t nameLength, prefixLength, valueLength;
+};
+
+struct element {
+	/* The qualified name is stored in _names. */
+	size_t nameOffset, nameLength;
+	/* The namespace bindings before this element was started. */
+	size_t namespacesCount, namespaceDataLength;
+};
+
+struct namespace_binding {
+	/* Both are stored in _namespaceData. */
+	size_t prefixOffset, prefixLength, URIOffset, URILength;
+};
+
+static const char XMLNamespace[] = "http://www.w3.org/XML/1998/namespace";
+static const char XMLNSNamespace[] = "http://www.w3.org/2000/xmlns/";
+
+@interface OFXMLReader ()
+- (instancetype)of_init OF_METHOD_FAMILY(init);
+- (bool)of_readMore;
+- (bool)of_parseStartTag: (const char *)start
+		     end: (const char *)end
+		   event: (of_xml_reader_event_t *)event;
+- (bool)of_parseEndTag: (const char *)start
+		   end: (const char *)end
+		 event: (of_xml_reader_event_t *)event;
+- (bool)of_skipDocumentTypeDeclaration: (const char *)start
+				   end: (const char *)end;
+- (bool)of_parseEvent: (of_xml_reader_event_t *)event
+		atEnd: (bool)atEnd;
+- (void)of_popElement;
+@end
+
+static OF_INLINE of_xml_reader_range_t
+makeRange(const char *items, size_t length)
+{
+	of_xml_reader_range_t range;
+
+	range.items = (length > 0 ? items : NULL);
+	range.length = length;
+
+	return range;
+}
+
+static OF_INLINE void
+splitName(const char *name, size_t length, of_xml_reader_range_t *prefix,
+    of_xml_reader_range_t *localName)
+{
+	const char *colon = memchr(name, ':', length);
+
+	if (colon != NULL) {
+		*prefix = makeRange(name, colon - name);
+		*localName = makeRange(colon + 1, length - (colon - name) - 1);
+	} else {
+		*prefix = makeRange(NULL, 0);
+		*localName = makeRange(name, length);
+	}
+}
+
+/*
+ * Searches for the specified sequence, returning NULL if it was not found.
+ * The sequence is expected to be short.
+ */
+static const char *
+findSequence(const char *items, size_t length, const char *sequence,
+    size_t sequenceLength)
+{
+	const char *end = items + length;
+
+	while ((size_t)(end - items) >= sequenceLength) {
+		const char *found = memchr(items, sequence[0],
+		    end - items - sequenceLength + 1);
+
+		if (found == NULL)
+			return NULL;
+
+		if (memcmp(found, sequence, sequenceLength) == 0)
+			return found;
+
+		items = found + 1;
+	}
+
+	return NULL;
+}
+
+/*
+ * Returns 1 if the items start with the literal, 0 if they don't and -1 if
+ * there are not enough items to tell.
+ */
+static int
+matchLiteral(const char *items, size_t length, const char *literal,
+    size_t literalLength)
+{
+	if (memcmp(items, literal,
+	    (length < literalLength ? length : literalLength)) != 0)
+		return 0;
+
+	return (length >= literalLength ? 1 : -1);
+}
+
+@implementation OFXMLReader
+@synthesize event = _event, depth = _depth, name = _name, prefix = _prefix;
+@synthesize namespace = _namespace, text = _text;
+
++ (instancetype)readerWithStream: (OFStream *)stream
+{
+	return [[[self alloc] initWithStream: stream] autorelease];
+}
+
++ (instancetype)readerWithData: (OFData *)data
+{
+	return [[[self alloc] initWithData: data] autorelease];
+}
+
+- (instancetype)init
+{
+	OF_INVALID_INIT_METHOD
+}
+
+- (instancetype)of_init
+{
+	self = [super init];
+
+	@try {
+		_attributes = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(struct attribute)];
+		_elements = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(struct element)];
+		_names = [[OFMutableData alloc] init];
+		_namespaces = [[OFMutableData alloc]
+		    initWithItemSize: sizeof(struct namespace_binding)];
+		_namespaceData = [[OFMutableData alloc] init];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithStream: (OFStream *)stream
+{
+	self = [self of_init];
+
+	@try {
+		_stream = [stream retain];
+		_storageSize = MIN_BUFFER_SIZE;
+		_storage = of_alloc(_storageSize, 1);
+		_buffer = _storage;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [self of_init];
+
+	@try {
+		if (data.itemSize != 1)
+			@throw [OFInvalidArgumentException exception];
+
+		_data = [data copy];
+		_buffer = _data.items;
+		_bufferLength = _data.count;
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_stream release];
+	[_data release];
+	free(_storage);
+	[_attributes release];
+	[_elements release];
+	[_names release];
+	[_namespaces release];
+	[_namespaceData release];
+
+	[super dealloc];
+}
+
+static of_xml_reader_range_t
+lookupNamespace(OFXMLReader *self, of_xml_reader_range_t prefix, bool *found)
+{
+	const struct namespace_binding *bindings = self->_namespaces.items;
+	const char *data = self->_namespaceData.items;
+
+	*found = true;
+
+	for (size_t i = self->_namespaces.count; i > 0; i--) {
+		const struct namespace_binding *binding = &bindings[i - 1];
+
+		if (binding->prefixLength != prefix.length)
+			continue;
+		if (prefix.length > 0 && memcmp(data + binding->prefixOffset,
+		    prefix.items, prefix.length) != 0)
+			continue;
+
+		return makeRange(data + binding->URIOffset,
+		    binding->URILength);
+	}
+
+	if (prefix.length == 0)
+		return makeRange(NULL, 0);
+
+	if (of_xml_reader_range_is_equal(prefix, "xml"))
+		return makeRange(XMLNamespace, sizeof(XMLNamespace) - 1);
+	if (of_xml_reader_range_is_equal(prefix, "xmlns"))
+		return makeRange(XMLNSNamespace, sizeof(XMLNSNamespace) - 1);
+
+	*found = false;
+	return makeRange(NULL, 0);
+}
+
+static of_xml_reader_range_t
+resolvePrefix(OFXMLReader *self, of_xml_reader_range_t prefix)
+{
+	bool found;
+	of_xml_reader_range_t namespace = lookupNamespace(self, prefix, &found);
+
+	if (!found) {
+		OFString *prefixString = [OFString
+		    stringWithUTF8String: prefix.items
+				  length: prefix.length];
+
+		@throw [OFUnboundPrefixException
+		    exceptionWithPrefix: prefixString
+				 parser: nil];
+	}
+
+	return namespace;
+}
+
+- (bool)of_readMore
+{
+	if (_stream == nil)
+		return false;
+
+	/*
+	 * This is only called when the rest of the buffer does not contain a
+	 * complete event, so the rest is short and everything before the
+	 * position can't be referenced anymore.
+	 */
+	if (_position > 0) {
+		memmove(_storage, _storage + _position,
+		    _bufferLength - _position);
+		_bufferLength -= _position;
+		_position = 0;
+	}
+
+	if (_bufferLength == _storageSize) {
+		if (_storageSize > SIZE_MAX / 2)
+			@throw [OFOutOfRangeException exception];
+
+		_storage = of_realloc(_storage, _storageSize * 2, 1);
+		_storageSize *= 2;
+		_buffer = _storage;
+	}
+
+	while (!_stream.atEndOfStream) {
+		size_t length = [_stream
+		    readIntoBuffer: _storage + _bufferLength
+			    length: _storageSize - _bufferLength];
+
+		if (length > 0) {
+			_bufferLength += length;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+- (bool)of_parseStartTag: (const char *)start
+		     end: (const char *)end
+		   event: (of_xml_reader_event_t *)event
+{
+	const char *tagEnd, *nameEnd, *p;
+	char quote = '\0';
+	struct attribute *attributes;
+	size_t attributesCount;
+	struct element element;
+	bool empty = false;
+
+	for (tagEnd = start + 1; tagEnd < end; tagEnd++) {
+		if (quote != '\0') {
+			if (*tagEnd == quote)
+				quote = '\0';
+		} else if (*tagEnd == '"' || *tagEnd == '\'')
+			quote = *tagEnd;
+		else if (*tagEnd == '>')
+			break;
+	}
+
+	if (tagEnd == end)
+		return false;
+
+	if (_finishedRootElement)
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+
+	for (nameEnd = start + 1; nameEnd < tagEnd; nameEnd++)
+		if (of_ascii_isspace(*nameEnd) || *nameEnd == '/')
+			break;
+
+	if (nameEnd == start + 1)
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+
+	p = nameEnd;
+	for (;;) {
+		struct attribute attribute;
+		of_xml_reader_range_t prefix, name;
+		const char *attributeName, *valueEnd;
+
+		while (p < tagEnd && of_ascii_isspace(*p))
+			p++;
+
+		if (p == tagEnd)
+			break;
+
+		if (*p == '/') {
+			if (p + 1 != tagEnd)
+				@throw [OFMalformedXMLException
+				    exceptionWithParser: nil];
+
+			empty = true;
+			break;
+		}
+
+		attributeName = p;
+		while (p < tagEnd && *p != '=' && !of_ascii_isspace(*p))
+			p++;
+
+		if (p == attributeName)
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+
+		splitName(attributeName, p - attributeName, &prefix, &name);
+
+		while (p < tagEnd && of_ascii_isspace(*p))
+			p++;
+		if (p == tagEnd || *p++ != '=')
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+		while (p < tagEnd && of_ascii_isspace(*p))
+			p++;
+		if (p == tagEnd || (*p != '"' && *p != '\''))
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+
+		valueEnd = memchr(p + 1, *p, tagEnd - p - 1);
+		if (valueEnd == NULL)
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+
+		attribute.name = name.items;
+		attribute.nameLength = name.length;
+		attribute.prefix = prefix.items;
+		attribute.prefixLength = prefix.length;
+		attribute.value = p + 1;
+		attribute.valueLength = valueEnd - p - 1;
+		[_attributes addItem: &attribute];
+
+		p = valueEnd + 1;
+		if (p < tagEnd && *p != '/' && !of_ascii_isspace(*p))
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+	}
+
+	element.nameOffset = _names.count;
+	element.nameLength = nameEnd - start - 1;
+	element.namespacesCount = _namespaces.count;
+	element.namespaceDataLength = _namespaceData.count;
+	[_names addItems: start + 1
+		   count: element.nameLength];
+	[_elements addItem: &element];
+	_depth++;
+	_sawRootElement = true;
+
+	attributes = _attributes.mutableItems;
+	attributesCount = _attributes.count;
+
+	for (size_t i = 0; i < attributesCount; i++) {
+		struct namespace_binding binding;
+
+		if (attributes[i].prefixLength == 0 &&
+		    attributes[i].nameLength == 5 &&
+		    memcmp(attributes[i].name, "xmlns", 5) == 0) {
+			binding.prefixOffset = _namespaceData.count;
+			binding.prefixLength = 0;
+		} else if (attributes[i].prefixLength == 5 &&
+		    memcmp(attributes[i].prefix, "xmlns", 5) == 0) {
+			binding.prefixOffset = _namespaceData.count;
+			binding.prefixLength = attributes[i].nameLength;
+			[_namespaceData addItems: attributes[i].name
+					   count: attributes[i].nameLength];
+		} else
+			continue;
+
+		binding.URIOffset = _namespaceData.count;
+		binding.URILength = attributes[i].valueLength;
+		[_namespaceData addItems: attributes[i].value
+				   count: attributes[i].valueLength];
+
+		[_namespaces addItem: &binding];
+	}
+
+	for (size_t i = 0; i < attributesCount; i++)
+		if (attributes[i].prefixLength > 0)
+			resolvePrefix(self, makeRange(attributes[i].prefix,
+			    attributes[i].prefixLength));
+
+	splitName(start + 1, element.nameLength, &_prefix, &_name);
+	_namespace = resolvePrefix(self, _prefix);
+
+	_emptyElement = empty;
+	_position = tagEnd + 1 - _buffer;
+	*event = OF_XML_READER_EVENT_START_ELEMENT;
+
+	return true;
+}
+
+- (bool)of_parseEndTag: (const char *)start
+		   end: (const char *)end
+		 event: (of_xml_reader_event_t *)event
+{
+	const char *tagEnd = memchr(start + 2, '>', end - start - 2);
+	const char *nameEnd;
+	const struct element *element;
+
+	if (tagEnd == NULL)
+		return false;
+
+	for (nameEnd = start + 2; nameEnd < tagEnd; nameEnd++)
+		if (of_ascii_isspace(*nameEnd))
+			break;
+
+	for (const char *p = nameEnd; p < tagEnd; p++)
+		if (!of_ascii_isspace(*p))
+			@throw [OFMalformedXMLException
+			    exceptionWithParser: nil];
+
+	if (_depth == 0)
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+
+	element = _elements.lastItem;
+	if (element->nameLength != (size_t)(nameEnd - start - 2) ||
+	    memcmp((const char *)_names.items + element->nameOffset, start + 2,
+	    element->nameLength) != 0)
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+
+	splitName(start + 2, element->nameLength, &_prefix, &_name);
+	_namespace = resolvePrefix(self, _prefix);
+
+	_popElement = true;
+	_position = tagEnd + 1 - _buffer;
+	*event = OF_XML_READER_EVENT_END_ELEMENT;
+
+	return true;
+}
+
+- (bool)of_skipDocumentTypeDeclaration: (const char *)start
+				   end: (const char *)end
+{
+	char quote = '\0';
+	size_t brackets = 0;
+
+	if (_sawRootElement)
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+
+	for (const char *p = start; p < end; p++) {
+		if (quote != '\0') {
+			if (*p == quote)
+				quote = '\0';
+		} else if (*p == '"' || *p == '\'')
+			quote = *p;
+		else if (*p == '[')
+			brackets++;
+		else if (*p == ']' && brackets > 0)
+			brackets--;
+		else if (*p == '>' && brackets == 0) {
+			_position = p + 1 - _buffer;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+- (bool)of_parseEvent: (of_xml_reader_event_t *)event
+		atEnd: (bool)atEnd
+{
+	const char *start = _buffer + _position;
+	const char *end = _buffer + _bufferLength;
+	size_t length = end - start;
+	const char *found;
+	int match;
+
+	*event = OF_XML_READER_EVENT_NONE;
+
+	if (*start != '<') {
+		found = memchr(start, '<', length);
+
+		if (found == NULL) {
+			if (!atEnd)
+				return false;
+
+			found = end;
+		}
+
+		if (_depth == 0) {
+			/* Outside of the root element, only whitespace. */
+			for (const char *p = start; p < found; p++)
+				if (!of_ascii_isspace(*p))
+					@throw [OFMalformedXMLException
+					    exceptionWithParser: nil];
+		} else {
+			_text = makeRange(start, found - start);
+			*event = OF_XML_READER_EVENT_CHARACTERS;
+		}
+
+		_position = found - _buffer;
+		return true;
+	}
+
+	if (length < 2)
+		return false;
+
+	switch (start[1]) {
+	case '?':
+		found = findSequence(start + 2, length - 2, "?>", 2);
+		if (found == NULL)
+			return false;
+
+		_text = makeRange(start + 2, found - start - 2);
+		_position = found + 2 - _buffer;
+		*event = OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS;
+		return true;
+	case '/':
+		return [self of_parseEndTag: start
+					end: end
+				      event: event];
+	case '!':
+		if ((match = matchLiteral(start, length, "<!--", 4)) == 1) {
+			found = findSequence(start + 4, length - 4, "-->", 3);
+			if (found == NULL)
+				return false;
+
+			_text = makeRange(start + 4, found - start - 4);
+			_position = found + 3 - _buffer;
+			*event = OF_XML_READER_EVENT_COMMENT;
+			return true;
+		} else if (match == -1)
+			return false;
+
+		if ((match = matchLiteral(start, length,
+		    "<![CDATA[", 9)) == 1) {
+			if (_depth == 0)
+				@throw [OFMalformedXMLException
+				    exceptionWithParser: nil];
+
+			found = findSequence(start + 9, length - 9, "]]>", 3);
+			if (found == NULL)
+				return false;
+
+			_text = makeRange(start + 9, found - start - 9);
+			_position = found + 3 - _buffer;
+			*event = OF_XML_READER_EVENT_CDATA;
+			return true;
+		} else if (match == -1)
+			return false;
+
+		if ((match = matchLiteral(start, length,
+		    "<!DOCTYPE", 9)) == 1)
+			return [self of_skipDocumentTypeDeclaration: start + 9
+								end: end];
+		else if (match == -1)
+			return false;
+
+		@throw [OFMalformedXMLException exceptionWithParser: nil];
+	default:
+		return [self of_parseStartTag: start
+					  end: end
+					event: event];
+	}
+}
+
+- (void)of_popElement
+{
+	const struct element *element = _elements.lastItem;
+
+	[_names removeItemsInRange: of_range(element->nameOffset,
+	    _names.count - element->nameOffset)];
+	[_namespaces removeItemsInRange: of_range(element->namespacesCount,
+	    _namespaces.count - element->namespacesCount)];
+	[_namespaceData removeItemsInRange: of_range(
+	    element->namespaceDataLength,
+	    _namespaceData.count - element->namespaceDataLength)];
+	[_elements removeLastItem];
+
+	if (--_depth == 0)
+		_finishedRootElement = true;
+}
+
+- (of_xml_reader_event_t)nextEvent
+{
+	bool atEnd = false;
+
+	if (_popElement) {
+		[self of_popElement];
+		_popElement = false;
+	}
+
+	if (_emptyElement) {
+		/* Name, prefix and namespace are still those of the start. */
+		[_attributes removeAllItems];
+		_emptyElement = false;
+		_popElement = true;
+
+		return (_event = OF_XML_READER_EVENT_END_ELEMENT);
+	}
+
+	if (_event == OF_XML_READER_EVENT_END_OF_DOCUMENT)
+		return _event;
+
+	[_attributes removeAllItems];
+	_name = _prefix = _namespace = _text = makeRange(NULL, 0);
+
+	for (;;) {
+		if (!_checkedByteOrderMark &&
+		    (_bufferLength - _position >= 3 || atEnd)) {
+			if (_bufferLength - _position >= 3 &&
+			    memcmp(_buffer + _position, "\xEF\xBB\xBF", 3) == 0)
+				_position += 3;
+
+			_checkedByteOrderMark = true;
+		}
+
+		if (_checkedByteOrderMark && _position < _bufferLength) {
+			of_xml_reader_event_t event;
+
+			if ([self of_parseEvent: &event
+					  atEnd: atEnd]) {
+				if (event != OF_XML_READER_EVENT_NONE)
+					return (_event = event);
+
+				continue;
+			}
+
+			if (atEnd)
+				@throw [OFMalformedXMLException
+				    exceptionWithParser: nil];
+		} else if (atEnd) {
+			if (!_finishedRootElement)
+				@throw [OFMalformedXMLException
+				    exceptionWithParser: nil];
+
+			return (_event = OF_XML_READER_EVENT_END_OF_DOCUMENT);
+		}
+
+		if (![self of_readMore])
+			atEnd = true;
+	}
+}
+
+- (void)skipSubtree
+{
+	size_t depth = _depth;
+	of_xml_reader_event_t event;
+
+	if (_event != OF_XML_READER_EVENT_START_ELEMENT)
+		return;
+
+	do {
+		event = [self nextEvent];
+	} while (event != OF_XML_READER_EVENT_END_ELEMENT || _depth != depth);
+}
+
+- (OFString *)string
+{
+	OFString *string;
+
+	switch (_event) {
+	case OF_XML_READER_EVENT_CHARACTERS:
+	case OF_XML_READER_EVENT_CDATA:
+	case OF_XML_READER_EVENT_COMMENT:
+	case OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS:
+		break;
+	default:
+		return @"";
+	}
+
+	string = [OFString stringWithUTF8String: (_text.items != NULL
+						     ? _text.items : "")
+					 length: _text.length];
+
+	if (_event == OF_XML_READER_EVENT_CHARACTERS)
+		return string.stringByXMLUnescaping;
+
+	return string;
+}
+
+- (size_t)attributesCount
+{
+	return _attributes.count;
+}
+
+- (of_xml_reader_range_t)nameOfAttributeAtIndex: (size_t)idx
+{
+	const struct attribute *attribute = [_attributes itemAtIndex: idx];
+
+	return makeRange(attribute->name, attribute->nameLength);
+}
+
+- (of_xml_reader_range_t)prefixOfAttributeAtIndex: (size_t)idx
+{
+	const struct attribute *attribute = [_attributes itemAtIndex: idx];
+
+	return makeRange(attribute->prefix, attribute->prefixLength);
+}
+
+- (of_xml_reader_range_t)namespaceOfAttributeAtIndex: (size_t)idx
+{
+	const struct attribute *attribute = [_attributes itemAtIndex: idx];
+
+	if (attribute->prefixLength == 0)
+		return makeRange(NULL, 0);
+
+	return resolvePrefix(self,
+	    makeRange(attribute->prefix, attribute->prefixLength));
+}
+
+- (of_xml_reader_range_t)valueOfAttributeAtIndex: (size_t)idx
+{
+	const struct attribute *attribute = [_attributes itemAtIndex: idx];
+
+	return makeRange(attribute->value, attribute->valueLength);
+}
+
+- (OFString *)stringValueOfAttributeAtIndex: (size_t)idx
+{
+	const struct attribute *attribute = [_attributes itemAtIndex: idx];
+
+	return [OFString stringWithUTF8String: (attribute->valueLength > 0
+						   ? attribute->value : "")
+				       length: attribute->valueLength]
+	    .stringByXMLUnescaping;
+}
+
+- (size_t)indexOfAttributeWithName: (const char *)name
+			 namespace: (const char *)namespace_
+{
+	const struct attribute *attributes = _attributes.items;
+	size_t count = _attributes.count;
+
+	for (size_t i = 0; i < count; i++) {
+		if (!of_xml_reader_range_is_equal(makeRange(attributes[i].name,
+		    attributes[i].nameLength), name))
+			continue;
+
+		if (namespace_ == NULL) {
+			if (attributes[i].prefixLength == 0)
+				return i;
+
+			continue;
+		}
+
+		if (attributes[i].prefixLength > 0 &&
+		    of_xml_reader_range_is_equal(resolvePrefix(self,
+		    makeRange(attributes[i].prefix,
+		    attributes[i].prefixLength)), namespace_))
+			return i;
+	}
+
+	return OF_NOT_FOUND;
+}
+@end
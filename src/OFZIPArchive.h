@@ -160,6 +160,9 @@ OF_SUBCLASSING_RESTRICTED
  *	    @ref OFWriteFailedException!
  *
  * @param entry The entry to write to the archive.@n
+ *		The compression method needs to be either
+ *		@ref OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_NONE or
+ *		@ref OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE.@n
  *		The following parts of the specified entry will be ignored:
  *		  * The lower 8 bits of the version made by.
  *		  * The lower 8 bits of the minimum version needed.
@@ -32,6 +32,7 @@
 #endif
 #import "OFInflateStream.h"
 #import "OFInflate64Stream.h"
+#import "OFDeflateStream.h"
 
 #import "crc32.h"
 
@@ -94,7 +95,9 @@ OF_DIRECT_MEMBERS
 @interface OFZIPArchiveFileWriteStream: OFStream
 {
 	OFStream *_stream;
+	OFDeflateStream *_Nullable _deflateStream;
 	uint32_t _CRC32;
+	int64_t _uncompressedSize;
 @public
 	int64_t _bytesWritten;
 	OFMutableZIPArchiveEntry *_entry;
@@ -508,7 +511,9 @@ seekOrThrowInvalidFormat(OFSeekableStream *stream,
 				errNo: EEXIST];
 
 	if (entry.compressionMethod !=
-	    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_NONE)
+	    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_NONE &&
+	    entry.compressionMethod !=
+	    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE)
 		@throw [OFNotImplementedException exceptionWithSelector: _cmd
 								 object: self];
 
@@ -874,9 +879,19 @@ seekOrThrowInvalidFormat(OFSeekableStream *stream,
 {
 	self = [super init];
 
-	_stream = [stream retain];
-	_entry = [entry retain];
-	_CRC32 = ~0;
+	@try {
+		_stream = [stream retain];
+		_entry = [entry retain];
+		_CRC32 = ~0;
+
+		if (entry.compressionMethod ==
+		    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE)
+			_deflateStream = [[OFDeflateStream alloc]
+			    initWithStream: stream];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
 
 	return self;
 }
@@ -886,6 +901,7 @@ seekOrThrowInvalidFormat(OFSeekableStream *stream,
 	if (_stream != nil)
 		[self close];
 
+	[_deflateStream release];
 	[_entry release];
 
 	[super dealloc];
@@ -894,23 +910,27 @@ seekOrThrowInvalidFormat(OFSeekableStream *stream,
 - (size_t)lowlevelWriteBuffer: (const void *)buffer
 		       length: (size_t)length
 {
-	size_t bytesWritten;
-
 #if SIZE_MAX >= INT64_MAX
 	if (length > INT64_MAX)
 		@throw [OFOutOfRangeException exception];
 #endif
 
-	if (INT64_MAX - _bytesWritten < (int64_t)length)
+	if (INT64_MAX - _uncompressedSize < (int64_t)length)
 		@throw [OFOutOfRangeException exception];
 
-	bytesWritten = [_stream writeBuffer: buffer
+	if (_deflateStream != nil)
+		[_deflateStream writeBuffer: buffer
 				     length: length];
+	else {
+		[_stream writeBuffer: buffer
+			      length: length];
+		_bytesWritten += (int64_t)length;
+	}
 
-	_bytesWritten += (int64_t)bytesWritten;
+	_uncompressedSize += (int64_t)length;
 	_CRC32 = of_crc32(_CRC32, buffer, length);
 
-	return bytesWritten;
+	return length;
 }
 
 - (void)close
@@ -918,17 +938,26 @@ seekOrThrowInvalidFormat(OFSeekableStream *stream,
 	if (_stream == nil)
 		@throw [OFNotOpenException exceptionWithObject: self];
 
+	if (_deflateStream != nil) {
+		[_deflateStream close];
+
+		if (_deflateStream.bytesWritten > INT64_MAX)
+			@throw [OFOutOfRangeException exception];
+
+		_bytesWritten = (int64_t)_deflateStream.bytesWritten;
+	}
+
 	[_stream writeLittleEndianInt32: 0x08074B50];
-	[_stream writeLittleEndianInt32: _CRC32];
-	[_stream writeLittleEndianInt64: _bytesWritten];
+	[_stream writeLittleEndianInt32: ~_CRC32];
 	[_stream writeLittleEndianInt64: _bytesWritten];
+	[_stream writeLittleEndianInt64: _uncompressedSize];
 
 	[_stream release];
 	_stream = nil;
 
 	_entry.CRC32 = ~_CRC32;
 	_entry.compressedSize = _bytesWritten;
-	_entry.uncompressedSize = _bytesWritten;
+	_entry.uncompressedSize = _uncompressedSize;
 	[_entry makeImmutable];
 
 	_bytesWritten += (2 * 4 + 2 * 8);
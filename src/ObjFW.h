@@ -55,6 +55,7 @@
 #import "OFStdIOStream.h"
 #import "OFInflateStream.h"
 #import "OFInflate64Stream.h"
+#import "OFDeflateStream.h"
 #import "OFGZIPStream.h"
 #import "OFLHAArchive.h"
 #import "OFLHAArchiveEntry.h"
@@ -123,8 +124,12 @@
 #import "OFXMLComment.h"
 #import "OFXMLProcessingInstructions.h"
 #import "OFXMLParser.h"
+#import "OFXMLReader.h"
 #import "OFXMLElementBuilder.h"
 
+#import "OFJSONReader.h"
+#import "OFJSONWriter.h"
+
 #import "OFMessagePackExtension.h"
 
 #import "OFApplication.h"
@@ -282,6 +287,7 @@
 #import "of_strptime.h"
 #import "pbkdf2.h"
 #import "scrypt.h"
+#import "siphash.h"
 #ifdef OF_HAVE_UNICODE_TABLES
 # import "unicode.h"
 #endif
@@ -134,7 +134,7 @@ of_atomic_ptr_cmpswap(void *volatile _Nullable *_Nonnull p,
 }
 
 static OF_INLINE void
-of_memory_barrier_full(void)
+of_memory_barrier(void)
 {
 	__atomic_thread_fence(__ATOMIC_SEQ_CST);
 }
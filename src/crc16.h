@@ -27,6 +27,18 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+/**
+ * @brief Updates a CRC-16 with the specified bytes.
+ *
+ * The CRC register is neither inverted on input nor on output, so a checksum
+ * can be computed incrementally by passing the return value of one call as the
+ * `crc` of the next call. The reflected polynomial is 0xA001.
+ *
+ * @param crc The current value of the CRC register
+ * @param bytes The bytes to update the CRC with
+ * @param length The number of bytes
+ * @return The new value of the CRC register
+ */
 extern uint16_t of_crc16(uint16_t crc, const void *_Nonnull bytes,
     size_t length);
 #ifdef __cplusplus
@@ -14,24 +14,52 @@
  * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
  * file.
  */
-
 #include "config.h"
 
 #import "crc16.h"
+#import "once.h"
 
 #define CRC16_MAGIC 0xA001
 
+static uint16_t table[8][256];
+static of_once_t initialized = OF_ONCE_INIT;
+
+static void
+initialize(void)
+{
+	for (uint16_t i = 0; i < 256; i++) {
+		uint16_t crc = i;
+
+		for (uint8_t j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (CRC16_MAGIC & (~(crc & 1) + 1));
+
+		table[0][i] = crc;
+	}
+
+	for (uint8_t i = 1; i < 8; i++)
+		for (uint16_t j = 0; j < 256; j++)
+			table[i][j] = (table[i - 1][j] >> 8) ^
+			    table[0][table[i - 1][j] & 0xFF];
+}
+
 uint16_t
 of_crc16(uint16_t crc, const void *bytes_, size_t length)
 {
 	const unsigned char *bytes = bytes_;
 
-	for (size_t i = 0; i < length; i++) {
-		crc ^= bytes[i];
+	of_once(&initialized, initialize);
 
-		for (uint8_t j = 0; j < 8; j++)
-			crc = (crc >> 1) ^ (CRC16_MAGIC & (~(crc & 1) + 1));
+	for (; length >= 8; bytes += 8, length -= 8) {
+		crc ^= (uint16_t)bytes[0] | (uint16_t)bytes[1] << 8;
+
+		crc = table[7][crc & 0xFF] ^ table[6][crc >> 8] ^
+		    table[5][bytes[2]] ^ table[4][bytes[3]] ^
+		    table[3][bytes[4]] ^ table[2][bytes[5]] ^
+		    table[1][bytes[6]] ^ table[0][bytes[7]];
 	}
 
+	while (length-- > 0)
+		crc = (crc >> 8) ^ table[0][(crc ^ *bytes++) & 0xFF];
+
 	return crc;
 }
@@ -27,6 +27,21 @@
 #ifdef __cplusplus
 extern "C" {
 #endif
+/**
+ * @brief Updates a CRC-32 with the specified bytes.
+ *
+ * The CRC register is neither inverted on input nor on output, so a checksum
+ * can be computed incrementally by passing the return value of one call as the
+ * `crc` of the next call. The reflected polynomial is 0xEDB88320.
+ *
+ * On CPUs that support it, PCLMULQDQ or the ARMv8 CRC32 instructions are
+ * used, which is detected at runtime.
+ *
+ * @param crc The current value of the CRC register
+ * @param bytes The bytes to update the CRC with
+ * @param length The number of bytes
+ * @return The new value of the CRC register
+ */
 extern uint32_t of_crc32(uint32_t crc, const void *_Nonnull bytes,
     size_t length);
 #ifdef __cplusplus
@@ -18,20 +18,202 @@
 #include "config.h"
 
 #import "crc32.h"
+#import "once.h"
+
+#if defined(HAVE_PCLMUL) && (defined(OF_X86_64) || defined(OF_X86))
+# import "OFSystemInfo.h"
+# include <wmmintrin.h>
+# include <smmintrin.h>
+# define USE_PCLMUL
+#endif
+#if defined(HAVE_ARM_CRC32) && defined(OF_ARM64)
+# include <arm_acle.h>
+# if defined(HAVE_SYS_AUXV_H) && defined(HAVE_GETAUXVAL)
+#  include <sys/auxv.h>
+# endif
+# define USE_ARM_CRC32
+#endif
 
 #define CRC32_MAGIC 0xEDB88320
 
-uint32_t
-of_crc32(uint32_t crc, const void *bytes_, size_t length)
+static uint32_t table[8][256];
+static uint32_t (*implementation)(uint32_t, const unsigned char *, size_t);
+static of_once_t initialized = OF_ONCE_INIT;
+
+static uint32_t
+crc32Slicing(uint32_t crc, const unsigned char *bytes, size_t length)
+{
+	for (; length >= 8; bytes += 8, length -= 8) {
+		crc ^= (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+		    (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+
+		crc = table[7][crc & 0xFF] ^ table[6][(crc >> 8) & 0xFF] ^
+		    table[5][(crc >> 16) & 0xFF] ^ table[4][crc >> 24] ^
+		    table[3][bytes[4]] ^ table[2][bytes[5]] ^
+		    table[1][bytes[6]] ^ table[0][bytes[7]];
+	}
+
+	while (length-- > 0)
+		crc = (crc >> 8) ^ table[0][(crc ^ *bytes++) & 0xFF];
+
+	return crc;
+}
+
+#ifdef USE_PCLMUL
+/*
+ * Folds 64 bytes at a time with carry-less multiplication as described in
+ * Intel's "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ
+ * Instruction". The constants are x^(4*128+32) mod P, x^(4*128-32) mod P,
+ * x^(128+32) mod P, x^(128-32) mod P and x^64 mod P, bit-reflected, followed by
+ * the Barrett constants for P.
+ */
+__attribute__((__target__("pclmul,sse4.1")))
+static uint32_t
+crc32PCLMUL(uint32_t crc, const unsigned char *bytes, size_t length)
+{
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, mask;
+	size_t tail;
+
+	if (length < 64)
+		return crc32Slicing(crc, bytes, length);
+
+	tail = length & 15;
+	length -= tail;
+
+	x1 = _mm_loadu_si128((const __m128i *)(const void *)bytes);
+	x2 = _mm_loadu_si128((const __m128i *)(const void *)(bytes + 16));
+	x3 = _mm_loadu_si128((const __m128i *)(const void *)(bytes + 32));
+	x4 = _mm_loadu_si128((const __m128i *)(const void *)(bytes + 48));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+	x0 = _mm_set_epi64x(0x1C6E41596, 0x154442BD4);
+	bytes += 64;
+	length -= 64;
+
+	for (; length >= 64; bytes += 64, length -= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(
+		    (const __m128i *)(const void *)bytes));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(
+		    (const __m128i *)(const void *)(bytes + 16)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(
+		    (const __m128i *)(const void *)(bytes + 32)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(
+		    (const __m128i *)(const void *)(bytes + 48)));
+	}
+
+	/* Fold the four lanes into one. */
+	x0 = _mm_set_epi64x(0x0CCAA009E, 0x1751997D0);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	for (; length >= 16; bytes += 16, length -= 16) {
+		x2 = _mm_loadu_si128((const __m128i *)(const void *)bytes);
+
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	}
+
+	/* Fold 128 bits to 64 bits. */
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	mask = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+	x0 = _mm_set_epi64x(0, 0x163CD6124);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	/* Barrett reduction to 32 bits. */
+	x0 = _mm_set_epi64x(0x1F7011641, 0x1DB710641);
+	x2 = _mm_and_si128(x1, mask);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, mask);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	crc = (uint32_t)_mm_extract_epi32(x1, 1);
+
+	return crc32Slicing(crc, bytes, tail);
+}
+#endif
+
+#ifdef USE_ARM_CRC32
+__attribute__((__target__("crc")))
+static uint32_t
+crc32ARM(uint32_t crc, const unsigned char *bytes, size_t length)
 {
-	const unsigned char *bytes = bytes_;
+	for (; length > 0 && ((uintptr_t)bytes & 7) != 0; length--)
+		crc = __crc32b(crc, *bytes++);
 
-	for (size_t i = 0; i < length; i++) {
-		crc ^= bytes[i];
+	for (; length >= 8; bytes += 8, length -= 8)
+		crc = __crc32d(crc,
+		    OF_BSWAP64_IF_BE(*(const uint64_t *)(const void *)bytes));
+
+	while (length-- > 0)
+		crc = __crc32b(crc, *bytes++);
+
+	return crc;
+}
+#endif
+
+static void
+initialize(void)
+{
+	for (uint32_t i = 0; i < 256; i++) {
+		uint32_t crc = i;
 
 		for (uint8_t j = 0; j < 8; j++)
 			crc = (crc >> 1) ^ (CRC32_MAGIC & (~(crc & 1) + 1));
+
+		table[0][i] = crc;
 	}
 
-	return crc;
+	for (uint8_t i = 1; i < 8; i++)
+		for (uint32_t j = 0; j < 256; j++)
+			table[i][j] = (table[i - 1][j] >> 8) ^
+			    table[0][table[i - 1][j] & 0xFF];
+
+	implementation = crc32Slicing;
+
+#if defined(USE_PCLMUL)
+	if ([OFSystemInfo supportsPCLMULQDQ] && [OFSystemInfo supportsSSE41])
+		implementation = crc32PCLMUL;
+#elif defined(USE_ARM_CRC32)
+# if defined(__ARM_FEATURE_CRC32) || defined(OF_MACOS) || defined(OF_IOS)
+	implementation = crc32ARM;
+# elif defined(HAVE_SYS_AUXV_H) && defined(HAVE_GETAUXVAL) && \
+    defined(HWCAP_CRC32)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+		implementation = crc32ARM;
+# endif
+#endif
+}
+
+uint32_t
+of_crc32(uint32_t crc, const void *bytes, size_t length)
+{
+	of_once(&initialized, initialize);
+
+	return implementation(crc, bytes, length);
 }
@@ -41,7 +41,7 @@ OF_ASSUME_NONNULL_BEGIN
 /**
  * @brief The parser which encountered the unbound prefix.
  */
-@property (readonly, nonatomic) OFXMLParser *parser;
+@property OF_NULLABLE_PROPERTY (readonly, nonatomic) OFXMLParser *parser;
 
 + (instancetype)exception OF_UNAVAILABLE;
 
@@ -53,7 +53,7 @@ OF_ASSUME_NONNULL_BEGIN
  * @return A new, autoreleased unbound prefix exception
  */
 + (instancetype)exceptionWithPrefix: (OFString *)prefix
-			     parser: (OFXMLParser *)parser;
+			     parser: (nullable OFXMLParser *)parser;
 
 - (instancetype)init OF_UNAVAILABLE;
 
@@ -65,7 +65,8 @@ OF_ASSUME_NONNULL_BEGIN
  * @return An initialized unbound prefix exception
  */
 - (instancetype)initWithPrefix: (OFString *)prefix
-			parser: (OFXMLParser *)parser OF_DESIGNATED_INITIALIZER;
+			parser: (nullable OFXMLParser *)parser
+    OF_DESIGNATED_INITIALIZER;
 @end
 
 OF_ASSUME_NONNULL_END
@@ -67,8 +67,14 @@
 
 - (OFString *)description
 {
-	return [OFString stringWithFormat:
-	    @"An XML parser of type %@ encountered the unbound prefix %@ in "
-	    @"line %zu!", _parser.class, _prefix, _parser.lineNumber];
+	if (_parser != nil)
+		return [OFString stringWithFormat:
+		    @"An XML parser of type %@ encountered the unbound prefix "
+		    @"%@ in line %zu!", _parser.class, _prefix,
+		    _parser.lineNumber];
+	else
+		return [OFString stringWithFormat:
+		    @"An XML parser encountered the unbound prefix %@!",
+		    _prefix];
 }
 @end
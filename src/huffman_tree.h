@@ -24,32 +24,58 @@
 
 OF_ASSUME_NONNULL_BEGIN
 
+#define OF_HUFFMAN_TREE_MAX_BITS 16
+#define OF_HUFFMAN_TREE_PRIMARY_BITS 10
+
+/*
+ * Each entry is either a symbol, a link to a secondary table or invalid. The
+ * lower 16 bits hold the symbol or the index of the secondary table, the next 8
+ * bits the number of bits that need to be available to trust the entry.
+ */
+#define OF_HUFFMAN_TREE_LINK 0x40000000u
+#define OF_HUFFMAN_TREE_INVALID 0x80000000u
+
+/*
+ * A multi-level lookup table for decoding canonical Huffman codes.
+ *
+ * The table is indexed with the next bits of the input in the order in which
+ * they are read, the first bit being the least significant one.
+ */
 struct of_huffman_tree {
-	struct of_huffman_tree *_Nullable leaves[2];
-	uint16_t value;
+	uint8_t primaryBits, secondaryBits;
+	uint32_t entries[];
 };
 
+/*
+ * Looks up the symbol starting at the least significant bit of the specified
+ * bits.
+ *
+ * Bits beyond bitsCount are allowed to contain anything. Returns false if more
+ * than bitsCount bits are needed to decode the symbol, in which case the
+ * caller should make more bits available and try again.
+ */
 static OF_INLINE bool
-of_huffman_tree_walk(id _Nullable stream,
-    bool (*bitReader)(id _Nullable, uint16_t *_Nonnull, uint8_t),
-    struct of_huffman_tree *_Nonnull *_Nonnull tree, uint16_t *_Nonnull value)
+of_huffman_tree_lookup(const struct of_huffman_tree *_Nonnull tree,
+    uint32_t bits, uint8_t bitsCount, uint16_t *_Nonnull value,
+    uint8_t *_Nonnull length)
 {
-	struct of_huffman_tree *iter = *tree;
-	uint16_t bits;
+	uint32_t entry =
+	    tree->entries[bits & ((UINT32_C(1) << tree->primaryBits) - 1)];
+
+	if (entry & OF_HUFFMAN_TREE_LINK)
+		entry = tree->entries[(entry & 0xFFFF) +
+		    ((bits >> tree->primaryBits) &
+		    ((UINT32_C(1) << tree->secondaryBits) - 1))];
 
-	while (iter->value == 0xFFFF) {
-		if OF_UNLIKELY (!bitReader(stream, &bits, 1)) {
-			*tree = iter;
-			return false;
-		}
+	if OF_UNLIKELY (((entry >> 16) & 0xFF) > bitsCount)
+		return false;
 
-		if OF_UNLIKELY (iter->leaves[bits] == NULL)
-			@throw [OFInvalidFormatException exception];
+	if OF_UNLIKELY (entry & OF_HUFFMAN_TREE_INVALID)
+		@throw [OFInvalidFormatException exception];
 
-		iter = iter->leaves[bits];
-	}
+	*value = entry & 0xFFFF;
+	*length = (entry >> 16) & 0xFF;
 
-	*value = iter->value;
 	return true;
 }
 
@@ -14,7 +14,6 @@
  * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
  * file.
  */
-
 #include "config.h"
 
 #include <stdint.h>
@@ -25,87 +24,128 @@
 #import "OFInvalidFormatException.h"
 #import "OFOutOfMemoryException.h"
 
-static struct of_huffman_tree *
-newTree(void)
+static OF_INLINE uint16_t
+reverseBits(uint16_t code, uint8_t length)
 {
-	struct of_huffman_tree *tree;
+	code = ((code >> 1) & 0x5555) | ((code & 0x5555) << 1);
+	code = ((code >> 2) & 0x3333) | ((code & 0x3333) << 2);
+	code = ((code >> 4) & 0x0F0F) | ((code & 0x0F0F) << 4);
+	code = (code >> 8) | (code << 8);
 
-	tree = of_alloc(1, sizeof(*tree));
-	tree->leaves[0] = tree->leaves[1] = NULL;
-	tree->value = 0xFFFF;
-
-	return tree;
+	return code >> (16 - length);
 }
 
-static void
-insertTree(struct of_huffman_tree *tree, uint16_t code, uint8_t length,
-    uint16_t value)
+struct of_huffman_tree *
+of_huffman_tree_construct(uint8_t lengths[], uint16_t count)
 {
-	while (length > 0) {
-		uint8_t bit;
+	struct of_huffman_tree *tree;
+	uint16_t lengthCount[OF_HUFFMAN_TREE_MAX_BITS + 1] = { 0 };
+	uint16_t nextCode[OF_HUFFMAN_TREE_MAX_BITS + 1];
+	uint_fast8_t maxBit = 0, primaryBits, secondaryBits;
+	uint32_t code, left, prefix, lastPrefix, secondaryCount;
+	uint32_t primarySize, secondarySize, secondaryIndex;
 
-		length--;
-		bit = (code & (1u << length)) >> length;
+	for (uint16_t i = 0; i < count; i++) {
+		if OF_UNLIKELY (lengths[i] > OF_HUFFMAN_TREE_MAX_BITS)
+			@throw [OFInvalidFormatException exception];
 
-		if (tree->leaves[bit] == NULL)
-			tree->leaves[bit] = newTree();
+		lengthCount[lengths[i]]++;
 
-		tree = tree->leaves[bit];
+		if (lengths[i] > maxBit)
+			maxBit = lengths[i];
 	}
 
-	tree->value = value;
-}
+	/* Reject over-subscribed codes. Incomplete ones are fine. */
+	left = 1;
+	for (uint_fast8_t i = 1; i <= maxBit; i++) {
+		left <<= 1;
 
-struct of_huffman_tree *
-of_huffman_tree_construct(uint8_t lengths[], uint16_t count)
-{
-	struct of_huffman_tree *tree;
-	uint16_t *lengthCount = NULL;
-	uint16_t code, maxCode = 0, *nextCode = NULL;
-	uint_fast8_t maxBit = 0;
-
-	@try {
-		for (uint16_t i = 0; i < count; i++) {
-			uint_fast8_t length = lengths[i];
-
-			if OF_UNLIKELY (length > maxBit) {
-				lengthCount = of_realloc(lengthCount,
-				    length + 1, sizeof(uint16_t));
-				nextCode = of_realloc(nextCode,
-				    length + 1, sizeof(uint16_t));
-
-				for (uint_fast8_t j = maxBit + 1; j <= length;
-				    j++) {
-					lengthCount[j] = 0;
-					nextCode[j] = 0;
-				}
-
-				maxBit = length;
-			}
+		if OF_UNLIKELY (lengthCount[i] > left)
+			@throw [OFInvalidFormatException exception];
 
-			if (length > 0) {
-				lengthCount[length]++;
-				maxCode = i;
-			}
-		}
+		left -= lengthCount[i];
+	}
 
-		code = 0;
-		for (size_t i = 1; i <= maxBit; i++) {
-			code = (code + lengthCount[i - 1]) << 1;
-			nextCode[i] = code;
-		}
+	code = 0;
+	lengthCount[0] = 0;
+	for (uint_fast8_t i = 1; i <= maxBit; i++) {
+		code = (code + lengthCount[i - 1]) << 1;
+		nextCode[i] = code;
+	}
 
-		tree = newTree();
+	primaryBits = (maxBit < OF_HUFFMAN_TREE_PRIMARY_BITS
+	    ? maxBit : OF_HUFFMAN_TREE_PRIMARY_BITS);
+	secondaryBits = maxBit - primaryBits;
+	primarySize = UINT32_C(1) << primaryBits;
+	secondarySize = UINT32_C(1) << secondaryBits;
+
+	/*
+	 * Codes are assigned in increasing order, so all codes sharing a
+	 * primary prefix are consecutive, which makes counting the secondary
+	 * tables easy.
+	 */
+	secondaryCount = 0;
+	lastPrefix = UINT32_MAX;
+	code = 0;
+	for (uint_fast8_t i = primaryBits + 1; i <= maxBit; i++) {
+		uint32_t first = nextCode[i], last = first + lengthCount[i];
+
+		for (code = first; code < last; code++) {
+			prefix = code >> (i - primaryBits);
+
+			if (prefix != lastPrefix) {
+				secondaryCount++;
+				lastPrefix = prefix;
+			}
+		}
+	}
 
-		for (uint16_t i = 0; i <= maxCode; i++) {
-			uint8_t length = lengths[i];
+	tree = of_alloc(1, sizeof(*tree) + (primarySize +
+	    secondaryCount * secondarySize) * sizeof(uint32_t));
+	tree->primaryBits = primaryBits;
+	tree->secondaryBits = secondaryBits;
+
+	for (uint32_t i = 0; i < primarySize; i++)
+		tree->entries[i] = OF_HUFFMAN_TREE_INVALID |
+		    ((uint32_t)primaryBits << 16);
+	for (uint32_t i = primarySize;
+	    i < primarySize + secondaryCount * secondarySize; i++)
+		tree->entries[i] = OF_HUFFMAN_TREE_INVALID |
+		    ((uint32_t)maxBit << 16);
+
+	secondaryIndex = primarySize;
+	for (uint16_t i = 0; i < count; i++) {
+		uint_fast8_t length = lengths[i];
+		uint32_t reversed, entry, *table;
+		uint_fast8_t tableBits;
+
+		if (length == 0)
+			continue;
+
+		reversed = reverseBits(nextCode[length]++, length);
+		entry = i | ((uint32_t)length << 16);
+
+		if (length <= primaryBits) {
+			table = tree->entries;
+			tableBits = primaryBits;
+		} else {
+			uint32_t *link = &tree->entries[reversed &
+			    (primarySize - 1)];
+
+			if (!(*link & OF_HUFFMAN_TREE_LINK)) {
+				*link = OF_HUFFMAN_TREE_LINK | secondaryIndex;
+				secondaryIndex += secondarySize;
+			}
 
-			if (length > 0)
-				insertTree(tree, nextCode[length]++, length, i);
+			table = tree->entries + (*link & 0xFFFF);
+			tableBits = secondaryBits;
+			reversed >>= primaryBits;
+			length -= primaryBits;
 		}
-	} @finally {
-		free(lengthCount);
-		free(nextCode);
+
+		for (uint32_t j = reversed; j < (UINT32_C(1) << tableBits);
+		    j += UINT32_C(1) << length)
+			table[j] = entry;
 	}
 
 	return tree;
@@ -114,9 +154,11 @@ of_huffman_tree_construct(uint8_t lengths[], uint16_t count)
 struct of_huffman_tree *
 of_huffman_tree_construct_single(uint16_t value)
 {
-	struct of_huffman_tree *tree = newTree();
+	struct of_huffman_tree *tree;
 
-	tree->value = value;
+	tree = of_alloc(1, sizeof(*tree) + sizeof(uint32_t));
+	tree->primaryBits = tree->secondaryBits = 0;
+	tree->entries[0] = value;
 
 	return tree;
 }
@@ -124,9 +166,5 @@ of_huffman_tree_construct_single(uint16_t value)
 void
 of_huffman_tree_release(struct of_huffman_tree *tree)
 {
-	for (uint_fast8_t i = 0; i < 2; i++)
-		if OF_LIKELY (tree->leaves[i] != NULL)
-			of_huffman_tree_release(tree->leaves[i]);
-
 	free(tree);
 }
@@ -175,6 +175,82 @@ struct objc_super {
 #endif
 };
 
+/**
+ * @brief Statistics about the locks used by `@synchronized`.
+ */
+struct objc_sync_statistics {
+	/**
+	 * @brief The number of times a lock was acquired.
+	 */
+	unsigned long long enterCount;
+	/**
+	 * @brief The number of times a thread had to wait for a lock held by
+	 *	  another thread.
+	 */
+	unsigned long long contentionCount;
+	/**
+	 * @brief The number of objects which are currently locked.
+	 */
+	unsigned long activeLocks;
+};
+
+/**
+ * @brief Statistics about the autorelease pools of a thread.
+ */
+struct objc_autorelease_pool_statistics {
+	/**
+	 * @brief The number of objects which are currently in autorelease
+	 *	  pools.
+	 */
+	uintptr_t count;
+	/**
+	 * @brief The highest number of objects which were in autorelease pools
+	 *	  at the same time.
+	 */
+	uintptr_t highWaterMark;
+	/**
+	 * @brief The number of times a pool was popped.
+	 */
+	unsigned long long popCount;
+	/**
+	 * @brief The number of objects which were released by popping pools.
+	 */
+	unsigned long long releaseCount;
+	/**
+	 * @brief The highest number of objects released by popping a single
+	 *	  pool.
+	 */
+	uintptr_t maxPoolCount;
+	/**
+	 * @brief The number of pages allocated for autoreleased objects,
+	 *	  including cached pages.
+	 */
+	unsigned long numPages;
+};
+
+/**
+ * @brief Statistics about the method cache of a class.
+ */
+struct objc_method_cache_statistics {
+	/**
+	 * @brief The number of entries in the method cache.
+	 */
+	unsigned int size;
+	/**
+	 * @brief The number of entries which are in use.
+	 */
+	unsigned int usedCount;
+	/**
+	 * @brief The number of times an entry was filled or cleared.
+	 *
+	 * A lookup that is not answered by the method cache fills the entry of
+	 * its selector, replacing the selector that was cached there before.
+	 * Lookups that find no method or that race with another thread filling
+	 * the same entry are not counted.
+	 */
+	unsigned long fillCount;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -648,6 +724,43 @@ extern uintptr_t object_getTaggedPointerValue(id _Nonnull object);
  */
 extern id _Nullable objc_createTaggedPointer(int class, uintptr_t value);
 
+/**
+ * @brief Returns statistics about the locks used by `@synchronized`.
+ *
+ * The counters are accumulated since the runtime was initialized and can be
+ * used to find contended locks.
+ *
+ * @param statistics A pointer to a struct objc_sync_statistics to fill
+ */
+extern void objc_sync_getStatistics(
+    struct objc_sync_statistics *_Nonnull statistics);
+
+/**
+ * @brief Returns statistics about the autorelease pools of the current thread.
+ *
+ * The counters are accumulated since the thread started. A high water mark or
+ * a high number of objects released by a single pool hints at a loop that
+ * autoreleases objects without a pool of its own.
+ *
+ * @param statistics A pointer to a struct objc_autorelease_pool_statistics to
+ *		     fill
+ */
+extern void objc_autoreleasePoolGetStatistics(
+    struct objc_autorelease_pool_statistics *_Nonnull statistics);
+
+/**
+ * @brief Returns statistics about the method cache of the specified class.
+ *
+ * Each class has a small method cache that is checked before the dispatch
+ * table. Lookups that hit the cache are not counted, so the miss rate needs
+ * to be calculated from the fill count and a known number of lookups.
+ *
+ * @param class_ The class whose method cache statistics should be returned
+ * @param statistics A pointer to a struct objc_method_cache_statistics to fill
+ */
+extern void class_getMethodCacheStatistics(Class _Nullable class_,
+    struct objc_method_cache_statistics *_Nonnull statistics);
+
 /*
  * Used by the compiler, but can also be called manually.
  *
@@ -840,3 +840,31 @@ glue_objc_createTaggedPointer PPC_PARAMS(int class, uintptr_t value)
 
 	return objc_createTaggedPointer(class, value);
 }
+
+void __saveds
+glue_objc_sync_getStatistics PPC_PARAMS(
+    struct objc_sync_statistics *statistics)
+{
+	M68K_ARG(struct objc_sync_statistics *, statistics, a0)
+
+	objc_sync_getStatistics(statistics);
+}
+
+void __saveds
+glue_objc_autoreleasePoolGetStatistics PPC_PARAMS(
+    struct objc_autorelease_pool_statistics *statistics)
+{
+	M68K_ARG(struct objc_autorelease_pool_statistics *, statistics, a0)
+
+	objc_autoreleasePoolGetStatistics(statistics);
+}
+
+void __saveds
+glue_class_getMethodCacheStatistics PPC_PARAMS(Class class,
+    struct objc_method_cache_statistics *statistics)
+{
+	M68K_ARG(Class, class, a0)
+	M68K_ARG(struct objc_method_cache_statistics *, statistics, a1)
+
+	class_getMethodCacheStatistics(class, statistics);
+}
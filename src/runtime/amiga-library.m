@@ -152,6 +152,9 @@ extern int glue_objc_registerTaggedPointerClass(void);
 extern bool glue_object_isTaggedPointer(void);
 extern uintptr_t glue_object_getTaggedPointerValue(void);
 extern id glue_objc_createTaggedPointer(void);
+extern void glue_objc_sync_getStatistics(void);
+extern void glue_objc_autoreleasePoolGetStatistics(void);
+extern void glue_class_getMethodCacheStatistics(void);
 
 #ifdef OF_MORPHOS
 const ULONG __abox__ = 1;
@@ -706,6 +709,9 @@ static CONST_APTR functionTable[] = {
 	(CONST_APTR)glue_object_isTaggedPointer,
 	(CONST_APTR)glue_object_getTaggedPointerValue,
 	(CONST_APTR)glue_objc_createTaggedPointer,
+	(CONST_APTR)glue_objc_sync_getStatistics,
+	(CONST_APTR)glue_objc_autoreleasePoolGetStatistics,
+	(CONST_APTR)glue_class_getMethodCacheStatistics,
 	(CONST_APTR)-1,
 #ifdef OF_MORPHOS
 	(CONST_APTR)FUNCARRAY_END
@@ -14,7 +14,6 @@
  * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
  * file.
  */
-
 #include "config.h"
 
 #include <stdio.h>
@@ -38,44 +37,136 @@
 @end
 #endif
 
+/*
+ * The autoreleased objects of a thread are stored in a chain of fixed-size
+ * pages. A pool is the total number of objects that were in the pools of the
+ * thread when it was pushed. Popping a pool releases all objects that were
+ * added since and moves the pages that became empty into a small per-thread
+ * cache, freeing the rest, so that a single pool with many objects does not
+ * keep its memory around for the lifetime of the thread.
+ */
+#define PAGE_SIZE_BYTES 4096
+#define OBJECTS_PER_PAGE \
+	((PAGE_SIZE_BYTES - 3 * sizeof(void *)) / sizeof(id))
+#define MAX_CACHED_PAGES 4
+
+struct autorelease_page {
+	struct autorelease_page *previous, *next;
+	uintptr_t base;
+	id objects[OBJECTS_PER_PAGE];
+};
+
+struct autorelease_state {
+	struct autorelease_page *top, *cache;
+	uintptr_t count;
+	unsigned long numPages, numCachedPages;
+	uintptr_t highWaterMark, maxPoolCount;
+	unsigned long long popCount, releaseCount;
+};
+
 #if defined(OF_HAVE_COMPILER_TLS)
-static thread_local id *objects = NULL;
-static thread_local uintptr_t count = 0;
-static thread_local uintptr_t size = 0;
+static thread_local struct autorelease_state threadState;
 #elif defined(OF_HAVE_THREADS)
-static of_tlskey_t objectsKey, countKey, sizeKey;
+static of_tlskey_t stateKey;
 #else
-static id *objects = NULL;
-static uintptr_t count = 0;
-static uintptr_t size = 0;
+static struct autorelease_state threadState;
 #endif
 
 #if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
 OF_CONSTRUCTOR()
 {
-	OF_ENSURE(of_tlskey_new(&objectsKey));
-	OF_ENSURE(of_tlskey_new(&countKey));
-	OF_ENSURE(of_tlskey_new(&sizeKey));
+	OF_ENSURE(of_tlskey_new(&stateKey));
 }
 #endif
 
-void *
-objc_autoreleasePoolPush()
+static OF_INLINE struct autorelease_state *
+currentState(void)
 {
 #if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-	uintptr_t count = (uintptr_t)of_tlskey_get(countKey);
+	struct autorelease_state *state = of_tlskey_get(stateKey);
+
+	if OF_UNLIKELY (state == NULL) {
+		OF_ENSURE((state = calloc(1, sizeof(*state))) != NULL);
+		OF_ENSURE(of_tlskey_set(stateKey, state));
+	}
+
+	return state;
+#else
+	return &threadState;
 #endif
-	return (void *)count;
+}
+
+static struct autorelease_page *
+addPage(struct autorelease_state *state)
+{
+	struct autorelease_page *page;
+
+	if (state->cache != NULL) {
+		page = state->cache;
+		state->cache = page->previous;
+		state->numCachedPages--;
+	} else {
+		OF_ENSURE((page = malloc(sizeof(*page))) != NULL);
+		state->numPages++;
+	}
+
+	page->previous = state->top;
+	page->next = NULL;
+	page->base = state->count;
+
+	if (state->top != NULL)
+		state->top->next = page;
+
+	state->top = page;
+
+	return page;
+}
+
+static void
+removePages(struct autorelease_state *state, uintptr_t count, bool freeMem)
+{
+	while (state->top != NULL && state->top->base >= count) {
+		struct autorelease_page *page = state->top;
+
+		state->top = page->previous;
+
+		if (!freeMem && state->numCachedPages < MAX_CACHED_PAGES) {
+			page->previous = state->cache;
+			state->cache = page;
+			state->numCachedPages++;
+		} else {
+			free(page);
+			state->numPages--;
+		}
+	}
+
+	if (state->top != NULL)
+		state->top->next = NULL;
+
+	if (freeMem) {
+		while (state->cache != NULL) {
+			struct autorelease_page *page = state->cache;
+
+			state->cache = page->previous;
+			free(page);
+		}
+
+		state->numPages = state->numCachedPages = 0;
+	}
+}
+
+void *
+objc_autoreleasePoolPush()
+{
+	return (void *)currentState()->count;
 }
 
 void
 objc_autoreleasePoolPop(void *pool)
 {
-#if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-	id *objects = of_tlskey_get(objectsKey);
-	uintptr_t count = (uintptr_t)of_tlskey_get(countKey);
-#endif
-	uintptr_t idx = (uintptr_t)pool;
+	struct autorelease_state *state = currentState();
+	struct autorelease_page *page = state->top;
+	uintptr_t idx = (uintptr_t)pool, released = 0;
 	bool freeMem = false;
 
 	if (idx == (uintptr_t)-1) {
@@ -83,62 +174,70 @@ objc_autoreleasePoolPop(void *pool)
 		freeMem = true;
 	}
 
-	for (uintptr_t i = idx; i < count; i++) {
-		[objects[i] release];
+	if (state->count > state->highWaterMark)
+		state->highWaterMark = state->count;
 
-#if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-		objects = of_tlskey_get(objectsKey);
-		count = (uintptr_t)of_tlskey_get(countKey);
-#endif
-	}
+	while (page != NULL && page->base > idx)
+		page = page->previous;
 
-	count = idx;
+	/*
+	 * Releasing an object can autorelease more objects or push and pop
+	 * pools, so the count needs to be checked again after each release.
+	 * The pages themselves never move, and pages at or below the current
+	 * one are never removed by a nested pool.
+	 */
+	for (uintptr_t i = idx; i < state->count; i++) {
+		if (i - page->base == OBJECTS_PER_PAGE)
+			page = page->next;
 
-	if (freeMem) {
-		free(objects);
-		objects = NULL;
-#if defined(OF_HAVE_COMPILER_TLS) || !defined(OF_HAVE_THREADS)
-		size = 0;
-#else
-		OF_ENSURE(of_tlskey_set(objectsKey, objects));
-		OF_ENSURE(of_tlskey_set(sizeKey, (void *)0));
-#endif
+		[page->objects[i - page->base] release];
+		released++;
 	}
 
+	state->count = idx;
+	state->popCount++;
+	state->releaseCount += released;
+	if (released > state->maxPoolCount)
+		state->maxPoolCount = released;
+
+	removePages(state, idx, freeMem);
+
 #if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-	OF_ENSURE(of_tlskey_set(countKey, (void *)count));
+	if (freeMem) {
+		free(state);
+		OF_ENSURE(of_tlskey_set(stateKey, NULL));
+	}
 #endif
 }
 
 id
 _objc_rootAutorelease(id object)
 {
-#if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-	id *objects = of_tlskey_get(objectsKey);
-	uintptr_t count = (uintptr_t)of_tlskey_get(countKey);
-	uintptr_t size = (uintptr_t)of_tlskey_get(sizeKey);
-#endif
-
-	if (count >= size) {
-		if (size == 0)
-			size = 16;
-		else
-			size *= 2;
+	struct autorelease_state *state = currentState();
+	struct autorelease_page *page = state->top;
 
-		OF_ENSURE((objects =
-		    realloc(objects, size * sizeof(id))) != NULL);
-
-#if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-		OF_ENSURE(of_tlskey_set(objectsKey, objects));
-		OF_ENSURE(of_tlskey_set(sizeKey, (void *)size));
-#endif
-	}
+	if OF_UNLIKELY (page == NULL ||
+	    state->count - page->base == OBJECTS_PER_PAGE)
+		page = addPage(state);
 
-	objects[count++] = object;
-
-#if !defined(OF_HAVE_COMPILER_TLS) && defined(OF_HAVE_THREADS)
-	OF_ENSURE(of_tlskey_set(countKey, (void *)count));
-#endif
+	page->objects[state->count++ - page->base] = object;
 
 	return object;
 }
+
+#ifdef OF_OBJFW_RUNTIME
+void
+objc_autoreleasePoolGetStatistics(
+    struct objc_autorelease_pool_statistics *statistics)
+{
+	struct autorelease_state *state = currentState();
+
+	statistics->count = state->count;
+	statistics->highWaterMark = (state->count > state->highWaterMark
+	    ? state->count : state->highWaterMark);
+	statistics->popCount = state->popCount;
+	statistics->releaseCount = state->releaseCount;
+	statistics->maxPoolCount = state->maxPoolCount;
+	statistics->numPages = state->numPages;
+}
+#endif
@@ -674,6 +674,26 @@ class_getInstanceSize(Class class)
 	return class->instanceSize;
 }
 
+void
+class_getMethodCacheStatistics(Class class,
+    struct objc_method_cache_statistics *statistics)
+{
+	statistics->size = OBJC_DTABLE_CACHE_SIZE;
+	statistics->usedCount = 0;
+	statistics->fillCount = 0;
+
+	if (class == Nil || class->DTable == NULL)
+		return;
+
+	/* Each fill advances the sequence of its entry by two. */
+	for (unsigned int i = 0; i < OBJC_DTABLE_CACHE_SIZE; i++) {
+		if (class->DTable->cache[i].UID != OBJC_DTABLE_CACHE_EMPTY)
+			statistics->usedCount++;
+
+		statistics->fillCount += class->DTable->cache[i].sequence / 2;
+	}
+}
+
 IMP
 class_getMethodImplementation(Class class, SEL selector)
 {
@@ -23,6 +23,10 @@
 #import "ObjFWRT.h"
 #import "private.h"
 
+#ifdef OF_HAVE_ATOMIC_OPS
+# import "atomic.h"
+#endif
+
 static struct objc_dtable_level2 *emptyLevel2 = NULL;
 #ifdef OF_SELUID24
 static struct objc_dtable_level3 *emptyLevel3 = NULL;
@@ -69,6 +73,12 @@ objc_dtable_new(void)
 	for (uint_fast16_t i = 0; i < 256; i++)
 		DTable->buckets[i] = emptyLevel2;
 
+	for (uint_fast8_t i = 0; i < OBJC_DTABLE_CACHE_SIZE; i++) {
+		DTable->cache[i].UID = OBJC_DTABLE_CACHE_EMPTY;
+		DTable->cache[i].sequence = 0;
+		DTable->cache[i].implementation = (IMP)0;
+	}
+
 	return DTable;
 }
 
@@ -114,6 +124,42 @@ objc_dtable_copy(struct objc_dtable *dest, struct objc_dtable *src)
 	}
 }
 
+#ifdef OF_HAVE_ATOMIC_OPS
+/*
+ * Makes the sequence of the entry odd and clears its UID, unless another
+ * thread is changing the entry or changed it since sequence was read. The
+ * entry is released again by storing sequence + 2.
+ */
+static bool
+claimCacheEntry(struct objc_dtable_cache_entry *entry, uint32_t sequence)
+{
+	if (sequence & 1 || !of_atomic_int32_cmpswap(
+	    (volatile int32_t *)&entry->sequence, (int32_t)sequence,
+	    (int32_t)(sequence + 1)))
+		return false;
+
+	of_memory_barrier_release();
+	entry->UID = OBJC_DTABLE_CACHE_EMPTY;
+	of_memory_barrier_release();
+
+	return true;
+}
+
+static void
+clearCacheEntry(struct objc_dtable_cache_entry *entry, uint32_t idx)
+{
+	uint32_t sequence = entry->sequence;
+
+	of_memory_barrier_acquire();
+
+	/* If the UID changes, so does the sequence and claiming fails. */
+	if (entry->UID != idx || !claimCacheEntry(entry, sequence))
+		return;
+
+	entry->sequence = sequence + 2;
+}
+#endif
+
 void
 objc_dtable_set(struct objc_dtable *DTable, uint32_t idx, IMP implementation)
 {
@@ -159,6 +205,47 @@ objc_dtable_set(struct objc_dtable *DTable, uint32_t idx, IMP implementation)
 #else
 	DTable->buckets[i]->buckets[j] = implementation;
 #endif
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	/*
+	 * A cache fill in progress checks the dtable again after filling the
+	 * entry. Either it sees the new implementation or the entry is seen
+	 * here.
+	 */
+	of_memory_barrier();
+	clearCacheEntry(&DTable->cache[idx % OBJC_DTABLE_CACHE_SIZE], idx);
+#endif
+}
+
+IMP
+objc_dtable_fill_cache(struct objc_dtable *DTable, uint32_t idx,
+    IMP implementation)
+{
+#ifdef OF_HAVE_ATOMIC_OPS
+	struct objc_dtable_cache_entry *entry =
+	    &DTable->cache[idx % OBJC_DTABLE_CACHE_SIZE];
+	uint32_t sequence = entry->sequence;
+
+	/* If another thread is changing the entry, just don't cache. */
+	if (!claimCacheEntry(entry, sequence))
+		return implementation;
+
+	entry->implementation = implementation;
+	of_memory_barrier_release();
+	entry->UID = idx;
+	of_memory_barrier_release();
+	entry->sequence = sequence + 2;
+
+	/*
+	 * The implementation might have been replaced since it was looked up.
+	 * See objc_dtable_set().
+	 */
+	of_memory_barrier();
+	if OF_UNLIKELY (objc_dtable_get(DTable, idx) != implementation)
+		clearCacheEntry(entry, idx);
+#endif
+
+	return implementation;
 }
 
 void
@@ -757,3 +757,23 @@ objc_createTaggedPointer(int class, uintptr_t value)
 {
 	return glue_objc_createTaggedPointer(class, value);
 }
+
+void
+objc_sync_getStatistics(struct objc_sync_statistics *statistics)
+{
+	glue_objc_sync_getStatistics(statistics);
+}
+
+void
+objc_autoreleasePoolGetStatistics(
+    struct objc_autorelease_pool_statistics *statistics)
+{
+	glue_objc_autoreleasePoolGetStatistics(statistics);
+}
+
+void
+class_getMethodCacheStatistics(Class class,
+    struct objc_method_cache_statistics *statistics)
+{
+	glue_class_getMethodCacheStatistics(class, statistics);
+}
@@ -23,6 +23,9 @@
 #import "ObjFWRT.h"
 #import "private.h"
 #import "macros.h"
+#if !defined(OF_ASM_LOOKUP) && defined(OF_HAVE_ATOMIC_OPS)
+# import "atomic.h"
+#endif
 
 static IMP forwardHandler = (IMP)0;
 static IMP stretForwardHandler = (IMP)0;
@@ -136,6 +139,34 @@ nilMethod(id self, SEL _cmd)
 	return nil;
 }
 
+static OF_INLINE IMP
+cachedLookup(struct objc_dtable *DTable, uint32_t idx)
+{
+	struct objc_dtable_cache_entry *entry =
+	    &DTable->cache[idx % OBJC_DTABLE_CACHE_SIZE];
+	uint32_t sequence = entry->sequence;
+	IMP imp;
+
+#ifdef OF_HAVE_ATOMIC_OPS
+	of_memory_barrier_acquire();
+#endif
+
+	if OF_LIKELY (!(sequence & 1) && entry->UID == idx) {
+		imp = entry->implementation;
+#ifdef OF_HAVE_ATOMIC_OPS
+		of_memory_barrier_acquire();
+#endif
+
+		if OF_LIKELY (entry->sequence == sequence)
+			return imp;
+	}
+
+	if ((imp = objc_dtable_get(DTable, idx)) == (IMP)0)
+		return (IMP)0;
+
+	return objc_dtable_fill_cache(DTable, idx, imp);
+}
+
 static OF_INLINE IMP
 commonLookup(id object, SEL selector, IMP (*notFound)(id, SEL))
 {
@@ -144,7 +175,7 @@ commonLookup(id object, SEL selector, IMP (*notFound)(id, SEL))
 	if (object == nil)
 		return (IMP)nilMethod;
 
-	imp = objc_dtable_get(object_getClass(object)->DTable,
+	imp = cachedLookup(object_getClass(object)->DTable,
 	    (uint32_t)selector->UID);
 
 	if (imp == (IMP)0)
@@ -174,7 +205,7 @@ commonSuperLookup(struct objc_super *super, SEL selector,
 	if (super->self == nil)
 		return (IMP)nilMethod;
 
-	imp = objc_dtable_get(super->class->DTable, (uint32_t)selector->UID);
+	imp = cachedLookup(super->class->DTable, (uint32_t)selector->UID);
 
 	if (imp == (IMP)0)
 		return notFound(super->self, selector);
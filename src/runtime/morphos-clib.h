@@ -90,3 +90,6 @@ int glue_objc_registerTaggedPointerClass(Class);
 bool glue_object_isTaggedPointer(id);
 uintptr_t glue_object_getTaggedPointerValue(id);
 id glue_objc_createTaggedPointer(int, uintptr_t);
+void glue_objc_sync_getStatistics(struct objc_sync_statistics *);
+void glue_objc_autoreleasePoolGetStatistics(struct objc_autorelease_pool_statistics *);
+void glue_class_getMethodCacheStatistics(Class, struct objc_method_cache_statistics *);
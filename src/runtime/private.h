@@ -206,6 +206,17 @@ struct objc_sparsearray {
 	uint8_t indexSize;
 };
 
+/*
+ * The cache is direct-mapped by selector UID and a new selector replaces the
+ * one in its entry. Writers make the sequence odd while they change an entry
+ * and clear the UID before they change the implementation, so that it can be
+ * read without locking: A reader checks that the UID matches and that the UID
+ * and the sequence did not change while it read the implementation. The
+ * lookup assembly depends on its offset and layout.
+ */
+#define OBJC_DTABLE_CACHE_SIZE 64
+#define OBJC_DTABLE_CACHE_EMPTY UINT32_MAX
+
 struct objc_dtable {
 	struct objc_dtable_level2 {
 #ifdef OF_SELUID24
@@ -216,6 +227,11 @@ struct objc_dtable {
 		IMP _Nullable buckets[256];
 #endif
 	} *_Nonnull buckets[256];
+	struct objc_dtable_cache_entry {
+		volatile uint32_t UID;
+		volatile uint32_t sequence;
+		IMP _Nullable volatile implementation;
+	} cache[OBJC_DTABLE_CACHE_SIZE];
 };
 
 #if defined(OBJC_COMPILING_AMIGA_LIBRARY) || \
@@ -315,6 +331,8 @@ extern void objc_dtable_copy(struct objc_dtable *_Nonnull,
 extern void objc_dtable_set(struct objc_dtable *_Nonnull, uint32_t,
     IMP _Nullable);
 extern void objc_dtable_free(struct objc_dtable *_Nonnull);
+extern IMP _Nonnull objc_dtable_fill_cache(struct objc_dtable *_Nonnull,
+    uint32_t, IMP _Nonnull);
 extern void objc_dtable_cleanup(void);
 extern void objc_init_static_instances(struct objc_symtab *_Nonnull);
 extern void objc_forget_pending_static_instances(void);
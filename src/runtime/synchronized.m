@@ -26,19 +26,45 @@
 #ifdef OF_HAVE_THREADS
 # import "mutex.h"
 
-static struct lock_s {
+/*
+ * Locks are spread over a fixed number of buckets by the address of the
+ * object, each bucket with its own mutex, so that @synchronized on unrelated
+ * objects does not contend on a single global mutex.
+ */
+# define NUM_BUCKETS 64
+# define MAX_FREE_LOCKS 8
+
+struct lock_s {
 	id	      object;
 	int	      count;
 	of_rmutex_t   rmutex;
 	struct lock_s *next;
-} *locks = NULL;
+};
 
-static of_mutex_t mutex;
+static struct bucket_s {
+	of_mutex_t	   mutex;
+	struct lock_s	   *locks, *freeLocks;
+	unsigned int	   numFreeLocks;
+	unsigned long	   activeLocks;
+	unsigned long long enterCount, contentionCount;
+} buckets[NUM_BUCKETS];
 
 OF_CONSTRUCTOR()
 {
-	if (!of_mutex_new(&mutex))
-		OBJC_ERROR("Failed to create mutex!")
+	for (size_t i = 0; i < NUM_BUCKETS; i++)
+		if (!of_mutex_new(&buckets[i].mutex))
+			OBJC_ERROR("Failed to create mutex!")
+}
+
+static OF_INLINE struct bucket_s *
+bucketForObject(id object)
+{
+	uintptr_t hash = (uintptr_t)object;
+
+	/* The lower bits are always zero due to alignment. */
+	hash = (hash >> 4) ^ (hash >> 10);
+
+	return &buckets[hash & (NUM_BUCKETS - 1)];
 }
 #endif
 
@@ -49,44 +75,57 @@ objc_sync_enter(id object)
 		return 0;
 
 #ifdef OF_HAVE_THREADS
+	struct bucket_s *bucket = bucketForObject(object);
 	struct lock_s *lock;
+	bool contended;
 
-	if (!of_mutex_lock(&mutex))
+	if (!of_mutex_lock(&bucket->mutex))
 		OBJC_ERROR("Failed to lock mutex!");
 
 	/* Look if we already have a lock */
-	for (lock = locks; lock != NULL; lock = lock->next) {
-		if (lock->object != object)
-			continue;
-
-		lock->count++;
-
-		if (!of_mutex_unlock(&mutex))
-			OBJC_ERROR("Failed to unlock mutex!");
+	for (lock = bucket->locks; lock != NULL; lock = lock->next)
+		if (lock->object == object)
+			break;
+
+	if (lock == NULL) {
+		/* Reuse a lock or create a new one */
+		if (bucket->freeLocks != NULL) {
+			lock = bucket->freeLocks;
+			bucket->freeLocks = lock->next;
+			bucket->numFreeLocks--;
+		} else {
+			if ((lock = malloc(sizeof(*lock))) == NULL)
+				OBJC_ERROR("Failed to allocate memory for "
+				    "mutex!");
+
+			if (!of_rmutex_new(&lock->rmutex))
+				OBJC_ERROR("Failed to create mutex!");
+		}
 
-		if (!of_rmutex_lock(&lock->rmutex))
-			OBJC_ERROR("Failed to lock mutex!");
+		lock->object = object;
+		lock->count = 0;
+		lock->next = bucket->locks;
 
-		return 0;
+		bucket->locks = lock;
+		bucket->activeLocks++;
 	}
 
-	/* Create a new lock */
-	if ((lock = malloc(sizeof(*lock))) == NULL)
-		OBJC_ERROR("Failed to allocate memory for mutex!");
+	lock->count++;
 
-	if (!of_rmutex_new(&lock->rmutex))
-		OBJC_ERROR("Failed to create mutex!");
+	/*
+	 * Only try to lock while holding the bucket's mutex, as blocking here
+	 * would block all other objects in the same bucket.
+	 */
+	contended = !of_rmutex_trylock(&lock->rmutex);
 
-	lock->object = object;
-	lock->count = 1;
-	lock->next = locks;
+	bucket->enterCount++;
+	if (contended)
+		bucket->contentionCount++;
 
-	locks = lock;
-
-	if (!of_mutex_unlock(&mutex))
+	if (!of_mutex_unlock(&bucket->mutex))
 		OBJC_ERROR("Failed to unlock mutex!");
 
-	if (!of_rmutex_lock(&lock->rmutex))
+	if (contended && !of_rmutex_lock(&lock->rmutex))
 		OBJC_ERROR("Failed to lock mutex!");
 #endif
 
@@ -100,12 +139,13 @@ objc_sync_exit(id object)
 		return 0;
 
 #ifdef OF_HAVE_THREADS
+	struct bucket_s *bucket = bucketForObject(object);
 	struct lock_s *lock, *last = NULL;
 
-	if (!of_mutex_lock(&mutex))
+	if (!of_mutex_lock(&bucket->mutex))
 		OBJC_ERROR("Failed to lock mutex!");
 
-	for (lock = locks; lock != NULL; lock = lock->next) {
+	for (lock = bucket->locks; lock != NULL; lock = lock->next) {
 		if (lock->object != object) {
 			last = lock;
 			continue;
@@ -115,18 +155,27 @@ objc_sync_exit(id object)
 			OBJC_ERROR("Failed to unlock mutex!");
 
 		if (--lock->count == 0) {
-			if (!of_rmutex_free(&lock->rmutex))
-				OBJC_ERROR("Failed to destroy mutex!");
-
 			if (last != NULL)
 				last->next = lock->next;
-			if (locks == lock)
-				locks = lock->next;
-
-			free(lock);
+			if (bucket->locks == lock)
+				bucket->locks = lock->next;
+
+			bucket->activeLocks--;
+
+			if (bucket->numFreeLocks < MAX_FREE_LOCKS) {
+				lock->object = nil;
+				lock->next = bucket->freeLocks;
+				bucket->freeLocks = lock;
+				bucket->numFreeLocks++;
+			} else {
+				if (!of_rmutex_free(&lock->rmutex))
+					OBJC_ERROR("Failed to destroy mutex!");
+
+				free(lock);
+			}
 		}
 
-		if (!of_mutex_unlock(&mutex))
+		if (!of_mutex_unlock(&bucket->mutex))
 			OBJC_ERROR("Failed to unlock mutex!");
 
 		return 0;
@@ -137,3 +186,25 @@ objc_sync_exit(id object)
 	return 0;
 #endif
 }
+
+void
+objc_sync_getStatistics(struct objc_sync_statistics *statistics)
+{
+	statistics->enterCount = 0;
+	statistics->contentionCount = 0;
+	statistics->activeLocks = 0;
+
+#ifdef OF_HAVE_THREADS
+	for (size_t i = 0; i < NUM_BUCKETS; i++) {
+		if (!of_mutex_lock(&buckets[i].mutex))
+			OBJC_ERROR("Failed to lock mutex!");
+
+		statistics->enterCount += buckets[i].enterCount;
+		statistics->contentionCount += buckets[i].contentionCount;
+		statistics->activeLocks += buckets[i].activeLocks;
+
+		if (!of_mutex_unlock(&buckets[i].mutex))
+			OBJC_ERROR("Failed to unlock mutex!");
+	}
+#endif
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#ifndef __STDC_LIMIT_MACROS
+# define __STDC_LIMIT_MACROS
+#endif
+#ifndef __STDC_CONSTANT_MACROS
+# define __STDC_CONSTANT_MACROS
+#endif
+
+#import "macros.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @brief The random key used by @ref of_hash_bytes, initialized once at
+ *	  startup.
+ */
+extern uint64_t of_hash_key[2];
+
+/**
+ * @brief Hashes the specified bytes using SipHash-1-3.
+ *
+ * SipHash processes 8 bytes at a time and, with a secret key, makes it
+ * infeasible to construct collisions to attack hash tables.
+ *
+ * @param key The 128 bit key
+ * @param bytes The bytes to hash
+ * @param length The number of bytes
+ * @return The 64 bit hash
+ */
+extern uint64_t of_siphash13(const uint64_t key[_Nonnull 2],
+    const void *_Nullable bytes, size_t length);
+
+/**
+ * @brief Hashes the specified bytes using SipHash-1-3 and @ref of_hash_key.
+ *
+ * @param bytes The bytes to hash
+ * @param length The number of bytes
+ * @return The hash
+ */
+static OF_INLINE unsigned long
+of_hash_bytes(const void *_Nullable bytes, size_t length)
+{
+	return (unsigned long)of_siphash13(of_hash_key, bytes, length);
+}
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "siphash.h"
+
+#define ROUND								\
+	{								\
+		v0 += v1;						\
+		v1 = OF_ROL(v1, 13);					\
+		v1 ^= v0;						\
+		v0 = OF_ROL(v0, 32);					\
+		v2 += v3;						\
+		v3 = OF_ROL(v3, 16);					\
+		v3 ^= v2;						\
+		v0 += v3;						\
+		v3 = OF_ROL(v3, 21);					\
+		v3 ^= v0;						\
+		v2 += v1;						\
+		v1 = OF_ROL(v1, 17);					\
+		v1 ^= v2;						\
+		v2 = OF_ROL(v2, 32);					\
+	}
+
+uint64_t of_hash_key[2];
+
+uint64_t
+of_siphash13(const uint64_t key[2], const void *bytes_, size_t length)
+{
+	const unsigned char *bytes = bytes_;
+	uint64_t v0 = UINT64_C(0x736F6D6570736575) ^ key[0];
+	uint64_t v1 = UINT64_C(0x646F72616E646F6D) ^ key[1];
+	uint64_t v2 = UINT64_C(0x6C7967656E657261) ^ key[0];
+	uint64_t v3 = UINT64_C(0x7465646279746573) ^ key[1];
+	uint64_t last = (uint64_t)length << 56;
+
+	for (; length >= 8; bytes += 8, length -= 8) {
+		uint64_t word;
+
+		memcpy(&word, bytes, 8);
+		word = OF_BSWAP64_IF_BE(word);
+
+		v3 ^= word;
+		ROUND
+		v0 ^= word;
+	}
+
+	switch (length) {
+	case 7:
+		last |= (uint64_t)bytes[6] << 48;
+		/* intentional fall-through */
+	case 6:
+		last |= (uint64_t)bytes[5] << 40;
+		/* intentional fall-through */
+	case 5:
+		last |= (uint64_t)bytes[4] << 32;
+		/* intentional fall-through */
+	case 4:
+		last |= (uint64_t)bytes[3] << 24;
+		/* intentional fall-through */
+	case 3:
+		last |= (uint64_t)bytes[2] << 16;
+		/* intentional fall-through */
+	case 2:
+		last |= (uint64_t)bytes[1] << 8;
+		/* intentional fall-through */
+	case 1:
+		last |= (uint64_t)bytes[0];
+	}
+
+	v3 ^= last;
+	ROUND
+	v0 ^= last;
+
+	v2 ^= 0xFF;
+	ROUND
+	ROUND
+	ROUND
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
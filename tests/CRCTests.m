@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"CRC";
+
+/*
+ * The lengths of the parts the data is split into. They are chosen so that the
+ * parts do not line up with the 8, 16 and 64 byte blocks processed at once by
+ * the different implementations.
+ */
+static const size_t splits[] = { 1, 3, 7, 13, 63, 65, 129, 200, 519 };
+
+@implementation TestsAppDelegate (CRCTests)
+- (void)CRCTests
+{
+	unsigned char buffer[1000 + 8];
+	uint32_t CRC32;
+	uint16_t CRC16;
+	bool ok;
+
+	TEST(@"CRC-32 of 123456789",
+	    ~of_crc32(~0, "123456789", 9) == 0xCBF43926)
+
+	TEST(@"CRC-16 of 123456789", of_crc16(0, "123456789", 9) == 0xBB3D)
+
+	TEST(@"CRC-32 and CRC-16 of no data",
+	    of_crc32(0x12345678, "", 0) == 0x12345678 &&
+	    of_crc16(0x1234, "", 0) == 0x1234)
+
+	ok = true;
+	for (size_t offset = 0; offset < 8; offset++) {
+		unsigned char *data = buffer + offset;
+
+		for (size_t i = 0; i < 1000; i++)
+			data[i] = (unsigned char)(i * 31 + 7);
+
+		if (~of_crc32(~0, data, 1000) != 0x8902161E ||
+		    of_crc16(0, data, 1000) != 0x973D)
+			ok = false;
+	}
+	TEST(@"CRC-32 and CRC-16 of unaligned data", ok)
+
+	ok = true;
+	for (size_t offset = 0; offset < 8; offset++) {
+		unsigned char *data = buffer + offset;
+		size_t position = 0;
+
+		for (size_t i = 0; i < 1000; i++)
+			data[i] = (unsigned char)(i * 31 + 7);
+
+		CRC32 = ~0;
+		CRC16 = 0;
+		for (size_t i = 0; position < 1000; i++) {
+			size_t length = splits[i % (sizeof(splits) /
+			    sizeof(*splits))];
+
+			if (length > 1000 - position)
+				length = 1000 - position;
+
+			CRC32 = of_crc32(CRC32, data + position, length);
+			CRC16 = of_crc16(CRC16, data + position, length);
+			position += length;
+		}
+
+		if (~CRC32 != 0x8902161E || CRC16 != 0x973D)
+			ok = false;
+	}
+	TEST(@"Incremental CRC-32 and CRC-16 in unaligned parts", ok)
+}
+@end
@@ -17,9 +17,226 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #import "TestsAppDelegate.h"
 
+static OFString *module = @"OFDNSResolver";
+static size_t numExpectedResponses, numAnswers, numNameErrors;
+
+@interface TestsAppDelegate (DNSResolverTests) <OFDNSResolverQueryDelegate>
+@end
+
+/*
+ * A stand-in name server that answers the first query with an A record and
+ * all other queries with a name error.
+ */
+@interface DNSResolverTestsServer: OFObject <OFUDPSocketDelegate>
+{
+@public
+	OFUDPSocket *_socket;
+	uint16_t _port;
+	size_t _numQueries;
+	unsigned char _buffer[512];
+}
+@end
+
+@implementation DNSResolverTestsServer
+- (instancetype)init
+{
+	self = [super init];
+
+	@try {
+		_socket = [[OFUDPSocket alloc] init];
+		_port = [_socket bindToHost: @"127.0.0.1"
+				       port: 0];
+		_socket.delegate = self;
+		/* Leave room for the records appended to the query. */
+		[_socket asyncReceiveIntoBuffer: _buffer
+					 length: 256];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_socket cancelAsyncRequests];
+	[_socket release];
+
+	[super dealloc];
+}
+
+-	  (bool)socket: (OFDatagramSocket *)sock
+  didReceiveIntoBuffer: (void *)buffer
+		length: (size_t)length
+		sender: (const of_socket_address_t *)sender
+	     exception: (id)exception
+{
+	static const unsigned char answer[] = {
+		/* Pointer to the name in the question, A, IN, TTL 60 */
+		0xC0, 0x0C, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C,
+		/* 127.0.0.2 */
+		0x00, 0x04, 0x7F, 0x00, 0x00, 0x02
+	};
+	static const unsigned char authority[] = {
+		/* Pointer to the name in the question, SOA, IN, TTL 60 */
+		0xC0, 0x0C, 0x00, 0x06, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C,
+		/* Root as primary name server and responsible person */
+		0x00, 0x16, 0x00, 0x00,
+		/* Serial, refresh, retry, expiration, minimum TTL 30 */
+		0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x3C,
+		0x00, 0x00, 0x00, 0x3C, 0x00, 0x00, 0x00, 0x3C,
+		0x00, 0x00, 0x00, 0x1E
+	};
+	unsigned char *response = buffer;
+
+	if (exception != nil || length < 12)
+		return false;
+
+	/* QR, RD, RA and NOERROR or NXDOMAIN */
+	response[2] = 0x81;
+	response[3] = (_numQueries == 0 ? 0x80 : 0x83);
+	/* ANCOUNT, NSCOUNT and ARCOUNT */
+	memset(response + 6, 0, 6);
+
+	if (_numQueries == 0) {
+		response[7] = 1;
+		memcpy(response + length, answer, sizeof(answer));
+		length += sizeof(answer);
+	} else {
+		response[9] = 1;
+		memcpy(response + length, authority, sizeof(authority));
+		length += sizeof(authority);
+	}
+
+	_numQueries++;
+
+	[sock sendBuffer: response
+		  length: length
+		receiver: sender];
+
+	return true;
+}
+@end
+
 @implementation TestsAppDelegate (OFDNSResolverTests)
+-  (void)resolver: (OFDNSResolver *)resolver
+  didPerformQuery: (OFDNSQuery *)query
+	 response: (OFDNSResponse *)response
+	exception: (id)exception
+{
+	if ([exception isKindOfClass: [OFDNSQueryFailedException class]] &&
+	    [exception error] == OF_DNS_RESOLVER_ERROR_SERVER_NAME_ERROR)
+		numNameErrors++;
+	else if ([[response.answerRecords objectForKey: query.domainName]
+	    count] == 1)
+		numAnswers++;
+
+	if (--numExpectedResponses == 0)
+		[[OFRunLoop mainRunLoop] stop];
+}
+
+- (void)DNSResolverCacheTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	DNSResolverTestsServer *server =
+	    [[[DNSResolverTestsServer alloc] init] autorelease];
+	OFDNSResolver *resolver = [OFDNSResolver resolver];
+	OFDNSQuery *query, *hostQuery;
+
+	resolver.configReloadInterval = 0;
+	resolver.nameServers = [OFArray arrayWithObject: @"127.0.0.1"];
+	resolver.nameServerPort = server->_port;
+
+	query = hostQuery = [OFDNSQuery
+	    queryWithDomainName: @"host.objfw.test"
+		       DNSClass: OF_DNS_CLASS_IN
+		     recordType: OF_DNS_RECORD_TYPE_A];
+
+	numExpectedResponses = 3;
+	for (size_t i = 0; i < 3; i++)
+		[resolver asyncPerformQuery: query
+				   delegate: self];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"Coalescing of identical queries in flight",
+	    numExpectedResponses == 0 && numAnswers == 3 &&
+	    server->_numQueries == 1 && resolver.cacheHits == 0 &&
+	    resolver.cacheMisses == 3)
+
+	numExpectedResponses = 1;
+	[resolver asyncPerformQuery: query
+			   delegate: self];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"Answering queries from the cache",
+	    numExpectedResponses == 0 && numAnswers == 4 &&
+	    server->_numQueries == 1 && resolver.cacheHits == 1)
+
+	query = [OFDNSQuery queryWithDomainName: @"nonexistent.objfw.test"
+				       DNSClass: OF_DNS_CLASS_IN
+				     recordType: OF_DNS_RECORD_TYPE_A];
+
+	for (size_t i = 0; i < 2; i++) {
+		numExpectedResponses = 1;
+		[resolver asyncPerformQuery: query
+				   delegate: self];
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 2]];
+	}
+
+	TEST(@"Caching of name errors",
+	    numExpectedResponses == 0 && numNameErrors == 2 &&
+	    server->_numQueries == 2 && resolver.cacheHits == 2 &&
+	    resolver.cacheMisses == 4)
+
+	TEST(@"-[removeAllCachedResponses]",
+	    R([resolver removeAllCachedResponses]))
+
+	numExpectedResponses = 1;
+	[resolver asyncPerformQuery: query
+			   delegate: self];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"Querying again after removing cached responses",
+	    numExpectedResponses == 0 && numNameErrors == 3 &&
+	    server->_numQueries == 3 && resolver.cacheMisses == 5)
+
+	/*
+	 * The server only answers the first query, so the host is a cached
+	 * name error now as well. Use the other name error after it, so the
+	 * host is the least recently used, even though it expires later.
+	 */
+	for (size_t i = 0; i < 2; i++) {
+		numExpectedResponses = 1;
+		[resolver asyncPerformQuery: (i == 0 ? hostQuery : query)
+				   delegate: self];
+		[[OFRunLoop mainRunLoop] runUntilDate:
+		    [OFDate dateWithTimeIntervalSinceNow: 2]];
+	}
+
+	resolver.cacheSize = 1;
+
+	numExpectedResponses = 1;
+	[resolver asyncPerformQuery: hostQuery
+			   delegate: self];
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	TEST(@"Evicting the least recently used cached response",
+	    numExpectedResponses == 0 && numNameErrors == 6 &&
+	    server->_numQueries == 5 && resolver.cacheHits == 3)
+
+	objc_autoreleasePoolPop(pool);
+}
+
 - (void)DNSResolverTests
 {
 	void *pool = objc_autoreleasePoolPush();
@@ -69,5 +286,7 @@
 	    resolver.configReloadInterval];
 
 	objc_autoreleasePoolPop(pool);
+
+	[self DNSResolverCacheTests];
 }
 @end
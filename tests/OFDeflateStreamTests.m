@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFDeflateStream";
+
+static OFData *
+randomData(size_t length, uint32_t seed)
+{
+	OFMutableData *data = [OFMutableData dataWithCapacity: length];
+	uint32_t state = seed;
+
+	for (size_t i = 0; i < length; i++) {
+		unsigned char byte;
+
+		state = state * 1103515245 + 12345;
+		byte = state >> 24;
+
+		[data addItem: &byte];
+	}
+
+	[data makeImmutable];
+
+	return data;
+}
+
+static OFData *
+deflateData(OFData *data, unsigned int level, size_t chunkLength)
+{
+	TestsMemoryStream *stream = [[[TestsMemoryStream alloc] init]
+	    autorelease];
+	OFDeflateStream *deflateStream =
+	    [OFDeflateStream streamWithStream: stream
+					level: level];
+	const char *items = data.items;
+
+	for (size_t i = 0; i < data.count; i += chunkLength)
+		[deflateStream writeBuffer: items + i
+				    length: (data.count - i < chunkLength
+					    ? data.count - i : chunkLength)];
+
+	[deflateStream close];
+
+	return stream.data;
+}
+
+static OFData *
+inflateData(OFData *data)
+{
+	TestsMemoryStream *stream = [[[TestsMemoryStream alloc]
+	    initWithData: data] autorelease];
+
+	/* Make the decompressor refill its input many times. */
+	stream.maxReadLength = 777;
+
+	return [[OFInflateStream streamWithStream: stream]
+	    readDataUntilEndOfStream];
+}
+
+static uint8_t
+firstBlockType(OFData *data)
+{
+	return (*(const unsigned char *)data.items >> 1) & 3;
+}
+
+@implementation TestsAppDelegate (OFDeflateStreamTests)
+- (void)deflateStreamTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFData *text = textData(300000, 1);
+	OFData *random = randomData(70000, 1);
+	OFData *hello = [OFData dataWithItems: "Hello, Hello, Hello!"
+					count: 20];
+	OFMutableData *window;
+	OFData *compressed;
+	TestsMemoryStream *stream;
+	OFDeflateStream *deflateStream;
+	OFGZIPStream *GZIPStream;
+	OFZIPArchive *archive;
+	OFMutableZIPArchiveEntry *entry;
+	OFZIPArchiveEntry *readEntry;
+	OFStream *entryStream;
+	const unsigned char *items;
+	uint32_t CRC32;
+	size_t offset;
+	bool ok;
+
+	ok = true;
+	for (size_t i = 0; i < 4; i++) {
+		static const unsigned int levels[] = { 0, 1, 6, 9 };
+		unsigned int level = levels[i];
+
+		compressed = deflateData(text, level, 1000);
+
+		if (![inflateData(compressed) isEqual: text])
+			ok = false;
+		if (level == 0 && firstBlockType(compressed) != 0)
+			ok = false;
+		if (level > 0 && compressed.count >= text.count / 2)
+			ok = false;
+	}
+	TEST(@"Round trip at levels 0, 1, 6 and 9", ok)
+
+	TEST(@"Stored blocks for incompressible data",
+	    (compressed = deflateData(random, 6, 4096)) &&
+	    firstBlockType(compressed) == 0 &&
+	    [inflateData(compressed) isEqual: random])
+
+	TEST(@"Fixed Huffman block for short data",
+	    (compressed = deflateData(hello, 6, 20)) &&
+	    firstBlockType(compressed) == 1 &&
+	    [inflateData(compressed) isEqual: hello])
+
+	TEST(@"Dynamic Huffman blocks for text",
+	    (compressed = deflateData(text, 6, 65536)) &&
+	    firstBlockType(compressed) == 2 &&
+	    [inflateData(compressed) isEqual: text])
+
+	/*
+	 * Repeats at distances just below the maximum distance, written in odd
+	 * chunks, so that matches are found across several slides.
+	 */
+	window = [OFMutableData data];
+	for (uint32_t i = 0; i < 8; i++) {
+		OFData *block = randomData(20000, i + 2);
+
+		[window addItems: block.items
+			   count: block.count];
+		[window addItems: randomData(12000, i + 100).items
+			   count: 12000];
+		[window addItems: block.items
+			   count: block.count];
+	}
+	[window makeImmutable];
+
+	TEST(@"Input longer than the window",
+	    (compressed = deflateData(window, 1, 777)) &&
+	    [inflateData(compressed) isEqual: window] &&
+	    compressed.count < window.count * 3 / 4 &&
+	    (compressed = deflateData(window, 9, 777)) &&
+	    [inflateData(compressed) isEqual: window] &&
+	    compressed.count < window.count * 3 / 4)
+
+	stream = [[[TestsMemoryStream alloc] init] autorelease];
+	deflateStream = [OFDeflateStream streamWithStream: stream];
+	ok = true;
+	for (size_t i = 0; i < text.count; i += 10000) {
+		static const unsigned int levels[] = { 0, 1, 6, 9, 3 };
+
+		deflateStream.level = levels[(i / 10000) % 5];
+		[deflateStream writeBuffer: (const char *)text.items + i
+				    length: 10000];
+	}
+	[deflateStream close];
+	TEST(@"-[setLevel:] while writing",
+	    [inflateData(stream.data) isEqual: text] &&
+	    deflateStream.bytesWritten == stream.data.count)
+
+	EXPECT_EXCEPTION(@"Detection of invalid level",
+	    OFInvalidArgumentException,
+	    [OFDeflateStream streamWithStream: stream
+					level: 10])
+
+	stream = [[[TestsMemoryStream alloc] init] autorelease];
+	CRC32 = ~of_crc32(~0, text.items, text.count);
+	TEST(@"Writing a GZIP stream",
+	    (GZIPStream = [OFGZIPStream streamWithStream: stream
+						    mode: @"w"]) &&
+	    R(GZIPStream.modificationDate =
+	    [OFDate dateWithTimeIntervalSince1970: 1000000000]) &&
+	    R([GZIPStream writeData: text]) && R([GZIPStream close]) &&
+	    (items = stream.data.items) &&
+	    items[0] == 0x1F && items[1] == 0x8B && items[2] == 8 &&
+	    littleEndianInt32(stream.data, 4) == 1000000000 &&
+	    littleEndianInt32(stream.data, stream.data.count - 8) == CRC32 &&
+	    littleEndianInt32(stream.data, stream.data.count - 4) ==
+	    text.count)
+
+	[stream seekToOffset: 0
+		      whence: SEEK_SET];
+	TEST(@"Reading the written GZIP stream",
+	    (GZIPStream = [OFGZIPStream streamWithStream: stream
+						    mode: @"r"]) &&
+	    [[GZIPStream readDataUntilEndOfStream] isEqual: text] &&
+	    [GZIPStream.modificationDate isEqual:
+	    [OFDate dateWithTimeIntervalSince1970: 1000000000]])
+
+	stream = [[[TestsMemoryStream alloc] init] autorelease];
+	entry = [OFMutableZIPArchiveEntry entryWithFileName: @"text.txt"];
+	entry.compressionMethod =
+	    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE;
+	TEST(@"Writing a deflated ZIP entry",
+	    (archive = [OFZIPArchive archiveWithStream: stream
+						  mode: @"w"]) &&
+	    (entryStream = [archive streamForWritingEntry: entry]) &&
+	    R([entryStream writeData: text]) && R([entryStream close]) &&
+	    R([archive close]))
+
+	[stream seekToOffset: 0
+		      whence: SEEK_SET];
+	TEST(@"Reading the deflated ZIP entry",
+	    (archive = [OFZIPArchive archiveWithStream: stream
+						  mode: @"r"]) &&
+	    archive.entries.count == 1 &&
+	    (readEntry = archive.entries.firstObject) &&
+	    readEntry.compressionMethod ==
+	    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE &&
+	    readEntry.CRC32 == CRC32 &&
+	    readEntry.uncompressedSize == text.count &&
+	    readEntry.compressedSize < text.count / 2 &&
+	    [[[archive streamForReadingFile: @"text.txt"]
+	    readDataUntilEndOfStream] isEqual: text])
+
+	/*
+	 * The data descriptor follows the compressed data, which follows the
+	 * local file header with its file name and extra field.
+	 */
+	items = stream.data.items;
+	offset = 30 + (items[26] | items[27] << 8) +
+	    (items[28] | items[29] << 8) + (size_t)readEntry.compressedSize;
+	TEST(@"CRC32 in the data descriptor",
+	    offset + 8 <= stream.data.count &&
+	    littleEndianInt32(stream.data, offset) == 0x08074B50 &&
+	    littleEndianInt32(stream.data, offset + 4) == CRC32)
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
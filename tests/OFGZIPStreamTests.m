@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFGZIPStream";
+
+static OFData *
+compress(OFData *data, OFThreadPool *threadPool)
+{
+	TestsMemoryStream *stream = [[[TestsMemoryStream alloc] init]
+	    autorelease];
+	OFGZIPStream *GZIPStream = [OFGZIPStream streamWithStream: stream
+							     mode: @"w"];
+	const char *items = data.items;
+
+	GZIPStream.threadPool = threadPool;
+
+	for (size_t i = 0; i < data.count; i += 100000)
+		[GZIPStream writeBuffer: items + i
+				 length: (data.count - i < 100000
+					     ? data.count - i : 100000)];
+
+	[GZIPStream close];
+
+	return stream.data;
+}
+
+static OFData *
+decompress(OFData *data, OFThreadPool *threadPool)
+{
+	TestsMemoryStream *stream = [[[TestsMemoryStream alloc]
+	    initWithData: data] autorelease];
+	OFGZIPStream *GZIPStream = [OFGZIPStream streamWithStream: stream
+							     mode: @"r"];
+
+	GZIPStream.threadPool = threadPool;
+
+	return [GZIPStream readDataUntilEndOfStream];
+}
+
+/* Returns the number of members if all of them store their size. */
+static size_t
+sizedMembersCount(OFData *data)
+{
+	const unsigned char *items = data.items;
+	size_t offset = 0, count = 0;
+
+	while (offset < data.count) {
+		if (data.count - offset < 20 || items[offset] != 0x1F ||
+		    items[offset + 1] != 0x8B || items[offset + 2] != 8 ||
+		    !(items[offset + 3] & OF_GZIP_STREAM_FLAG_EXTRA) ||
+		    items[offset + 10] != 8 || items[offset + 11] != 0 ||
+		    items[offset + 12] != 'O' || items[offset + 13] != 'F')
+			return 0;
+
+		offset += littleEndianInt32(data, offset + 16);
+		count++;
+	}
+
+	return (offset == data.count ? count : 0);
+}
+
+/* Writes data as BGZF, which stores the size of each member in "BC". */
+static OFData *
+BGZFData(OFData *data)
+{
+	OFMutableData *ret = [OFMutableData data];
+	const char *items = data.items;
+
+	/* The last member is the empty end of file marker. */
+	for (size_t i = 0;;) {
+		size_t length =
+		    (data.count - i < 60000 ? data.count - i : 60000);
+		TestsMemoryStream *stream = [[[TestsMemoryStream alloc] init]
+		    autorelease];
+		OFDeflateStream *deflateStream =
+		    [OFDeflateStream streamWithStream: stream];
+		unsigned char header[18] = {
+			0x1F, 0x8B, 8, OF_GZIP_STREAM_FLAG_EXTRA, 0, 0, 0, 0,
+			0, 255, 6, 0, 'B', 'C', 2, 0
+		};
+		unsigned char trailer[8];
+		uint32_t CRC32 = ~of_crc32(~0, items + i, length);
+		size_t size;
+
+		[deflateStream writeBuffer: items + i
+				    length: length];
+		[deflateStream close];
+
+		size = sizeof(header) + stream.data.count + sizeof(trailer);
+		header[16] = (size - 1) & 0xFF;
+		header[17] = (size - 1) >> 8;
+
+		for (uint_fast8_t j = 0; j < 4; j++) {
+			trailer[j] = (CRC32 >> (j * 8)) & 0xFF;
+			trailer[j + 4] = (length >> (j * 8)) & 0xFF;
+		}
+
+		[ret addItems: header
+			count: sizeof(header)];
+		[ret addItems: stream.data.items
+			count: stream.data.count];
+		[ret addItems: trailer
+			count: sizeof(trailer)];
+
+		if (length == 0)
+			break;
+
+		i += length;
+	}
+
+	[ret makeImmutable];
+
+	return ret;
+}
+
+@implementation TestsAppDelegate (OFGZIPStreamTests)
+- (void)GZIPStreamTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFThreadPool *threadPool = [OFThreadPool threadPoolWithSize: 2];
+	OFThreadPool *singleThreadPool = [OFThreadPool threadPoolWithSize: 1];
+	OFData *text = textData(OF_GZIP_STREAM_PARALLEL_BLOCK_SIZE * 5 / 2, 1);
+	OFData *text2 = textData(100000, 2);
+	OFMutableData *mixed, *mixedText;
+	OFData *parallelCompressed, *compressed;
+	TestsMemoryStream *stream;
+	OFGZIPStream *GZIPStream;
+	OFTarArchive *archive;
+	OFMutableTarArchiveEntry *entry;
+	OFStream *entryStream;
+	char buffer;
+
+	TEST(@"Parallel compression into sized members",
+	    (parallelCompressed = compress(text, threadPool)) &&
+	    sizedMembersCount(parallelCompressed) == 3)
+
+	TEST(@"Sequential decompression of parallel compressed data",
+	    [decompress(parallelCompressed, nil) isEqual: text])
+
+	/* A single thread reads the three members in two batches. */
+	TEST(@"Parallel decompression of \"OF\" members",
+	    [decompress(parallelCompressed, threadPool) isEqual: text] &&
+	    [decompress(parallelCompressed, singleThreadPool) isEqual: text])
+
+	TEST(@"Parallel decompression of \"BC\" members",
+	    [decompress(BGZFData(text2), threadPool) isEqual: text2])
+
+	TEST(@"Sequential fallback for a plain GZIP file",
+	    (compressed = compress(text2, nil)) &&
+	    sizedMembersCount(compressed) == 0 &&
+	    [decompress(compressed, threadPool) isEqual: text2])
+
+	mixed = [[parallelCompressed mutableCopy] autorelease];
+	[mixed addItems: compressed.items
+		  count: compressed.count];
+	mixedText = [[text mutableCopy] autorelease];
+	[mixedText addItems: text2.items
+		      count: text2.count];
+	TEST(@"Sequential fallback after sized members",
+	    [decompress(mixed, threadPool) isEqual: mixedText])
+
+	stream = [[[TestsMemoryStream alloc] init] autorelease];
+	GZIPStream = [OFGZIPStream streamWithStream: stream
+					       mode: @"w"];
+	[GZIPStream writeBuffer: "x"
+			 length: 1];
+	EXPECT_EXCEPTION(@"Detection of setting a thread pool after writing",
+	    OFAlreadyConnectedException, GZIPStream.threadPool = threadPool)
+	[GZIPStream close];
+
+	[stream seekToOffset: 0
+		      whence: SEEK_SET];
+	GZIPStream = [OFGZIPStream streamWithStream: stream
+					       mode: @"r"];
+	TEST(@"Reading after setting a thread pool",
+	    R(GZIPStream.threadPool = threadPool) &&
+	    [GZIPStream readIntoBuffer: &buffer
+				length: 1] == 1 && buffer == 'x')
+	EXPECT_EXCEPTION(@"Detection of setting a thread pool after reading",
+	    OFAlreadyConnectedException, GZIPStream.threadPool = nil)
+
+	/* This is what ofarc does for tgz archives with --threads. */
+	stream = [[[TestsMemoryStream alloc] init] autorelease];
+	GZIPStream = [OFGZIPStream streamWithStream: stream
+					       mode: @"w"];
+	GZIPStream.threadPool = threadPool;
+	entry = [OFMutableTarArchiveEntry entryWithFileName: @"text.txt"];
+	entry.size = text.count;
+	TEST(@"Writing a tar archive to a parallel GZIP stream",
+	    (archive = [OFTarArchive archiveWithStream: GZIPStream
+						  mode: @"w"]) &&
+	    (entryStream = [archive streamForWritingEntry: entry]) &&
+	    R([entryStream writeData: text]) && R([entryStream close]) &&
+	    R([archive close]) && R([GZIPStream close]) &&
+	    sizedMembersCount(stream.data) > 1)
+
+	[stream seekToOffset: 0
+		      whence: SEEK_SET];
+	GZIPStream = [OFGZIPStream streamWithStream: stream
+					       mode: @"r"];
+	GZIPStream.threadPool = threadPool;
+	TEST(@"Reading a tar archive from a parallel GZIP stream",
+	    (archive = [OFTarArchive archiveWithStream: GZIPStream
+						  mode: @"r"]) &&
+	    [[archive nextEntry].fileName isEqual: @"text.txt"] &&
+	    [[archive.streamForReadingCurrentEntry readDataUntilEndOfStream]
+	    isEqual: text] && [archive nextEntry] == nil)
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
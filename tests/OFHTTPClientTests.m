@@ -24,7 +24,9 @@
 
 static OFString *module = @"OFHTTPClient";
 static OFCondition *cond;
-static OFHTTPResponse *response = nil;
+static OFMutableArray OF_GENERIC(OFHTTPResponse *) *responses;
+static size_t expectedResponses;
+static bool readsResponses;
 
 @interface TestsAppDelegate (HTTPClientTests) <OFHTTPClientDelegate>
 @end
@@ -32,14 +34,31 @@ static OFHTTPResponse *response = nil;
 @interface HTTPClientTestsServer: OFThread
 {
 @public
-	uint16_t _port;
+	uint16_t _port, _port2;
 }
 @end
 
+static void
+serve(OFTCPSocket *client, OFString *path)
+{
+	OFString *line;
+
+	if (![[client readLine] isEqual:
+	    [OFString stringWithFormat: @"GET %@ HTTP/1.1", path]])
+		OF_ENSURE(0);
+
+	while ((line = [client readLine]) != nil && line.length > 0);
+
+	[client writeString: @"HTTP/1.1 200 OK\r\n"
+			     @"Content-Length: 3\r\n"
+			     @"\r\n"
+			     @"baz"];
+}
+
 @implementation HTTPClientTestsServer
 - (id)main
 {
-	OFTCPSocket *listener, *client;
+	OFTCPSocket *listener, *listener2, *client, *client2, *client3;
 	char buffer[5];
 
 	[cond lock];
@@ -49,6 +68,11 @@ static OFHTTPResponse *response = nil;
 				port: 0];
 	[listener listen];
 
+	listener2 = [OFTCPSocket socket];
+	_port2 = [listener2 bindToHost: @"127.0.0.1"
+				  port: 0];
+	[listener2 listen];
+
 	[cond signal];
 	[cond unlock];
 
@@ -86,10 +110,94 @@ static OFHTTPResponse *response = nil;
 			     @"bar"];
 	[client close];
 
+	/* Two requests on the same keep-alive connection */
+	client = [listener accept];
+
+	serve(client, @"/bar");
+	serve(client, @"/bar");
+	[client close];
+
+	/*
+	 * With a single idle connection allowed, the connection to the second
+	 * port evicts the one to the first port, so that the next request to
+	 * the first port needs a new connection.
+	 */
+	client = [listener accept];
+	serve(client, @"/a");
+	client2 = [listener2 accept];
+	serve(client2, @"/b");
+	serve(client2, @"/b");
+	client3 = [listener accept];
+	serve(client3, @"/a");
+	[client close];
+	[client2 close];
+	[client3 close];
+
+	/* Two concurrent requests */
+	client = [listener accept];
+	client2 = [listener accept];
+	serve(client, @"/c");
+	serve(client2, @"/c");
+	[client close];
+	[client2 close];
+
+	/* The idle connection times out before the second request. */
+	client = [listener accept];
+	serve(client, @"/d");
+	client2 = [listener accept];
+	serve(client2, @"/d");
+	[client close];
+	[client2 close];
+
+	/* The second request waits for the connection of the first one. */
+	client = [listener accept];
+	serve(client, @"/e");
+	serve(client, @"/e");
+	[client close];
+
 	return nil;
 }
 @end
 
+static OFURL *
+URLWithPort(uint16_t port, OFString *path)
+{
+	return [OFURL URLWithString:
+	    [OFString stringWithFormat: @"http://127.0.0.1:%" @PRIu16 "%@",
+					port, path]];
+}
+
+/*
+ * Performs count concurrent requests for URL and returns whether all of them
+ * were answered with "baz". Reading the responses makes their connections
+ * reusable.
+ */
+static bool
+performRequests(OFHTTPClient *client, OFURL *URL, size_t count)
+{
+	responses = [OFMutableArray array];
+	expectedResponses = count;
+
+	for (size_t i = 0; i < count; i++)
+		[client asyncPerformRequest:
+		    [OFHTTPRequest requestWithURL: URL]];
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]];
+
+	if (responses.count != count)
+		return false;
+
+	for (OFHTTPResponse *response in responses) {
+		OFData *data = [response readDataUntilEndOfStream];
+
+		if (data.count != 3 || memcmp(data.items, "baz", 3) != 0)
+			return false;
+	}
+
+	return true;
+}
+
 @implementation TestsAppDelegate (OFHTTPClientTests)
 -     (void)client: (OFHTTPClient *)client
   wantsRequestBody: (OFStream *)body
@@ -100,14 +208,30 @@ static OFHTTPResponse *response = nil;
 
 -      (void)client: (OFHTTPClient *)client
   didPerformRequest: (OFHTTPRequest *)request
-	   response: (OFHTTPResponse *)response_
+	   response: (OFHTTPResponse *)response
 	  exception: (id)exception
 {
 	OF_ENSURE(exception == nil);
 
-	response = [response_ retain];
+	/*
+	 * Reading the response entirely returns its connection to the pool,
+	 * where a queued request can pick it up.
+	 */
+	if (readsResponses) {
+		OFData *data;
+
+		OF_ENSURE(client.connectionsInUse == 1);
+
+		data = [response readDataUntilEndOfStream];
+		OF_ENSURE(data.count == 3 && memcmp(data.items, "baz", 3) == 0);
+		OF_ENSURE(client.connectionsInUse == 0 ||
+		    responses.count + 1 < expectedResponses);
+	}
 
-	[[OFRunLoop mainRunLoop] stop];
+	[responses addObject: response];
+
+	if (responses.count == expectedResponses)
+		[[OFRunLoop mainRunLoop] stop];
 }
 
 - (void)HTTPClientTests
@@ -117,6 +241,7 @@ static OFHTTPResponse *response = nil;
 	OFURL *URL;
 	OFHTTPClient *client;
 	OFHTTPRequest *request;
+	OFHTTPResponse *response;
 	OFData *data;
 
 	cond = [OFCondition condition];
@@ -129,9 +254,9 @@ static OFHTTPResponse *response = nil;
 	[cond wait];
 	[cond unlock];
 
-	URL = [OFURL URLWithString:
-	    [OFString stringWithFormat: @"http://127.0.0.1:%" @PRIu16 "/foo",
-					server->_port]];
+	URL = URLWithPort(server->_port, @"/foo");
+	responses = [OFMutableArray array];
+	expectedResponses = 1;
 
 	TEST(@"-[asyncPerformRequest:]",
 	    (client = [OFHTTPClient client]) && (client.delegate = self) &&
@@ -143,7 +268,7 @@ static OFHTTPResponse *response = nil;
 
 	[[OFRunLoop mainRunLoop] runUntilDate:
 	    [OFDate dateWithTimeIntervalSinceNow: 2]];
-	[response autorelease];
+	response = responses.firstObject;
 
 	TEST(@"Asynchronous handling of requests", response != nil)
 
@@ -154,6 +279,71 @@ static OFHTTPResponse *response = nil;
 	    (data = [response readDataUntilEndOfStream]) &&
 	    data.count == 7 && memcmp(data.items, "foo\nbar", 7) == 0)
 
+	URL = URLWithPort(server->_port, @"/bar");
+
+	TEST(@"First request on a keep-alive connection",
+	    performRequests(client, URL, 1) && client.reusedConnections == 0)
+
+	TEST(@"Reuse of keep-alive connections",
+	    performRequests(client, URL, 1) && client.reusedConnections == 1)
+
+	[client close];
+	client.maxIdleConnections = 1;
+
+	TEST(@"Eviction of the oldest connection at maxIdleConnections",
+	    performRequests(client, URLWithPort(server->_port, @"/a"), 1) &&
+	    performRequests(client, URLWithPort(server->_port2, @"/b"), 1) &&
+	    client.evictedConnections == 1 &&
+	    performRequests(client, URLWithPort(server->_port2, @"/b"), 1) &&
+	    client.reusedConnections == 2 &&
+	    performRequests(client, URLWithPort(server->_port, @"/a"), 1) &&
+	    client.reusedConnections == 2 && client.evictedConnections == 2)
+
+	[client close];
+	client.maxIdleConnections = OF_HTTP_CLIENT_DEFAULT_MAX_IDLE_CONNECTIONS;
+	client.maxIdleConnectionsPerHost = 1;
+
+	TEST(@"Concurrent requests",
+	    performRequests(client, URLWithPort(server->_port, @"/c"), 2) &&
+	    client.reusedConnections == 2)
+
+	TEST(@"Eviction at maxIdleConnectionsPerHost",
+	    client.evictedConnections == 3)
+
+	[client close];
+	client.idleTimeout = 0.5;
+	URL = URLWithPort(server->_port, @"/d");
+
+	TEST(@"Request before the idle timeout",
+	    performRequests(client, URL, 1))
+
+	[[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 1.5]];
+
+	TEST(@"Closing of connections after idleTimeout",
+	    client.evictedConnections == 4 &&
+	    performRequests(client, URL, 1) && client.reusedConnections == 2)
+
+	[client close];
+	client.maxConnections = 1;
+	responses = [OFMutableArray array];
+	expectedResponses = 2;
+	readsResponses = true;
+	URL = URLWithPort(server->_port, @"/e");
+
+	TEST(@"Queueing of requests at maxConnections",
+	    R([client asyncPerformRequest:
+	    [OFHTTPRequest requestWithURL: URL]]) &&
+	    R([client asyncPerformRequest:
+	    [OFHTTPRequest requestWithURL: URL]]) &&
+	    client.connectionsInUse == 1 &&
+	    R([[OFRunLoop mainRunLoop] runUntilDate:
+	    [OFDate dateWithTimeIntervalSinceNow: 2]]) &&
+	    responses.count == 2 && client.reusedConnections == 3 &&
+	    client.connectionsInUse == 0)
+
+	readsResponses = false;
+	[client close];
 	[server join];
 
 	objc_autoreleasePoolPop(pool);
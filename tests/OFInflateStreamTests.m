@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFInflateStream";
+
+/*
+ * Lines 0 to 3 of inflateText() in a stored block, lines 4 to 9 in a block
+ * with fixed Huffman codes and the remaining lines in a final block with
+ * dynamic Huffman codes.
+ */
+static const unsigned char deflated[534] = {
+	0x00, 0xC0, 0x00, 0x3F, 0xFF, 0x30, 0x3A, 0x20, 0x54, 0x68, 0x65, 0x20,
+	0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+	0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F, 0x76,
+	0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20,
+	0x64, 0x6F, 0x67, 0x2E, 0x0A, 0x31, 0x3A, 0x20, 0x54, 0x68, 0x65, 0x20,
+	0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+	0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F, 0x76,
+	0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20,
+	0x64, 0x6F, 0x67, 0x2E, 0x0A, 0x32, 0x3A, 0x20, 0x54, 0x68, 0x65, 0x20,
+	0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+	0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F, 0x76,
+	0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20,
+	0x64, 0x6F, 0x67, 0x2E, 0x0A, 0x33, 0x3A, 0x20, 0x54, 0x68, 0x65, 0x20,
+	0x71, 0x75, 0x69, 0x63, 0x6B, 0x20, 0x62, 0x72, 0x6F, 0x77, 0x6E, 0x20,
+	0x66, 0x6F, 0x78, 0x20, 0x6A, 0x75, 0x6D, 0x70, 0x73, 0x20, 0x6F, 0x76,
+	0x65, 0x72, 0x20, 0x74, 0x68, 0x65, 0x20, 0x6C, 0x61, 0x7A, 0x79, 0x20,
+	0x64, 0x6F, 0x67, 0x2E, 0x0A, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x32, 0xB1,
+	0x52, 0x08, 0xC9, 0x48, 0x55, 0x28, 0x2C, 0xCD, 0x4C, 0xCE, 0x56, 0x48,
+	0x2A, 0xCA, 0x2F, 0xCF, 0x53, 0x48, 0xCB, 0xAF, 0x50, 0xC8, 0x2A, 0xCD,
+	0x2D, 0x28, 0x56, 0xC8, 0x2F, 0x4B, 0x2D, 0x52, 0x28, 0x01, 0x4A, 0xE7,
+	0x24, 0x56, 0x55, 0x2A, 0xA4, 0xE4, 0xA7, 0xEB, 0x71, 0x99, 0x92, 0xA8,
+	0xDE, 0x8C, 0x44, 0xF5, 0xE6, 0x24, 0xAA, 0xB7, 0x20, 0x51, 0xBD, 0x25,
+	0x89, 0xEA, 0x01, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x95, 0xD1, 0xC7, 0x51,
+	0x04, 0x41, 0x10, 0x00, 0xC1, 0x3F, 0x56, 0x8C, 0x05, 0x04, 0x37, 0x3D,
+	0xAA, 0xB1, 0x03, 0x07, 0xD0, 0x9A, 0x85, 0x83, 0x43, 0x59, 0x0F, 0x2E,
+	0xE4, 0xBB, 0xA2, 0x5E, 0xB9, 0x3B, 0x39, 0x2D, 0x67, 0x77, 0xD7, 0xE5,
+	0xED, 0x70, 0x7F, 0xF9, 0x58, 0x2E, 0xF6, 0xDB, 0xD7, 0x4B, 0xB9, 0xD9,
+	0xBE, 0xCB, 0xC3, 0xE1, 0xF9, 0xF5, 0xBD, 0x6C, 0x9F, 0xD7, 0xFB, 0xF2,
+	0xF1, 0x9F, 0x9F, 0xCE, 0x7F, 0x7F, 0xCA, 0xD5, 0x76, 0x7B, 0x7C, 0xB4,
+	0xDB, 0xE9, 0x50, 0x75, 0x08, 0x1D, 0x9A, 0x0E, 0x5D, 0x87, 0xA1, 0xC3,
+	0xD4, 0x61, 0xE9, 0x90, 0x38, 0x54, 0x95, 0xAE, 0x2A, 0x5D, 0x55, 0xBA,
+	0xAA, 0x74, 0x55, 0xE9, 0xAA, 0xD2, 0x55, 0xA5, 0xAB, 0x4A, 0x57, 0x95,
+	0xAE, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A,
+	0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0x1D, 0x2A, 0xDD, 0x54,
+	0xBA, 0xA9, 0x74, 0x53, 0xE9, 0xA6, 0xD2, 0x4D, 0xA5, 0x9B, 0x4A, 0x37,
+	0x95, 0x6E, 0x2A, 0xDD, 0x54, 0xBA, 0xA9, 0x74, 0x57, 0xE9, 0xAE, 0xD2,
+	0x5D, 0xA5, 0xBB, 0x4A, 0x77, 0x95, 0xEE, 0x2A, 0xDD, 0x55, 0xBA, 0xAB,
+	0x74, 0x57, 0xE9, 0xAE, 0xD2, 0x43, 0xA5, 0x87, 0x4A, 0x0F, 0x95, 0x1E,
+	0x2A, 0x3D, 0x54, 0x7A, 0xA8, 0xF4, 0x50, 0xE9, 0xA1, 0xD2, 0x43, 0xA5,
+	0x87, 0x4A, 0x4F, 0x95, 0x9E, 0x2A, 0x3D, 0x55, 0x7A, 0xAA, 0xF4, 0x54,
+	0xE9, 0xA9, 0xD2, 0x53, 0xA5, 0xA7, 0x4A, 0x4F, 0x95, 0x9E, 0x2A, 0xBD,
+	0x54, 0x7A, 0xA9, 0xF4, 0x52, 0xE9, 0xA5, 0xD2, 0x4B, 0xA5, 0x97, 0x4A,
+	0x2F, 0x95, 0x5E, 0x2A, 0xBD, 0x54, 0x7A, 0xA9, 0x74, 0xAA, 0x74, 0xAA,
+	0x74, 0xAA, 0x74, 0xAA, 0x74, 0xAA, 0x74, 0xAA, 0x74, 0xAA, 0x74, 0xAA,
+	0x74, 0xAA, 0x74, 0xAA, 0xF4, 0x1F
+};
+
+/*
+ * A block with fixed Huffman codes producing 50000 bytes, followed by a final
+ * block with dynamic Huffman codes using Deflate64 distances of up to 65536
+ * and a match of the maximum length of 65538. See inflate64Text().
+ */
+static const unsigned char deflated64[593] = {
+	0x62, 0x60, 0x64, 0x62, 0x66, 0x61, 0x65, 0x63, 0xE7, 0xE0, 0xE4, 0xE2,
+	0xE6, 0xE1, 0xE5, 0xE3, 0x17, 0x10, 0x14, 0x12, 0x16, 0x11, 0x15, 0x13,
+	0x97, 0x90, 0x94, 0x92, 0x96, 0x91, 0x95, 0x93, 0x57, 0x50, 0x54, 0x52,
+	0x56, 0x51, 0x55, 0x53, 0xD7, 0xD0, 0xD4, 0xD2, 0xD6, 0xD1, 0xD5, 0xD3,
+	0x37, 0x30, 0x34, 0x32, 0x36, 0x31, 0x35, 0x33, 0xB7, 0xB0, 0xB4, 0xB2,
+	0xB6, 0xB1, 0xB5, 0xB3, 0x77, 0x70, 0x74, 0x72, 0x76, 0x71, 0x75, 0x73,
+	0xF7, 0xF0, 0xF4, 0xF2, 0xF6, 0xF1, 0xF5, 0xF3, 0x0F, 0x08, 0x0C, 0x0A,
+	0x0E, 0x09, 0x0D, 0x0B, 0x8F, 0x88, 0x8C, 0x8A, 0x8E, 0x89, 0x8D, 0x8B,
+	0x4F, 0x48, 0x4C, 0x4A, 0x4E, 0x49, 0x4D, 0x4B, 0xCF, 0xC8, 0xCC, 0xCA,
+	0xCE, 0xC9, 0xCD, 0xCB, 0x2F, 0x28, 0x2C, 0x2A, 0x2E, 0x29, 0x2D, 0x2B,
+	0xAF, 0xA8, 0xAC, 0xAA, 0xAE, 0xA9, 0xAD, 0xAB, 0x6F, 0x68, 0x6C, 0x6A,
+	0x6E, 0x69, 0x6D, 0x6B, 0xEF, 0xE8, 0xEC, 0xEA, 0xEE, 0xE9, 0xED, 0xEB,
+	0x9F, 0x30, 0x71, 0xD2, 0xE4, 0x29, 0x53, 0xA7, 0x4D, 0x9F, 0x31, 0x73,
+	0xD6, 0xEC, 0x39, 0x73, 0xE7, 0xCD, 0x5F, 0xB0, 0x70, 0xD1, 0xE2, 0x25,
+	0x4B, 0x97, 0x2D, 0x5F, 0xB1, 0x72, 0xD5, 0xEA, 0x35, 0x6B, 0xD7, 0xAD,
+	0xDF, 0xB0, 0x71, 0xD3, 0xE6, 0x2D, 0x5B, 0xB7, 0x6D, 0xDF, 0xB1, 0x73,
+	0xD7, 0xEE, 0x3D, 0x7B, 0xF7, 0xED, 0x3F, 0x70, 0xF0, 0xD0, 0xE1, 0x23,
+	0x47, 0x8F, 0x1D, 0x3F, 0x71, 0xF2, 0xD4, 0xE9, 0x33, 0x67, 0xCF, 0x9D,
+	0xBF, 0x70, 0xF1, 0xD2, 0xE5, 0x2B, 0x57, 0xAF, 0x5D, 0xBF, 0x71, 0xF3,
+	0xD6, 0xED, 0x3B, 0x77, 0xEF, 0xDD, 0x7F, 0xF0, 0xF0, 0xD1, 0xE3, 0x27,
+	0x4F, 0x9F, 0x3D, 0x7F, 0xF1, 0xF2, 0xD5, 0xEB, 0x37, 0x6F, 0xDF, 0xBD,
+	0xFF, 0xF0, 0xF1, 0xD3, 0xE7, 0x2F, 0x5F, 0xBF, 0x7D, 0xFF, 0xF1, 0xF3,
+	0xD7, 0xA8, 0x2A, 0x98, 0xD7, 0x95, 0x34, 0x0D, 0xCC, 0xED, 0x5C, 0x7D,
+	0x82, 0xA3, 0x12, 0x33, 0xF2, 0xCB, 0x6A, 0x5B, 0xBA, 0x27, 0xCD, 0x5C,
+	0xB0, 0x7C, 0xDD, 0xD6, 0x3D, 0x87, 0x4F, 0x5D, 0xBC, 0x71, 0xFF, 0xD9,
+	0x5B, 0x66, 0x2E, 0x41, 0x09, 0x79, 0x35, 0x5D, 0x13, 0x6B, 0x27, 0xCF,
+	0x80, 0xF0, 0xB8, 0xD4, 0x9C, 0xE2, 0xAA, 0xC6, 0x8E, 0xFE, 0x69, 0x73,
+	0x97, 0xAC, 0xDE, 0xB4, 0xF3, 0xC0, 0xF1, 0x73, 0x57, 0xEF, 0x3C, 0x7E,
+	0xC5, 0xC0, 0xCE, 0x27, 0x2A, 0xA3, 0xAC, 0x65, 0x68, 0x61, 0xEF, 0xE6,
+	0x1B, 0x12, 0x9D, 0x94, 0x59, 0x50, 0x5E, 0xD7, 0xDA, 0x33, 0x79, 0xD6,
+	0xC2, 0x15, 0xEB, 0xB7, 0xED, 0x3D, 0x72, 0xFA, 0xD2, 0xCD, 0x07, 0xCF,
+	0xDF, 0xB1, 0x70, 0x0B, 0x49, 0x2A, 0xA8, 0xEB, 0x99, 0xDA, 0x38, 0x7B,
+	0x05, 0x46, 0xC4, 0xA7, 0xE5, 0x96, 0x54, 0x37, 0x75, 0x4E, 0x98, 0x3E,
+	0x6F, 0xE9, 0x9A, 0xCD, 0xBB, 0x0E, 0x9E, 0x38, 0x7F, 0xED, 0xEE, 0x93,
+	0xD7, 0x8C, 0x1C, 0xFC, 0x62, 0xB2, 0x2A, 0xDA, 0x46, 0x96, 0x0E, 0xEE,
+	0x7E, 0xA1, 0x31, 0xC9, 0x59, 0x85, 0x15, 0xF5, 0x6D, 0xBD, 0x53, 0x66,
+	0x2F, 0x5A, 0xB9, 0x61, 0xFB, 0xBE, 0xA3, 0x67, 0x2E, 0xDF, 0x7A, 0xF8,
+	0xE2, 0x3D, 0x2B, 0x8F, 0xB0, 0x94, 0xA2, 0x86, 0xBE, 0x99, 0xAD, 0x8B,
+	0x77, 0x50, 0x64, 0x42, 0x7A, 0x5E, 0x69, 0x4D, 0x73, 0xD7, 0xC4, 0x19,
+	0xF3, 0x97, 0xAD, 0xDD, 0xB2, 0xFB, 0xD0, 0xC9, 0x0B, 0xD7, 0xEF, 0x3D,
+	0x7D, 0xC3, 0xC4, 0x29, 0x20, 0x2E, 0xA7, 0xAA, 0x63, 0x6C, 0xE5, 0xE8,
+	0xE1, 0x1F, 0x16, 0x9B, 0x92, 0x5D, 0x54, 0xD9, 0xD0, 0xDE, 0x37, 0x75,
+	0xCE, 0xE2, 0x55, 0x1B, 0x77, 0xEC, 0x3F, 0x76, 0xF6, 0xCA, 0xED, 0x47,
+	0x2F, 0x3F, 0xB0, 0xF1, 0x8A, 0x48, 0x8F, 0xD2, 0x82, 0x79, 0x18, 0xD0,
+	0xFE, 0x1D, 0x40, 0x00, 0x00, 0x00, 0x30, 0x0C, 0x02, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xE0, 0x03, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00,
+	0x40, 0x29, 0x1F, 0xF8, 0x34, 0x48, 0x09, 0xF0, 0xC3, 0xCD, 0xFF, 0xBF,
+	0x73, 0xA0, 0xFF, 0xFF, 0x01
+};
+
+static OFData *
+inflateText(void)
+{
+	OFMutableData *text = [OFMutableData data];
+
+	for (int i = 0; i < 100; i++) {
+		OFString *line = [OFString stringWithFormat:
+		    @"%d: The quick brown fox jumps over the lazy dog.\n", i];
+
+		[text addItems: line.UTF8String
+			 count: line.UTF8StringLength];
+	}
+
+	[text makeImmutable];
+
+	return text;
+}
+
+static OFData *
+inflate64Text(void)
+{
+	static const struct {
+		uint32_t length, distance;
+	} matches[] = {
+		{ 1000, 50000 }, { 300, 40000 }, { 1, 0 }, { 65538, 33000 },
+		{ 3, 65536 }
+	};
+	OFMutableData *text = [OFMutableData dataWithCapacity: 116842];
+
+	for (uint32_t i = 0; i < 50000; i++) {
+		unsigned char byte = (i < 25000 ? i % 251 : (i * 7) % 241);
+
+		[text addItem: &byte];
+	}
+
+	/* A distance of 0 stands for the literal E. */
+	for (size_t i = 0; i < sizeof(matches) / sizeof(*matches); i++) {
+		if (matches[i].distance == 0) {
+			[text addItem: "E"];
+			continue;
+		}
+
+		for (uint32_t j = 0; j < matches[i].length; j++) {
+			unsigned char byte = *(const unsigned char *)[text
+			    itemAtIndex: text.count - matches[i].distance];
+
+			[text addItem: &byte];
+		}
+	}
+
+	[text makeImmutable];
+
+	return text;
+}
+
+/*
+ * Inflates with the underlying stream returning at most readLength bytes and
+ * the decompressor being asked for at most bufferLength bytes at a time. The
+ * data following the compressed data needs to be left in the underlying
+ * stream.
+ */
+static bool
+inflate(Class streamClass, const unsigned char *items, size_t count,
+    OFData *text, size_t readLength, size_t bufferLength)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableData *data = [OFMutableData dataWithItems: items
+						     count: count];
+	OFMutableData *inflated = [OFMutableData data];
+	TestsMemoryStream *stream;
+	OFStream *inflateStream;
+	char *buffer = of_alloc(bufferLength, 1);
+	bool ret;
+
+	[data addItems: "TRAILER"
+		 count: 7];
+
+	stream = [[[TestsMemoryStream alloc] initWithData: data] autorelease];
+	stream.maxReadLength = readLength;
+	inflateStream = [[[streamClass alloc] initWithStream: stream]
+	    autorelease];
+
+	@try {
+		while (!inflateStream.atEndOfStream) {
+			size_t length = [inflateStream
+			    readIntoBuffer: buffer
+				    length: bufferLength];
+
+			[inflated addItems: buffer
+				     count: length];
+		}
+	} @finally {
+		free(buffer);
+	}
+
+	stream.maxReadLength = 0;
+	ret = ([inflated isEqual: text] &&
+	    [[stream readDataUntilEndOfStream] isEqual:
+	    [OFData dataWithItems: "TRAILER"
+			    count: 7]]);
+
+	objc_autoreleasePoolPop(pool);
+
+	return ret;
+}
+
+@implementation TestsAppDelegate (OFInflateStreamTests)
+- (void)inflateStreamTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFData *text = inflateText(), *text64 = inflate64Text();
+	static const size_t readLengths[] = { 1, 5, 4096 };
+	static const size_t bufferLengths[] = { 1, 13, 100000 };
+	bool ok;
+
+	ok = true;
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 3; j++)
+			if (!inflate([OFInflateStream class], deflated,
+			    sizeof(deflated), text, readLengths[i],
+			    bufferLengths[j]))
+				ok = false;
+	TEST(@"Stored, fixed and dynamic Huffman blocks", ok)
+
+	module = @"OFInflate64Stream";
+
+	ok = true;
+	for (size_t i = 0; i < 3; i++)
+		for (size_t j = 0; j < 3; j++)
+			if (!inflate([OFInflate64Stream class], deflated64,
+			    sizeof(deflated64), text64, readLengths[i],
+			    bufferLengths[j]))
+				ok = false;
+	TEST(@"Long distances and lengths", ok)
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
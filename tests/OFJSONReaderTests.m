@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFJSONReader";
+static const char document[] =
+    "{\"name\": \"a\\\"b\\u00E4\\ud83d\\ude00\", \"n\": -12, \"d\": 1.5e2,\n"
+    " \"t\": true, \"f\": false, \"z\": null,\n"
+    " \"skip\": {\"x\": [1, \"]}\", {\"y\": \"\\\\\"}], \"w\": 2},\n"
+    " \"list\": [1, 2, 3]}\n";
+
+/* Returns the document in tiny pieces to hit every buffer boundary. */
+@interface JSONReaderTestsStream: OFStream
+{
+	size_t _position;
+}
+@end
+
+@implementation JSONReaderTestsStream
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= sizeof(document) - 1);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (length > 3)
+		length = 3;
+	if (length > sizeof(document) - 1 - _position)
+		length = sizeof(document) - 1 - _position;
+
+	memcpy(buffer, document + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
+
+static OFJSONReader *
+readerForCString(const char *string)
+{
+	return [OFJSONReader readerWithData:
+	    [OFData dataWithItems: string
+			    count: strlen(string)]];
+}
+
+@implementation TestsAppDelegate (OFJSONReaderTests)
+- (void)JSONReaderTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONReader *readers[2], *reader;
+	OFArray *array;
+
+	readers[0] = readerForCString(document);
+	readers[1] = [OFJSONReader readerWithStream:
+	    [[[JSONReaderTestsStream alloc] init] autorelease]];
+
+	for (size_t i = 0; i < 2; i++) {
+		reader = readers[i];
+		module = (i == 0
+		    ? @"OFJSONReader (data)" : @"OFJSONReader (stream)");
+
+		TEST(@"Start of object",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_BEGIN_OBJECT &&
+		    reader.depth == 1)
+
+		TEST(@"Key and escaped string",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    of_json_reader_range_is_equal(reader.range, "name") &&
+		    !reader.hasEscapes &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_STRING &&
+		    reader.hasEscapes && [reader.stringValue isEqual:
+		    @"a\"b\xC3\xA4\xF0\x9F\x98\x80"])
+
+		TEST(@"Numbers",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_NUMBER &&
+		    reader.longLongValue == -12 &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_NUMBER &&
+		    of_json_reader_range_is_equal(reader.range, "1.5e2") &&
+		    reader.numberValue.doubleValue == 150)
+
+		TEST(@"Literals",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_TRUE &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_FALSE &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_NULL)
+
+		TEST(@"-[skipValue]",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    of_json_reader_range_is_equal(reader.range, "skip") &&
+		    R([reader skipValue]) &&
+		    reader.token == OF_JSON_READER_TOKEN_END_OBJECT &&
+		    reader.depth == 1 && reader.line == 3)
+
+		array = [OFArray arrayWithObjects: [OFNumber numberWithInt: 1],
+		    [OFNumber numberWithInt: 2], [OFNumber numberWithInt: 3],
+		    nil];
+		TEST(@"-[readObject]",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_KEY &&
+		    [[reader readObject] isEqual: array] &&
+		    reader.token == OF_JSON_READER_TOKEN_END_ARRAY)
+
+		TEST(@"End of document",
+		    [reader nextToken] == OF_JSON_READER_TOKEN_END_OBJECT &&
+		    reader.depth == 0 &&
+		    [reader nextToken] ==
+		    OF_JSON_READER_TOKEN_END_OF_DOCUMENT &&
+		    reader.token == OF_JSON_READER_TOKEN_END_OF_DOCUMENT &&
+		    [reader nextToken] == OF_JSON_READER_TOKEN_END_OF_DOCUMENT)
+	}
+
+	module = @"OFJSONReader";
+
+	reader = readerForCString("{\"a\": 1}\n{\"a\": [2]}\n");
+	TEST(@"-[setAllowsMultipleValues:]",
+	    R(reader.allowsMultipleValues = true) &&
+	    [reader nextToken] == OF_JSON_READER_TOKEN_BEGIN_OBJECT &&
+	    [[reader readObject] isEqual: [OFDictionary
+	    dictionaryWithObject: [OFNumber numberWithInt: 1]
+			  forKey: @"a"]] &&
+	    [reader nextToken] == OF_JSON_READER_TOKEN_BEGIN_OBJECT &&
+	    [[reader readObject] isEqual: [OFDictionary
+	    dictionaryWithObject: [OFArray arrayWithObject:
+				      [OFNumber numberWithInt: 2]]
+			  forKey: @"a"]] &&
+	    [reader nextToken] == OF_JSON_READER_TOKEN_END_OF_DOCUMENT)
+
+	reader = readerForCString("1 2");
+	EXPECT_EXCEPTION(@"Detection of multiple values",
+	    OFInvalidJSONException, [reader nextToken]; [reader nextToken])
+
+	reader = readerForCString("[1,]");
+	EXPECT_EXCEPTION(@"Detection of trailing comma",
+	    OFInvalidJSONException, [reader nextToken]; [reader readObject])
+
+	reader = readerForCString("{\"a\" 1}");
+	EXPECT_EXCEPTION(@"Detection of missing colon",
+	    OFInvalidJSONException, [reader nextToken]; [reader readObject])
+
+	reader = readerForCString("[01]");
+	EXPECT_EXCEPTION(@"Detection of invalid number",
+	    OFInvalidJSONException, [reader nextToken]; [reader readObject])
+
+	reader = readerForCString("[[1]");
+	EXPECT_EXCEPTION(@"Detection of unclosed array",
+	    OFInvalidJSONException, [reader nextToken]; [reader skipValue])
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFJSONWriter";
+
+/* Collects everything written to it. */
+@interface JSONWriterTestsStream: OFStream
+{
+@public
+	OFMutableData *_data;
+}
+@end
+
+@implementation JSONWriterTestsStream
+- (instancetype)init
+{
+	self = [super init];
+
+	_data = [[OFMutableData alloc] init];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	[_data addItems: buffer
+		  count: length];
+
+	return length;
+}
+@end
+
+@implementation TestsAppDelegate (OFJSONWriterTests)
+- (void)JSONWriterTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFJSONWriter *writer;
+	JSONWriterTestsStream *stream;
+	OFMutableString *longString;
+
+	TEST(@"+[writer]", (writer = [OFJSONWriter writer]))
+
+	TEST(@"Writing arrays and objects",
+	    R([writer beginObject]) && R([writer writeKey: @"a"]) &&
+	    R([writer beginArray]) && R([writer writeLongLong: -12]) &&
+	    R([writer writeUnsignedLongLong: 18446744073709551615ULL]) &&
+	    R([writer writeDouble: 0.5]) && R([writer writeBool: true]) &&
+	    R([writer writeNull]) && R([writer endArray]) &&
+	    R([writer writeKey: @"b"]) && R([writer beginObject]) &&
+	    R([writer endObject]) && writer.depth == 1 &&
+	    R([writer endObject]) && writer.depth == 0 &&
+	    [writer.string isEqual:
+	    @"{\"a\":[-12,18446744073709551615,0.5,true,null],\"b\":{}}"])
+
+	TEST(@"Escaping of strings", R([writer reset]) &&
+	    R([writer writeString: @"a\"b\\c\x01\td\xC3\xA4"]) &&
+	    [writer.string isEqual: @"\"a\\\"b\\\\c\\u0001\\td\xC3\xA4\""])
+
+	TEST(@"-[setOptions:]", R([writer reset]) &&
+	    R(writer.options = OF_JSON_REPRESENTATION_PRETTY |
+	    OF_JSON_REPRESENTATION_JSON5) &&
+	    R([writer writeObject: [OFDictionary dictionaryWithKeysAndObjects:
+	    @"x", [OFArray arrayWithObjects: @"a\nb",
+	    [OFNumber numberWithDouble: INFINITY], [OFArray array], nil],
+	    nil]]) &&
+	    [writer.string isEqual:
+	    @"{\n\tx: [\n\t\t\"a\\\nb\",\n\t\tInfinity,\n\t\t[\n\t\t]\n\t]\n}"])
+
+	writer = [OFJSONWriter writer];
+	EXPECT_EXCEPTION(@"Detection of value without key",
+	    OFInvalidArgumentException,
+	    [writer beginObject]; [writer writeNull])
+
+	writer = [OFJSONWriter writer];
+	EXPECT_EXCEPTION(@"Detection of mismatched end",
+	    OFInvalidArgumentException, [writer beginArray]; [writer endObject])
+
+	writer = [OFJSONWriter writer];
+	EXPECT_EXCEPTION(@"Detection of multiple values",
+	    OFInvalidArgumentException, [writer writeNull]; [writer writeNull])
+
+	writer = [OFJSONWriter writer];
+	EXPECT_EXCEPTION(@"Detection of infinity without JSON5",
+	    OFInvalidArgumentException, [writer writeDouble: INFINITY])
+
+	stream = [[[JSONWriterTestsStream alloc] init] autorelease];
+	longString = [OFMutableString string];
+	for (size_t i = 0; i < 4096; i++)
+		[longString appendString: @"0123456789\n"];
+
+	TEST(@"+[writerWithStream:]",
+	    (writer = [OFJSONWriter writerWithStream: stream]) &&
+	    R([writer beginArray]) && R([writer writeString: longString]) &&
+	    R([writer writeString: longString]) && R([writer endArray]) &&
+	    writer.data.count == 0 &&
+	    [[OFString stringWithUTF8String: stream->_data.items
+				     length: stream->_data.count]
+	    .objectByParsingJSON isEqual: [OFArray arrayWithObjects:
+	    longString, longString, nil]])
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
@@ -195,11 +195,29 @@ static OFString *module;
 }
 @end
 
+@interface MovedStreamTest: OFObject <OFKernelEventObserverDelegate>
+{
+@public
+	id _readyObject;
+}
+@end
+
+@implementation MovedStreamTest
+- (void)objectIsReadyForReading: (id)object
+{
+	_readyObject = object;
+}
+@end
+
 @implementation TestsAppDelegate (OFKernelEventObserverTests)
 - (void)kernelEventObserverTestsWithClass: (Class)class
 {
 	void *pool = objc_autoreleasePoolPush();
 	ObserverTest *test;
+	MovedStreamTest *movedTest;
+	OFKernelEventObserver *observer;
+	OFTCPSocket *server, *client, *accepted;
+	uint16_t port;
 
 	module = [class className];
 	test = [[[ObserverTest alloc]
@@ -214,6 +232,33 @@ static OFString *module;
 	[test run];
 	_fails += test->_fails;
 
+	/*
+	 * A stream with data in its read buffer, but none on the socket, that
+	 * is moved to another observer before the first one handled it.
+	 */
+	server = [OFTCPSocket socket];
+	port = [server bindToHost: @"127.0.0.1"
+			     port: 0];
+	[server listen];
+	client = [OFTCPSocket socket];
+	[client connectToHost: @"127.0.0.1"
+			 port: port];
+	accepted = [server accept];
+
+	[test->_observer addObjectForReading: accepted];
+	[accepted unreadFromBuffer: "x"
+			    length: 1];
+	[test->_observer removeObjectForReading: accepted];
+
+	movedTest = [[[MovedStreamTest alloc] init] autorelease];
+	observer = [class observer];
+	observer.delegate = movedTest;
+
+	TEST(@"-[observe] with buffered data after moving the stream",
+	    R([observer addObjectForReading: accepted]) &&
+	    R([observer observeForTimeInterval: 0]) &&
+	    movedTest->_readyObject == accepted)
+
 	objc_autoreleasePoolPop(pool);
 }
 
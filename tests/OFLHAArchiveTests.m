@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFLHAArchive";
+
+/*
+ * An archive with level 2 headers containing lh5.txt, lh6.txt and lh7.txt,
+ * compressed with the respective method. The contents are generated by
+ * LHAText(). Each file is split into several blocks, some of which use the
+ * single code form for a tree, and ends with a block of a single literal.
+ */
+static const unsigned char archive[2091] = {
+	0x29, 0x00, 0x2D, 0x6C, 0x68, 0x35, 0x2D, 0x19, 0x02, 0x00, 0x00, 0xAC,
+	0x1D, 0x00, 0x00, 0x00, 0xCA, 0x9A, 0x3B, 0x20, 0x02, 0xF9, 0xEC, 0x55,
+	0x05, 0x00, 0x00, 0x61, 0xB3, 0x0A, 0x00, 0x01, 0x6C, 0x68, 0x35, 0x2E,
+	0x74, 0x78, 0x74, 0x00, 0x00, 0x00, 0x96, 0x53, 0x43, 0x01, 0x98, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x0E, 0x00, 0x00, 0x00, 0x70, 0x01, 0xC0, 0x6C,
+	0x21, 0x66, 0x40, 0x48, 0x89, 0x10, 0x66, 0x4A, 0x95, 0xB2, 0x53, 0x66,
+	0x5C, 0x8D, 0x0B, 0xC5, 0xE3, 0x40, 0x85, 0x2B, 0x12, 0xA7, 0x6C, 0x00,
+	0xA1, 0xC1, 0x96, 0x7E, 0x7E, 0xA7, 0x79, 0xFE, 0x26, 0x6B, 0x37, 0x7B,
+	0xB4, 0x07, 0x2E, 0xCD, 0x18, 0x02, 0xC2, 0x05, 0xFF, 0x9C, 0x72, 0x20,
+	0x26, 0xA0, 0x44, 0xDB, 0xB4, 0x7B, 0xF1, 0xF7, 0x7F, 0x10, 0xD2, 0xED,
+	0xD7, 0xCB, 0xAF, 0xE4, 0x21, 0x5F, 0xD3, 0xB8, 0x35, 0x60, 0x1D, 0xE9,
+	0x8B, 0xB1, 0x8B, 0xDA, 0x97, 0x03, 0x8C, 0x50, 0xB1, 0x83, 0x47, 0x0F,
+	0x20, 0x44, 0x91, 0x32, 0x85, 0x4B, 0x17, 0x30, 0x64, 0xD1, 0xB3, 0x87,
+	0x4F, 0x1F, 0x40, 0x85, 0x12, 0x34, 0x89, 0x53, 0x27, 0x50, 0xA5, 0x52,
+	0xB5, 0x8B, 0x57, 0x2F, 0x60, 0x03, 0x16, 0x4C, 0xDA, 0x35, 0x6C, 0xDD,
+	0xC3, 0x97, 0x4E, 0xDE, 0x3D, 0x7C, 0xFE, 0x04, 0x18, 0x50, 0xE2, 0x45,
+	0x8D, 0x1E, 0x44, 0x99, 0x40, 0xCB, 0x99, 0x36, 0x74, 0xFA, 0x14, 0x69,
+	0x53, 0xA9, 0x54, 0x2A, 0xD5, 0xEC, 0x59, 0xB5, 0x6E, 0xE0, 0x04, 0xB2,
+	0xC0, 0x58, 0x00, 0xA7, 0x64, 0x42, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x35, 0x35, 0x75, 0xB5, 0xF6,
+	0x36, 0x76, 0xB6, 0xF7, 0x37, 0x77, 0xB7, 0xF8, 0x38, 0x78, 0xB8, 0xF9,
+	0x39, 0x79, 0xB9, 0xFA, 0x3A, 0x7A, 0xBA, 0xFB, 0x3B, 0x7B, 0xBB, 0xFC,
+	0x3C, 0x7C, 0xBC, 0xFD, 0x3D, 0x7D, 0xBD, 0xFE, 0x3E, 0x7E, 0xBE, 0xFF,
+	0x3F, 0x7F, 0xBF, 0xC0, 0x01, 0x04, 0x0C, 0x20, 0x50, 0xC1, 0xC4, 0x09,
+	0x14, 0x2C, 0x60, 0xD1, 0xC3, 0xC8, 0x11, 0x24, 0x4C, 0xA1, 0x52, 0xC5,
+	0xCC, 0x19, 0x34, 0x6C, 0xE1, 0xD3, 0xC7, 0xD0, 0x21, 0x44, 0x8D, 0x22,
+	0x54, 0xC9, 0xD4, 0x29, 0x54, 0xAD, 0x62, 0xD5, 0xCB, 0xD8, 0x31, 0x64,
+	0xCD, 0xA3, 0x56, 0xCD, 0xDC, 0x39, 0x74, 0xED, 0xE3, 0xD7, 0xCF, 0xE0,
+	0x41, 0x85, 0x0E, 0x24, 0x58, 0xD1, 0xE4, 0x49, 0x95, 0x2E, 0x64, 0xD9,
+	0xD3, 0xE8, 0x51, 0xA5, 0x4E, 0xA5, 0x5A, 0xD5, 0xEC, 0x59, 0xB5, 0x6E,
+	0xE5, 0xDB, 0xD7, 0xF0, 0x61, 0xC5, 0x8F, 0x26, 0x5C, 0xD9, 0xF4, 0x69,
+	0x00, 0x8C, 0x55, 0x6E, 0x92, 0xC3, 0xFE, 0x8E, 0xA0, 0x1D, 0x94, 0xF3,
+	0x74, 0x02, 0x81, 0x52, 0x43, 0x80, 0x1F, 0x38, 0xE0, 0x52, 0xE8, 0x00,
+	0x08, 0x4A, 0x17, 0xDC, 0xE9, 0x6A, 0x20, 0x53, 0xB6, 0x70, 0x00, 0x0A,
+	0xC1, 0x54, 0x09, 0xBB, 0x7F, 0x0E, 0x3C, 0xB9, 0xF4, 0xEB, 0xDB, 0xBF,
+	0x8F, 0x3E, 0xBD, 0xFC, 0x2F, 0x45, 0xE8, 0xBD, 0x17, 0xA2, 0xF4, 0x5E,
+	0x8B, 0xD1, 0x7A, 0x2F, 0x45, 0xE8, 0xBD, 0x17, 0xA2, 0xF4, 0x5E, 0x8B,
+	0xD1, 0x7A, 0x2F, 0x45, 0xE8, 0xBD, 0x17, 0xA2, 0xF4, 0x5E, 0xBF, 0xBD,
+	0x7E, 0xE7, 0xAF, 0x9D, 0x59, 0x2B, 0xDE, 0x89, 0x33, 0x49, 0x7E, 0xD6,
+	0x14, 0xB3, 0x1C, 0x35, 0x64, 0x4B, 0x90, 0xD6, 0x98, 0x24, 0xC7, 0x97,
+	0x3A, 0x43, 0x4C, 0x51, 0xA6, 0x8F, 0xBE, 0xEC, 0x56, 0x36, 0xEC, 0x4B,
+	0x70, 0xBB, 0x36, 0x62, 0xBE, 0x7B, 0x3E, 0x7C, 0xF7, 0xCF, 0xA0, 0xF9,
+	0xF4, 0x5F, 0x3E, 0x93, 0xE7, 0xD3, 0x7C, 0xFA, 0x8F, 0x9F, 0x54, 0x55,
+	0xF2, 0xDC, 0x02, 0xE1, 0x51, 0x71, 0x28, 0xB8, 0xD4, 0x5C, 0x8A, 0x2E,
+	0x55, 0x17, 0x32, 0x8B, 0x9D, 0x45, 0xD0, 0xA2, 0xE9, 0x61, 0x74, 0xB4,
+	0xBF, 0xE5, 0x8B, 0xA5, 0x85, 0xD2, 0xC2, 0xE9, 0x61, 0x74, 0xB0, 0xBA,
+	0x58, 0x5D, 0x2C, 0x2E, 0x96, 0x17, 0x48, 0x00, 0x40, 0x00, 0x00, 0x2D,
+	0x00, 0x00, 0x29, 0x00, 0x2D, 0x6C, 0x68, 0x36, 0x2D, 0x97, 0x02, 0x00,
+	0x00, 0x6C, 0x7B, 0x00, 0x00, 0x00, 0xCA, 0x9A, 0x3B, 0x20, 0x02, 0xD7,
+	0x15, 0x55, 0x05, 0x00, 0x00, 0x75, 0xDF, 0x0A, 0x00, 0x01, 0x6C, 0x68,
+	0x36, 0x2E, 0x74, 0x78, 0x74, 0x00, 0x00, 0x00, 0x96, 0x5A, 0x63, 0x02,
+	0x18, 0xFF, 0x7B, 0xFF, 0xCF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x03, 0x92, 0x86, 0x14, 0xA2, 0x91, 0x4C, 0x0A, 0x64, 0x65,
+	0x4C, 0x48, 0xC0, 0xC2, 0xC0, 0x52, 0x92, 0x9A, 0x53, 0x13, 0x32, 0x52,
+	0x99, 0x94, 0x61, 0x64, 0x60, 0x61, 0x31, 0x00, 0x0C, 0x35, 0xB5, 0xD9,
+	0xC9, 0xB7, 0xB6, 0xC1, 0x7B, 0xB9, 0x16, 0xEF, 0x52, 0x8E, 0x8E, 0x77,
+	0x34, 0xFC, 0xB0, 0x01, 0x94, 0x79, 0x6D, 0xF9, 0xF1, 0xEE, 0xD6, 0xFD,
+	0x57, 0xC2, 0xEB, 0xA5, 0x57, 0x1E, 0x9E, 0x97, 0x73, 0x83, 0xE0, 0x97,
+	0x35, 0x76, 0x3E, 0x82, 0x66, 0xCB, 0xD7, 0x6A, 0xC0, 0x29, 0xDE, 0xC1,
+	0xC7, 0x96, 0x20, 0x5D, 0x01, 0x7D, 0x03, 0xFB, 0xFC, 0xFD, 0x08, 0x17,
+	0xFB, 0xFC, 0x30, 0x71, 0x02, 0x45, 0x0B, 0x18, 0x34, 0x70, 0xF2, 0x04,
+	0x49, 0x13, 0x28, 0x54, 0xB1, 0x73, 0x06, 0x4D, 0x1B, 0x38, 0x74, 0xF1,
+	0xF4, 0x08, 0x51, 0x23, 0x48, 0x95, 0x32, 0x75, 0x0A, 0x55, 0x2B, 0x58,
+	0xB5, 0x72, 0xF6, 0x0C, 0x59, 0x33, 0x68, 0xD5, 0xB3, 0x77, 0x0E, 0x5D,
+	0x3B, 0x78, 0xF5, 0xF3, 0xF8, 0x10, 0x61, 0x43, 0x89, 0x16, 0x34, 0x79,
+	0x12, 0x65, 0x4B, 0x99, 0x36, 0x74, 0xF0, 0x28, 0x00, 0x4B, 0x2C, 0x05,
+	0x80, 0x0A, 0x76, 0x44, 0x2F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9,
+	0xDA, 0xDB, 0xDC, 0xDD, 0xDE, 0xDF, 0xE0, 0xE1, 0xE2, 0xE3, 0xE4, 0xE5,
+	0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xEB, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1,
+	0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA, 0xFB, 0xFC, 0xFD,
+	0xFE, 0xFF, 0x00, 0x04, 0x10, 0x30, 0x81, 0x43, 0x07, 0x10, 0x24, 0x50,
+	0xB1, 0x83, 0x47, 0x0F, 0x20, 0x44, 0x91, 0x32, 0x85, 0x4B, 0x17, 0x30,
+	0x64, 0xD1, 0xB3, 0x87, 0x4F, 0x1F, 0x40, 0x85, 0x12, 0x34, 0x89, 0x53,
+	0x27, 0x50, 0xA5, 0x52, 0xB5, 0x8B, 0x57, 0x2F, 0x60, 0xC5, 0x93, 0x36,
+	0x8D, 0x5B, 0x37, 0x70, 0xE5, 0xD3, 0xB7, 0x8F, 0x5F, 0x3F, 0x81, 0x06,
+	0x14, 0x38, 0x91, 0x63, 0x47, 0x91, 0x26, 0x54, 0xB9, 0x93, 0x67, 0x4F,
+	0xA1, 0x46, 0x95, 0x3A, 0x95, 0x6B, 0x57, 0xB1, 0x66, 0xD5, 0xBB, 0x97,
+	0x6F, 0x5F, 0xC1, 0x87, 0x16, 0x3C, 0x99, 0x73, 0x67, 0xD1, 0xA4, 0x02,
+	0x59, 0x4D, 0xB2, 0x80, 0x29, 0x9F, 0xEC, 0x0C, 0xFD, 0xCE, 0xAD, 0xD8,
+	0x0A, 0xB4, 0x44, 0x84, 0x50, 0x42, 0x44, 0x63, 0x00, 0x00, 0x0C, 0x23,
+	0x57, 0x65, 0x5F, 0xA0, 0x00, 0x00, 0x00, 0x40, 0x00, 0x03, 0x75, 0xF8,
+	0x63, 0x96, 0x7A, 0x6B, 0xB6, 0xFC, 0x73, 0xD7, 0x7E, 0x1E, 0x8F, 0x47,
+	0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8,
+	0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D,
+	0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47,
+	0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8,
+	0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D,
+	0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47,
+	0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8,
+	0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D,
+	0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47,
+	0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8,
+	0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD7, 0xAF, 0x5F, 0x75, 0x6F,
+	0xFD, 0xFE, 0x11, 0x4D, 0x2C, 0x2A, 0xB2, 0x79, 0x28, 0x84, 0x75, 0xD3,
+	0x68, 0x02, 0xA2, 0x95, 0x8D, 0xB2, 0xA5, 0x2F, 0xE3, 0xD8, 0x01, 0xDE,
+	0x54, 0x1E, 0xF5, 0x55, 0x58, 0x13, 0x82, 0xA8, 0x11, 0x5F, 0xA2, 0xAA,
+	0x2B, 0x87, 0x17, 0x02, 0xFB, 0xD5, 0x60, 0x00, 0x1A, 0x00, 0xBB, 0x63,
+	0xF5, 0x34, 0x8A, 0xB2, 0xB2, 0xEC, 0x22, 0x99, 0xFD, 0xBE, 0x31, 0xDF,
+	0x75, 0x7E, 0xF6, 0xD6, 0x3E, 0x53, 0xFF, 0x3E, 0x4A, 0x67, 0xB9, 0x9F,
+	0xD2, 0x67, 0xF5, 0x99, 0xFD, 0xA6, 0x7F, 0x79, 0x9F, 0xE2, 0x67, 0xF9,
+	0x99, 0xFE, 0x85, 0x7F, 0x0E, 0x01, 0xC2, 0x87, 0x12, 0x1C, 0x68, 0x72,
+	0x21, 0xCA, 0x87, 0x32, 0x1C, 0xE8, 0x74, 0x21, 0xD2, 0xC7, 0x4B, 0xE3,
+	0xF2, 0xC7, 0x4B, 0x1D, 0x2C, 0x74, 0xB1, 0xD2, 0xC7, 0x4B, 0x1D, 0x2C,
+	0x74, 0xB1, 0xD2, 0x00, 0x10, 0x00, 0x00, 0x0B, 0x40, 0x00, 0x29, 0x00,
+	0x2D, 0x6C, 0x68, 0x37, 0x2D, 0xFF, 0x02, 0x00, 0x00, 0x9C, 0xF0, 0x00,
+	0x00, 0x00, 0xCA, 0x9A, 0x3B, 0x20, 0x02, 0xE7, 0xEC, 0x55, 0x05, 0x00,
+	0x00, 0xAC, 0x1A, 0x0A, 0x00, 0x01, 0x6C, 0x68, 0x37, 0x2E, 0x74, 0x78,
+	0x74, 0x00, 0x00, 0x00, 0x96, 0x52, 0x63, 0x01, 0x97, 0xEB, 0x80, 0x00,
+	0x00, 0x00, 0x00, 0x70, 0x00, 0x00, 0x00, 0x00, 0x01, 0x4C, 0x0D, 0x09,
+	0x95, 0x90, 0x44, 0x66, 0xF8, 0x0A, 0x64, 0x30, 0xB0, 0x29, 0x98, 0x61,
+	0x53, 0x2A, 0x92, 0x53, 0x4B, 0x0A, 0x4C, 0xAA, 0x32, 0x00, 0x0E, 0xAA,
+	0xC1, 0xB5, 0x88, 0x2C, 0x38, 0x12, 0x6D, 0x5F, 0xE6, 0xF7, 0xAC, 0x80,
+	0x3B, 0xB7, 0xD3, 0x4E, 0x39, 0x86, 0x3E, 0xCA, 0x7B, 0x7F, 0x9F, 0xBE,
+	0x3C, 0x1B, 0x5C, 0xCD, 0x77, 0xC7, 0x70, 0xB6, 0x7E, 0xED, 0xBF, 0x2F,
+	0xCC, 0xF0, 0x77, 0x20, 0xD0, 0x16, 0xBB, 0x9A, 0xA7, 0xD1, 0xF9, 0x58,
+	0x10, 0x23, 0x27, 0xFF, 0xCA, 0xB8, 0x60, 0x03, 0x88, 0x12, 0x28, 0x58,
+	0xC1, 0xA3, 0x87, 0x90, 0x22, 0x48, 0x99, 0x42, 0xA5, 0x8B, 0x98, 0x32,
+	0x68, 0xD9, 0xC3, 0xA7, 0x8F, 0xA0, 0x42, 0x89, 0x1A, 0x44, 0xA9, 0x93,
+	0xA8, 0x52, 0xA9, 0x5A, 0xC5, 0xAB, 0x81, 0x5E, 0xC1, 0x8B, 0x26, 0x6D,
+	0x1A, 0xB6, 0x6E, 0xE1, 0xCB, 0xA7, 0x6F, 0x1E, 0xBE, 0x7F, 0x02, 0x0C,
+	0x28, 0x71, 0x22, 0xC6, 0x8F, 0x22, 0x4C, 0xA9, 0x73, 0x26, 0xCE, 0x9F,
+	0x42, 0x8D, 0x2A, 0x75, 0x2A, 0xD6, 0xAF, 0x62, 0xC8, 0x04, 0xB2, 0xC0,
+	0x58, 0x00, 0xA7, 0x64, 0x42, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0D, 0x4D, 0x5D, 0x6D, 0x7D, 0x8D,
+	0x9D, 0xAD, 0xBD, 0xCD, 0xDD, 0xED, 0xFE, 0x0E, 0x1E, 0x2E, 0x3E, 0x4E,
+	0x5E, 0x6E, 0x7E, 0x8E, 0x9E, 0xAE, 0xBE, 0xCE, 0xDE, 0xEE, 0xFF, 0x0F,
+	0x1F, 0x2F, 0x3F, 0x4F, 0x5F, 0x6F, 0x7F, 0x8F, 0x9F, 0xAF, 0xBF, 0xCF,
+	0xDF, 0xEF, 0xF0, 0x00, 0x41, 0x03, 0x08, 0x14, 0x30, 0x71, 0x02, 0x45,
+	0x0B, 0x18, 0x34, 0x70, 0xF2, 0x04, 0x49, 0x13, 0x28, 0x54, 0xB1, 0x73,
+	0x06, 0x4D, 0x1B, 0x38, 0x74, 0xF1, 0xF4, 0x08, 0x51, 0x23, 0x48, 0x95,
+	0x32, 0x75, 0x0A, 0x55, 0x2B, 0x58, 0xB5, 0x72, 0xF6, 0x0C, 0x59, 0x33,
+	0x68, 0xD5, 0xB3, 0x77, 0x0E, 0x5D, 0x3B, 0x78, 0xF5, 0xF3, 0xF8, 0x10,
+	0x61, 0x43, 0x89, 0x16, 0x34, 0x79, 0x12, 0x65, 0x4B, 0x99, 0x36, 0x74,
+	0xFA, 0x14, 0x69, 0x53, 0xA9, 0x56, 0xB5, 0x7B, 0x16, 0x6D, 0x5B, 0xB9,
+	0x76, 0xF5, 0xFC, 0x18, 0x71, 0x63, 0xC9, 0x97, 0x36, 0x7D, 0x1A, 0x40,
+	0x25, 0x90, 0x02, 0x18, 0x0C, 0xFF, 0xA6, 0xC0, 0x00, 0x1E, 0x77, 0x60,
+	0x22, 0x53, 0xA5, 0x6D, 0x7C, 0x67, 0x5B, 0xE7, 0x7D, 0xF8, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A, 0x7A,
+	0x7A, 0x00, 0x96, 0x56, 0x8C, 0xC0, 0x6C, 0x8F, 0xFB, 0x9D, 0x80, 0x3F,
+	0x75, 0x3C, 0x1C, 0x8C, 0x05, 0x74, 0x84, 0x00, 0xFE, 0xAA, 0xAA, 0xAC,
+	0x71, 0xB0, 0x5E, 0xED, 0xB0, 0x42, 0xC8, 0x6F, 0x62, 0x00, 0x01, 0xA0,
+	0x40, 0x00, 0x00, 0xCF, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E,
+	0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3,
+	0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4,
+	0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E,
+	0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3,
+	0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4,
+	0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E,
+	0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3,
+	0xD1, 0xE8, 0xF4, 0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xA3, 0xD1, 0xE8, 0xF4,
+	0x7A, 0x3D, 0x1E, 0x8F, 0x47, 0xAD, 0x5E, 0xB4, 0xFA, 0xA7, 0xF7, 0x71,
+	0x8E, 0x5E, 0x66, 0x8A, 0x2C, 0xF5, 0xD7, 0xE4, 0x74, 0xA6, 0x57, 0x7F,
+	0x8E, 0xF2, 0xBE, 0x3D, 0xD9, 0xFA, 0x7A, 0xA2, 0x56, 0xCD, 0x4C, 0x57,
+	0x96, 0xEF, 0xBC, 0xF1, 0xC2, 0x3B, 0x4B, 0xC6, 0xDD, 0x9B, 0xF3, 0x9F,
+	0xC3, 0x39, 0xE0, 0x06, 0x69, 0x01, 0x8C, 0x20, 0x0C, 0xBF, 0x07, 0x68,
+	0x06, 0x6F, 0x5C, 0xB0, 0x00, 0x01, 0x00, 0x57, 0x1A, 0x7F, 0x3A, 0x7F,
+	0x5A, 0x7F, 0x7A, 0x7F, 0x9A, 0x7F, 0xBA, 0x7F, 0xC5, 0x7F, 0xEE, 0x03,
+	0x86, 0x1C, 0x50, 0xE3, 0x87, 0x24, 0x39, 0x61, 0xCD, 0x0E, 0x78, 0x74,
+	0x43, 0xA6, 0x9D, 0x37, 0xFF, 0x96, 0x74, 0xD3, 0xA6, 0x9D, 0x34, 0xE9,
+	0xA7, 0x4D, 0x3A, 0x69, 0xD3, 0x4E, 0x90, 0x00, 0x80, 0x00, 0x00, 0x5A,
+	0x00, 0x00, 0x00
+};
+
+static OFData *
+LHAText(uint32_t seed, size_t fillLength)
+{
+	OFMutableData *text = [OFMutableData data];
+	unsigned char random[64];
+	uint32_t state = seed;
+
+	for (size_t i = 0; i < 64; i++) {
+		state = state * 1103515245 + 12345;
+		random[i] = state >> 24;
+	}
+
+	/* The second copy of random needs the full distance to be found. */
+	[text addItems: random
+		 count: 64];
+	for (size_t i = 0; i < fillLength; i++) {
+		unsigned char byte = i % 251;
+
+		[text addItem: &byte];
+	}
+	[text addItems: random
+		 count: 64];
+
+	for (int i = 0; i < 30; i++) {
+		OFString *line = [OFString stringWithFormat:
+		    @"%d: The quick brown fox jumps over the lazy dog.\n", i];
+
+		[text addItems: line.UTF8String
+			 count: line.UTF8StringLength];
+	}
+
+	[text addItems: "ZZZZZZZZ"
+		 count: 8];
+
+	[text makeImmutable];
+
+	return text;
+}
+
+@implementation TestsAppDelegate (OFLHAArchiveTests)
+- (void)LHAArchiveTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	static const struct {
+		OFString *fileName, *compressionMethod;
+		uint32_t seed;
+		size_t fillLength;
+		uint16_t CRC16;
+	} entries[] = {
+		{ @"lh5.txt", @"-lh5-", 5, 6000, 0xECF9 },
+		{ @"lh6.txt", @"-lh6-", 6, 30000, 0x15D7 },
+		{ @"lh7.txt", @"-lh7-", 7, 60000, 0xECE7 }
+	};
+	static const size_t readLengths[] = { 1, 100, 0 };
+	OFData *data = [OFData dataWithItems: archive
+				       count: sizeof(archive)];
+	bool ok;
+
+	ok = true;
+	for (size_t i = 0; i < 3; i++) {
+		TestsMemoryStream *stream = [[[TestsMemoryStream alloc]
+		    initWithData: data] autorelease];
+		OFLHAArchive *LHAArchive;
+
+		stream.maxReadLength = readLengths[i];
+		LHAArchive = [OFLHAArchive archiveWithStream: stream
+							mode: @"r"];
+
+		for (size_t j = 0; j < 3; j++) {
+			OFLHAArchiveEntry *entry = [LHAArchive nextEntry];
+			OFData *text = LHAText(entries[j].seed,
+			    entries[j].fillLength);
+
+			if (![entry.fileName isEqual: entries[j].fileName] ||
+			    ![entry.compressionMethod isEqual:
+			    entries[j].compressionMethod] ||
+			    entry.uncompressedSize != text.count ||
+			    entry.CRC16 != entries[j].CRC16 ||
+			    ![[LHAArchive.streamForReadingCurrentEntry
+			    readDataUntilEndOfStream] isEqual: text])
+				ok = false;
+		}
+
+		if ([LHAArchive nextEntry] != nil)
+			ok = false;
+	}
+	TEST(@"Decompressing -lh5-, -lh6- and -lh7- entries", ok)
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
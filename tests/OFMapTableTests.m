@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#import "TestsAppDelegate.h"
+
+#define NUM_KEYS 10000
+
+static OFString *module = @"OFMapTable";
+
+static unsigned long
+collidingHash(void *key)
+{
+	/*
+	 * Every two keys collide and the first home buckets are at the end, so
+	 * that probing and shifting back wraps around.
+	 */
+	return ~0UL - ((uintptr_t)key & ~1UL);
+}
+
+static bool
+checkKeys(OFMapTable *mapTable, size_t step)
+{
+	size_t count = 0;
+
+	for (size_t i = 1; i <= NUM_KEYS; i++) {
+		void *key = (void *)(uintptr_t)i;
+		void *object = [mapTable objectForKey: key];
+
+		if ((i % step == 0) != (object == key))
+			return false;
+	}
+
+	for (void *key in mapTable) {
+		if ((uintptr_t)key % step != 0)
+			return false;
+
+		count++;
+	}
+
+	return (count == mapTable.count && count == NUM_KEYS / step);
+}
+
+@implementation TestsAppDelegate (OFMapTableTests)
+- (void)mapTableTestsWithKeyFunctions: (of_map_table_functions_t)keyFunctions
+{
+	OFMapTable *mapTable;
+
+	TEST(@"+[mapTableWithKeyFunctions:objectFunctions:]",
+	    (mapTable = [OFMapTable
+	    mapTableWithKeyFunctions: keyFunctions
+		     objectFunctions: (of_map_table_functions_t){ NULL }]))
+
+	for (size_t i = 1; i <= NUM_KEYS; i++)
+		[mapTable setObject: (void *)(uintptr_t)i
+			     forKey: (void *)(uintptr_t)i];
+
+	TEST(@"-[setObject:forKey:]", checkKeys(mapTable, 1))
+
+	for (size_t i = 1; i <= NUM_KEYS; i += 2)
+		[mapTable removeObjectForKey: (void *)(uintptr_t)i];
+
+	TEST(@"-[removeObjectForKey:]", checkKeys(mapTable, 2))
+
+	for (size_t i = 1; i <= NUM_KEYS; i++)
+		if (i % 10 != 0)
+			[mapTable removeObjectForKey: (void *)(uintptr_t)i];
+
+	TEST(@"-[removeObjectForKey:] with shrinking",
+	    checkKeys(mapTable, 10))
+
+	TEST(@"-[copy]", [[[mapTable copy] autorelease] isEqual: mapTable])
+
+	TEST(@"-[removeAllObjects]", R([mapTable removeAllObjects]) &&
+	    mapTable.count == 0 &&
+	    [mapTable objectForKey: (void *)(uintptr_t)10] == NULL)
+}
+
+- (void)mapTableTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	of_map_table_functions_t keyFunctions = { NULL };
+
+	[self mapTableTestsWithKeyFunctions: keyFunctions];
+
+	module = @"OFMapTable with colliding hashes";
+	keyFunctions.hash = collidingHash;
+	[self mapTableTestsWithKeyFunctions: keyFunctions];
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
@@ -83,12 +83,71 @@ static OFString *module = @"OFObject";
 }
 @end
 
+static bool deallocTrackerDeallocated = false;
+
+@interface DeallocTracker: OFObject
+@end
+
+@implementation DeallocTracker
+- (void)dealloc
+{
+	deallocTrackerDeallocated = true;
+
+	[super dealloc];
+}
+@end
+
+#ifdef OF_HAVE_THREADS
+@interface RetainReleaseThread: OFThread
+{
+@public
+	id _object;
+	bool _releases;
+}
+@end
+
+@implementation RetainReleaseThread
+- (id)main
+{
+	for (size_t i = 0; i < 1000; i++) {
+		if (_releases)
+			[_object release];
+		else
+			[_object retain];
+	}
+
+	return nil;
+}
+@end
+
+@interface AllocatingThread: OFThread
+{
+@public
+	id _object;
+}
+@end
+
+@implementation AllocatingThread
+- (id)main
+{
+	/* The reference is released by the main thread. */
+	_object = [[DeallocTracker alloc] init];
+
+	return nil;
+}
+@end
+#endif
+
 @implementation TestsAppDelegate (OFObjectTests)
 - (void)objectTests
 {
 	void *pool = objc_autoreleasePoolPush();
 	OFObject *o;
 	MyObj *m;
+#ifdef OF_HAVE_THREADS
+	RetainReleaseThread *thread;
+	AllocatingThread *allocatingThread;
+#endif
 
 	TEST(@"+[description]",
 	    [[OFObject description] isEqual: @"OFObject"] &&
@@ -216,6 +275,35 @@ static OFString *module = @"OFObject";
 	       forKeyPath: @"objectValue.objectValue.doubleValue"]) &&
 	    [[m.objectValue objectValue] doubleValue] == 0.75)
 
+#ifdef OF_HAVE_THREADS
+	o = [[DeallocTracker alloc] init];
+	for (size_t i = 0; i < 1000; i++)
+		[o retain];
+
+	thread = [RetainReleaseThread thread];
+	thread->_object = o;
+	thread->_releases = true;
+	TEST(@"-[release] from another thread",
+	    R([thread start]) && R([thread join]) && o.retainCount == 1)
+
+	thread = [RetainReleaseThread thread];
+	thread->_object = o;
+	TEST(@"-[retain] from another thread",
+	    R([thread start]) && R([thread join]) && o.retainCount == 1001)
+
+	for (size_t i = 0; i < 1000; i++)
+		[o release];
+
+	TEST(@"-[release] of references retained by another thread",
+	    o.retainCount == 1 && R([o release]) && deallocTrackerDeallocated)
+
+	deallocTrackerDeallocated = false;
+	allocatingThread = [AllocatingThread thread];
+	TEST(@"-[release] of an object allocated by an exited thread",
+	    R([allocatingThread start]) && R([allocatingThread join]) &&
+	    R([allocatingThread->_object release]) && deallocTrackerDeallocated)
+#endif
+
 	objc_autoreleasePoolPop(pool);
 }
 @end
@@ -46,6 +46,23 @@ static uint16_t sutf16str[] = {
 	0xFFFE, 0x6600, 0xF600, 0xF600, 0x6200, 0xE400, 0x7200, 0x3CD8, 0x3ADC,
 	0
 };
+/* The key 00 01 ... 0F of the SipHash reference test vectors */
+static const uint64_t sipHashKey[2] = {
+	UINT64_C(0x0706050403020100), UINT64_C(0x0F0E0D0C0B0A0908)
+};
+/* SipHash-1-3 of the message 00 01 ... (length - 1) */
+static const struct {
+	size_t length;
+	uint64_t hash;
+} sipHashVectors[] = {
+	{  0, UINT64_C(0xABAC0158050FC4DC) },
+	{  1, UINT64_C(0xC9F49BF37D57CA93) },
+	{  7, UINT64_C(0xD3927D989BB11140) },
+	{  8, UINT64_C(0x369095118D299A8E) },
+	{ 15, UINT64_C(0xD320D86D2A519956) },
+	{ 16, UINT64_C(0xCC4FDD1A7D908B66) },
+	{ 63, UINT64_C(0x9D199062B7BBB3A8) }
+};
 
 @interface SimpleString: OFString
 {
@@ -278,7 +295,7 @@ static uint16_t sutf16str[] = {
 
 	TEST(@"-[length]", s[0].length == 7)
 	TEST(@"-[UTF8StringLength]", s[0].UTF8StringLength == 13)
-	TEST(@"-[hash]", s[0].hash == 0x705583C0)
+	TEST(@"-[hash]", s[0].hash == @"täs€1𝄞3".hash)
 
 	TEST(@"-[characterAtIndex:]", [s[0] characterAtIndex: 0] == 't' &&
 	    [s[0] characterAtIndex: 1] == 0xE4 &&
@@ -1428,6 +1445,112 @@ static uint16_t sutf16str[] = {
 	objc_autoreleasePoolPop(pool);
 }
 
+#ifdef OF_OBJFW_RUNTIME
+- (void)taggedPointerStringTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *string;
+	OFMutableString *mutableString;
+
+	TEST(@"Only short ASCII strings are tagged pointers",
+	    (string = [OFString stringWithUTF8String: "abc"]) &&
+	    object_isTaggedPointer(string) &&
+	    object_isTaggedPointer([OFString string]) &&
+	    !object_isTaggedPointer(
+	    [OFString stringWithUTF8String: "abcdefghijklmnop"]) &&
+	    !object_isTaggedPointer(
+	    [OFString stringWithUTF8String: "\xC3\xA4"]))
+
+	TEST(@"-[length] and -[characterAtIndex:]",
+	    string.length == 3 && [string characterAtIndex: 2] == 'c')
+
+	EXPECT_EXCEPTION(@"Detect out of range in -[characterAtIndex:]",
+	    OFOutOfRangeException, [string characterAtIndex: 3])
+
+	TEST(@"-[UTF8String]", string.UTF8StringLength == 3 &&
+	    strcmp(string.UTF8String, "abc") == 0)
+
+	TEST(@"-[isEqual:]", [string isEqual: @"abc"] &&
+	    [@"abc" isEqual: string] && ![string isEqual: @"abd"] &&
+	    ![@"ab" isEqual: string] &&
+	    [string isEqual: [OFString stringWithUTF8String: "abc"]])
+
+	TEST(@"-[hash]", string.hash == @"abc".hash)
+
+	TEST(@"-[compare:]", [string compare: @"abd"] == OF_ORDERED_ASCENDING)
+
+	TEST(@"Dictionary lookup",
+	    [[[OFDictionary dictionaryWithObject: @"x"
+					  forKey: @"abc"] objectForKey: string]
+	    isEqual: @"x"] &&
+	    [[[OFDictionary dictionaryWithObject: @"x"
+					  forKey: string] objectForKey: @"abc"]
+	    isEqual: @"x"])
+
+	mutableString = [[string mutableCopy] autorelease];
+	TEST(@"-[mutableCopy] and -[appendString:]",
+	    R([mutableString appendString: string]) &&
+	    [mutableString isEqual: @"abcabc"] && mutableString.length == 6)
+
+	TEST(@"-[copy] of a mutable string", object_isTaggedPointer(
+	    [[[OFMutableString stringWithString: @"ab"] copy] autorelease]))
+
+	objc_autoreleasePoolPop(pool);
+}
+#endif
+
+- (void)stringHashTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	const char *UTF8Strings[] = {
+		"", "abc", "abcdefghijklmnopqrstuvwxyz",
+		"t\xC3\xA4s\xE2\x82\xAC"
+	};
+	unsigned char message[64];
+	bool ok = true;
+
+	for (size_t i = 0; i < sizeof(message); i++)
+		message[i] = (unsigned char)i;
+
+	for (size_t i = 0;
+	    i < sizeof(sipHashVectors) / sizeof(*sipHashVectors); i++)
+		if (of_siphash13(sipHashKey, message,
+		    sipHashVectors[i].length) != sipHashVectors[i].hash)
+			ok = false;
+
+	TEST(@"of_siphash13() reference vectors", ok)
+
+	/*
+	 * Strings are used as keys across classes, e.g. a constant string to
+	 * look up a key that was read from a file, so they need to agree.
+	 */
+	ok = true;
+	for (size_t i = 0; i < sizeof(UTF8Strings) / sizeof(*UTF8Strings);
+	    i++) {
+		const char *UTF8String = UTF8Strings[i];
+		OFString *string = [OFString stringWithUTF8String: UTF8String];
+		OFString *UTF8 = [[[OFUTF8String alloc]
+		    initWithUTF8String: UTF8String] autorelease];
+		OFString *simple =
+		    [SimpleString stringWithUTF8String: UTF8String];
+
+		if (string.hash != UTF8.hash || string.hash != simple.hash)
+			ok = false;
+	}
+
+	TEST(@"-[hash] is the same for all string classes", ok &&
+	    @"abc".hash == [SimpleString stringWithUTF8String: "abc"].hash)
+
+#ifdef OF_OBJFW_RUNTIME
+	TEST(@"-[hash] of tagged pointer strings matches other classes",
+	    object_isTaggedPointer([OFString stringWithUTF8String: "abc"]) &&
+	    [OFString stringWithUTF8String: "abc"].hash ==
+	    [[[OFUTF8String alloc] initWithUTF8String: "abc"] autorelease].hash)
+#endif
+
+	objc_autoreleasePoolPop(pool);
+}
+
 - (void)stringTests
 {
 	module = @"OFString";
@@ -1437,5 +1560,13 @@ static uint16_t sutf16str[] = {
 	module = @"OFString_UTF8";
 	[self stringTestsWithClass: [OFUTF8String class]
 		      mutableClass: [OFMutableUTF8String class]];
+
+	module = @"OFString hashing";
+	[self stringHashTests];
+
+#ifdef OF_OBJFW_RUNTIME
+	module = @"OFTaggedPointerString";
+	[self taggedPointerStringTests];
+#endif
 }
 @end
@@ -106,6 +106,9 @@
 	[of_stdout writeFormat: @"[OFSystemInfo] Supports AES-NI: %d\n",
 	    [OFSystemInfo supportsAESNI]];
 
+	[of_stdout writeFormat: @"[OFSystemInfo] Supports PCLMULQDQ: %d\n",
+	    [OFSystemInfo supportsPCLMULQDQ]];
+
 	[of_stdout writeFormat: @"[OFSystemInfo] Supports SHA extensions: %d\n",
 	    [OFSystemInfo supportsSHAExtensions]];
 #endif
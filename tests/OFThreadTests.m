@@ -34,6 +34,44 @@ static OFString *module = @"OFThread";
 }
 @end
 
+@interface ThreadPoolCounter: OFObject
+{
+@public
+	OFThreadPool *_threadPool;
+	size_t _count;
+}
+
+- (void)increase: (id)object;
+- (void)spawn: (OFNumber *)depth;
+@end
+
+@implementation ThreadPoolCounter
+- (void)increase: (id)object
+{
+	@synchronized (self) {
+		_count++;
+	}
+}
+
+- (void)spawn: (OFNumber *)depth
+{
+	unsigned int value = depth.unsignedIntValue;
+
+	[self increase: nil];
+
+	if (value == 0)
+		return;
+
+	depth = [OFNumber numberWithUnsignedInt: value - 1];
+	[_threadPool dispatchWithTarget: self
+			       selector: @selector(spawn:)
+				 object: depth];
+	[_threadPool dispatchWithTarget: self
+			       selector: @selector(spawn:)
+				 object: depth];
+}
+@end
+
 @implementation TestsAppDelegate (OFThreadTests)
 - (void)threadTests
 {
@@ -51,5 +89,50 @@ static OFString *module = @"OFThread";
 	    [d objectForKey: @"foo"] == nil)
 
 	objc_autoreleasePoolPop(pool);
+
+	[self threadPoolTestsWithWorkStealing: false];
+	[self threadPoolTestsWithWorkStealing: true];
+}
+
+- (void)threadPoolTestsWithWorkStealing: (bool)usesWorkStealing
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFString *module = (usesWorkStealing
+	    ? @"OFThreadPool (work stealing)" : @"OFThreadPool");
+	OFMutableArray *objects = [OFMutableArray array];
+	ThreadPoolCounter *counter =
+	    [[[ThreadPoolCounter alloc] init] autorelease];
+	OFThreadPool *threadPool;
+
+	for (size_t i = 0; i < 100; i++)
+		[objects addObject: [OFNumber numberWithSize: i]];
+
+	TEST(@"+[threadPoolWithSize:usesWorkStealing:]",
+	    (threadPool = [OFThreadPool threadPoolWithSize: 4
+					  usesWorkStealing: usesWorkStealing]))
+
+	counter->_threadPool = threadPool;
+
+	TEST(@"-[dispatchWithTarget:selector:object:]",
+	    R([threadPool dispatchWithTarget: counter
+				    selector: @selector(increase:)
+				      object: nil]))
+
+	TEST(@"-[dispatchWithTarget:selector:objects:]",
+	    R([threadPool dispatchWithTarget: counter
+				    selector: @selector(increase:)
+				     objects: objects]))
+
+	TEST(@"-[waitUntilDone]", R([threadPool waitUntilDone]) &&
+	    counter->_count == 101)
+
+	TEST(@"Dispatching from within jobs",
+	    R([threadPool dispatchWithTarget: counter
+				    selector: @selector(spawn:)
+				      object: [OFNumber numberWithUnsignedInt:
+						  10]]) &&
+	    R([threadPool waitUntilDone]) && counter->_count == 101 + 2047)
+
+	objc_autoreleasePoolPop(pool);
 }
 @end
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#import "TestsAppDelegate.h"
+
+static OFString *module = @"OFXMLReader";
+static const char document[] =
+    "\xEF\xBB\xBF<?xml version='1.0'?>\n"
+    "<!DOCTYPE root [<!ELEMENT root ANY>]>\n"
+    "<root xmlns='urn:a' xmlns:b=\"urn:b\" x='1' b:y='2&amp;3'>\n"
+    " <skip><deep a='>'/><!-- c --><b:x>y</b:x></skip>\n"
+    " <b:item>t&lt;x</b:item>\n"
+    " <empty/><![CDATA[<c>]]>\n"
+    "</root>\n"
+    "<!-- end -->\n";
+
+/* Returns the document in tiny pieces to hit every buffer boundary. */
+@interface XMLReaderTestsStream: OFStream
+{
+	size_t _position;
+}
+@end
+
+@implementation XMLReaderTestsStream
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= sizeof(document) - 1);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (length > 3)
+		length = 3;
+	if (length > sizeof(document) - 1 - _position)
+		length = sizeof(document) - 1 - _position;
+
+	memcpy(buffer, document + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
+
+@implementation TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFXMLReader *readers[2], *reader;
+
+	readers[0] = [OFXMLReader readerWithData:
+	    [OFData dataWithItems: document
+			    count: sizeof(document) - 1]];
+	readers[1] = [OFXMLReader readerWithStream:
+	    [[[XMLReaderTestsStream alloc] init] autorelease]];
+
+	for (size_t i = 0; i < 2; i++) {
+		reader = readers[i];
+		module = (i == 0
+		    ? @"OFXMLReader (data)" : @"OFXMLReader (stream)");
+
+		TEST(@"Processing instructions",
+		    [reader nextEvent] ==
+		    OF_XML_READER_EVENT_PROCESSING_INSTRUCTIONS &&
+		    [reader.string isEqual: @"xml version='1.0'"])
+
+		TEST(@"Start of root element",
+		    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "root") &&
+		    reader.prefix.length == 0 &&
+		    of_xml_reader_range_is_equal(reader.namespace, "urn:a") &&
+		    reader.depth == 1 && reader.attributesCount == 4)
+
+		TEST(@"Attributes",
+		    of_xml_reader_range_is_equal(
+		    [reader valueOfAttributeAtIndex: 2], "1") &&
+		    of_xml_reader_range_is_equal(
+		    [reader namespaceOfAttributeAtIndex: 1],
+		    "http://www.w3.org/2000/xmlns/") &&
+		    [reader indexOfAttributeWithName: "x"
+					   namespace: NULL] == 2 &&
+		    [reader indexOfAttributeWithName: "y"
+					   namespace: NULL] == OF_NOT_FOUND &&
+		    [reader indexOfAttributeWithName: "y"
+					   namespace: "urn:b"] == 3 &&
+		    of_xml_reader_range_is_equal(
+		    [reader valueOfAttributeAtIndex: 3], "2&amp;3") &&
+		    [[reader stringValueOfAttributeAtIndex: 3]
+		    isEqual: @"2&3"])
+
+		TEST(@"Characters",
+		    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS &&
+		    of_xml_reader_range_is_equal(reader.text, "\n "))
+
+		TEST(@"-[skipSubtree]",
+		    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "skip") &&
+		    R([reader skipSubtree]) &&
+		    reader.event == OF_XML_READER_EVENT_END_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "skip") &&
+		    reader.depth == 2 &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS)
+
+		TEST(@"Prefixed element",
+		    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "item") &&
+		    of_xml_reader_range_is_equal(reader.prefix, "b") &&
+		    of_xml_reader_range_is_equal(reader.namespace, "urn:b") &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS &&
+		    of_xml_reader_range_is_equal(reader.text, "t&lt;x") &&
+		    [reader.string isEqual: @"t<x"] &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_END_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "item") &&
+		    of_xml_reader_range_is_equal(reader.namespace, "urn:b"))
+
+		TEST(@"Empty element",
+		    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_START_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "empty") &&
+		    reader.depth == 2 &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_END_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "empty") &&
+		    of_xml_reader_range_is_equal(reader.namespace, "urn:a") &&
+		    reader.depth == 2)
+
+		TEST(@"CDATA",
+		    [reader nextEvent] == OF_XML_READER_EVENT_CDATA &&
+		    of_xml_reader_range_is_equal(reader.text, "<c>"))
+
+		TEST(@"End of root element",
+		    [reader nextEvent] == OF_XML_READER_EVENT_CHARACTERS &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_END_ELEMENT &&
+		    of_xml_reader_range_is_equal(reader.name, "root") &&
+		    reader.depth == 1)
+
+		TEST(@"End of document",
+		    [reader nextEvent] == OF_XML_READER_EVENT_COMMENT &&
+		    [reader.string isEqual: @" end "] &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_END_OF_DOCUMENT &&
+		    reader.depth == 0 &&
+		    [reader nextEvent] == OF_XML_READER_EVENT_END_OF_DOCUMENT)
+	}
+
+	module = @"OFXMLReader";
+
+	reader = [OFXMLReader readerWithData:
+	    [OFData dataWithItems: "<a><b></a></b>"
+			    count: 14]];
+	EXPECT_EXCEPTION(@"Detection of mismatched end tag",
+	    OFMalformedXMLException,
+	    [reader nextEvent]; [reader skipSubtree])
+
+	reader = [OFXMLReader readerWithData:
+	    [OFData dataWithItems: "<a><b>"
+			    count: 6]];
+	EXPECT_EXCEPTION(@"Detection of unclosed element",
+	    OFMalformedXMLException,
+	    [reader nextEvent]; [reader skipSubtree])
+
+	reader = [OFXMLReader readerWithData:
+	    [OFData dataWithItems: "<x:a/>"
+			    count: 6]];
+	EXPECT_EXCEPTION(@"Detection of unbound prefix",
+	    OFUnboundPrefixException, [reader nextEvent])
+
+	objc_autoreleasePoolPop(pool);
+}
+@end
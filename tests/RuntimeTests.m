@@ -20,6 +20,9 @@
 #import "TestsAppDelegate.h"
 
 static OFString *module = @"Runtime";
+#ifdef OF_OBJFW_RUNTIME
+static size_t deallocCount = 0;
+#endif
 
 @interface OFObject (SuperTest)
 - (id)superTest;
@@ -61,6 +64,83 @@ static OFString *module = @"Runtime";
 }
 @end
 
+#ifdef OF_OBJFW_RUNTIME
+@interface RuntimeAutoreleaseTest: OFObject
+@end
+
+@implementation RuntimeAutoreleaseTest
+- (void)dealloc
+{
+	/* Autoreleasing during a pop must not disturb the pop. */
+	if (deallocCount++ % 1000 == 0)
+		[[[OFObject alloc] init] autorelease];
+
+	[super dealloc];
+}
+@end
+
+@interface RuntimeCacheTest: OFObject
+- (int)value;
+@end
+
+@interface RuntimeCacheSubclassTest: RuntimeCacheTest
+@end
+
+@implementation RuntimeCacheTest
+- (int)value
+{
+	return 1;
+}
+@end
+
+@implementation RuntimeCacheSubclassTest
+@end
+
+static int
+replacedValue(id self, SEL _cmd)
+{
+	return 2;
+}
+
+static int
+addedValue(id self, SEL _cmd)
+{
+	return 3;
+}
+
+/*
+ * Looks up the specified selectors on the object round-robin and returns the
+ * time per lookup in nanoseconds and the fraction of lookups that missed the
+ * method cache, which is the fraction that filled an entry.
+ */
+static double
+benchmarkLookups(id object, SEL *selectors, unsigned int count,
+    size_t iterations, double *missRate)
+{
+	Class class = object_getClass(object);
+	struct objc_method_cache_statistics before, after;
+	OFDate *start;
+	double duration;
+
+	/* Warm up the cache so that only steady-state misses are counted. */
+	for (unsigned int i = 0; i < count; i++)
+		objc_msg_lookup(object, selectors[i]);
+
+	class_getMethodCacheStatistics(class, &before);
+	start = [OFDate date];
+
+	for (size_t i = 0; i < iterations; i++)
+		objc_msg_lookup(object, selectors[i % count]);
+
+	duration = -start.timeIntervalSinceNow;
+	class_getMethodCacheStatistics(class, &after);
+
+	*missRate = (double)(after.fillCount - before.fillCount) / iterations;
+
+	return duration * 1000000000 / iterations;
+}
+#endif
+
 @implementation TestsAppDelegate (RuntimeTests)
 - (void)runtimeTests
 {
@@ -71,6 +151,17 @@ static OFString *module = @"Runtime";
 	int cid1, cid2;
 	uintmax_t value;
 	id object;
+	struct objc_autorelease_pool_statistics statistics;
+	void *pool2;
+	SEL selector;
+	Method *methods;
+	SEL *selectors;
+	unsigned int methodsCount;
+	double nanoseconds, missRate, maxMissRate;
+	OFString *name;
+	RuntimeCacheTest *cacheTest;
+	RuntimeCacheSubclassTest *cacheSubclassTest;
+	const char *typeEncoding;
 #endif
 
 	EXPECT_EXCEPTION(@"Calling a non-existent method via super",
@@ -106,6 +197,91 @@ static OFString *module = @"Runtime";
 	    object_getTaggedPointerValue(object) == value &&
 	    objc_createTaggedPointer(cid2, UINTPTR_MAX >> 4) != nil &&
 	    objc_createTaggedPointer(cid2, (UINTPTR_MAX >> 4) + 1) == nil)
+
+	pool2 = objc_autoreleasePoolPush();
+	for (size_t i = 0; i < 100000; i++)
+		[[[RuntimeAutoreleaseTest alloc] init] autorelease];
+	objc_autoreleasePoolPop(pool2);
+
+	objc_autoreleasePoolGetStatistics(&statistics);
+	TEST(@"Popping autorelease pools spanning many pages",
+	    deallocCount == 100000 && statistics.maxPoolCount >= 100100 &&
+	    statistics.highWaterMark >= 100000 + statistics.count &&
+	    statistics.numPages <= 4 + statistics.count / 256 + 1)
+
+	selector = @selector(foo);
+	nanoseconds = benchmarkLookups(rt, &selector, 1, 1000000, &missRate);
+	name = [OFString stringWithFormat:
+	    @"Method cache: monomorphic lookup (%.1f ns, %.2f%% misses)",
+	    nanoseconds, missRate * 100];
+	/* Without atomic operations, the cache is never filled. */
+# ifdef OF_HAVE_ATOMIC_OPS
+	TEST(name, missRate < 0.001)
+# else
+	TEST(name, missRate == 0)
+# endif
+
+	/*
+	 * OFString has many more methods than the cache has entries, so
+	 * selectors that share an entry replace each other and miss every time.
+	 * Selectors that are looked up repeatedly need to take over their entry
+	 * instead of missing because another selector was cached there first.
+	 */
+	methods = class_copyMethodList([OFString class], &methodsCount);
+	selectors = of_alloc(methodsCount, sizeof(SEL));
+	missRate = maxMissRate = -1;
+	@try {
+		for (unsigned int i = 0; i < methodsCount; i++)
+			selectors[i] = method_getName(methods[i]);
+
+		if (methodsCount > 0) {
+			id string = [OFMutableString string];
+
+			nanoseconds = benchmarkLookups(string, selectors,
+			    methodsCount, 1000000, &missRate);
+
+			maxMissRate = 0;
+			for (unsigned int i = 0; i < methodsCount; i++) {
+				double rate;
+
+				benchmarkLookups(string, &selectors[i], 1, 100,
+				    &rate);
+
+				if (rate > maxMissRate)
+					maxMissRate = rate;
+			}
+		}
+	} @finally {
+		free(selectors);
+		free(methods);
+	}
+	name = [OFString stringWithFormat:
+	    @"Method cache: lookup of %u selectors (%.1f ns, %.2f%% misses)",
+	    methodsCount, nanoseconds, missRate * 100];
+# ifdef OF_HAVE_ATOMIC_OPS
+	TEST(name, missRate > 0 && missRate < 1)
+	TEST(@"Method cache: replacing the entry of another selector",
+	    maxMissRate == 0)
+# else
+	TEST(name, missRate == 0 && maxMissRate == 0)
+# endif
+
+	cacheTest = [[[RuntimeCacheTest alloc] init] autorelease];
+	cacheSubclassTest =
+	    [[[RuntimeCacheSubclassTest alloc] init] autorelease];
+	typeEncoding = method_getTypeEncoding(class_getInstanceMethod(
+	    [RuntimeCacheTest class], @selector(value)));
+
+	TEST(@"Method cache: replacing a cached method",
+	    [cacheTest value] == 1 && [cacheSubclassTest value] == 1 &&
+	    class_replaceMethod([RuntimeCacheTest class], @selector(value),
+	    (IMP)replacedValue, typeEncoding) != NULL &&
+	    [cacheTest value] == 2 && [cacheSubclassTest value] == 2)
+
+	TEST(@"Method cache: overriding a cached inherited method",
+	    class_addMethod([RuntimeCacheSubclassTest class], @selector(value),
+	    (IMP)addedValue, typeEncoding) &&
+	    [cacheSubclassTest value] == 3 && [cacheTest value] == 2)
 #endif
 
 	objc_autoreleasePoolPop(pool);
@@ -70,6 +70,40 @@
 	     inModule: (OFString *)module;
 @end
 
+/*
+ * A seekable stream that reads from and writes to memory, for tests of
+ * classes that wrap another stream.
+ */
+@interface TestsMemoryStream: OFSeekableStream
+{
+	OFMutableData *_data;
+	size_t _position, _maxReadLength;
+}
+
+/* A copy of all data written to or initially passed to the stream. */
+@property (readonly, nonatomic) OFData *data;
+
+/* The maximum number of bytes returned per read, or 0 for no limit. */
+@property (nonatomic) size_t maxReadLength;
+
+- (instancetype)initWithData: (OFData *)data;
+@end
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Returns length bytes of text made of random words, which compresses like
+ * real text. The same seed always results in the same text.
+ */
+extern OFData *textData(size_t length, uint32_t seed);
+
+/* Returns the little endian 32 bit integer at offset in data. */
+extern uint32_t littleEndianInt32(OFData *data, size_t offset);
+#ifdef __cplusplus
+}
+#endif
+
 @interface TestsAppDelegate (OFASN1DERParsingTests)
 - (void)ASN1DERParsingTests;
 @end
@@ -102,6 +136,10 @@
 - (void)dateTests;
 @end
 
+@interface TestsAppDelegate (OFDeflateStreamTests)
+- (void)deflateStreamTests;
+@end
+
 @interface TestsAppDelegate (OFDictionaryTests)
 - (void)dictionaryTests;
 @end
@@ -110,6 +148,10 @@
 - (void)forwardingTests;
 @end
 
+@interface TestsAppDelegate (OFGZIPStreamTests)
+- (void)GZIPStreamTests;
+@end
+
 @interface TestsAppDelegate (OFHTTPClientTests)
 - (void)HTTPClientTests;
 @end
@@ -130,6 +172,10 @@
 - (void)IPXSocketTests;
 @end
 
+@interface TestsAppDelegate (OFInflateStreamTests)
+- (void)inflateStreamTests;
+@end
+
 @interface TestsAppDelegate (OFInvocationTests)
 - (void)invocationTests;
 @end
@@ -138,10 +184,22 @@
 - (void)JSONTests;
 @end
 
+@interface TestsAppDelegate (OFJSONReaderTests)
+- (void)JSONReaderTests;
+@end
+
+@interface TestsAppDelegate (OFJSONWriterTests)
+- (void)JSONWriterTests;
+@end
+
 @interface TestsAppDelegate (OFKernelEventObserverTests)
 - (void)kernelEventObserverTests;
 @end
 
+@interface TestsAppDelegate (OFLHAArchiveTests)
+- (void)LHAArchiveTests;
+@end
+
 @interface TestsAppDelegate (OFListTests)
 - (void)listTests;
 @end
@@ -150,6 +208,10 @@
 - (void)localeTests;
 @end
 
+@interface TestsAppDelegate (OFMapTableTests)
+- (void)mapTableTests;
+@end
+
 @interface TestsAppDelegate (OFMD5HashTests)
 - (void)MD5HashTests;
 @end
@@ -252,6 +314,7 @@
 
 @interface TestsAppDelegate (OFThreadTests)
 - (void)threadTests;
+- (void)threadPoolTestsWithWorkStealing: (bool)usesWorkStealing;
 @end
 
 @interface TestsAppDelegate (OFUDPSocketTests)
@@ -283,6 +346,14 @@
 - (void)XMLParserTests;
 @end
 
+@interface TestsAppDelegate (OFXMLReaderTests)
+- (void)XMLReaderTests;
+@end
+
+@interface TestsAppDelegate (CRCTests)
+- (void)CRCTests;
+@end
+
 @interface TestsAppDelegate (PBKDF2Tests)
 - (void)PBKDF2Tests;
 @end
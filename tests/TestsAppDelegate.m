@@ -17,7 +17,9 @@
 
 #include "config.h"
 
+#include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #import "TestsAppDelegate.h"
 
@@ -93,6 +95,7 @@ main(int argc, char *argv[])
 
 	/* We need deterministic hashes for tests */
 	of_hash_seed = 0;
+	of_hash_key[0] = of_hash_key[1] = 0;
 
 #ifdef OF_WII
 	GXRModeObj *rmode;
@@ -330,11 +333,15 @@ main(int argc, char *argv[])
 	[self arrayTests];
 	[self dictionaryTests];
 	[self listTests];
+	[self mapTableTests];
 	[self setTests];
 	[self dateTests];
 	[self valueTests];
 	[self numberTests];
 	[self streamTests];
+	[self deflateStreamTests];
+	[self inflateStreamTests];
+	[self LHAArchiveTests];
 #ifdef OF_HAVE_FILES
 	[self MD5HashTests];
 	[self RIPEMD160HashTests];
@@ -345,6 +352,7 @@ main(int argc, char *argv[])
 	[self SHA512HashTests];
 	[self HMACTests];
 #endif
+	[self CRCTests];
 	[self PBKDF2Tests];
 	[self scryptTests];
 #if defined(OF_HAVE_FILES) && defined(HAVE_CODEPAGE_437)
@@ -366,6 +374,7 @@ main(int argc, char *argv[])
 #endif
 #ifdef OF_HAVE_THREADS
 	[self threadTests];
+	[self GZIPStreamTests];
 #endif
 	[self URLTests];
 #if defined(OF_HAVE_SOCKETS) && defined(OF_HAVE_THREADS)
@@ -376,12 +385,15 @@ main(int argc, char *argv[])
 	[self HTTPCookieManagerTests];
 #endif
 	[self XMLParserTests];
+	[self XMLReaderTests];
 	[self XMLNodeTests];
 	[self XMLElementBuilderTests];
 #ifdef OF_HAVE_FILES
 	[self serializationTests];
 #endif
 	[self JSONTests];
+	[self JSONReaderTests];
+	[self JSONWriterTests];
 	[self propertyListTests];
 	[self ASN1DERParsingTests];
 	[self ASN1DERRepresentationTests];
@@ -443,3 +455,147 @@ main(int argc, char *argv[])
 #endif
 }
 @end
+
+OFData *
+textData(size_t length, uint32_t seed)
+{
+	static const char *const words[] = {
+		"the ", "quick ", "brown ", "fox ", "jumps ", "over ", "a ",
+		"lazy ", "dog", ". ", ", ", "ObjFW ", "stream ", "\n"
+	};
+	OFMutableData *data = [OFMutableData dataWithCapacity: length + 8];
+	uint32_t state = seed;
+
+	while (data.count < length) {
+		const char *word;
+
+		state = state * 1103515245 + 12345;
+		word = words[(state >> 16) % (sizeof(words) / sizeof(*words))];
+
+		[data addItems: word
+			 count: strlen(word)];
+	}
+
+	[data removeItemsInRange: of_range(length, data.count - length)];
+	[data makeImmutable];
+
+	return data;
+}
+
+uint32_t
+littleEndianInt32(OFData *data, size_t offset)
+{
+	const unsigned char *items = (const unsigned char *)data.items + offset;
+
+	return (uint32_t)items[0] | (uint32_t)items[1] << 8 |
+	    (uint32_t)items[2] << 16 | (uint32_t)items[3] << 24;
+}
+
+@implementation TestsMemoryStream
+@synthesize maxReadLength = _maxReadLength;
+
+- (instancetype)init
+{
+	return [self initWithData: [OFData data]];
+}
+
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	@try {
+		_data = [data mutableCopy];
+	} @catch (id e) {
+		[self release];
+		@throw e;
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (OFData *)data
+{
+	return [[_data copy] autorelease];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= _data.count);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (_position >= _data.count)
+		return 0;
+
+	if (length > _data.count - _position)
+		length = _data.count - _position;
+	if (_maxReadLength > 0 && length > _maxReadLength)
+		length = _maxReadLength;
+
+	memcpy(buffer, (const char *)_data.items + _position, length);
+	_position += length;
+
+	return length;
+}
+
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	size_t overwriteLength;
+
+	if (_position > _data.count)
+		[_data increaseCountBy: _position - _data.count];
+
+	overwriteLength = _data.count - _position;
+	if (overwriteLength > length)
+		overwriteLength = length;
+
+	if (overwriteLength > 0)
+		memcpy((char *)_data.mutableItems + _position, buffer,
+		    overwriteLength);
+	[_data addItems: (const char *)buffer + overwriteLength
+		  count: length - overwriteLength];
+	_position += length;
+
+	return length;
+}
+
+- (of_offset_t)lowlevelSeekToOffset: (of_offset_t)offset
+			     whence: (int)whence
+{
+	of_offset_t position;
+
+	switch (whence) {
+	case SEEK_SET:
+		position = offset;
+		break;
+	case SEEK_CUR:
+		position = (of_offset_t)_position + offset;
+		break;
+	case SEEK_END:
+		position = (of_offset_t)_data.count + offset;
+		break;
+	default:
+		@throw [OFInvalidArgumentException exception];
+	}
+
+	if (position < 0)
+		@throw [OFSeekFailedException exceptionWithStream: self
+							   offset: offset
+							   whence: whence
+							    errNo: EINVAL];
+
+	_position = (size_t)position;
+
+	return position;
+}
+@end
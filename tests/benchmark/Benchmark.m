@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#import "Benchmark.h"
+
+static const struct {
+	const char *name;
+	void (*function)(void);
+} benchmarks[] = {
+	{ "crc", CRCBenchmark },
+	{ "dictionary", dictionaryBenchmark },
+	{ "json", JSONBenchmark },
+	{ "maptable", mapTableBenchmark },
+	{ "retainrelease", retainReleaseBenchmark },
+	{ "stream", streamBenchmark },
+	{ "threadpool", threadPoolBenchmark },
+	{ "xml", XMLBenchmark }
+};
+
+int
+main(int argc, char *argv[])
+{
+	bool found = false;
+
+	for (size_t i = 0; i < sizeof(benchmarks) / sizeof(*benchmarks); i++) {
+		if (argc > 1 && strcmp(argv[1], benchmarks[i].name) != 0)
+			continue;
+
+		void *pool = objc_autoreleasePoolPush();
+
+		printf("== %s ==\n", benchmarks[i].name);
+		benchmarks[i].function();
+		found = true;
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	if (!found) {
+		fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#import "OFDate.h"
+#import "OFString.h"
+
+#import "crc16.h"
+#import "crc32.h"
+
+#import "Benchmark.h"
+
+#define TOTAL_SIZE (1024 * 1024 * 1024)
+
+static void
+benchmarkCRC32(const unsigned char *buffer, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	OFDate *start = [OFDate date];
+	double duration;
+
+	for (size_t i = 0; i < TOTAL_SIZE / length; i++)
+		crc = of_crc32(crc, buffer, length);
+
+	duration = -[start timeIntervalSinceNow];
+
+	printf("CRC-32, %7zu byte chunks: %8.1f MiB/s (%08" PRIX32 ")\n",
+	    length, TOTAL_SIZE / duration / (1024 * 1024), ~crc);
+}
+
+static void
+benchmarkCRC16(const unsigned char *buffer, size_t length)
+{
+	uint16_t crc = 0;
+	OFDate *start = [OFDate date];
+	double duration;
+
+	for (size_t i = 0; i < TOTAL_SIZE / length; i++)
+		crc = of_crc16(crc, buffer, length);
+
+	duration = -[start timeIntervalSinceNow];
+
+	printf("CRC-16, %7zu byte chunks: %8.1f MiB/s (%04" PRIX16 ")\n",
+	    length, TOTAL_SIZE / duration / (1024 * 1024), crc);
+}
+
+void
+CRCBenchmark(void)
+{
+	void *pool = objc_autoreleasePoolPush();
+	const size_t maxLength = 1024 * 1024;
+	unsigned char *buffer = of_alloc(maxLength, 1);
+
+	for (size_t i = 0; i < maxLength; i++)
+		buffer[i] = (unsigned char)(i * 2654435761u >> 24);
+
+	@try {
+		for (size_t length = 16; length <= maxLength; length *= 16)
+			benchmarkCRC32(buffer, length);
+
+		for (size_t length = 16; length <= maxLength; length *= 16)
+			benchmarkCRC16(buffer, length);
+	} @finally {
+		free(buffer);
+	}
+
+	objc_autoreleasePoolPop(pool);
+}
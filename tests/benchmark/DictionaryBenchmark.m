@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#include <stdio.h>
+
+#import "OFArray.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFString.h"
+
+#import "Benchmark.h"
+
+#define NUM_KEYS 2000000
+
+static void
+printRate(const char *name, size_t count, double duration)
+{
+	printf("%-32s %12.0f ops/s\n", name, count / duration);
+}
+
+static OFArray OF_GENERIC(OFString *) *
+createKeys(OFString *format)
+{
+	OFMutableArray *keys = [OFMutableArray arrayWithCapacity: NUM_KEYS];
+
+	for (size_t i = 0; i < NUM_KEYS; i++) {
+		void *pool = objc_autoreleasePoolPush();
+
+		[keys addObject: [OFString stringWithFormat: format, i]];
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	[keys makeImmutable];
+
+	return keys;
+}
+
+static void
+keysBenchmark(const char *name, OFString *format)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFArray OF_GENERIC(OFString *) *keys = createKeys(format);
+	OFMutableDictionary *dictionary;
+	OFDate *start;
+	size_t found = 0;
+	char title[64];
+
+	start = [OFDate date];
+	for (OFString *key in keys)
+		(void)key.hash;
+	snprintf(title, sizeof(title), "hash, %s", name);
+	printRate(title, NUM_KEYS, -[start timeIntervalSinceNow]);
+
+	dictionary = [OFMutableDictionary dictionary];
+	start = [OFDate date];
+	for (OFString *key in keys)
+		[dictionary setObject: key
+			       forKey: key];
+	snprintf(title, sizeof(title), "insert, %s", name);
+	printRate(title, NUM_KEYS, -[start timeIntervalSinceNow]);
+
+	start = [OFDate date];
+	for (OFString *key in keys)
+		if ([dictionary objectForKey: key] != nil)
+			found++;
+	snprintf(title, sizeof(title), "lookup, %s", name);
+	printRate(title, NUM_KEYS, -[start timeIntervalSinceNow]);
+
+	if (found != NUM_KEYS)
+		fprintf(stderr, "Only %zu of %u keys found!\n", found,
+		    NUM_KEYS);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+dictionaryBenchmark(void)
+{
+	keysBenchmark("short ASCII keys", @"%zx");
+	keysBenchmark("long ASCII keys", @"dictionary-benchmark-key-%zu");
+	keysBenchmark("non-ASCII keys", @"Schlüssel-€-%zu");
+}
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+# include <sys/resource.h>
+#endif
+
+#import "OFArray.h"
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFDictionary.h"
+#import "OFJSONReader.h"
+#import "OFJSONWriter.h"
+#import "OFStream.h"
+#import "OFString.h"
+
+#import "Benchmark.h"
+
+#define DOCUMENT_SIZE (32 * 1024 * 1024)
+
+/* Discards everything written to it, only counting the bytes. */
+@interface JSONBenchmarkNullStream: OFStream
+{
+@public
+	size_t _count;
+}
+@end
+
+@implementation JSONBenchmarkNullStream
+- (size_t)lowlevelWriteBuffer: (const void *)buffer
+		       length: (size_t)length
+{
+	_count += length;
+
+	return length;
+}
+@end
+
+/* Returns the document in chunks, like a file or socket would. */
+@interface JSONBenchmarkDataStream: OFStream
+{
+	OFData *_data;
+	size_t _position;
+}
+
+- (instancetype)initWithData: (OFData *)data;
+@end
+
+@implementation JSONBenchmarkDataStream
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	_data = [data retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= _data.count);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (length > _data.count - _position)
+		length = _data.count - _position;
+
+	memcpy(buffer, (const char *)_data.items + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
+
+static OFData *
+createDocument(void)
+{
+	OFMutableData *document = [OFMutableData dataWithCapacity:
+	    DOCUMENT_SIZE + 1024];
+	unsigned int i = 0;
+
+	[document addItems: "[\n"
+		     count: 2];
+
+	while (document.count < DOCUMENT_SIZE) {
+		char record[512];
+		int length = snprintf(record, sizeof(record),
+		    "%s{\"id\": %u, \"name\": \"Record \\\"%u\\\"\", "
+		    "\"tags\": [\"alpha\", \"beta\", \"gamma\"], "
+		    "\"position\": {\"x\": %u.25, \"y\": -%u.5e1, "
+		    "\"flags\": [true, false, null]}, "
+		    "\"text\": \"Some text as it would appear in a log record, "
+		    "long enough to be worth skipping over in one go\"}",
+		    (i > 0 ? ",\n" : ""), i, i, i % 1000, i % 100);
+
+		[document addItems: record
+			     count: length];
+		i++;
+	}
+
+	[document addItems: "\n]\n"
+		     count: 3];
+
+	[document makeImmutable];
+
+	return document;
+}
+
+static void
+printResult(const char *name, size_t count, size_t records, OFDate *start)
+{
+	double duration = -[start timeIntervalSinceNow];
+
+	printf("%-28s %8zu records, %7.1f MiB/s\n",
+	    name, records, count / duration / (1024 * 1024));
+}
+
+static void
+countStrings(id object, size_t *strings, size_t *tagged)
+{
+	if ([object isKindOfClass: [OFString class]]) {
+		(*strings)++;
+#ifdef OF_OBJFW_RUNTIME
+		if (object_isTaggedPointer(object))
+			(*tagged)++;
+#endif
+	} else if ([object isKindOfClass: [OFArray class]]) {
+		for (id child in object)
+			countStrings(child, strings, tagged);
+	} else if ([object isKindOfClass: [OFDictionary class]]) {
+		for (id key in object) {
+			countStrings(key, strings, tagged);
+			countStrings([object objectForKey: key], strings,
+			    tagged);
+		}
+	}
+}
+
+static OFArray *
+benchmarkDOM(OFData *document)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDate *start = [OFDate date];
+	OFString *string = [OFString stringWithUTF8String: document.items
+						   length: document.count];
+	OFArray *records = string.objectByParsingJSON;
+	size_t strings = 0, tagged = 0;
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+	struct rusage usage;
+#endif
+
+	printResult("objectByParsingJSON", document.count, records.count,
+	    start);
+
+	/* Every string that is a tagged pointer is one allocation less. */
+	countStrings(records, &strings, &tagged);
+	printf("%zu strings, %zu of them tagged pointers\n", strings, tagged);
+
+#if defined(HAVE_SYS_RESOURCE_H) && defined(HAVE_GETRUSAGE)
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+		printf("Maximum resident set size: %ld\n",
+		    (long)usage.ru_maxrss);
+#endif
+
+	[records retain];
+
+	objc_autoreleasePoolPop(pool);
+
+	return [records autorelease];
+}
+
+static void
+benchmarkTokens(OFData *document, bool fromStream)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDate *start = [OFDate date];
+	OFJSONReader *reader;
+	size_t records = 0;
+	of_json_reader_token_t token;
+
+	if (fromStream) {
+		JSONBenchmarkDataStream *stream = [[[JSONBenchmarkDataStream
+		    alloc] initWithData: document] autorelease];
+
+		reader = [OFJSONReader readerWithStream: stream];
+	} else
+		reader = [OFJSONReader readerWithData: document];
+
+	while ((token = [reader nextToken]) !=
+	    OF_JSON_READER_TOKEN_END_OF_DOCUMENT)
+		if (token == OF_JSON_READER_TOKEN_BEGIN_OBJECT &&
+		    reader.depth == 2)
+			records++;
+
+	printResult((fromStream
+	    ? "OFJSONReader, all tokens from stream"
+	    : "OFJSONReader, all tokens"), document.count, records, start);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+benchmarkExtracting(OFData *document)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDate *start = [OFDate date];
+	OFJSONReader *reader = [OFJSONReader readerWithData: document];
+	size_t records = 0;
+	long long sum = 0;
+
+	[reader nextToken];
+
+	while ([reader nextToken] == OF_JSON_READER_TOKEN_BEGIN_OBJECT) {
+		while ([reader nextToken] == OF_JSON_READER_TOKEN_KEY) {
+			if (!of_json_reader_range_is_equal(reader.range,
+			    "id")) {
+				[reader skipValue];
+				continue;
+			}
+
+			[reader nextToken];
+			sum += reader.longLongValue;
+		}
+
+		records++;
+	}
+
+	printResult("OFJSONReader, extracting id", document.count, records,
+	    start);
+
+	if (sum == 0)
+		printf("Unexpected sum of IDs\n");
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+benchmarkReadingObjects(OFData *document)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDate *start = [OFDate date];
+	OFJSONReader *reader = [OFJSONReader readerWithData: document];
+	size_t records = 0;
+
+	[reader nextToken];
+
+	while ([reader nextToken] == OF_JSON_READER_TOKEN_BEGIN_OBJECT) {
+		void *pool2 = objc_autoreleasePoolPush();
+
+		[reader readObject];
+		records++;
+
+		objc_autoreleasePoolPop(pool2);
+	}
+
+	printResult("OFJSONReader, readObject", document.count, records,
+	    start);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+benchmarkWriting(OFArray *records)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFDate *start = [OFDate date];
+	OFString *JSON = records.JSONRepresentation;
+	JSONBenchmarkNullStream *stream;
+	OFJSONWriter *writer;
+
+	printResult("JSONRepresentation", JSON.UTF8StringLength,
+	    records.count, start);
+
+	start = [OFDate date];
+	writer = [OFJSONWriter writer];
+	[writer writeObject: records];
+	printResult("OFJSONWriter, writeObject", JSON.UTF8StringLength,
+	    records.count, start);
+
+	stream = [[[JSONBenchmarkNullStream alloc] init] autorelease];
+	start = [OFDate date];
+	writer = [OFJSONWriter writerWithStream: stream];
+	[writer writeObject: records];
+	printResult("OFJSONWriter, to stream", stream->_count, records.count,
+	    start);
+
+	stream = [[[JSONBenchmarkNullStream alloc] init] autorelease];
+	start = [OFDate date];
+	writer = [OFJSONWriter writerWithStream: stream];
+	[writer beginArray];
+
+	for (size_t i = 0; i < records.count; i++) {
+		[writer beginObject];
+		[writer writeKey: @"id"];
+		[writer writeUnsignedLongLong: i];
+		[writer writeKey: @"name"];
+		[writer writeUTF8String: "Record \"x\""
+				 length: 10];
+		[writer endObject];
+	}
+
+	[writer endArray];
+	printResult("OFJSONWriter, by hand", stream->_count, records.count,
+	    start);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+JSONBenchmark(void)
+{
+	OFData *document = createDocument();
+	OFArray *records;
+
+	records = benchmarkDOM(document);
+	benchmarkTokens(document, false);
+	benchmarkTokens(document, true);
+	benchmarkExtracting(document);
+	benchmarkReadingObjects(document);
+	benchmarkWriting(records);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#include <stdio.h>
+
+#import "OFDate.h"
+#import "OFMapTable.h"
+
+#import "Benchmark.h"
+
+#define MIN_ENTRIES 1000
+#define MAX_ENTRIES 10000000
+#define NUM_OPERATIONS 10000000
+
+static unsigned long
+mixingHash(void *key)
+{
+	uint64_t hash = (uintptr_t)key;
+
+	/* The finalizer of MurmurHash3, so that the order is random. */
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xFF51AFD7ED558CCD);
+	hash ^= hash >> 33;
+	hash *= UINT64_C(0xC4CEB9FE1A85EC53);
+	hash ^= hash >> 33;
+
+	return (unsigned long)hash;
+}
+
+static void
+printRate(const char *name, size_t count, double duration)
+{
+	printf("%-32s %12.0f ops/s\n", name, count / duration);
+}
+
+static void
+entriesBenchmark(size_t numEntries)
+{
+	void *pool = objc_autoreleasePoolPush();
+	of_map_table_functions_t keyFunctions = { .hash = mixingHash };
+	OFMapTable *mapTable = [OFMapTable
+	    mapTableWithKeyFunctions: keyFunctions
+		     objectFunctions: (of_map_table_functions_t){ NULL }];
+	size_t rounds = (NUM_OPERATIONS + numEntries - 1) / numEntries;
+	size_t found = 0;
+	OFDate *start;
+	char title[64];
+
+	/* Keys start at 1, as NULL is not a valid key. */
+	start = [OFDate date];
+	for (size_t i = 1; i <= numEntries; i++)
+		[mapTable setObject: (void *)(uintptr_t)i
+			     forKey: (void *)(uintptr_t)i];
+	snprintf(title, sizeof(title), "insert, %zu entries", numEntries);
+	printRate(title, numEntries, -[start timeIntervalSinceNow]);
+
+	start = [OFDate date];
+	for (size_t j = 0; j < rounds; j++)
+		for (size_t i = 1; i <= numEntries; i++)
+			if ([mapTable objectForKey: (void *)(uintptr_t)i] !=
+			    NULL)
+				found++;
+	snprintf(title, sizeof(title), "lookup, %zu entries", numEntries);
+	printRate(title, rounds * numEntries, -[start timeIntervalSinceNow]);
+
+	start = [OFDate date];
+	for (size_t j = 0; j < rounds; j++)
+		for (size_t i = numEntries + 1; i <= 2 * numEntries; i++)
+			if ([mapTable objectForKey: (void *)(uintptr_t)i] !=
+			    NULL)
+				found++;
+	snprintf(title, sizeof(title), "failed lookup, %zu entries",
+	    numEntries);
+	printRate(title, rounds * numEntries, -[start timeIntervalSinceNow]);
+
+	if (found != rounds * numEntries)
+		fprintf(stderr, "Found %zu instead of %zu entries!\n", found,
+		    rounds * numEntries);
+
+	/* Remove every other key first, then the rest. */
+	start = [OFDate date];
+	for (size_t i = 1; i <= numEntries; i += 2)
+		[mapTable removeObjectForKey: (void *)(uintptr_t)i];
+	for (size_t i = 2; i <= numEntries; i += 2)
+		[mapTable removeObjectForKey: (void *)(uintptr_t)i];
+	snprintf(title, sizeof(title), "remove, %zu entries", numEntries);
+	printRate(title, numEntries, -[start timeIntervalSinceNow]);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+mapTableBenchmark(void)
+{
+	for (size_t i = MIN_ENTRIES; i <= MAX_ENTRIES; i *= 10)
+		entriesBenchmark(i);
+}
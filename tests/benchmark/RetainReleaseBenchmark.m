@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#include <stdio.h>
+
+#import "OFArray.h"
+#import "OFDate.h"
+#import "OFThread.h"
+
+#import "Benchmark.h"
+
+#define NUM_ITERATIONS 10000000
+#define NUM_OBJECTS 1000000
+#define NUM_POOL_OBJECTS 10000000
+#define MAX_THREADS 8
+
+#ifdef OF_HAVE_THREADS
+@interface RetainReleaseBenchmarkThread: OFThread
+{
+@public
+	id _object;
+}
+@end
+
+@implementation RetainReleaseBenchmarkThread
+- (id)main
+{
+	for (size_t i = 0; i < NUM_ITERATIONS; i++) {
+		[_object retain];
+		[_object release];
+	}
+
+	return nil;
+}
+@end
+#endif
+
+static void
+printRate(const char *name, size_t count, double duration)
+{
+	printf("%-32s %12.0f ops/s\n", name, count / duration);
+}
+
+static void
+ownerBenchmark(void)
+{
+	OFObject *object = [[OFObject alloc] init];
+	OFDate *start = [OFDate date];
+
+	for (size_t i = 0; i < NUM_ITERATIONS; i++) {
+		[object retain];
+		[object release];
+	}
+
+	printRate("retain/release, owner thread", NUM_ITERATIONS * 2,
+	    -[start timeIntervalSinceNow]);
+
+	[object release];
+}
+
+static void
+temporariesBenchmark(void)
+{
+	OFDate *start = [OFDate date];
+
+	for (size_t i = 0; i < NUM_OBJECTS; i++) {
+		void *pool = objc_autoreleasePoolPush();
+
+		[[[OFObject alloc] init] autorelease];
+
+		objc_autoreleasePoolPop(pool);
+	}
+
+	printRate("alloc/autorelease/dealloc", NUM_OBJECTS,
+	    -[start timeIntervalSinceNow]);
+}
+
+static void
+poolBenchmark(void)
+{
+	OFObject *object = [[OFObject alloc] init];
+	OFDate *start = [OFDate date];
+	void *pool;
+#ifdef OF_OBJFW_RUNTIME
+	struct objc_autorelease_pool_statistics statistics;
+#endif
+
+	for (size_t i = 0; i < NUM_ITERATIONS; i++)
+		objc_autoreleasePoolPop(objc_autoreleasePoolPush());
+
+	printRate("autorelease pool push/pop", NUM_ITERATIONS,
+	    -[start timeIntervalSinceNow]);
+
+	start = [OFDate date];
+	pool = objc_autoreleasePoolPush();
+
+	for (size_t i = 0; i < NUM_POOL_OBJECTS; i++)
+		[[object retain] autorelease];
+
+	objc_autoreleasePoolPop(pool);
+
+	printRate("autorelease, single pool", NUM_POOL_OBJECTS,
+	    -[start timeIntervalSinceNow]);
+
+#ifdef OF_OBJFW_RUNTIME
+	objc_autoreleasePoolGetStatistics(&statistics);
+	printf("%-32s %12lu\n", "pages kept after pop", statistics.numPages);
+#endif
+
+	[object release];
+}
+
+#ifdef OF_HAVE_THREADS
+@interface RetainReleaseBenchmarkOwnerThread: OFThread
+@end
+
+@implementation RetainReleaseBenchmarkOwnerThread
+- (id)main
+{
+	ownerBenchmark();
+	temporariesBenchmark();
+
+	return nil;
+}
+@end
+
+static void
+sharedBenchmark(size_t numThreads)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFObject *object = [[[OFObject alloc] init] autorelease];
+	OFMutableArray *threads = [OFMutableArray array];
+	OFDate *start;
+	char name[64];
+
+	for (size_t i = 0; i < numThreads; i++) {
+		RetainReleaseBenchmarkThread *thread =
+		    [RetainReleaseBenchmarkThread thread];
+
+		thread->_object = object;
+		[threads addObject: thread];
+	}
+
+	start = [OFDate date];
+
+	for (RetainReleaseBenchmarkThread *thread in threads)
+		[thread start];
+	for (RetainReleaseBenchmarkThread *thread in threads)
+		[thread join];
+
+	snprintf(name, sizeof(name), "retain/release, %zu other thread%s",
+	    numThreads, (numThreads == 1 ? "" : "s"));
+	printRate(name, numThreads * NUM_ITERATIONS * 2,
+	    -[start timeIntervalSinceNow]);
+
+	objc_autoreleasePoolPop(pool);
+}
+#endif
+
+void
+retainReleaseBenchmark(void)
+{
+#ifdef OF_HAVE_THREADS
+	void *pool = objc_autoreleasePoolPush();
+	/* Only objects allocated by an OFThread use a biased count. */
+	OFThread *thread = [RetainReleaseBenchmarkOwnerThread thread];
+
+	[thread start];
+	[thread join];
+
+	objc_autoreleasePoolPop(pool);
+#else
+	ownerBenchmark();
+	temporariesBenchmark();
+#endif
+	poolBenchmark();
+#ifdef OF_HAVE_THREADS
+	for (size_t i = 1; i <= MAX_THREADS; i *= 2)
+		sharedBenchmark(i);
+#endif
+}
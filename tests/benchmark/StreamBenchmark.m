@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#import "OFDate.h"
+#import "OFFile.h"
+#import "OFFileManager.h"
+#import "OFString.h"
+
+#import "Benchmark.h"
+
+#define FILE_PATH @"StreamBenchmark.txt"
+#define FILE_SIZE (1024 * 1024 * 1024)
+#define LINE_LENGTH 79
+
+#ifdef OF_HAVE_FILES
+static void
+writeFile(void)
+{
+	OFFile *file = [OFFile fileWithPath: FILE_PATH
+				       mode: @"w"];
+	char line[LINE_LENGTH + 1];
+
+	memset(line, 'x', LINE_LENGTH);
+	line[LINE_LENGTH] = '\n';
+
+	file.buffersWrites = true;
+
+	for (size_t i = 0; i < FILE_SIZE / sizeof(line); i++)
+		[file writeBuffer: line
+			   length: sizeof(line)];
+
+	[file close];
+}
+
+static void
+readLines(size_t readBufferSize)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFFile *file = [OFFile fileWithPath: FILE_PATH
+				       mode: @"r"];
+	size_t lines = 0;
+	OFDate *start;
+	double duration;
+
+	file.readBufferSize = readBufferSize;
+
+	start = [OFDate date];
+	while ([file readLine] != nil) {
+		lines++;
+
+		if (lines % 65536 == 0) {
+			objc_autoreleasePoolPop(pool);
+			pool = objc_autoreleasePoolPush();
+		}
+	}
+	duration = -[start timeIntervalSinceNow];
+
+	printf("readLine, %7zu byte buffer: %8zu lines, %7.1f MiB/s\n",
+	    readBufferSize, lines, FILE_SIZE / duration / (1024 * 1024));
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+readTillDelimiter(size_t readBufferSize)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFFile *file = [OFFile fileWithPath: FILE_PATH
+				       mode: @"r"];
+	size_t lines = 0;
+	OFDate *start;
+	double duration;
+
+	file.readBufferSize = readBufferSize;
+
+	start = [OFDate date];
+	while ([file readTillDelimiter: @"x\n"] != nil) {
+		lines++;
+
+		if (lines % 65536 == 0) {
+			objc_autoreleasePoolPop(pool);
+			pool = objc_autoreleasePoolPush();
+		}
+	}
+	duration = -[start timeIntervalSinceNow];
+
+	printf("readTillDelimiter:, %7zu byte buffer: %8zu lines, "
+	    "%7.1f MiB/s\n",
+	    readBufferSize, lines, FILE_SIZE / duration / (1024 * 1024));
+
+	objc_autoreleasePoolPop(pool);
+}
+#endif
+
+void
+streamBenchmark(void)
+{
+#ifdef OF_HAVE_FILES
+	OFFileManager *fileManager = [OFFileManager defaultManager];
+
+	writeFile();
+
+	@try {
+		for (size_t size = 4096; size <= 1024 * 1024; size *= 16) {
+			readLines(size);
+			readTillDelimiter(size);
+		}
+	} @finally {
+		[fileManager removeItemAtPath: FILE_PATH];
+	}
+#endif
+}
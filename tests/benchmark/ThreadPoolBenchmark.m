@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+
+#import "OFArray.h"
+#import "OFDate.h"
+#import "OFNumber.h"
+#import "OFThreadPool.h"
+
+#import "Benchmark.h"
+
+#define NUM_FLAT_JOBS 1000000
+#define BATCH_SIZE 1000
+#define TREE_DEPTH 18
+#define MAX_THREADS 64
+
+static OFThreadPool *threadPool;
+
+@interface ThreadPoolBenchmarkTarget: OFObject
+- (void)doNothing: (id)object;
+- (void)spawn: (OFNumber *)depth;
+@end
+
+@implementation ThreadPoolBenchmarkTarget
+- (void)doNothing: (id)object
+{
+}
+
+- (void)spawn: (OFNumber *)depth
+{
+	unsigned int value = depth.unsignedIntValue;
+	OFNumber *childDepth;
+
+	if (value == 0)
+		return;
+
+	childDepth = [OFNumber numberWithUnsignedInt: value - 1];
+
+	[threadPool dispatchWithTarget: self
+			      selector: @selector(spawn:)
+				object: childDepth];
+	[threadPool dispatchWithTarget: self
+			      selector: @selector(spawn:)
+				object: childDepth];
+}
+@end
+
+static void
+benchmark(size_t numThreads, bool usesWorkStealing)
+{
+	void *pool = objc_autoreleasePoolPush();
+	ThreadPoolBenchmarkTarget *target =
+	    [[[ThreadPoolBenchmarkTarget alloc] init] autorelease];
+	OFMutableArray *batch = [OFMutableArray array];
+	OFDate *start;
+	double flatDuration, treeDuration;
+
+	for (size_t i = 0; i < BATCH_SIZE; i++)
+		[batch addObject: [OFNumber numberWithSize: i]];
+
+	threadPool = [[OFThreadPool alloc] initWithSize: numThreads
+				       usesWorkStealing: usesWorkStealing];
+
+	/* Many tiny jobs submitted from outside the pool */
+	start = [OFDate date];
+	for (size_t i = 0; i < NUM_FLAT_JOBS / BATCH_SIZE; i++)
+		[threadPool dispatchWithTarget: target
+				      selector: @selector(doNothing:)
+				       objects: batch];
+	[threadPool waitUntilDone];
+	flatDuration = -[start timeIntervalSinceNow];
+
+	/* Jobs recursively submitting jobs from inside the pool */
+	start = [OFDate date];
+	[threadPool dispatchWithTarget: target
+			      selector: @selector(spawn:)
+				object: [OFNumber numberWithUnsignedInt:
+					    TREE_DEPTH]];
+	[threadPool waitUntilDone];
+	treeDuration = -[start timeIntervalSinceNow];
+
+	[threadPool release];
+	threadPool = nil;
+
+	printf("%2zu threads, %s: %10.0f flat jobs/s, %10.0f nested jobs/s\n",
+	    numThreads, (usesWorkStealing ? "work stealing" : "shared queue "),
+	    NUM_FLAT_JOBS / flatDuration,
+	    ((2 << TREE_DEPTH) - 1) / treeDuration);
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+threadPoolBenchmark(void)
+{
+	for (size_t i = 1; i <= MAX_THREADS; i *= 2) {
+		benchmark(i, false);
+		benchmark(i, true);
+	}
+}
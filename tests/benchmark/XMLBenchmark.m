@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2008, 2009, 2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017,
+ *               2018, 2019, 2020
+ *   Jonathan Schleifer <js@nil.im>
+ *
+ * All rights reserved.
+ *
+ * This file is part of ObjFW. It may be distributed under the terms of the
+ * Q Public License 1.0, which can be found in the file LICENSE.QPL included in
+ * the packaging of this file.
+ *
+ * Alternatively, it may be distributed under the terms of the GNU General
+ * Public License, either version 2 or 3, which can be found in the file
+ * LICENSE.GPLv2 or LICENSE.GPLv3 respectively included in the packaging of this
+ * file.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#import "OFData.h"
+#import "OFDate.h"
+#import "OFStream.h"
+#import "OFString.h"
+#import "OFXMLParser.h"
+#import "OFXMLReader.h"
+
+#import "Benchmark.h"
+
+#define DOCUMENT_SIZE (64 * 1024 * 1024)
+
+OF_DIRECT_MEMBERS
+@interface XMLBenchmarkDelegate: OFObject <OFXMLParserDelegate>
+{
+@public
+	size_t _elements;
+}
+@end
+
+@implementation XMLBenchmarkDelegate
+-    (void)parser: (OFXMLParser *)parser
+  didStartElement: (OFString *)name
+	   prefix: (OFString *)prefix
+	namespace: (OFString *)namespace
+       attributes: (OFArray OF_GENERIC(OFXMLAttribute *) *)attributes
+{
+	_elements++;
+}
+@end
+
+/* Returns the document in chunks, like a file or socket would. */
+@interface XMLBenchmarkDataStream: OFStream
+{
+	OFData *_data;
+	size_t _position;
+}
+
+- (instancetype)initWithData: (OFData *)data;
+@end
+
+@implementation XMLBenchmarkDataStream
+- (instancetype)initWithData: (OFData *)data
+{
+	self = [super init];
+
+	_data = [data retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_data release];
+
+	[super dealloc];
+}
+
+- (bool)lowlevelIsAtEndOfStream
+{
+	return (_position >= _data.count);
+}
+
+- (size_t)lowlevelReadIntoBuffer: (void *)buffer
+			  length: (size_t)length
+{
+	if (length > _data.count - _position)
+		length = _data.count - _position;
+
+	memcpy(buffer, (const char *)_data.items + _position, length);
+	_position += length;
+
+	return length;
+}
+@end
+
+static OFData *
+createDocument(void)
+{
+	OFMutableData *document = [OFMutableData dataWithCapacity:
+	    DOCUMENT_SIZE + 1024];
+	const char *entry =
+	    "  <entry id=\"12345\" title=\"An attribute value that is long "
+	    "enough to be worth skipping over in one go\">\n"
+	    "    Some character data, as it would appear in a feed, with a "
+	    "few lines of text\n"
+	    "    and an entity &amp; a reference to it.\n"
+	    "    <![CDATA[Some CDATA with <markup> that is not parsed]]>\n"
+	    "    <!-- A comment describing the entry -->\n"
+	    "  </entry>\n";
+	size_t entryLength = strlen(entry);
+
+	[document addItems: "<feed>\n"
+		     count: 7];
+
+	while (document.count < DOCUMENT_SIZE)
+		[document addItems: entry
+			     count: entryLength];
+
+	[document addItems: "</feed>\n"
+		     count: 8];
+
+	[document makeImmutable];
+
+	return document;
+}
+
+static void
+benchmarkParsing(OFData *document, size_t chunkSize)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFXMLParser *parser = [OFXMLParser parser];
+	XMLBenchmarkDelegate *delegate =
+	    [[[XMLBenchmarkDelegate alloc] init] autorelease];
+	const char *items = document.items;
+	size_t count = document.count;
+	OFDate *start;
+	double duration;
+
+	parser.delegate = delegate;
+
+	start = [OFDate date];
+	for (size_t i = 0; i < count; i += chunkSize) {
+		void *pool2 = objc_autoreleasePoolPush();
+
+		[parser parseBuffer: items + i
+			     length: (count - i < chunkSize
+					 ? count - i : chunkSize)];
+
+		objc_autoreleasePoolPop(pool2);
+	}
+	duration = -[start timeIntervalSinceNow];
+
+	printf("parseBuffer:, %8zu byte chunks: %8zu elements, "
+	    "%7.1f MiB/s\n",
+	    chunkSize, delegate->_elements, count / duration / (1024 * 1024));
+
+	objc_autoreleasePoolPop(pool);
+}
+
+static void
+benchmarkReading(OFData *document, bool skip, bool fromStream)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFXMLReader *reader;
+	size_t elements = 0, IDs = 0;
+	of_xml_reader_event_t event;
+	OFDate *start;
+	double duration;
+
+	if (fromStream) {
+		XMLBenchmarkDataStream *stream = [[[XMLBenchmarkDataStream
+		    alloc] initWithData: document] autorelease];
+
+		reader = [OFXMLReader readerWithStream: stream];
+	} else
+		reader = [OFXMLReader readerWithData: document];
+
+	start = [OFDate date];
+	while ((event = [reader nextEvent]) !=
+	    OF_XML_READER_EVENT_END_OF_DOCUMENT) {
+		size_t idx;
+
+		if (event != OF_XML_READER_EVENT_START_ELEMENT)
+			continue;
+
+		elements++;
+
+		idx = [reader indexOfAttributeWithName: "id"
+					     namespace: NULL];
+		if (idx != OF_NOT_FOUND &&
+		    [reader valueOfAttributeAtIndex: idx].length > 0)
+			IDs++;
+
+		if (skip && reader.depth > 1)
+			[reader skipSubtree];
+	}
+	duration = -[start timeIntervalSinceNow];
+
+	printf("OFXMLReader, %s, %s: %8zu elements, %8zu IDs, "
+	    "%7.1f MiB/s\n",
+	    (fromStream ? "stream" : "data  "),
+	    (skip ? "skipSubtree" : "all events "), elements, IDs,
+	    document.count / duration / (1024 * 1024));
+
+	objc_autoreleasePoolPop(pool);
+}
+
+void
+XMLBenchmark(void)
+{
+	OFData *document = createDocument();
+
+	for (size_t size = 4096; size <= 1024 * 1024; size *= 16)
+		benchmarkParsing(document, size);
+
+	benchmarkReading(document, false, false);
+	benchmarkReading(document, true, false);
+	benchmarkReading(document, false, true);
+	benchmarkReading(document, true, true);
+}
@@ -19,9 +19,14 @@
 
 #include <stdio.h>
 
+#import "OFDate.h"
+#import "OFArray.h"
 #import "OFString.h"
 #import "OFThread.h"
 
+#define BENCHMARK_ITERATIONS 100000
+#define BENCHMARK_MAX_THREADS 64
+
 OFObject *lock;
 
 @interface MyThread: OFThread
@@ -46,6 +51,79 @@ OFObject *lock;
 }
 @end
 
+@interface BenchmarkThread: OFThread
+{
+	OFObject *_object;
+}
+
+- (instancetype)initWithObject: (OFObject *)object;
+@end
+
+@implementation BenchmarkThread
+- (instancetype)initWithObject: (OFObject *)object
+{
+	self = [super init];
+
+	_object = [object retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_object release];
+
+	[super dealloc];
+}
+
+- (id)main
+{
+	for (size_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		@synchronized (_object) {
+		}
+	}
+
+	return nil;
+}
+@end
+
+static void
+benchmark(size_t numThreads, bool shared)
+{
+	void *pool = objc_autoreleasePoolPush();
+	OFMutableArray *threads = [OFMutableArray array];
+	OFObject *sharedObject = [[[OFObject alloc] init] autorelease];
+	struct objc_sync_statistics before, after;
+	OFDate *start;
+	double duration;
+
+	for (size_t i = 0; i < numThreads; i++) {
+		OFObject *object = (shared
+		    ? sharedObject : [[[OFObject alloc] init] autorelease]);
+
+		[threads addObject: [[[BenchmarkThread alloc]
+		    initWithObject: object] autorelease]];
+	}
+
+	objc_sync_getStatistics(&before);
+	start = [OFDate date];
+
+	for (BenchmarkThread *thread in threads)
+		[thread start];
+	for (BenchmarkThread *thread in threads)
+		[thread join];
+
+	duration = -[start timeIntervalSinceNow];
+	objc_sync_getStatistics(&after);
+
+	printf("%2zu threads, %s object: %12.0f locks/s, %llu contended\n",
+	    numThreads, (shared ? "shared " : "private"),
+	    numThreads * BENCHMARK_ITERATIONS / duration,
+	    after.contentionCount - before.contentionCount);
+
+	objc_autoreleasePoolPop(pool);
+}
+
 int
 main()
 {
@@ -65,5 +143,10 @@ main()
 	[t1 join];
 	[t2 join];
 
+	for (size_t i = 1; i <= BENCHMARK_MAX_THREADS; i *= 2) {
+		benchmark(i, false);
+		benchmark(i, true);
+	}
+
 	return 0;
 }
@@ -85,6 +85,9 @@ setModificationDate(OFString *path, OFGZIPStream *stream)
 	@try {
 		_stream = [[OFGZIPStream alloc] initWithStream: stream
 							  mode: mode];
+#ifdef OF_HAVE_THREADS
+		_stream.threadPool = app->_threadPool;
+#endif
 	} @catch (id e) {
 		[self release];
 		@throw e;
@@ -182,4 +185,74 @@ setModificationDate(OFString *path, OFGZIPStream *stream)
 		}
 	}
 }
+
+- (void)addFiles: (OFArray OF_GENERIC(OFString *) *)files
+{
+	OFString *fileName;
+	of_file_attributes_t attributes;
+	unsigned long long size, written = 0;
+	int8_t percent = -1, newPercent;
+	OFFile *input;
+
+	if (files.count != 1) {
+		[of_stderr writeLine: OF_LOCALIZED(@"add_gz_needs_one_file",
+		    @"A .gz archive needs exactly one file to add!")];
+		app->_exitStatus = 1;
+		return;
+	}
+
+	fileName = files.firstObject;
+	attributes = [[OFFileManager defaultManager]
+	    attributesOfItemAtPath: fileName];
+	size = attributes.fileSize;
+
+	if (app->_outputLevel >= 0)
+		[of_stdout writeString: OF_LOCALIZED(@"adding_file",
+		    @"Adding %[file]...",
+		    @"file", fileName)];
+
+	_stream.modificationDate = attributes.fileModificationDate;
+
+	input = [OFFile fileWithPath: fileName
+				mode: @"r"];
+
+	while (!input.atEndOfStream) {
+		ssize_t length = [app copyBlockFromStream: input
+						 toStream: _stream
+						 fileName: fileName];
+
+		if (length < 0) {
+			app->_exitStatus = 1;
+			return;
+		}
+
+		written += length;
+		newPercent = (written == size
+		    ? 100 : (int8_t)(written * 100 / size));
+
+		if (app->_outputLevel >= 0 && percent != newPercent) {
+			OFString *percentString;
+
+			percent = newPercent;
+			percentString = [OFString
+			    stringWithFormat: @"%3u", percent];
+
+			[of_stdout writeString: @"\r"];
+			[of_stdout writeString: OF_LOCALIZED(
+			    @"adding_file_percent",
+			    @"Adding %[file]... %[percent]%",
+			    @"file", fileName,
+			    @"percent", percentString)];
+		}
+	}
+
+	if (app->_outputLevel >= 0) {
+		[of_stdout writeString: @"\r"];
+		[of_stdout writeLine: OF_LOCALIZED(@"adding_file_done",
+		    @"Adding %[file]... done",
+		    @"file", fileName)];
+	}
+
+	[_stream close];
+}
 @end
@@ -20,6 +20,10 @@
 
 #import "Archive.h"
 
+#ifdef OF_HAVE_THREADS
+@class OFThreadPool;
+#endif
+
 OF_ASSUME_NONNULL_BEGIN
 
 #ifndef S_IRWXG
@@ -36,6 +40,9 @@ OF_ASSUME_NONNULL_BEGIN
 	int8_t _outputLevel;
 	OFString *_archivePath;
 	int _exitStatus;
+#ifdef OF_HAVE_THREADS
+	OFThreadPool *_threadPool;
+#endif
 }
 
 - (id <Archive>)openArchiveWithPath: (OFString *)path
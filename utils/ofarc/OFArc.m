@@ -27,6 +27,9 @@
 #import "OFOptionsParser.h"
 #import "OFSandbox.h"
 #import "OFStdIOStream.h"
+#ifdef OF_HAVE_THREADS
+# import "OFThreadPool.h"
+#endif
 #import "OFURL.h"
 
 #import "OFArc.h"
@@ -52,7 +55,7 @@ static void
 help(OFStream *stream, bool full, int status)
 {
 	[stream writeLine: OF_LOCALIZED(@"usage",
-	    @"Usage: %[prog] -[acCfhlnpqtvx] archive.zip [file1 file2 ...]",
+	    @"Usage: %[prog] -[acCfhlnpqtTvx] archive.zip [file1 file2 ...]",
 	    @"prog", [OFApplication programName])];
 
 	if (full) {
@@ -75,6 +78,8 @@ help(OFStream *stream, bool full, int status)
 		    @"errors)\n"
 		    @"    -t  --type        Archive type (gz, lha, tar, tgz, "
 		    @"zip)\n"
+		    @"    -T  --threads     Number of threads for gz and tgz "
+		    @"archives\n"
 		    @"    -v  --verbose     Verbose output for file list\n"
 		    @"    -x  --extract     Extract files")];
 	}
@@ -150,7 +155,7 @@ writingNotSupported(OFString *type)
 @implementation OFArc
 - (void)applicationDidFinishLaunching
 {
-	OFString *outputDir, *encodingString, *type;
+	OFString *outputDir, *encodingString, *type, *threadsString;
 	const of_options_parser_option_t options[] = {
 		{ 'a', @"append", 0, NULL, NULL },
 		{ 'c', @"create", 0, NULL, NULL },
@@ -163,6 +168,7 @@ writingNotSupported(OFString *type)
 		{ 'p', @"print", 0, NULL, NULL },
 		{ 'q', @"quiet", 0, NULL, NULL },
 		{ 't', @"type", 1, NULL, &type },
+		{ 'T', @"threads", 1, NULL, &threadsString },
 		{ 'v', @"verbose", 0, NULL, NULL },
 		{ 'x', @"extract", 0, NULL, NULL },
 		{ '\0', nil, 0, NULL, NULL }
@@ -172,6 +178,7 @@ writingNotSupported(OFString *type)
 	OFOptionsParser *optionsParser;
 	OFArray OF_GENERIC(OFString *) *remainingArguments, *files;
 	id <Archive> archive;
+	void *pool;
 
 #ifdef OF_HAVE_SANDBOX
 	OFSandbox *sandbox = [OFSandbox sandbox];
@@ -309,6 +316,31 @@ writingNotSupported(OFString *type)
 		[OFApplication terminateWithStatus: 1];
 	}
 
+	if (threadsString != nil) {
+		unsigned long long threads = 0;
+
+		@try {
+			threads = threadsString.unsignedLongLongValue;
+		} @catch (OFInvalidFormatException *e) {
+		}
+
+		if (threads == 0 || threads > SIZE_MAX) {
+			[of_stderr writeLine: OF_LOCALIZED(
+			    @"invalid_threads",
+			    @"%[prog]: Invalid number of threads: %[threads]",
+			    @"prog", [OFApplication programName],
+			    @"threads", threadsString)];
+
+			[OFApplication terminateWithStatus: 1];
+		}
+
+#ifdef OF_HAVE_THREADS
+		if (threads > 1)
+			_threadPool = [[OFThreadPool alloc]
+			    initWithSize: (size_t)threads];
+#endif
+	}
+
 	remainingArguments = optionsParser.remainingArguments;
 
 	switch (mode) {
@@ -333,6 +365,13 @@ writingNotSupported(OFString *type)
 		[OFApplication activateSandbox: sandbox];
 #endif
 
+		/*
+		 * The archive and the streams it wraps need to be deallocated
+		 * before terminating, as e.g. the GZIP stream of a .tgz
+		 * archive only writes its trailer when it is closed.
+		 */
+		pool = objc_autoreleasePoolPush();
+
 		archive = [self
 		    openArchiveWithPath: remainingArguments.firstObject
 				   type: type
@@ -340,6 +379,8 @@ writingNotSupported(OFString *type)
 			       encoding: encoding];
 
 		[archive addFiles: files];
+
+		objc_autoreleasePoolPop(pool);
 		break;
 	case 'l':
 		if (remainingArguments.count != 1)
@@ -559,9 +600,12 @@ writingNotSupported(OFString *type)
 							   mode: modeString
 						       encoding: encoding];
 		else if ([type isEqual: @"tgz"]) {
-			OFStream *GZIPStream = [OFGZIPStream
+			OFGZIPStream *GZIPStream = [OFGZIPStream
 			    streamWithStream: file
 					mode: modeString];
+#ifdef OF_HAVE_THREADS
+			GZIPStream.threadPool = _threadPool;
+#endif
 			archive = [TarArchive archiveWithStream: GZIPStream
 							   mode: modeString
 						       encoding: encoding];
@@ -450,8 +450,9 @@ outer_loop_end:
 		entry.compressedSize = (int64_t)size;
 		entry.uncompressedSize = (int64_t)size;
 
-		entry.compressionMethod =
-		    OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_NONE;
+		entry.compressionMethod = (isDirectory
+		    ? OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_NONE
+		    : OF_ZIP_ARCHIVE_ENTRY_COMPRESSION_METHOD_DEFLATE);
 		entry.modificationDate = attributes.fileModificationDate;
 
 		[entry makeImmutable];